@@ -563,16 +563,15 @@ static NSUInteger globalOrderOfArrival = 1;
 
 -(void) transform
 {
-	kmMat4 transfrom4x4;
-
-	// Convert 3x3 into 4x4 matrix
+	// Multiply by the 2D affine transform directly, expanding it into a 4x4 matrix costs a full 4x4 multiplication
 	CGAffineTransform tmpAffine = [self nodeToParentTransform];
-	CGAffineToGL(&tmpAffine, transfrom4x4.mat);
+	kmMat3x2 transform3x2 = {{tmpAffine.a, tmpAffine.b, tmpAffine.c, tmpAffine.d, tmpAffine.tx, tmpAffine.ty}};
 
-	// Update Z vertex manually
-	transfrom4x4.mat[14] = vertexZ_;
+	kmGLMultMatrix3x2( &transform3x2 );
 
-	kmGLMultMatrix( &transfrom4x4 );
+	// Update Z vertex manually
+	if( vertexZ_ )
+		kmGLTranslatef(0, 0, vertexZ_);
 
 
 	// XXX: Expensive calls. Camera should be integrated into the cached affine matrix
@@ -46,6 +46,7 @@ enum {
 	TMXLayerAttribBase64 = 1 << 1,
 	TMXLayerAttribGzip = 1 << 2,
 	TMXLayerAttribZlib = 1 << 3,
+	TMXLayerAttribLZ4 = 1 << 4,
 };
 
 enum {
@@ -38,6 +38,7 @@
 #import "CCTMXTiledMap.h"
 #import "CCTMXObjectGroup.h"
 #import "Support/base64.h"
+#import "Support/ccLZ4.h"
 #import "Support/ZipUtils.h"
 #import "Support/CCFileUtils.h"
 
@@ -339,10 +340,13 @@
 			else if( [compression isEqualToString:@"zlib"] )
 				layerAttribs |= TMXLayerAttribZlib;
 
-			NSAssert( !compression || [compression isEqualToString:@"gzip"] || [compression isEqualToString:@"zlib"], @"TMX: unsupported compression method" );
+			else if( [compression isEqualToString:@"lz4"] )
+				layerAttribs |= TMXLayerAttribLZ4;
+
+			NSAssert( !compression || [compression isEqualToString:@"gzip"] || [compression isEqualToString:@"zlib"] || [compression isEqualToString:@"lz4"], @"TMX: unsupported compression method" );
 		}
 
-		NSAssert( layerAttribs != TMXLayerAttribNone, @"TMX tile map: Only base64 and/or gzip/zlib maps are supported" );
+		NSAssert( layerAttribs != TMXLayerAttribNone, @"TMX tile map: Only base64 and/or gzip/zlib/lz4 maps are supported" );
 
 	} else if([elementName isEqualToString:@"object"]) {
 
@@ -479,6 +483,22 @@
 			}
 
 			layer.tiles = (unsigned int*) deflated;
+
+		} else if( layerAttribs & TMXLayerAttribLZ4 ) {
+			// a raw LZ4 block, the layer size gives its inflated length
+			CGSize s = [layer layerSize];
+			unsigned int tilesLen = s.width * s.height * sizeof(uint32_t);
+			unsigned char *tiles = malloc( tilesLen );
+
+			if( ! tiles || ccLZ4Decompress(buffer, len, tiles, tilesLen) < 0 ) {
+				CCLOG(@"cocos2d: TiledMap: inflate data error");
+				free( tiles );
+				free( buffer );
+				return;
+			}
+
+			free( buffer );
+			layer.tiles = (unsigned int*) tiles;
 		} else
 			layer.tiles = (unsigned int*) buffer;
 
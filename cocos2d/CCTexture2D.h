@@ -100,6 +100,21 @@ typedef enum {
     
 } CCTexture2DPixelFormat;
 
+/** @typedef ccTexImageData
+ Pixels of an image decoded by +[CCTexture2D decodeCGImage:imageData:], ready to be uploaded
+ @since v2.0.0
+ */
+typedef struct _ccTexImageData {
+	//! the pixels in pixelFormat, allocated with malloc(). -initWithImageData: frees them
+	void					*data;
+	CCTexture2DPixelFormat	pixelFormat;
+	NSUInteger				pixelsWide;
+	NSUInteger				pixelsHigh;
+	//! size of the image, it can be smaller than pixelsWide x pixelsHigh
+	CGSize					contentSize;
+	BOOL					hasPremultipliedAlpha;
+} ccTexImageData;
+
 
 @class CCGLProgram;
 
@@ -199,6 +214,28 @@ typedef enum {
 #elif defined(__CC_PLATFORM_MAC)
 - (id) initWithCGImage:(CGImageRef)cgImage;
 #endif
+
+/** Draws a CGImage into a bitmap of the pixel format -initWithCGImage: would use.
+ It doesn't call OpenGL, so it can be used from any thread. The pixels must be uploaded with -initWithImageData: or freed.
+ Returns NO if the image can't be used as a texture.
+ @since v2.0.0
+ */
++ (BOOL) decodeCGImage:(CGImageRef)cgImage imageData:(ccTexImageData*)imageData;
+
+/** Same as decodeCGImage:imageData:, but if threaded is NO the pixels are converted in the calling thread
+ instead of being split between several threads. Use it when several images are decoded at the same time.
+ @since v2.0.0
+ */
++ (BOOL) decodeCGImage:(CGImageRef)cgImage imageData:(ccTexImageData*)imageData threaded:(BOOL)threaded;
+
+/** Initializes a texture from the pixels of a decoded image, and frees them.
+ @since v2.0.0
+ */
+#ifdef __CC_PLATFORM_IOS
+- (id) initWithImageData:(ccTexImageData*)imageData resolutionType:(ccResolutionType)resolution;
+#elif defined(__CC_PLATFORM_MAC)
+- (id) initWithImageData:(ccTexImageData*)imageData;
+#endif
 @end
 
 /**
@@ -247,6 +284,16 @@ typedef enum {
  */
 -(id) initWithPVRFile: (NSString*) file;
 
+/** Initializes a texture from a PVR file whose full path was already resolved with CCFileUtils.
+ Unlike initWithPVRFile:, it doesn't use CCFileUtils, so the path can be resolved in another thread.
+ @since v2.0.0
+ */
+#ifdef __CC_PLATFORM_IOS
+-(id) initWithPVRFullPath:(NSString*)fullpath resolutionType:(ccResolutionType)resolution;
+#elif defined(__CC_PLATFORM_MAC)
+-(id) initWithPVRFullPath:(NSString*)fullpath;
+#endif
+
 /** treats (or not) PVR files as if they have alpha premultiplied.
  Since it is impossible to know at runtime if the PVR images have the alpha channel premultiplied, it is
  possible load them as if they have (or not) the alpha channel premultiplied.
@@ -333,6 +380,21 @@ typedef struct _ccTexParams {
  */
 +(CCTexture2DPixelFormat) defaultAlphaPixelFormat;
 
+/** sets whether CGImages converted to a 16-bit format (RGBA4444, RGB5A1 or RGB565) use ordered dithering.
+ Dithering removes most of the banding of gradients, but flat colors may get a faint pattern.
+ Default is NO, so the textures are the same as before.
+ 
+ This parameter is not valid for PVR / PVR.CCZ images.
+ 
+ @since v2.0.0
+ */
++(void) setDitherConvertedImages:(BOOL)dither;
+
+/** returns whether CGImages converted to a 16-bit format use ordered dithering
+ @since v2.0.0
+ */
++(BOOL) ditherConvertedImages;
+
 /** returns the bits-per-pixel of the in-memory OpenGL texture
  @since v1.0
  */
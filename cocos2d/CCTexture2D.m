@@ -84,6 +84,7 @@
 
 #import "Support/ccUtils.h"
 #import "Support/CCFileUtils.h"
+#import "Support/ccPixelConvert.h"
 
 #import "ccDeprecated.h"
 
@@ -102,6 +103,9 @@
 // Default is: RGBA8888 (32-bit textures)
 static CCTexture2DPixelFormat defaultAlphaPixelFormat_ = kCCTexture2DPixelFormat_Default;
 
+// Ordered dithering when images are converted to a 16-bit format
+static BOOL ditherConvertedImages_ = NO;
+
 #pragma mark -
 #pragma mark CCTexture2D - Main
 
@@ -234,14 +238,54 @@ static CCTexture2DPixelFormat defaultAlphaPixelFormat_ = kCCTexture2DPixelFormat
 #elif defined(__CC_PLATFORM_MAC)
 - (id) initWithCGImage:(CGImageRef)cgImage
 #endif
+{
+	ccTexImageData imageData;
+	
+	if( ! [[self class] decodeCGImage:cgImage imageData:&imageData] ) {
+		[self release];
+		return nil;
+	}
+	
+#ifdef __CC_PLATFORM_IOS
+	return [self initWithImageData:&imageData resolutionType:resolution];
+#elif defined(__CC_PLATFORM_MAC)
+	return [self initWithImageData:&imageData];
+#endif
+}
+
+#ifdef __CC_PLATFORM_IOS
+- (id) initWithImageData:(ccTexImageData*)imageData resolutionType:(ccResolutionType)resolution
+#elif defined(__CC_PLATFORM_MAC)
+- (id) initWithImageData:(ccTexImageData*)imageData
+#endif
+{
+	self = [self initWithData:imageData->data pixelFormat:imageData->pixelFormat pixelsWide:imageData->pixelsWide pixelsHigh:imageData->pixelsHigh contentSize:imageData->contentSize];
+    
+	// should be after calling super init
+	hasPremultipliedAlpha_ = imageData->hasPremultipliedAlpha;
+    
+	[self releaseData:imageData->data];
+	imageData->data = NULL;
+    
+#ifdef __CC_PLATFORM_IOS
+	resolutionType_ = resolution;
+#endif
+    
+	return self;
+}
+
++ (BOOL) decodeCGImage:(CGImageRef)cgImage imageData:(ccTexImageData*)imageData
+{
+	return [self decodeCGImage:cgImage imageData:imageData threaded:YES];
+}
+
++ (BOOL) decodeCGImage:(CGImageRef)cgImage imageData:(ccTexImageData*)imageData threaded:(BOOL)threaded
 {
 	NSUInteger				textureWidth, textureHeight;
 	CGContextRef			context = nil;
 	void*					data = nil;
 	CGColorSpaceRef			colorSpace;
 	void*					tempData;
-	unsigned int*			inPixel32;
-	unsigned short*			outPixel16;
 	BOOL					hasAlpha;
 	CGImageAlphaInfo		info;
 	CGSize					imageSize;
@@ -249,8 +293,7 @@ static CCTexture2DPixelFormat defaultAlphaPixelFormat_ = kCCTexture2DPixelFormat
     
 	if(cgImage == NULL) {
 		CCLOG(@"cocos2d: CCTexture2D. Can't create Texture. cgImage is nil");
-		[self release];
-		return nil;
+		return NO;
 	}
     
 	CCConfiguration *conf = [CCConfiguration sharedConfiguration];
@@ -314,7 +357,7 @@ static CCTexture2DPixelFormat defaultAlphaPixelFormat_ = kCCTexture2DPixelFormat
 	if( [conf OSVersion] >= kCCiOSVersion_5_0 )
 	{
 		
-		NSUInteger bpp = [[self class] bitsPerPixelForFormat:pixelFormat];
+		NSUInteger bpp = [self bitsPerPixelForFormat:pixelFormat];
 		NSUInteger bytes = textureWidth * bpp / 8;
 		
 		// XXX: Should it be 4 or sizeof(int) ??
@@ -336,8 +379,7 @@ static CCTexture2DPixelFormat defaultAlphaPixelFormat_ = kCCTexture2DPixelFormat
         CCLOGWARN(@"cocos2d: WARNING: Image (%lu x %lu) is bigger than the supported %ld x %ld",
                   (long)textureWidth, (long)textureHeight,
                   (long)maxTextureSize, (long)maxTextureSize);
-        [self release];
-        return nil;
+        return NO;
     }
     
 	imageSize = CGSizeMake(CGImageGetWidth(cgImage), CGImageGetHeight(cgImage));
@@ -370,95 +412,57 @@ static CCTexture2DPixelFormat defaultAlphaPixelFormat_ = kCCTexture2DPixelFormat
 	CGContextClearRect(context, CGRectMake(0, 0, textureWidth, textureHeight));
 	CGContextTranslateCTM(context, 0, textureHeight - imageSize.height);
 	CGContextDrawImage(context, CGRectMake(0, 0, CGImageGetWidth(cgImage), CGImageGetHeight(cgImage)), cgImage);
+	CGContextRelease(context);
     
 	// Repack the pixel data into the right format
     
-	if(pixelFormat == kCCTexture2DPixelFormat_RGB565) {
-		//Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRRGGGGGGBBBBB"
-		tempData = malloc(textureHeight * textureWidth * 2);
-		inPixel32 = (unsigned int*)data;
-		outPixel16 = (unsigned short*)tempData;
-		for(unsigned int i = 0; i < textureWidth * textureHeight; ++i, ++inPixel32)
-			*outPixel16++ = ((((*inPixel32 >> 0) & 0xFF) >> 3) << 11) | ((((*inPixel32 >> 8) & 0xFF) >> 2) << 5) | ((((*inPixel32 >> 16) & 0xFF) >> 3) << 0);
-		free(data);
-		data = tempData;
-        
-	}
-    
-	else if(pixelFormat == kCCTexture2DPixelFormat_RGB888) {
-		//Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRRRRRGGGGGGGGBBBBBBB"
-		tempData = malloc(textureHeight * textureWidth * 3);
-		char *inData = (char*)data;
-		char *outData = (char*)tempData;
-		int j=0;
-		for(unsigned int i = 0; i < textureWidth * textureHeight *4; i++) {
-			outData[j++] = inData[i++];
-			outData[j++] = inData[i++];
-			outData[j++] = inData[i++];
-		}
-		free(data);
-		data = tempData;
-		
+	ccPixelConvertFormat convertFormat = kCCPixelConvertRGB565;
+	BOOL convert = YES;
+	switch(pixelFormat) {
+		case kCCTexture2DPixelFormat_RGB565:
+			//Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRRGGGGGGBBBBB"
+			convertFormat = kCCPixelConvertRGB565;
+			break;
+		case kCCTexture2DPixelFormat_RGB888:
+			//Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRRRRRGGGGGGGGBBBBBBB"
+			convertFormat = kCCPixelConvertRGB888;
+			break;
+		case kCCTexture2DPixelFormat_RGBA4444:
+			//Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRGGGGBBBBAAAA"
+			convertFormat = kCCPixelConvertRGBA4444;
+			break;
+		case kCCTexture2DPixelFormat_RGB5A1:
+			//Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRRGGGGGBBBBBA"
+			// Transparent pixels become 0, otherwise they leave a "ghost" image on dark backgrounds
+			convertFormat = kCCPixelConvertRGB5A1;
+			break;
+		default:
+			// RGBA8888 and A8 are used as they were drawn
+			convert = NO;
+			break;
 	}
     
-	else if (pixelFormat == kCCTexture2DPixelFormat_RGBA4444) {
-		//Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRGGGGBBBBAAAA"
-		tempData = malloc(textureHeight * textureWidth * 2);
-		inPixel32 = (unsigned int*)data;
-		outPixel16 = (unsigned short*)tempData;
-		for(unsigned int i = 0; i < textureWidth * textureHeight; ++i, ++inPixel32)
-			*outPixel16++ =
-			((((*inPixel32 >> 0) & 0xFF) >> 4) << 12) | // R
-			((((*inPixel32 >> 8) & 0xFF) >> 4) << 8) | // G
-			((((*inPixel32 >> 16) & 0xFF) >> 4) << 4) | // B
-			((((*inPixel32 >> 24) & 0xFF) >> 4) << 0); // A
-        
-        
-		free(data);
-		data = tempData;
-        
-	}
-	else if (pixelFormat == kCCTexture2DPixelFormat_RGB5A1) {
-		//Convert "RRRRRRRRRGGGGGGGGBBBBBBBBAAAAAAAA" to "RRRRRGGGGGBBBBBA"
-		/*
-		 Here was a bug.
-		 When you convert RGBA8888 texture to RGB5A1 texture and then render it on black background, you'll see a "ghost" image as if the texture is still RGBA8888.
-		 On background lighter than the pixel color this effect disappers.
-		 This happens because the old convertion function doesn't premultiply old RGB with new A.
-		 As Result = sourceRGB + destination*(1-source A), then
-		 if Destination = 0000, then Result = source. Here comes the ghost!
-		 We need to check new alpha value first (it may be 1 or 0) and depending on it whether convert RGB values or just set pixel to 0
-		 */
-		tempData = malloc(textureHeight * textureWidth * 2);
-		inPixel32 = (unsigned int*)data;
-		outPixel16 = (unsigned short*)tempData;
-		for(unsigned int i = 0; i < textureWidth * textureHeight; ++i, ++inPixel32) {
-			if ((*inPixel32 >> 31))// A can be 1 or 0
-				*outPixel16++ =
-				((((*inPixel32 >> 0) & 0xFF) >> 3) << 11) | // R
-				((((*inPixel32 >> 8) & 0xFF) >> 3) << 6) | // G
-				((((*inPixel32 >> 16) & 0xFF) >> 3) << 1) | // B
-				1; // A
-			else
-				*outPixel16++ = 0;
-		}
-		
+	if( convert ) {
+		unsigned int options = ditherConvertedImages_ ? kCCPixelConvertDither : 0;
+		size_t stride = textureWidth * ccPixelConvertBitsPerPixel(convertFormat) / 8;
+		tempData = malloc(textureHeight * stride);
+
+		if( threaded )
+			ccPixelConvert(tempData, data, textureWidth, textureHeight, convertFormat, options);
+		else
+			ccPixelConvertRows(tempData, stride, data, textureWidth * 4, textureWidth, 0, textureHeight, convertFormat, options);
 		free(data);
 		data = tempData;
 	}
-	self = [self initWithData:data pixelFormat:pixelFormat pixelsWide:textureWidth pixelsHigh:textureHeight contentSize:imageSize];
-    
-	// should be after calling super init
-	hasPremultipliedAlpha_ = (info == kCGImageAlphaPremultipliedLast || info == kCGImageAlphaPremultipliedFirst);
-    
-	CGContextRelease(context);
-	[self releaseData:data];
-    
-#ifdef __CC_PLATFORM_IOS
-	resolutionType_ = resolution;
-#endif
-    
-	return self;
+	
+	imageData->data = data;
+	imageData->pixelFormat = pixelFormat;
+	imageData->pixelsWide = textureWidth;
+	imageData->pixelsHigh = textureHeight;
+	imageData->contentSize = imageSize;
+	imageData->hasPremultipliedAlpha = (info == kCGImageAlphaPremultipliedLast || info == kCGImageAlphaPremultipliedFirst);
+    
+	return YES;
 }
 @end
 
@@ -725,11 +729,22 @@ static BOOL PVRHaveAlphaPremultiplied_ = NO;
 #ifdef __CC_PLATFORM_IOS
 	ccResolutionType resolution;
 	NSString *fullpath = [[CCFileUtils sharedFileUtils] fullPathFromRelativePath:relPath resolutionType:&resolution];
+
+	return [self initWithPVRFullPath:fullpath resolutionType:resolution];
     
 #elif defined(__CC_PLATFORM_MAC)
 	NSString *fullpath = [[CCFileUtils sharedFileUtils] fullPathFromRelativePath:relPath];
+
+	return [self initWithPVRFullPath:fullpath];
 #endif
-    
+}
+
+#ifdef __CC_PLATFORM_IOS
+-(id) initWithPVRFullPath:(NSString*)fullpath resolutionType:(ccResolutionType)resolution
+#elif defined(__CC_PLATFORM_MAC)
+-(id) initWithPVRFullPath:(NSString*)fullpath
+#endif
+{
 	if( (self = [super init]) ) {
 		CCTexturePVR *pvr = [[CCTexturePVR alloc] initWithContentsOfFile:fullpath];
 		if( pvr ) {
@@ -749,7 +764,7 @@ static BOOL PVRHaveAlphaPremultiplied_ = NO;
             
 		} else {
             
-			CCLOG(@"cocos2d: Couldn't load PVR image: %@", relPath);
+			CCLOG(@"cocos2d: Couldn't load PVR image: %@", fullpath);
 			[self release];
 			return nil;
 		}
@@ -905,6 +920,16 @@ static BOOL PVRHaveAlphaPremultiplied_ = NO;
 	return defaultAlphaPixelFormat_;
 }
 
++(void) setDitherConvertedImages:(BOOL)dither
+{
+	ditherConvertedImages_ = dither;
+}
+
++(BOOL) ditherConvertedImages
+{
+	return ditherConvertedImages_;
+}
+
 +(NSUInteger) bitsPerPixelForFormat:(CCTexture2DPixelFormat)format
 {
 	NSUInteger ret=0;
@@ -33,6 +33,7 @@
 #import <Foundation/Foundation.h>
 
 @class CCTexture2D;
+@class CCTextureRequest;
 
 /** Singleton that handles the loading of textures
  * Once the texture is loaded, the next time it will return
@@ -44,6 +45,14 @@
 
 	dispatch_queue_t _loadingQueue;
 	dispatch_queue_t _dictQueue;
+
+	// asynchronous loading: paths -> the images being loaded with their requests,
+	// and the images waiting for a decoder in request order
+	NSMutableDictionary *_asyncLoads;
+	NSMutableArray *_pendingLoads;
+	NSUInteger _activeDecoders;
+	NSUInteger _maxDecoders;
+	dispatch_semaphore_t _uploadSemaphore;
 }
 
 /** Retruns ths shared instance of the cache */
@@ -81,6 +90,25 @@
  */
 -(void) addImageAsync:(NSString*) filename withBlock:(void(^)(CCTexture2D *tex))block;
 
+/** Asynchronously, load a texture2d from a file, with a priority.
+ * The images are decoded by several threads (see CC_TEXTURE_CACHE_ASYNC_DECODERS), the ones with the highest priority first,
+ * and uploaded to OpenGL by another one. Requests with the same priority are loaded in order.
+ * If the file image was previously loaded, the block is called before returning. Otherwise it will be called in the cocos2d thread,
+ * with nil if the image couldn't be loaded.
+ * Returns the request, it can be used to change its priority or to cancel it.
+ * @since v2.0.0
+ */
+-(CCTextureRequest*) addImageAsync:(NSString*) filename priority:(NSInteger)priority withBlock:(void(^)(CCTexture2D *tex))block;
+
+/** Asynchronously, load a list of texture2d from files, with a priority.
+ * progress is called in the cocos2d thread every time an image is loaded, cancelled or fails, with the number of them and the number of files. It can be nil.
+ * block is called in the cocos2d thread when all of them are finished, with the textures by file name. The images that could not be loaded or were cancelled are not in it.
+ * Images that were previously loaded are reported before returning.
+ * Returns the requests, in the order of the files.
+ * @since v2.0.0
+ */
+-(NSArray*) addImagesAsync:(NSArray*) filenames priority:(NSInteger)priority progress:(void(^)(NSUInteger loaded, NSUInteger count))progress withBlock:(void(^)(NSDictionary *textures))block;
+
 
 /** Returns a Texture2D object given an CGImageRef image
  * If the image was not previously loaded, it will create a new CCTexture2D object and it will return it.
@@ -123,6 +151,36 @@
 @end
 
 
+/** An image loaded asynchronously by CCTextureCache
+ @since v2.0.0
+ */
+@interface CCTextureRequest : NSObject
+{
+	NSString	*path_;
+	NSInteger	priority_;
+	BOOL		isCancelled_;
+	void		(^completion_)(CCTextureRequest *request, CCTexture2D *tex);
+}
+
+/** the path of the image. On iOS it doesn't have the -hd suffix */
+@property (nonatomic, readonly) NSString *path;
+
+/** images with a higher priority are loaded first. It can be changed until the image is being decoded.
+ If several requests load the same image, the highest priority is used.
+ */
+@property (readwrite) NSInteger priority;
+
+/** whether the request was cancelled */
+@property (readonly) BOOL isCancelled;
+
+/** cancels the request. Its block won't be called if it is cancelled in the cocos2d thread before the image is loaded.
+ The image is not loaded if all the requests for it are cancelled before it is decoded or uploaded.
+ */
+-(void) cancel;
+
+@end
+
+
 @interface CCTextureCache (PVRSupport)
 
 /** Returns a Texture2D object given an PVR filename.
@@ -52,6 +52,114 @@ static EAGLContext *_auxGLcontext = nil;
 static NSOpenGLContext *_auxGLcontext = nil;
 #endif
 
+typedef void (^CCTextureRequestCompletion)(CCTextureRequest *request, CCTexture2D *tex);
+
+#pragma mark - CCTextureRequest
+
+@interface CCTextureRequest ()
+-(id) initWithPath:(NSString*)path priority:(NSInteger)priority completion:(CCTextureRequestCompletion)completion;
+-(void) finishWithTexture:(CCTexture2D*)tex;
+@end
+
+@implementation CCTextureRequest
+
+@synthesize path = path_;
+@synthesize priority = priority_;
+@synthesize isCancelled = isCancelled_;
+
+-(id) initWithPath:(NSString*)path priority:(NSInteger)priority completion:(CCTextureRequestCompletion)completion
+{
+	if( (self=[super init]) ) {
+		path_ = [path copy];
+		priority_ = priority;
+		completion_ = [completion copy];
+	}
+
+	return self;
+}
+
+- (NSString*) description
+{
+	return [NSString stringWithFormat:@"<%@ = %p | path = %@ | priority = %ld | cancelled = %d>", [self class], self, path_, (long)self.priority, self.isCancelled];
+}
+
+-(void) dealloc
+{
+	[path_ release];
+	[completion_ release];
+
+	[super dealloc];
+}
+
+-(void) cancel
+{
+	isCancelled_ = YES;
+}
+
+// called once, in the cocos2d thread
+-(void) finishWithTexture:(CCTexture2D*)tex
+{
+	CCTextureRequestCompletion completion = completion_;
+	completion_ = nil;
+
+	completion(self, tex);
+	[completion release];
+}
+
+@end
+
+#pragma mark - CCTextureAsyncLoad
+
+// An image being loaded asynchronously and the requests waiting for it.
+// Its full path is resolved when it is requested, since CCFileUtils can't be used by the decoders.
+@interface CCTextureAsyncLoad : NSObject
+{
+@public
+	NSString *path_;
+	NSString *fullPath_;
+	ccResolutionType resolution_;
+	NSMutableArray *requests_;
+}
+-(id) initWithPath:(NSString*)path fullPath:(NSString*)fullPath resolutionType:(ccResolutionType)resolution;
+@end
+
+@implementation CCTextureAsyncLoad
+
+-(id) initWithPath:(NSString*)path fullPath:(NSString*)fullPath resolutionType:(ccResolutionType)resolution
+{
+	if( (self=[super init]) ) {
+		path_ = [path copy];
+		fullPath_ = [fullPath copy];
+		resolution_ = resolution;
+		requests_ = [[NSMutableArray alloc] initWithCapacity:1];
+	}
+
+	return self;
+}
+
+-(void) dealloc
+{
+	[path_ release];
+	[fullPath_ release];
+	[requests_ release];
+
+	[super dealloc];
+}
+
+@end
+
+#pragma mark - CCTextureCache
+
+@interface CCTextureCache ()
+-(CCTextureRequest*) requestImageAsync:(NSString*)path priority:(NSInteger)priority completion:(CCTextureRequestCompletion)completion;
+-(void) finishRequests:(NSArray*)requests texture:(CCTexture2D*)tex;
+-(void) finishAsyncImage:(CCTextureAsyncLoad*)load texture:(CCTexture2D*)tex;
+-(BOOL) isAsyncImageCancelled:(CCTextureAsyncLoad*)load;
+-(CCTextureAsyncLoad*) nextPendingLoad:(NSMutableArray*)cancelled;
+-(void) decodeAsyncImages;
+-(void) loadAsyncImage:(CCTextureAsyncLoad*)load;
+@end
+
 @implementation CCTextureCache
 
 #pragma mark TextureCache - Alloc, Init & Dealloc
@@ -86,6 +194,11 @@ static CCTextureCache *sharedTextureCache;
 		_loadingQueue = dispatch_queue_create("org.cocos2d.texturecacheloading", NULL);
 		_dictQueue = dispatch_queue_create("org.cocos2d.texturecachedict", NULL);
 
+		_asyncLoads = [[NSMutableDictionary alloc] initWithCapacity:10];
+		_pendingLoads = [[NSMutableArray alloc] initWithCapacity:10];
+		_maxDecoders = CC_TEXTURE_CACHE_ASYNC_DECODERS ? CC_TEXTURE_CACHE_ASYNC_DECODERS : [[NSProcessInfo processInfo] activeProcessorCount];
+		_uploadSemaphore = dispatch_semaphore_create(CC_TEXTURE_CACHE_ASYNC_UPLOADS);
+
 		CCGLView *view = (CCGLView*)[[CCDirector sharedDirector] view];
 		NSAssert(view, @"Do not initialize the TextureCache before the Director");
 
@@ -129,12 +242,15 @@ static CCTextureCache *sharedTextureCache;
 
 	dispatch_sync(_dictQueue, ^{
 		[textures_ release];
+		[_asyncLoads release];
+		[_pendingLoads release];
 	});
 	[_auxGLcontext release];
 	_auxGLcontext = nil;
 	sharedTextureCache = nil;
 	dispatch_release(_loadingQueue);
 	dispatch_release(_dictQueue);
+	dispatch_release(_uploadSemaphore);
 
 	[super dealloc];
 }
@@ -147,124 +263,317 @@ static CCTextureCache *sharedTextureCache;
 	NSAssert(target != nil, @"TextureCache: target can't be nil");
 	NSAssert(selector != NULL, @"TextureCache: selector can't be NULL");
 
-	// optimization
+	[self addImageAsync:path priority:0 withBlock:^(CCTexture2D *tex) {
+		[target performSelector:selector withObject:tex];
+	}];
+}
 
+-(void) addImageAsync:(NSString*)path withBlock:(void(^)(CCTexture2D *tex))block
+{
+	[self addImageAsync:path priority:0 withBlock:block];
+}
+
+-(CCTextureRequest*) addImageAsync:(NSString*)path priority:(NSInteger)priority withBlock:(void(^)(CCTexture2D *tex))block
+{
+	NSAssert(path != nil, @"TextureCache: fileimage MUST not be nil");
+	NSAssert(block != nil, @"TextureCache: block can't be nil");
+
+	return [self requestImageAsync:path priority:priority completion:^(CCTextureRequest *request, CCTexture2D *tex) {
+		if( ! request.isCancelled )
+			block(tex);
+	}];
+}
+
+-(NSArray*) addImagesAsync:(NSArray*)paths priority:(NSInteger)priority progress:(void(^)(NSUInteger loaded, NSUInteger count))progress withBlock:(void(^)(NSDictionary *textures))block
+{
+	NSAssert(paths != nil, @"TextureCache: filenames MUST not be nil");
+	NSAssert(block != nil, @"TextureCache: block can't be nil");
+
+	NSUInteger count = [paths count];
+	NSMutableArray *requests = [NSMutableArray arrayWithCapacity:count];
+	NSMutableDictionary *textures = [NSMutableDictionary dictionaryWithCapacity:count];
+
+	// all the completions run in the cocos2d thread
+	__block NSUInteger loaded = 0;
+
+	if( count == 0 )
+		block(textures);
+
+	for( NSString *path in paths ) {
+		CCTextureRequest *request = [self requestImageAsync:path priority:priority completion:^(CCTextureRequest *finished, CCTexture2D *tex) {
+			if( tex && ! finished.isCancelled )
+				[textures setObject:tex forKey:path];
+
+			loaded++;
+			if( progress )
+				progress(loaded, count);
+			if( loaded == count )
+				block(textures);
+		}];
+
+		[requests addObject:request];
+	}
+
+	return requests;
+}
+
+-(CCTextureRequest*) requestImageAsync:(NSString*)path priority:(NSInteger)priority completion:(CCTextureRequestCompletion)completion
+{
 	__block CCTexture2D * tex;
+	__block BOOL startDecoder = NO;
 
 #ifdef __CC_PLATFORM_IOS
 	path = [[CCFileUtils sharedFileUtils] removeSuffixFromFile:path];
 #endif
 
+	CCTextureRequest *request = [[[CCTextureRequest alloc] initWithPath:path priority:priority completion:completion] autorelease];
+
+	// CCFileUtils is not thread safe: resolve the full path here instead of in the decoders
+	ccResolutionType resolution = kCCResolutionUnknown;
+#ifdef __CC_PLATFORM_IOS
+	NSString *fullpath = [[CCFileUtils sharedFileUtils] fullPathFromRelativePath:path resolutionType:&resolution];
+#elif defined(__CC_PLATFORM_MAC)
+	NSString *fullpath = [[CCFileUtils sharedFileUtils] fullPathFromRelativePath:path];
+#endif
+
 	dispatch_sync(_dictQueue, ^{
 		tex = [textures_ objectForKey:path];
+		if( tex )
+			return;
+
+		// an image requested several times is loaded once
+		CCTextureAsyncLoad *load = [_asyncLoads objectForKey:path];
+		if( ! load ) {
+			load = [[CCTextureAsyncLoad alloc] initWithPath:path fullPath:fullpath resolutionType:resolution];
+			[_asyncLoads setObject:load forKey:path];
+			[_pendingLoads addObject:load];
+			[load release];
+
+			if( _activeDecoders < _maxDecoders ) {
+				_activeDecoders++;
+				startDecoder = YES;
+			}
+		}
+		[load->requests_ addObject:request];
 	});
 
-	if(tex) {
-		[target performSelector:selector withObject:tex];
-		return;
+	// optimization
+	if( tex )
+		[request finishWithTexture:tex];
+
+	else if( startDecoder ) {
+		dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+			[self decodeAsyncImages];
+		});
 	}
 
-	// dispatch it serially
-	dispatch_async(_loadingQueue, ^{
+	return request;
+}
 
-		CCTexture2D *texture;
+#pragma mark TextureCache - Async loading pipeline
 
-#ifdef __CC_PLATFORM_IOS
-		if( [EAGLContext setCurrentContext:_auxGLcontext] ) {
+// Calls the completions of the requests in the cocos2d thread
+-(void) finishRequests:(NSArray*)requests texture:(CCTexture2D*)tex
+{
+	NSThread *thread = [[CCDirector sharedDirector] runningThread];
+	[thread performBlock:^{
+		for( CCTextureRequest *request in requests )
+			[request finishWithTexture:tex];
+	} waitUntilDone:NO];
+}
 
-			// load / create the texture
-			texture = [self addImage:path];
+-(void) finishAsyncImage:(CCTextureAsyncLoad*)load texture:(CCTexture2D*)tex
+{
+	__block NSArray *requests;
 
-			glFlush();
+	dispatch_sync(_dictQueue, ^{
+		requests = [load->requests_ copy];
+		[_asyncLoads removeObjectForKey:load->path_];
+	});
 
-			// callback should be executed in cocos2d thread
-			[target performSelector:selector onThread:[[CCDirector sharedDirector] runningThread] withObject:texture waitUntilDone:NO];
+	[self finishRequests:requests texture:tex];
+	[requests release];
+}
 
-			[EAGLContext setCurrentContext:nil];
-		} else {
-			CCLOG(@"cocos2d: ERROR: TetureCache: Could not set EAGLContext");
+// must be called in _dictQueue
+-(BOOL) isAsyncImageCancelled:(CCTextureAsyncLoad*)load
+{
+	for( CCTextureRequest *request in load->requests_ )
+		if( ! request.isCancelled )
+			return NO;
+
+	return YES;
+}
+
+// must be called in _dictQueue. Removes the pending image with the highest priority, and the ones that were cancelled.
+-(CCTextureAsyncLoad*) nextPendingLoad:(NSMutableArray*)cancelled
+{
+	CCTextureAsyncLoad *next = nil;
+	NSInteger nextPriority = 0;
+
+	for( CCTextureAsyncLoad *load in [[_pendingLoads copy] autorelease] ) {
+
+		if( [self isAsyncImageCancelled:load] ) {
+			[cancelled addObjectsFromArray:load->requests_];
+			[_asyncLoads removeObjectForKey:load->path_];
+			[_pendingLoads removeObjectIdenticalTo:load];
+			continue;
 		}
 
-#elif defined(__CC_PLATFORM_MAC)
+		for( CCTextureRequest *request in load->requests_ ) {
+			NSInteger priority = request.priority;
+			if( ! request.isCancelled && (!next || priority > nextPriority) ) {
+				next = load;
+				nextPriority = priority;
+			}
+		}
+	}
 
-		[_auxGLcontext makeCurrentContext];
+	// it stays in _asyncLoads until it is loaded
+	if( next )
+		[_pendingLoads removeObjectIdenticalTo:next];
 
-		// load / create the texture
-		texture = [self addImage:path];
+	return next;
+}
 
-		glFlush();
+// Runs in a background thread until there are no more images to decode
+-(void) decodeAsyncImages
+{
+	for( ;; ) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		NSMutableArray *cancelled = [NSMutableArray array];
+		__block CCTextureAsyncLoad *load;
 
-		// callback should be executed in cocos2d thread
-        NSThread *thread = [[CCDirector sharedDirector] runningThread];
-		[target performSelector:selector onThread:thread withObject:texture waitUntilDone:NO];
+		dispatch_sync(_dictQueue, ^{
+			load = [[self nextPendingLoad:cancelled] retain];
+			if( ! load )
+				_activeDecoders--;
+		});
 
-		[NSOpenGLContext clearCurrentContext];
+		if( [cancelled count] )
+			[self finishRequests:cancelled texture:nil];
 
-#endif // __CC_PLATFORM_MAC
+		if( load )
+			[self loadAsyncImage:load];
 
-	});
+		[load release];
+		[pool release];
+
+		if( ! load )
+			break;
+	}
 }
 
--(void) addImageAsync:(NSString*)path withBlock:(void(^)(CCTexture2D *tex))block
+// Decodes the image in the calling thread, and uploads it in _loadingQueue
+-(void) loadAsyncImage:(CCTextureAsyncLoad*)load
 {
-	NSAssert(path != nil, @"TextureCache: fileimage MUST not be nil");
+	ccTexImageData imageData = { NULL };
+	NSString *path = load->path_;
+	NSString *fullpath = load->fullPath_;
+	ccResolutionType resolution = load->resolution_;
+	BOOL decoded = NO;
 
-	// optimization
+	NSString *lowerCase = [path lowercaseString];
+	BOOL isPVR = [lowerCase hasSuffix:@".pvr"] || [lowerCase hasSuffix:@".pvr.gz"] || [lowerCase hasSuffix:@".pvr.ccz"];
 
-	__block CCTexture2D * tex;
+	// PVR images are loaded and uploaded by CCTexturePVR
+	if( ! isPVR ) {
 
+		// several images are decoded at the same time: convert the pixels in this thread only
 #ifdef __CC_PLATFORM_IOS
-	path = [[CCFileUtils sharedFileUtils] removeSuffixFromFile:path];
-#endif
+		UIImage *image = [[UIImage alloc] initWithContentsOfFile:fullpath];
+		decoded = [CCTexture2D decodeCGImage:image.CGImage imageData:&imageData threaded:NO];
+		[image release];
+
+#elif defined(__CC_PLATFORM_MAC)
+		NSData *data = [[NSData alloc] initWithContentsOfFile:fullpath];
+		NSBitmapImageRep *image = [[NSBitmapImageRep alloc] initWithData:data];
+		decoded = [CCTexture2D decodeCGImage:[image CGImage] imageData:&imageData threaded:NO];
 
+		[data release];
+		[image release];
+#endif // __CC_PLATFORM_MAC
+
+		if( ! decoded ) {
+			CCLOG(@"cocos2d: Couldn't add image:%@ in CCTextureCache", path);
+			[self finishAsyncImage:load texture:nil];
+			return;
+		}
+	}
+
+	// the requests could have been cancelled while decoding
+	__block BOOL cancelled;
 	dispatch_sync(_dictQueue, ^{
-		tex = [textures_ objectForKey:path];
+		cancelled = [self isAsyncImageCancelled:load];
 	});
 
-	if(tex) {
-		block(tex);
+	if( cancelled ) {
+		free(imageData.data);
+		[self finishAsyncImage:load texture:nil];
 		return;
 	}
 
-	// dispatch it serially
-	dispatch_async( _loadingQueue, ^{
+	// wait while there are too many decoded images
+	dispatch_semaphore_wait(_uploadSemaphore, DISPATCH_TIME_FOREVER);
 
-		CCTexture2D *texture;
+	dispatch_async(_loadingQueue, ^{
+
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		ccTexImageData pixels = imageData;
+		__block CCTexture2D *texture = nil;
 
 #ifdef __CC_PLATFORM_IOS
-		if( [EAGLContext setCurrentContext:_auxGLcontext] ) {
+		BOOL current = [EAGLContext setCurrentContext:_auxGLcontext];
+#elif defined(__CC_PLATFORM_MAC)
+		[_auxGLcontext makeCurrentContext];
+		BOOL current = YES;
+#endif
 
-			// load / create the texture
-			texture = [self addImage:path];
+		if( current ) {
+			CCTexture2D *tex;
 
-			glFlush();
+#ifdef __CC_PLATFORM_IOS
+			if( isPVR )
+				tex = [[CCTexture2D alloc] initWithPVRFullPath:fullpath resolutionType:resolution];
+			else
+				tex = [[CCTexture2D alloc] initWithImageData:&pixels resolutionType:resolution];
+#elif defined(__CC_PLATFORM_MAC)
+			if( isPVR )
+				tex = [[CCTexture2D alloc] initWithPVRFullPath:fullpath];
+			else
+				tex = [[CCTexture2D alloc] initWithImageData:&pixels];
+#endif
+			if( ! tex )
+				CCLOG(@"cocos2d: Couldn't add image:%@ in CCTextureCache", path);
 
-			// callback should be executed in cocos2d thread
-			NSThread *thread = [[CCDirector sharedDirector] runningThread];
-			[thread performBlock:block withObject:texture waitUntilDone:NO];
+			// addImage: may have loaded it meanwhile
+			dispatch_sync(_dictQueue, ^{
+				texture = [[textures_ objectForKey:path] retain];
+				if( ! texture && tex ) {
+					[textures_ setObject:tex forKey:path];
+					texture = [tex retain];
+				}
+			});
+			[tex release];
 
+			glFlush();
+
+#ifdef __CC_PLATFORM_IOS
 			[EAGLContext setCurrentContext:nil];
+#elif defined(__CC_PLATFORM_MAC)
+			[NSOpenGLContext clearCurrentContext];
+#endif
 		} else {
 			CCLOG(@"cocos2d: ERROR: TetureCache: Could not set EAGLContext");
+			free(pixels.data);
 		}
 
-#elif defined(__CC_PLATFORM_MAC)
-
-		[_auxGLcontext makeCurrentContext];
-
-		// load / create the texture
-		texture = [self addImage:path];
-
-		glFlush();
-
-		// callback should be executed in cocos2d thread
-		NSThread *thread = [[CCDirector sharedDirector] runningThread];
-		[thread performBlock:block withObject:texture waitUntilDone:NO];
+		dispatch_semaphore_signal(_uploadSemaphore);
 
-		[NSOpenGLContext clearCurrentContext];
-
-#endif // __CC_PLATFORM_MAC
+		[self finishAsyncImage:load texture:texture];
+		[texture release];
 
+		[pool release];
 	});
 }
 
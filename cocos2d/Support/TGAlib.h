@@ -12,6 +12,8 @@
  TGA image support
  */
 
+#include <stdio.h>
+
 enum {
 	TGA_OK,
 	TGA_ERROR_FILE_OPEN,
@@ -46,6 +48,12 @@ void tgaLoadImageData(FILE *file, tImageTGA *info);
 /// this is the function to call when we want to load an image
 tImageTGA * tgaLoad(const char *filename);
 
+/** loads an image from a TGA file already in memory. The RLE expansion, the BGR(A) to RGB(A)
+ swap and the vertical flip are done in a single pass over the pixels.
+ @since v2.0.0
+ */
+tImageTGA * tgaLoadFromMemory(const unsigned char *buffer, size_t length);
+
 // /converts RGB to greyscale
 void tgaRGBtogreyscale(tImageTGA *info);
 
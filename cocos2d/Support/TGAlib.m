@@ -8,218 +8,348 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #import "TGAlib.h"
 
-void tgaLoadRLEImageData(FILE *file, tImageTGA *info);
-void tgaFlipImage( tImageTGA *info );
+#define TGA_HEADER_SIZE 18
 
-// load the image header fields. We only keep those that matter!
-void tgaLoadHeader(FILE *file, tImageTGA *info) {
-	unsigned char cGarbage;
-	short int iGarbage;
+// parses the 18 byte header, returns the offset of the pixels from the start of the file
+static size_t tgaParseHeader(const unsigned char *header, tImageTGA *info)
+{
+	unsigned char idLength = header[0];
+	unsigned char colorMapType = header[1];
+	unsigned short colorMapLength = header[5] | (header[6] << 8);
+	unsigned char colorMapEntrySize = header[7];
 
-	fread(&cGarbage, sizeof(unsigned char), 1, file);
-	fread(&cGarbage, sizeof(unsigned char), 1, file);
+	// type must be 2, 3 or 10
+	info->type = header[2];
 
-	// type must be 2 or 3
-	fread(&info->type, sizeof(unsigned char), 1, file);
+	info->width = (short int)(header[12] | (header[13] << 8));
+	info->height = (short int)(header[14] | (header[15] << 8));
+	info->pixelDepth = header[16];
 
-	fread(&iGarbage, sizeof(short int), 1, file);
-	fread(&iGarbage, sizeof(short int), 1, file);
-	fread(&cGarbage, sizeof(unsigned char), 1, file);
-	fread(&iGarbage, sizeof(short int), 1, file);
-	fread(&iGarbage, sizeof(short int), 1, file);
+	info->flipped = 0;
+	if ( header[17] & 0x20 ) info->flipped = 1;
 
-	fread(&info->width, sizeof(short int), 1, file);
-	fread(&info->height, sizeof(short int), 1, file);
-	fread(&info->pixelDepth, sizeof(unsigned char), 1, file);
+	// the image ID and the color map, if any, come before the pixels
+	size_t offset = TGA_HEADER_SIZE + idLength;
+	if ( colorMapType == 1 )
+		offset += colorMapLength * ((colorMapEntrySize + 7) / 8);
 
-	fread(&cGarbage, sizeof(unsigned char), 1, file);
+	return offset;
+}
 
-	info->flipped = 0;
-	if ( cGarbage & 0x20 ) info->flipped = 1;
+// Copies count pixels of mode bytes. TGA stores RGB(A) as BGR(A), so R and B are
+// swapped for 24 and 32 bit pixels. dst may be the same as src.
+static void tgaCopyPixels(unsigned char *dst, const unsigned char *src, unsigned int count, unsigned int mode)
+{
+	unsigned int i = 0;
+
+	if ( mode == 4 ) {
+#if defined(__ARM_NEON__)
+		for ( ; i + 16 <= count; i += 16 ) {
+			uint8x16x4_t p = vld4q_u8(src + i * 4);
+			uint8x16_t b = p.val[0];
+			p.val[0] = p.val[2];
+			p.val[2] = b;
+			vst4q_u8(dst + i * 4, p);
+		}
+#elif defined(__SSSE3__)
+		const __m128i swap = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		for ( ; i + 4 <= count; i += 4 ) {
+			__m128i p = _mm_loadu_si128((const __m128i*)(src + i * 4));
+			_mm_storeu_si128((__m128i*)(dst + i * 4), _mm_shuffle_epi8(p, swap));
+		}
+#elif defined(__SSE2__)
+		// in each little endian 32 bit lane B is the low byte and R the third one
+		const __m128i ga = _mm_set1_epi32(0xFF00FF00), low = _mm_set1_epi32(0x000000FF);
+		for ( ; i + 4 <= count; i += 4 ) {
+			__m128i p = _mm_loadu_si128((const __m128i*)(src + i * 4));
+			__m128i r = _mm_and_si128(_mm_srli_epi32(p, 16), low);
+			__m128i b = _mm_slli_epi32(_mm_and_si128(p, low), 16);
+			_mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(_mm_and_si128(p, ga), _mm_or_si128(r, b)));
+		}
+#endif
+		src += i * 4;
+		dst += i * 4;
+		for ( ; i < count; i++, src += 4, dst += 4 ) {
+			unsigned char b = src[0];
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = b;
+			dst[3] = src[3];
+		}
+	}
+	else if ( mode == 3 ) {
+#if defined(__ARM_NEON__)
+		for ( ; i + 16 <= count; i += 16 ) {
+			uint8x16x3_t p = vld3q_u8(src + i * 3);
+			uint8x16_t b = p.val[0];
+			p.val[0] = p.val[2];
+			p.val[2] = b;
+			vst3q_u8(dst + i * 3, p);
+		}
+#elif defined(__SSSE3__)
+		// 5 pixels per 16 bytes, the last byte is copied as it is and fixed by the next iteration
+		const __m128i swap = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+		for ( ; i + 6 <= count; i += 5 ) {
+			__m128i p = _mm_loadu_si128((const __m128i*)(src + i * 3));
+			_mm_storeu_si128((__m128i*)(dst + i * 3), _mm_shuffle_epi8(p, swap));
+		}
+#endif
+		src += i * 3;
+		dst += i * 3;
+		for ( ; i < count; i++, src += 3, dst += 3 ) {
+			unsigned char b = src[0];
+			dst[0] = src[2];
+			dst[1] = src[1];
+			dst[2] = b;
+		}
+	}
+	else if ( dst != src )
+		memcpy(dst, src, count * mode);
 }
 
-// loads the image pixels. You shouldn't call this function directly
-void tgaLoadImageData(FILE *file, tImageTGA *info) {
+// fills count pixels with the pixel at dst. Short runs are written a pixel at a time,
+// long ones by doubling the copied block every time
+static void tgaFillPixels(unsigned char *dst, unsigned int count, unsigned int mode)
+{
+	unsigned int i;
+
+	if ( count <= 16 ) {
+		switch ( mode ) {
+			case 4: for ( i = 1; i < count; i++ ) memcpy(dst + i * 4, dst, 4); return;
+			case 3: for ( i = 1; i < count; i++ ) memcpy(dst + i * 3, dst, 3); return;
+			case 2: for ( i = 1; i < count; i++ ) memcpy(dst + i * 2, dst, 2); return;
+			case 1: memset(dst, dst[0], count); return;
+		}
+	}
 
-	int mode,total,i;
-	unsigned char aux;
+	size_t filled = mode, total = (size_t)count * mode;
 
-	// mode equal the number of components for each pixel
-	mode = info->pixelDepth / 8;
-	// total is the number of unsigned chars we'll have to read
-	total = info->height * info->width * mode;
+	while ( filled < total ) {
+		size_t n = filled < total - filled ? filled : total - filled;
+		memcpy(dst + filled, dst, n);
+		filled += n;
+	}
+}
 
-	fread(info->imageData,sizeof(unsigned char),total,file);
+// destination of the y-th row stored in the file. The image is returned bottom up
+static unsigned char * tgaRow(tImageTGA *info, int y)
+{
+	int mode = info->pixelDepth / 8;
 
-	// mode=3 or 4 implies that the image is RGB(A). However TGA
-	// stores it as BGR(A) so we'll have to swap R and B.
-	if (mode >= 3)
-		for (i=0; i < total; i+= mode) {
-			aux = info->imageData[i];
-			info->imageData[i] = info->imageData[i+2];
-			info->imageData[i+2] = aux;
-		}
+	if ( info->flipped )
+		y = info->height - 1 - y;
+
+	return &info->imageData[(size_t)y * info->width * mode];
 }
 
-// loads the RLE encoded image pixels. You shouldn't call this function directly
-void tgaLoadRLEImageData(FILE *file, tImageTGA *info)
+// decodes the uncompressed pixels, returns 0 if the file is truncated
+static int tgaDecodeImageData(tImageTGA *info, const unsigned char *data, size_t length)
 {
-	unsigned int mode,total,i, index = 0;
-	unsigned char aux[4], runlength = 0;
-	unsigned int skip = 0, flag = 0;
+	unsigned int mode = info->pixelDepth / 8;
+	size_t rowbytes = (size_t)info->width * mode;
+	int y;
 
-	// mode equal the number of components for each pixel
-	mode = info->pixelDepth / 8;
-	// total is the number of unsigned chars we'll have to read
-	total = info->height * info->width;
+	if ( length < rowbytes * info->height )
+		return 0;
+
+	for( y = 0; y < info->height; y++ )
+		tgaCopyPixels(tgaRow(info, y), data + y * rowbytes, info->width, mode);
+
+	return 1;
+}
 
-	for( i = 0; i < total; i++ )
+// decodes the RLE encoded pixels, returns 0 if the file is truncated. Packets may span several rows
+static int tgaDecodeRLEImageData(tImageTGA *info, const unsigned char *data, size_t length)
+{
+	const unsigned char *end = data + length;
+	unsigned int mode = info->pixelDepth / 8;
+	unsigned int x = 0;
+	int y = 0;
+	unsigned char *row = tgaRow(info, 0);
+
+	while ( y < info->height )
 	{
-		// if we have a run length pending, run it
-		if ( runlength != 0 )
-		{
-			// we do, update the run length count
-			runlength--;
-			skip = (flag != 0);
-		}
-		else
-		{
-			// otherwise, read in the run length token
-			if ( fread(&runlength,sizeof(unsigned char),1,file) != 1 )
-				return;
-
-			// see if it's a RLE encoded sequence
-			flag = runlength & 0x80;
-			if ( flag ) runlength -= 128;
-			skip = 0;
-		}
+		if ( data >= end )
+			return 0;
+
+		// the run length token: the high bit tells if the packet is a single repeated pixel
+		unsigned char token = *data++;
+		unsigned int count = (token & 0x7f) + 1;
+		int repeated = token & 0x80;
 
-		// do we need to skip reading this pixel?
-		if ( !skip )
+		if ( (size_t)(end - data) < (repeated ? 1 : count) * mode )
+			return 0;
+
+		while ( count && y < info->height )
 		{
-			// no, read in the pixel data
-			if ( fread(aux,sizeof(unsigned char),mode,file) != mode )
-				return;
-
-			// mode=3 or 4 implies that the image is RGB(A). However TGA
-			// stores it as BGR(A) so we'll have to swap R and B.
-			if ( mode >= 3 )
-			{
-				unsigned char tmp;
-
-				tmp = aux[0];
-				aux[0] = aux[2];
-				aux[2] = tmp;
+			unsigned int n = info->width - x;
+			if ( n > count ) n = count;
+
+			if ( repeated ) {
+				tgaCopyPixels(&row[x * mode], data, 1, mode);
+				tgaFillPixels(&row[x * mode], n, mode);
+			} else {
+				tgaCopyPixels(&row[x * mode], data, n, mode);
+				data += n * mode;
+			}
+
+			count -= n;
+			x += n;
+			if ( x == (unsigned int)info->width ) {
+				x = 0;
+				if ( ++y < info->height )
+					row = tgaRow(info, y);
 			}
 		}
 
-		// add the pixel to our image
-		memcpy(&info->imageData[index], aux, mode);
-		index += mode;
+		if ( repeated )
+			data += mode;
 	}
-}
 
-void tgaFlipImage( tImageTGA *info )
-{
-	// mode equal the number of components for each pixel
-	int mode = info->pixelDepth / 8;
-	int rowbytes = info->width*mode;
-	unsigned char *row = (unsigned char *)malloc(rowbytes);
-	int y;
+	return 1;
+}
 
-	if (row == NULL) return;
+// load the image header fields. We only keep those that matter!
+void tgaLoadHeader(FILE *file, tImageTGA *info) {
+	unsigned char header[TGA_HEADER_SIZE];
 
-	for( y = 0; y < (info->height/2); y++ )
-	{
-		memcpy(row, &info->imageData[y*rowbytes],rowbytes);
-		memcpy(&info->imageData[y*rowbytes], &info->imageData[(info->height-(y+1))*rowbytes], rowbytes);
-		memcpy(&info->imageData[(info->height-(y+1))*rowbytes], row, rowbytes);
+	if ( fread(header, 1, TGA_HEADER_SIZE, file) != TGA_HEADER_SIZE ) {
+		memset(header, 0, sizeof(header));
+		info->status = TGA_ERROR_READING_FILE;
 	}
 
-	free(row);
-	info->flipped = 0;
+	// leave the file at the pixels
+	size_t offset = tgaParseHeader(header, info);
+	fseek(file, (long)(offset - TGA_HEADER_SIZE), SEEK_CUR);
 }
 
-// this is the function to call when we want to load an image
-tImageTGA * tgaLoad(const char *filename) {
+// loads the image pixels. You shouldn't call this function directly
+void tgaLoadImageData(FILE *file, tImageTGA *info) {
 
-	FILE *file;
-	tImageTGA *info;
 	int mode,total;
 
+	// mode equal the number of components for each pixel
+	mode = info->pixelDepth / 8;
+	// total is the number of unsigned chars we'll have to read
+	total = info->height * info->width * mode;
+
+	fread(info->imageData,sizeof(unsigned char),total,file);
+
+	// mode=3 or 4 implies that the image is RGB(A). However TGA
+	// stores it as BGR(A) so we'll have to swap R and B.
+	tgaCopyPixels(info->imageData, info->imageData, info->height * info->width, mode);
+}
+
+tImageTGA * tgaLoadFromMemory(const unsigned char *buffer, size_t length) {
+
+	tImageTGA *info;
+	int mode;
+	size_t offset;
+
 	// allocate memory for the info struct and check!
-	info = (tImageTGA *)malloc(sizeof(tImageTGA));
+	info = (tImageTGA *)calloc(1, sizeof(tImageTGA));
 	if (info == NULL)
 		return(NULL);
 
-
-	// open the file for reading (binary mode)
-	file = fopen(filename, "rb");
-	if (file == NULL) {
-		info->status = TGA_ERROR_FILE_OPEN;
-		return(info);
-	}
-
 	// load the header
-	tgaLoadHeader(file,info);
-
-	// check for errors when loading the header
-	if (ferror(file)) {
+	if (length < TGA_HEADER_SIZE) {
 		info->status = TGA_ERROR_READING_FILE;
-		fclose(file);
 		return(info);
 	}
 
+	offset = tgaParseHeader(buffer, info);
+
 	// check if the image is color indexed
 	if (info->type == 1) {
 		info->status = TGA_ERROR_INDEXED_COLOR;
-		fclose(file);
 		return(info);
 	}
 	// check for other types (compressed images)
 	if ((info->type != 2) && (info->type !=3) && (info->type !=10) ) {
 		info->status = TGA_ERROR_COMPRESSED_FILE;
-		fclose(file);
 		return(info);
 	}
 
 	// mode equals the number of image components
 	mode = info->pixelDepth / 8;
-	// total is the number of unsigned chars to read
-	total = info->height * info->width * mode;
+	if (mode < 1 || mode > 4 || info->width <= 0 || info->height <= 0 || offset > length) {
+		info->status = TGA_ERROR_READING_FILE;
+		return(info);
+	}
+
 	// allocate memory for image pixels
-	info->imageData = (unsigned char *)malloc(sizeof(unsigned char) *
-											  total);
+	info->imageData = (unsigned char *)malloc((size_t)info->height * info->width * mode);
 
 	// check to make sure we have the memory required
 	if (info->imageData == NULL) {
 		info->status = TGA_ERROR_MEMORY;
-		fclose(file);
 		return(info);
 	}
-	// finally load the image pixels
+
+	// finally decode the image pixels, already flipped
+	int ok;
 	if ( info->type == 10 )
-		tgaLoadRLEImageData(file, info);
+		ok = tgaDecodeRLEImageData(info, buffer + offset, length - offset);
 	else
-		tgaLoadImageData(file,info);
+		ok = tgaDecodeImageData(info, buffer + offset, length - offset);
 
-	// check for errors when reading the pixels
-	if (ferror(file)) {
+	// check for truncated files, the partly decoded pixels are of no use
+	if (!ok) {
+		free(info->imageData);
+		info->imageData = NULL;
 		info->status = TGA_ERROR_READING_FILE;
-		fclose(file);
 		return(info);
 	}
-	fclose(file);
+
+	info->flipped = 0;
 	info->status = TGA_OK;
 
-	if ( info->flipped )
-	{
-		tgaFlipImage( info );
-		if ( info->flipped ) info->status = TGA_ERROR_MEMORY;
+	return(info);
+}
+
+// this is the function to call when we want to load an image
+tImageTGA * tgaLoad(const char *filename) {
+
+	tImageTGA *info;
+	struct stat st;
+
+	// map the file instead of reading it piece by piece
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		info = (tImageTGA *)calloc(1, sizeof(tImageTGA));
+		if (info)
+			info->status = TGA_ERROR_FILE_OPEN;
+		return(info);
+	}
+
+	void *buffer = MAP_FAILED;
+	size_t length = 0;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		length = (size_t)st.st_size;
+		buffer = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
 	}
+	close(fd);
+
+	if (buffer == MAP_FAILED)
+		return tgaLoadFromMemory(NULL, 0);
+
+	info = tgaLoadFromMemory(buffer, length);
+	munmap(buffer, length);
 
 	return(info);
 }
@@ -27,16 +27,28 @@ extern "C" {
 	struct CCZHeader {
 		uint8_t			sig[4];				// signature. Should be 'CCZ!' 4 bytes
 		uint16_t		compression_type;	// should 0
-		uint16_t		version;			// should be 2 (although version type==1 is also supported)
+		uint16_t		version;			// 1, 2 or 3. Version 3 files are split in chunks, see CCZChunkTable
 		uint32_t		reserved;			// Reserverd for users.
 		uint32_t		len;				// size of the uncompressed file
 	};
 
+	/** @struct CCZChunkTable
+	 In version 3 files the CCZHeader is followed by this table, then by chunk_count
+	 big endian uint32_t with the compressed size of each chunk, then by the chunks.
+	 Every chunk is compressed on its own with the header's compression_type and
+	 inflates to chunk_size bytes, except the last one which holds the remainder.
+	 */
+	struct CCZChunkTable {
+		uint32_t		chunk_size;			// uncompressed size of each chunk
+		uint32_t		chunk_count;		// number of chunks
+	};
+
 	enum {
 		CCZ_COMPRESSION_ZLIB,				// zlib format.
 		CCZ_COMPRESSION_BZIP2,				// bzip2 format (not supported yet)
-		CCZ_COMPRESSION_GZIP,				// gzip format (not supported yet)
-		CCZ_COMPRESSION_NONE,				// plain (not supported yet)
+		CCZ_COMPRESSION_GZIP,				// gzip format.
+		CCZ_COMPRESSION_NONE,				// plain
+		CCZ_COMPRESSION_LZ4,				// LZ4 block format. Bigger than zlib, but inflates several times faster
 	};
 
 /** @file
@@ -60,6 +72,9 @@ int ccInflateMemory(unsigned char *in, unsigned int inLength, unsigned char **ou
  *
  * outLenghtHint is assumed to be the needed room to allocate the inflated buffer.
  *
+ * Memory that starts with a CCZHeader is inflated with ccInflateCCZBuffer() instead,
+ * so any CCZ compression method, like CCZ_COMPRESSION_LZ4, can be used.
+ *
  * @returns the length of the deflated buffer
  *
  @since v1.0.0
@@ -76,6 +91,9 @@ int ccInflateMemoryWithHint(unsigned char *in, unsigned int inLength, unsigned c
 int ccInflateGZipFile(const char *filename, unsigned char **out);
 
 /** inflates a CCZ file into memory
+ *
+ * The file is mapped instead of read, and the chunks of version 3 files are inflated
+ * in parallel straight into the returned buffer.
  *
  * @returns the length of the deflated buffer
  *
@@ -83,6 +101,15 @@ int ccInflateGZipFile(const char *filename, unsigned char **out);
  */
 int ccInflateCCZFile(const char *filename, unsigned char **out);
 
+/** inflates a CCZ file that is already in memory. The inflated memory is
+ * expected to be freed by the caller.
+ *
+ * @returns the length of the deflated buffer, or -1 on error
+ *
+ * @since v2.0.0
+ */
+int ccInflateCCZBuffer(const unsigned char *buffer, unsigned int bufferLen, unsigned char **out);
+
 
 #ifdef __cplusplus
 }
@@ -16,10 +16,17 @@
 
 #import <zlib.h>
 #import <stdlib.h>
+#import <string.h>
 #import <assert.h>
 #import <stdio.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <dispatch/dispatch.h>
 
 #import "ZipUtils.h"
+#import "ccLZ4.h"
 #import "CCFileUtils.h"
 #import "../ccMacros.h"
 
@@ -92,6 +99,12 @@ static int inflateMemoryWithHint(unsigned char *in, unsigned int inLength, unsig
 
 int ccInflateMemoryWithHint(unsigned char *in, unsigned int inLength, unsigned char **out, unsigned int outLengthHint )
 {
+	// CCZ data knows its inflated length and compression method
+	if( inLength >= sizeof(struct CCZHeader) && in[0] == 'C' && in[1] == 'C' && in[2] == 'Z' && in[3] == '!' ) {
+		int len = ccInflateCCZBuffer(in, inLength, out);
+		return len < 0 ? 0 : len;
+	}
+
 	unsigned int outLength = 0;
 	int err = inflateMemoryWithHint(in, inLength, out, &outLength, outLengthHint );
 
@@ -183,40 +196,136 @@ int ccInflateGZipFile(const char *path, unsigned char **out)
 	return offset;
 }
 
-int ccInflateCCZFile(const char *path, unsigned char **out)
+#pragma mark - CCZ
+
+static uint32_t cczReadUInt32(const unsigned char *p)
 {
-	NSCAssert( out, @"ccInflateCCZFile: invalid 'out' parameter");
-	NSCAssert( &*out, @"ccInflateCCZFile: invalid 'out' parameter");
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
 
-	// load file into memory
-	unsigned char *compressed = NULL;
-	NSInteger fileLen  = ccLoadFileIntoMemory( path, &compressed );
-	if( fileLen < 0 ) {
-		CCLOG(@"cocos2d: Error loading CCZ compressed file");
+// Inflates exactly outLength bytes. Every CCZ chunk knows its inflated size, so
+// the output never needs to grow like in inflateMemoryWithHint().
+static BOOL cczInflateChunk(uint16_t compression, const unsigned char *in, uint32_t inLength, unsigned char *out, uint32_t outLength)
+{
+	if( compression == CCZ_COMPRESSION_NONE ) {
+		if( inLength != outLength )
+			return NO;
+
+		memcpy(out, in, outLength);
+		return YES;
+	}
+
+	if( compression == CCZ_COMPRESSION_LZ4 )
+		return ccLZ4Decompress(in, inLength, out, outLength) >= 0;
+
+	z_stream d_stream;
+	d_stream.zalloc = (alloc_func)0;
+	d_stream.zfree = (free_func)0;
+	d_stream.opaque = (voidpf)0;
+
+	d_stream.next_in = (Bytef*)in;
+	d_stream.avail_in = inLength;
+	d_stream.next_out = out;
+	d_stream.avail_out = outLength;
+
+	// 15 + 16 only accepts a gzip wrapper, 15 only a zlib one
+	int windowBits = (compression == CCZ_COMPRESSION_GZIP) ? 15 + 16 : 15;
+	if( inflateInit2(&d_stream, windowBits) != Z_OK )
+		return NO;
+
+	int err = inflate(&d_stream, Z_FINISH);
+	BOOL ok = (err == Z_STREAM_END && d_stream.total_out == outLength);
+
+	inflateEnd(&d_stream);
+	return ok;
+}
+
+// Version 3: the chunks are independent, so they are inflated concurrently, each
+// one straight to its place in the output.
+static BOOL cczInflateChunks(uint16_t compression, const unsigned char *data, size_t dataLen, unsigned char *out, uint32_t len)
+{
+	if( dataLen < sizeof(struct CCZChunkTable) ) {
+		CCLOG(@"cocos2d: CCZ: Truncated chunk table");
+		return NO;
+	}
+
+	uint32_t chunkSize = cczReadUInt32(data);
+	uint32_t chunkCount = cczReadUInt32(data + 4);
+	data += sizeof(struct CCZChunkTable);
+	dataLen -= sizeof(struct CCZChunkTable);
+
+	if( chunkSize == 0 || chunkCount != (uint32_t)(((uint64_t)len + chunkSize - 1) / chunkSize) || dataLen / sizeof(uint32_t) < chunkCount ) {
+		CCLOG(@"cocos2d: CCZ: Invalid chunk table");
+		return NO;
+	}
+
+	const unsigned char *sizes = data;
+	const unsigned char *chunks = data + chunkCount * sizeof(uint32_t);
+	size_t chunksLen = dataLen - chunkCount * sizeof(uint32_t);
+
+	size_t *offsets = malloc( (chunkCount + 1) * sizeof(size_t) );
+	if( ! offsets ) {
+		CCLOG(@"cocos2d: CCZ: out of memory");
+		return NO;
+	}
+
+	offsets[0] = 0;
+	for( uint32_t i=0; i < chunkCount; i++ ) {
+		uint32_t size = cczReadUInt32(sizes + i * sizeof(uint32_t));
+
+		// compare against the remaining bytes, so the sum can't wrap around a 32-bit size_t
+		if( size > chunksLen - offsets[i] ) {
+			CCLOG(@"cocos2d: CCZ: Truncated file");
+			free(offsets);
+			return NO;
+		}
+		offsets[i+1] = offsets[i] + size;
+	}
+
+	__block BOOL failed = NO;
+	dispatch_apply(chunkCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+		uint32_t start = (uint32_t)i * chunkSize;
+		uint32_t outLength = MIN(chunkSize, len - start);
+
+		if( ! cczInflateChunk(compression, chunks + offsets[i], (uint32_t)(offsets[i+1] - offsets[i]), out + start, outLength) )
+			failed = YES;
+	});
+
+	free(offsets);
+	return !failed;
+}
+
+int ccInflateCCZBuffer(const unsigned char *buffer, unsigned int bufferLen, unsigned char **out)
+{
+	NSCAssert( out, @"ccInflateCCZBuffer: invalid 'out' parameter");
+	NSCAssert( &*out, @"ccInflateCCZBuffer: invalid 'out' parameter");
+
+	*out = NULL;
+
+	if( bufferLen < sizeof(struct CCZHeader) ) {
+		CCLOG(@"cocos2d: Invalid CCZ file");
 		return -1;
 	}
 
-	struct CCZHeader *header = (struct CCZHeader*) compressed;
+	struct CCZHeader *header = (struct CCZHeader*) buffer;
 
 	// verify header
 	if( header->sig[0] != 'C' || header->sig[1] != 'C' || header->sig[2] != 'Z' || header->sig[3] != '!' ) {
 		CCLOG(@"cocos2d: Invalid CCZ file");
-		free(compressed);
 		return -1;
 	}
 
 	// verify header version
 	uint16_t version = CFSwapInt16BigToHost( header->version );
-	if( version > 2 ) {
+	if( version > 3 ) {
 		CCLOG(@"cocos2d: Unsupported CCZ header format");
-		free(compressed);
 		return -1;
 	}
 
 	// verify compression format
-	if( CFSwapInt16BigToHost(header->compression_type) != CCZ_COMPRESSION_ZLIB ) {
+	uint16_t compression = CFSwapInt16BigToHost( header->compression_type );
+	if( compression != CCZ_COMPRESSION_ZLIB && compression != CCZ_COMPRESSION_GZIP && compression != CCZ_COMPRESSION_NONE && compression != CCZ_COMPRESSION_LZ4 ) {
 		CCLOG(@"cocos2d: CCZ Unsupported compression method");
-		free(compressed);
 		return -1;
 	}
 
@@ -226,18 +335,19 @@ int ccInflateCCZFile(const char *path, unsigned char **out)
 	if(! *out )
 	{
 		CCLOG(@"cocos2d: CCZ: Failed to allocate memory for texture");
-		free(compressed);
 		return -1;
 	}
 
+	const unsigned char *data = buffer + sizeof(*header);
+	size_t dataLen = bufferLen - sizeof(*header);
 
-	uLongf destlen = len;
-	uLongf source = (uLongf) compressed + sizeof(*header);
-	int ret = uncompress(*out, &destlen, (Bytef*)source, fileLen - sizeof(*header) );
+	BOOL ok;
+	if( version == 3 )
+		ok = cczInflateChunks(compression, data, dataLen, *out, len);
+	else
+		ok = cczInflateChunk(compression, data, (uint32_t)dataLen, *out, len);
 
-	free( compressed );
-
-	if( ret != Z_OK )
+	if( ! ok )
 	{
 		CCLOG(@"cocos2d: CCZ: Failed to uncompress data");
 		free( *out );
@@ -245,6 +355,43 @@ int ccInflateCCZFile(const char *path, unsigned char **out)
 		return -1;
 	}
 
-
 	return len;
 }
+
+int ccInflateCCZFile(const char *path, unsigned char **out)
+{
+	NSCAssert( out, @"ccInflateCCZFile: invalid 'out' parameter");
+	NSCAssert( &*out, @"ccInflateCCZFile: invalid 'out' parameter");
+
+	// map the file instead of loading it, so only the inflated buffer is allocated
+	int fd = open( path, O_RDONLY );
+	if( fd < 0 ) {
+		CCLOG(@"cocos2d: Error loading CCZ compressed file");
+		return -1;
+	}
+
+	struct stat st;
+	if( fstat(fd, &st) != 0 || st.st_size <= 0 || st.st_size > UINT32_MAX ) {
+		CCLOG(@"cocos2d: Error loading CCZ compressed file");
+		close(fd);
+		return -1;
+	}
+
+	size_t fileLen = (size_t)st.st_size;
+	void *compressed = mmap(NULL, fileLen, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if( compressed == MAP_FAILED ) {
+		CCLOG(@"cocos2d: Error mapping CCZ compressed file");
+		return -1;
+	}
+
+	// the chunks are read concurrently, so ask for all of the file up front
+	madvise(compressed, fileLen, MADV_WILLNEED);
+
+	int ret = ccInflateCCZBuffer( compressed, (unsigned int)fileLen, out );
+
+	munmap(compressed, fileLen);
+
+	return ret;
+}
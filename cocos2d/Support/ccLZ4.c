@@ -0,0 +1,237 @@
+/*
+ * cocos2d for iPhone: http://www.cocos2d-iphone.org
+ *
+ */
+
+/*
+ LZ4 block format, as described in https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+
+ Every sequence is a token (4 bits literal length, 4 bits match length - 4), the
+ literals, a 2 byte little endian offset and the extra length bytes. The last
+ sequence only has literals.
+ */
+
+#include <string.h>
+#include <stdint.h>
+
+#include "ccLZ4.h"
+
+#define MIN_MATCH		4
+#define LAST_LITERALS	5		// the last 5 bytes are always literals
+#define MF_LIMIT		12		// no match starts in the last 12 bytes
+#define MAX_OFFSET		65535
+#define HASH_LOG		12
+
+static inline uint32_t read32( const unsigned char *p )
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint32_t hash4( uint32_t sequence )
+{
+	return (sequence * 2654435761u) >> (32 - HASH_LOG);
+}
+
+static inline unsigned char *writeLength( unsigned char *op, unsigned int length )
+{
+	for( ; length >= 255; length -= 255 )
+		*op++ = 255;
+
+	*op++ = (unsigned char)length;
+	return op;
+}
+
+static inline unsigned char *writeSequence( unsigned char *op, const unsigned char *literals, unsigned int literalLength, unsigned int offset, unsigned int matchLength )
+{
+	unsigned char *token = op++;
+	*token = (unsigned char)((literalLength < 15 ? literalLength : 15) << 4);
+	if( literalLength >= 15 )
+		op = writeLength(op, literalLength - 15);
+
+	memcpy(op, literals, literalLength);
+	op += literalLength;
+
+	// the last sequence has no match
+	if( offset ) {
+		*op++ = (unsigned char)offset;
+		*op++ = (unsigned char)(offset >> 8);
+
+		matchLength -= MIN_MATCH;
+		*token |= (unsigned char)(matchLength < 15 ? matchLength : 15);
+		if( matchLength >= 15 )
+			op = writeLength(op, matchLength - 15);
+	}
+
+	return op;
+}
+
+unsigned int ccLZ4CompressBound( unsigned int inLength )
+{
+	return inLength + inLength / 255 + 16;
+}
+
+unsigned int ccLZ4Compress( const unsigned char *in, unsigned int inLength, unsigned char *out, unsigned int outCapacity )
+{
+	// with room for the worst case there is no need to check every write
+	if( outCapacity < ccLZ4CompressBound(inLength) )
+		return 0;
+
+	uint32_t table[1 << HASH_LOG];
+	memset(table, 0, sizeof(table));
+
+	const unsigned char *ip = in, *anchor = in;
+	const unsigned char *iend = in + inLength;
+	unsigned char *op = out;
+
+	if( inLength > MF_LIMIT ) {
+		const unsigned char *mflimit = iend - MF_LIMIT;
+		const unsigned char *matchlimit = iend - LAST_LITERALS;
+		unsigned int misses = 0;
+
+		while( ip <= mflimit ) {
+			uint32_t sequence = read32(ip);
+			uint32_t h = hash4(sequence);
+			const unsigned char *ref = in + table[h];
+			table[h] = (uint32_t)(ip - in);
+
+			if( ref >= ip || ip - ref > MAX_OFFSET || read32(ref) != sequence ) {
+				// skip faster through data that doesn't compress
+				ip += 1 + (misses++ >> 6);
+				continue;
+			}
+
+			while( ip > anchor && ref > in && ip[-1] == ref[-1] ) {
+				ip--;
+				ref--;
+			}
+
+			const unsigned char *end = ip + MIN_MATCH;
+			ref += MIN_MATCH;
+			while( end < matchlimit && *end == *ref ) {
+				end++;
+				ref++;
+			}
+
+			op = writeSequence(op, anchor, (unsigned int)(ip - anchor), (unsigned int)(end - ref), (unsigned int)(end - ip));
+			ip = anchor = end;
+			misses = 0;
+
+			if( ip <= mflimit )
+				table[hash4(read32(ip - 2))] = (uint32_t)(ip - 2 - in);
+		}
+	}
+
+	op = writeSequence(op, anchor, (unsigned int)(iend - anchor), 0, 0);
+	return (unsigned int)(op - out);
+}
+
+static inline int readLength( const unsigned char **ip, const unsigned char *iend, size_t *length )
+{
+	unsigned int s;
+	do {
+		if( *ip >= iend )
+			return 0;
+
+		s = *(*ip)++;
+		*length += s;
+	} while( s == 255 );
+
+	return 1;
+}
+
+int ccLZ4Decompress( const unsigned char *in, unsigned int inLength, unsigned char *out, unsigned int outLength )
+{
+	const unsigned char *ip = in, *iend = in + inLength;
+	unsigned char *op = out, *oend = out + outLength;
+
+	for(;;) {
+		if( ip >= iend )
+			return -1;
+
+		unsigned int token = *ip++;
+
+		// literals
+		size_t length = token >> 4;
+		if( length == 15 && ! readLength(&ip, iend, &length) )
+			return -1;
+
+		if( (size_t)(iend - ip) < length || (size_t)(oend - op) < length )
+			return -1;
+
+		// short runs are copied 16 bytes at once when there is room, the extra bytes get overwritten later
+		if( length <= 16 && iend - ip >= 16 && oend - op >= 16 )
+			memcpy(op, ip, 16);
+		else
+			memcpy(op, ip, length);
+
+		ip += length;
+		op += length;
+
+		if( ip == iend )
+			break;
+
+		// match
+		if( iend - ip < 2 )
+			return -1;
+
+		size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+
+		if( offset == 0 || offset > (size_t)(op - out) )
+			return -1;
+
+		length = token & 15;
+		if( length == 15 && ! readLength(&ip, iend, &length) )
+			return -1;
+
+		length += MIN_MATCH;
+		if( (size_t)(oend - op) < length )
+			return -1;
+
+		const unsigned char *match = op - offset;
+		unsigned char *end = op + length;
+
+		if( offset < length && length >= 64 ) {
+			// long runs of a short pattern, like flat colors. Each copy doubles the pattern
+			// so the copies don't read what they just wrote
+			const unsigned char *pattern = match;
+
+			while( op < end ) {
+				size_t n = (size_t)(op - pattern);
+				if( n > (size_t)(end - op) )
+					n = (size_t)(end - op);
+
+				memcpy(op, pattern, n);
+				op += n;
+			}
+		} else if( (size_t)(oend - end) >= 8 ) {
+			// copies of up to 8 bytes past the end are fine, later sequences overwrite them
+			if( offset < 8 ) {
+				// short offsets repeat a pattern, copy from a multiple of it at least 8 bytes back
+				size_t distance = offset * ((8 + offset - 1) / offset);
+				unsigned char *patternEnd = op + distance - offset;
+
+				while( op < patternEnd )
+					*op++ = *match++;
+
+				match = op - distance;
+			}
+
+			while( op < end ) {
+				memcpy(op, match, 8);
+				op += 8;
+				match += 8;
+			}
+		} else {
+			// overlapping copies repeat the last offset bytes
+			while( op < end )
+				*op++ = *match++;
+		}
+
+		op = end;
+	}
+
+	return (op == oend) ? (int)outLength : -1;
+}
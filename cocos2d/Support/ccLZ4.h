@@ -0,0 +1,46 @@
+/*
+ * cocos2d for iPhone: http://www.cocos2d-iphone.org
+ *
+ */
+
+#ifndef __CC_LZ4_H
+#define __CC_LZ4_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @file ccLZ4.h
+ LZ4 block format codec.
+
+ Decompresses 3-5 times faster than zlib for a somewhat bigger file, which makes it
+ a good fit for assets that are loaded often. Blocks are compatible with the LZ4 block
+ format, so they can also be created with the reference lz4 library.
+ */
+
+/** returns the worst case compressed size of inLength bytes.
+
+ @since v2.0.0
+ */
+unsigned int ccLZ4CompressBound( unsigned int inLength );
+
+/** compresses inLength bytes into out, which must hold ccLZ4CompressBound(inLength) bytes.
+
+ @returns the compressed length, or 0 if out is too small
+ @since v2.0.0
+ */
+unsigned int ccLZ4Compress( const unsigned char *in, unsigned int inLength, unsigned char *out, unsigned int outCapacity );
+
+/** decompresses a block that inflates to exactly outLength bytes. Malformed blocks
+ are rejected without reading or writing out of bounds.
+
+ @returns outLength, or -1 on error
+ @since v2.0.0
+ */
+int ccLZ4Decompress( const unsigned char *in, unsigned int inLength, unsigned char *out, unsigned int outLength );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ! __CC_LZ4_H
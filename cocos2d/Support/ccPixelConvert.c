@@ -0,0 +1,445 @@
+/*
+ * cocos2d for iPhone: http://www.cocos2d-iphone.org
+ *
+ */
+
+/*
+ The scalar conversions are the ones CCTexture2D always used: every channel is truncated
+ to its new size. Dithering adds a threshold from a 4x4 Bayer matrix, scaled to the step
+ of each channel, before truncating, so on average the truncation rounds as much up as down.
+ The GPU expands an n bit channel c to c * 255 / (2^n - 1), so the channel is first scaled
+ by (2^n - 1) / 2^n, v - (v >> n), or the dithered image would get brighter.
+
+ The SIMD kernels give exactly the same results as the scalar code.
+ */
+
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "ccPixelConvert.h"
+
+#if !defined(CC_PIXEL_NO_SIMD) && (defined(__ARM_NEON__) || defined(__ARM_NEON))
+#define CC_PIXEL_NEON 1
+#include <arm_neon.h>
+#elif !defined(CC_PIXEL_NO_SIMD) && defined(__SSE2__)
+#define CC_PIXEL_SSE 1
+#include <emmintrin.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#endif
+
+// images with fewer pixels per thread are not worth splitting
+#define MIN_PIXELS_PER_THREAD	(128 * 1024)
+#define MAX_THREADS				8
+
+static unsigned int threadCount_ = 0;
+
+static const unsigned char bayer4x4[4][4] = {
+	{  0,  8,  2, 10 },
+	{ 12,  4, 14,  6 },
+	{  3, 11,  1,  9 },
+	{ 15,  7, 13,  5 },
+};
+
+// The Bayer values go from 0 to 15, shifting them by 4 minus the bits a channel loses
+// scales them to the step of the channel. 8 turns them off.
+static const unsigned char ditherShift[][4] = {
+	{ 1, 2, 1, 8 },		// RGB565
+	{ 0, 0, 0, 0 },		// RGBA4444
+	{ 1, 1, 1, 8 },		// RGB5A1, alpha is a threshold
+	{ 8, 8, 8, 8 },		// RGB888
+	{ 8, 8, 8, 8 },		// A8
+};
+
+// bits of each channel once converted, 8 for the channels that are not dithered
+static const unsigned char ditherBits[][4] = {
+	{ 5, 6, 5, 8 },
+	{ 4, 4, 4, 4 },
+	{ 5, 5, 5, 8 },
+	{ 8, 8, 8, 8 },
+	{ 8, 8, 8, 8 },
+};
+
+unsigned int ccPixelConvertBitsPerPixel( ccPixelConvertFormat format )
+{
+	switch( format ) {
+		case kCCPixelConvertRGB565:
+		case kCCPixelConvertRGBA4444:
+		case kCCPixelConvertRGB5A1:
+			return 16;
+		case kCCPixelConvertRGB888:
+			return 24;
+		case kCCPixelConvertA8:
+			return 8;
+	}
+
+	return 0;
+}
+
+void ccPixelConvertSetThreadCount( unsigned int count )
+{
+	threadCount_ = count;
+}
+
+// never overflows: v - (v >> n) + offset <= 255 for the offsets of an n bit channel
+static inline unsigned int ditherChannel( unsigned int value, unsigned int bits, unsigned int offset )
+{
+	return value - (value >> bits) + offset;
+}
+
+// the loops CCTexture2D used, one per format so the compiler can vectorize them.
+// size_t indices, so the compiler knows x * 4 doesn't wrap
+static void convertRowTruncate( unsigned char * restrict dst, const unsigned char * restrict src, size_t x, size_t width, ccPixelConvertFormat format )
+{
+	uint16_t *dst16 = (uint16_t*)dst;
+	uint32_t p;
+
+	// one 32 bit load per pixel, the targets are little endian
+	switch( format ) {
+		case kCCPixelConvertRGB565:
+			for( ; x < width; x++ ) {
+				memcpy(&p, src + x * 4, 4);
+				dst16[x] = (uint16_t)((((p >> 0) & 0xFF) >> 3) << 11 | (((p >> 8) & 0xFF) >> 2) << 5 | (((p >> 16) & 0xFF) >> 3));
+			}
+			break;
+		case kCCPixelConvertRGBA4444:
+			for( ; x < width; x++ ) {
+				memcpy(&p, src + x * 4, 4);
+				dst16[x] = (uint16_t)((((p >> 0) & 0xFF) >> 4) << 12 | (((p >> 8) & 0xFF) >> 4) << 8 | (((p >> 16) & 0xFF) >> 4) << 4 | (p >> 28));
+			}
+			break;
+		case kCCPixelConvertRGB5A1:
+			// A can be 1 or 0, transparent pixels are black so they don't leave a ghost image
+			for( ; x < width; x++ ) {
+				memcpy(&p, src + x * 4, 4);
+				dst16[x] = (p >> 31) ? (uint16_t)((((p >> 0) & 0xFF) >> 3) << 11 | (((p >> 8) & 0xFF) >> 3) << 6 | (((p >> 16) & 0xFF) >> 3) << 1 | 1) : 0;
+			}
+			break;
+		case kCCPixelConvertRGB888:
+			for( ; x < width; x++ ) {
+				dst[x * 3 + 0] = src[x * 4 + 0];
+				dst[x * 3 + 1] = src[x * 4 + 1];
+				dst[x * 3 + 2] = src[x * 4 + 2];
+			}
+			break;
+		case kCCPixelConvertA8:
+			for( ; x < width; x++ )
+				dst[x] = src[x * 4 + 3];
+			break;
+	}
+}
+
+// converts the pixels from x to width of a 16 bit format. offsets holds the dither offsets of
+// 4 pixels, 4 channels each, and bits the size of each channel
+static void convertRowDither( unsigned char *dst, const unsigned char *src, size_t x, size_t width, ccPixelConvertFormat format, const unsigned char offsets[16], const unsigned char bits[4] )
+{
+	uint16_t *dst16 = (uint16_t*)dst;
+
+	for( ; x < width; x++ ) {
+		const unsigned char *p = src + x * 4;
+		const unsigned char *o = offsets + (x & 3) * 4;
+		unsigned int r = ditherChannel(p[0], bits[0], o[0]);
+		unsigned int g = ditherChannel(p[1], bits[1], o[1]);
+		unsigned int b = ditherChannel(p[2], bits[2], o[2]);
+		unsigned int a = ditherChannel(p[3], bits[3], o[3]);
+
+		if( format == kCCPixelConvertRGB565 )
+			dst16[x] = (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+		else if( format == kCCPixelConvertRGBA4444 )
+			dst16[x] = (uint16_t)(((r >> 4) << 12) | ((g >> 4) << 8) | ((b >> 4) << 4) | (a >> 4));
+		else
+			dst16[x] = (a >> 7) ? (uint16_t)(((r >> 3) << 11) | ((g >> 3) << 6) | ((b >> 3) << 1) | 1) : 0;
+	}
+}
+
+#if CC_PIXEL_SSE
+
+// RGBA pixels in the 32 bit lanes, R is the low byte
+static inline __m128i pack565( __m128i p )
+{
+	__m128i r = _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF8)), 8);
+	__m128i g = _mm_srli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xFC00)), 5);
+	__m128i b = _mm_srli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF80000)), 19);
+	return _mm_or_si128(r, _mm_or_si128(g, b));
+}
+
+static inline __m128i pack4444( __m128i p )
+{
+	__m128i r = _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF0)), 8);
+	__m128i g = _mm_srli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF000)), 4);
+	__m128i b = _mm_srli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF00000)), 16);
+	__m128i a = _mm_srli_epi32(p, 28);
+	return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+}
+
+static inline __m128i pack5A1( __m128i p )
+{
+	__m128i r = _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF8)), 8);
+	__m128i g = _mm_srli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF800)), 5);
+	__m128i b = _mm_srli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF80000)), 18);
+	__m128i rgba = _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, _mm_set1_epi32(1)));
+
+	// all ones when the top bit of alpha is set
+	return _mm_and_si128(rgba, _mm_srai_epi32(p, 31));
+}
+
+// v - (v >> n) for the n bit channels of a format, see ditherChannel()
+static inline __m128i scaleChannels( __m128i p, ccPixelConvertFormat format )
+{
+	__m128i sub;
+
+	// the 16 bit shifts move bits of the next byte in, the masks remove them
+	if( format == kCCPixelConvertRGB565 )
+		sub = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(p, 5), _mm_set1_epi32(0x00070007)), _mm_and_si128(_mm_srli_epi16(p, 6), _mm_set1_epi32(0x00000300)));
+	else if( format == kCCPixelConvertRGBA4444 )
+		sub = _mm_and_si128(_mm_srli_epi16(p, 4), _mm_set1_epi8(0x0F));
+	else
+		sub = _mm_and_si128(_mm_srli_epi16(p, 5), _mm_set1_epi32(0x00070707));
+
+	return _mm_sub_epi8(p, sub);
+}
+
+// packs the low 16 bits of each lane, _mm_packs_epi32 saturates so they are sign extended first
+static inline __m128i narrow16( __m128i lo, __m128i hi )
+{
+	lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+	hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+	return _mm_packs_epi32(lo, hi);
+}
+
+// returns the number of pixels converted, always a multiple of 4 so the dither pattern stays in phase
+static unsigned int convertRowSSE( unsigned char *dst, const unsigned char *src, unsigned int width, ccPixelConvertFormat format, const unsigned char offsets[16], int dither )
+{
+	const __m128i o = _mm_loadu_si128((const __m128i*)offsets);
+	unsigned int x = 0;
+
+	switch( format ) {
+		case kCCPixelConvertRGB565:
+		case kCCPixelConvertRGBA4444:
+		case kCCPixelConvertRGB5A1:
+			for( ; x + 8 <= width; x += 8 ) {
+				__m128i p0 = _mm_loadu_si128((const __m128i*)(src + x * 4));
+				__m128i p1 = _mm_loadu_si128((const __m128i*)(src + x * 4 + 16));
+
+				if( dither ) {
+					p0 = _mm_add_epi8(scaleChannels(p0, format), o);
+					p1 = _mm_add_epi8(scaleChannels(p1, format), o);
+				}
+
+				__m128i out;
+				if( format == kCCPixelConvertRGB565 )
+					out = narrow16(pack565(p0), pack565(p1));
+				else if( format == kCCPixelConvertRGBA4444 )
+					out = narrow16(pack4444(p0), pack4444(p1));
+				else
+					out = narrow16(pack5A1(p0), pack5A1(p1));
+
+				_mm_storeu_si128((__m128i*)(dst + x * 2), out);
+			}
+			break;
+
+		case kCCPixelConvertA8:
+			for( ; x + 16 <= width; x += 16 ) {
+				__m128i a0 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(src + x * 4)), 24);
+				__m128i a1 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(src + x * 4 + 16)), 24);
+				__m128i a2 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(src + x * 4 + 32)), 24);
+				__m128i a3 = _mm_srli_epi32(_mm_loadu_si128((const __m128i*)(src + x * 4 + 48)), 24);
+				_mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3)));
+			}
+			break;
+
+		case kCCPixelConvertRGB888:
+#if defined(__SSSE3__)
+			{
+				// 12 bytes per 4 pixels, the other 4 are overwritten by the next iteration
+				const __m128i drop = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+				for( ; x * 3 + 16 <= width * 3; x += 4 ) {
+					__m128i p = _mm_loadu_si128((const __m128i*)(src + x * 4));
+					_mm_storeu_si128((__m128i*)(dst + x * 3), _mm_shuffle_epi8(p, drop));
+				}
+			}
+#endif
+			break;
+	}
+
+	return x;
+}
+
+#endif // CC_PIXEL_SSE
+
+#if CC_PIXEL_NEON
+
+// the 8 bit channels moved to the top of 16 bit lanes, VSRI inserts each one below the previous
+#define WIDEN(v, half) vshll_n_u8(vget_##half##_u8(v), 8)
+
+// see ditherChannel()
+#define DITHER(v, bits, o) vaddq_u8(vsubq_u8(v, vshrq_n_u8(v, bits)), o)
+
+static unsigned int convertRowNEON( unsigned char *dst, const unsigned char *src, unsigned int width, ccPixelConvertFormat format, const unsigned char offsets[16], int dither )
+{
+	uint8x16_t o[4];
+	unsigned int x = 0;
+	int c, i;
+
+	// per channel offsets of 16 pixels
+	for( c = 0; c < 4; c++ ) {
+		unsigned char channel[16];
+		for( i = 0; i < 16; i++ )
+			channel[i] = offsets[(i & 3) * 4 + c];
+		o[c] = vld1q_u8(channel);
+	}
+
+	for( ; x + 16 <= width; x += 16 ) {
+		uint8x16x4_t p = vld4q_u8(src + x * 4);
+
+		uint8x16_t r = p.val[0], g = p.val[1], b = p.val[2], a = p.val[3];
+		uint16x8_t lo, hi;
+
+		if( dither && format == kCCPixelConvertRGB565 ) {
+			r = DITHER(r, 5, o[0]); g = DITHER(g, 6, o[1]); b = DITHER(b, 5, o[2]);
+		}
+		else if( dither && format == kCCPixelConvertRGBA4444 ) {
+			r = DITHER(r, 4, o[0]); g = DITHER(g, 4, o[1]); b = DITHER(b, 4, o[2]); a = DITHER(a, 4, o[3]);
+		}
+		else if( dither && format == kCCPixelConvertRGB5A1 ) {
+			r = DITHER(r, 5, o[0]); g = DITHER(g, 5, o[1]); b = DITHER(b, 5, o[2]);
+		}
+
+		switch( format ) {
+			case kCCPixelConvertRGB565:
+				lo = vsriq_n_u16(vsriq_n_u16(WIDEN(r, low), WIDEN(g, low), 5), WIDEN(b, low), 11);
+				hi = vsriq_n_u16(vsriq_n_u16(WIDEN(r, high), WIDEN(g, high), 5), WIDEN(b, high), 11);
+				vst1q_u16((uint16_t*)dst + x, lo);
+				vst1q_u16((uint16_t*)dst + x + 8, hi);
+				break;
+
+			case kCCPixelConvertRGBA4444:
+				lo = vsriq_n_u16(vsriq_n_u16(vsriq_n_u16(WIDEN(r, low), WIDEN(g, low), 4), WIDEN(b, low), 8), WIDEN(a, low), 12);
+				hi = vsriq_n_u16(vsriq_n_u16(vsriq_n_u16(WIDEN(r, high), WIDEN(g, high), 4), WIDEN(b, high), 8), WIDEN(a, high), 12);
+				vst1q_u16((uint16_t*)dst + x, lo);
+				vst1q_u16((uint16_t*)dst + x + 8, hi);
+				break;
+
+			case kCCPixelConvertRGB5A1:
+				lo = vsriq_n_u16(vsriq_n_u16(vsriq_n_u16(WIDEN(r, low), WIDEN(g, low), 5), WIDEN(b, low), 10), WIDEN(a, low), 15);
+				hi = vsriq_n_u16(vsriq_n_u16(vsriq_n_u16(WIDEN(r, high), WIDEN(g, high), 5), WIDEN(b, high), 10), WIDEN(a, high), 15);
+
+				// transparent pixels become 0
+				lo = vandq_u16(lo, vreinterpretq_u16_s16(vshrq_n_s16(vreinterpretq_s16_u16(WIDEN(a, low)), 15)));
+				hi = vandq_u16(hi, vreinterpretq_u16_s16(vshrq_n_s16(vreinterpretq_s16_u16(WIDEN(a, high)), 15)));
+				vst1q_u16((uint16_t*)dst + x, lo);
+				vst1q_u16((uint16_t*)dst + x + 8, hi);
+				break;
+
+			case kCCPixelConvertRGB888:
+			{
+				uint8x16x3_t rgb = { { r, g, b } };
+				vst3q_u8(dst + x * 3, rgb);
+				break;
+			}
+
+			case kCCPixelConvertA8:
+				vst1q_u8(dst + x, a);
+				break;
+		}
+	}
+
+	return x;
+}
+
+#endif // CC_PIXEL_NEON
+
+void ccPixelConvertRows( void *dst, size_t dstStride, const void *src, size_t srcStride, unsigned int width, unsigned int firstRow, unsigned int rows, ccPixelConvertFormat format, unsigned int options )
+{
+	int dither = (options & kCCPixelConvertDither) && ccPixelConvertBitsPerPixel(format) == 16;
+	unsigned int y, x, c;
+
+	for( y = firstRow; y < firstRow + rows; y++ ) {
+		unsigned char offsets[16];
+		const unsigned char *in = (const unsigned char*)src + (size_t)(y - firstRow) * srcStride;
+		unsigned char *out = (unsigned char*)dst + (size_t)(y - firstRow) * dstStride;
+
+		for( x = 0; x < 4; x++ )
+			for( c = 0; c < 4; c++ )
+				offsets[x * 4 + c] = dither ? (unsigned char)(bayer4x4[y & 3][x] >> ditherShift[format][c]) : 0;
+
+#if CC_PIXEL_SSE
+		x = convertRowSSE(out, in, width, format, offsets, dither);
+#elif CC_PIXEL_NEON
+		x = convertRowNEON(out, in, width, format, offsets, dither);
+#else
+		x = 0;
+#endif
+
+		if( dither )
+			convertRowDither(out, in, x, width, format, offsets, ditherBits[format]);
+		else
+			convertRowTruncate(out, in, x, width, format);
+	}
+}
+
+typedef struct {
+	unsigned char			*dst;
+	const unsigned char		*src;
+	unsigned int			width, firstRow, rows;
+	ccPixelConvertFormat	format;
+	unsigned int			options;
+} ConvertBand;
+
+static void *convertBand( void *arg )
+{
+	ConvertBand *band = (ConvertBand*)arg;
+	size_t dstStride = (size_t)band->width * ccPixelConvertBitsPerPixel(band->format) / 8;
+
+	ccPixelConvertRows(band->dst, dstStride, band->src, (size_t)band->width * 4, band->width, band->firstRow, band->rows, band->format, band->options);
+	return NULL;
+}
+
+static unsigned int threadsForImage( unsigned int width, unsigned int height )
+{
+	unsigned int threads = threadCount_;
+	if( threads == 0 ) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = cpus > 0 ? (unsigned int)cpus : 1;
+	}
+
+	size_t byPixels = (size_t)width * height / MIN_PIXELS_PER_THREAD;
+	if( threads > byPixels ) threads = (unsigned int)byPixels;
+	if( threads > height ) threads = height;
+	if( threads > MAX_THREADS ) threads = MAX_THREADS;
+
+	return threads ? threads : 1;
+}
+
+void ccPixelConvert( void *dst, const void *src, unsigned int width, unsigned int height, ccPixelConvertFormat format, unsigned int options )
+{
+	size_t dstStride = (size_t)width * ccPixelConvertBitsPerPixel(format) / 8;
+	size_t srcStride = (size_t)width * 4;
+	unsigned int threads = threadsForImage(width, height);
+
+	ConvertBand bands[MAX_THREADS];
+	pthread_t ids[MAX_THREADS];
+	unsigned int i, started = 0;
+
+	// the calling thread converts the first band
+	for( i = 0; i < threads; i++ ) {
+		unsigned int firstRow = (unsigned int)((uint64_t)height * i / threads);
+		unsigned int lastRow = (unsigned int)((uint64_t)height * (i + 1) / threads);
+
+		ConvertBand band = { (unsigned char*)dst + firstRow * dstStride, (const unsigned char*)src + firstRow * srcStride, width, firstRow, lastRow - firstRow, format, options };
+		bands[i] = band;
+
+		if( i > 0 && pthread_create(&ids[started], NULL, convertBand, &bands[i]) == 0 )
+			started++;
+		else if( i > 0 )
+			convertBand(&bands[i]);
+	}
+
+	convertBand(&bands[0]);
+
+	for( i = 0; i < started; i++ )
+		pthread_join(ids[i], NULL);
+}
@@ -0,0 +1,77 @@
+/*
+ * cocos2d for iPhone: http://www.cocos2d-iphone.org
+ *
+ */
+
+#ifndef __CC_PIXEL_CONVERT_H
+#define __CC_PIXEL_CONVERT_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @file ccPixelConvert.h
+ Converts RGBA8888 pixels into the smaller texture formats.
+
+ The input has the bytes R, G, B and A in this order, like the bitmaps CCTexture2D draws
+ its images into. 16 bit pixels are written in the native byte order, as OpenGL expects them.
+
+ NEON or SSE2 kernels are used when the target supports them, unless CC_PIXEL_NO_SIMD is
+ defined. Big images are split in bands of rows that are converted by several threads.
+ */
+
+/** @typedef ccPixelConvertFormat
+ Destination pixel formats
+ */
+typedef enum {
+	//! 16-bit: RRRRRGGGGGGBBBBB
+	kCCPixelConvertRGB565,
+	//! 16-bit: RRRRGGGGBBBBAAAA
+	kCCPixelConvertRGBA4444,
+	//! 16-bit: RRRRRGGGGGBBBBBA. Pixels with alpha < 128 become 0, like in CCTexture2D
+	kCCPixelConvertRGB5A1,
+	//! 24-bit: RRRRRRRRGGGGGGGGBBBBBBBB
+	kCCPixelConvertRGB888,
+	//! 8-bit: AAAAAAAA
+	kCCPixelConvertA8,
+} ccPixelConvertFormat;
+
+/** conversion options */
+enum {
+	/** Ordered (4x4 Bayer) dithering for the 16 bit formats. It removes most of the banding of
+	 gradients. The same threshold is used for every channel of a pixel, so premultiplied colors
+	 never get bigger than their alpha. */
+	kCCPixelConvertDither = 1 << 0,
+};
+
+/** returns the bits per pixel of a destination format.
+ @since v2.0.0
+ */
+unsigned int ccPixelConvertBitsPerPixel( ccPixelConvertFormat format );
+
+/** converts width x height tightly packed RGBA8888 pixels from src into dst, which must not
+ overlap src. Big images are converted by several threads, see ccPixelConvertSetThreadCount().
+ @since v2.0.0
+ */
+void ccPixelConvert( void *dst, const void *src, unsigned int width, unsigned int height, ccPixelConvertFormat format, unsigned int options );
+
+/** converts rows rows of width pixels in the calling thread. The strides are the distances in
+ bytes between rows. firstRow is the row of the image src starts at, it sets the phase of the
+ dithering pattern, so an image converted in bands looks the same as one converted at once.
+ @since v2.0.0
+ */
+void ccPixelConvertRows( void *dst, size_t dstStride, const void *src, size_t srcStride, unsigned int width, unsigned int firstRow, unsigned int rows, ccPixelConvertFormat format, unsigned int options );
+
+/** sets the maximum number of threads ccPixelConvert() uses. 0, the default, uses one per CPU
+ and 1 converts everything in the calling thread.
+ @since v2.0.0
+ */
+void ccPixelConvertSetThreadCount( unsigned int count );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ! __CC_PIXEL_CONVERT_H
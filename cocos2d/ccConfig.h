@@ -184,6 +184,30 @@
 #define CC_TEXTURE_ATLAS_USE_VAO 1
 #endif
 
+/** @def CC_TEXTURE_CACHE_ASYNC_DECODERS
+ Maximum number of images CCTextureCache decodes at the same time when they are loaded asynchronously.
+ Each decoder keeps one decoded image in memory.
+
+ 0 uses one decoder per CPU. Default value: 0.
+
+ @since v2.0.0
+ */
+#ifndef CC_TEXTURE_CACHE_ASYNC_DECODERS
+#define CC_TEXTURE_CACHE_ASYNC_DECODERS 0
+#endif
+
+/** @def CC_TEXTURE_CACHE_ASYNC_UPLOADS
+ Maximum number of decoded images waiting to be uploaded to OpenGL when they are loaded asynchronously.
+ When it is reached, the decoders wait, so it bounds the memory used by the decoded images.
+
+ Default value: 4.
+
+ @since v2.0.0
+ */
+#ifndef CC_TEXTURE_CACHE_ASYNC_UPLOADS
+#define CC_TEXTURE_CACHE_ASYNC_UPLOADS 4
+#endif
+
 
 /** @def CC_USE_LA88_LABELS
  If enabled, it will use LA88 (Luminance Alpha 16-bit textures) for CCLabelTTF objects.
@@ -0,0 +1,661 @@
+/* Copyright (c) 2012 Scott Lembcke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+	Headless benchmark.
+
+	Runs a set of standard scenes with each spatial index and reports the time per frame
+	along with the number of allocations Chipmunk made while stepping.
+	Results can be written to a file and compared against a run of another build to measure the speedup.
+
+	Usage: chipmunk_benchmark [--scene name] [--index hash|bbtree|sweep] [--steps n] [--quick]
+	                          [--write results.txt | --compare results.txt]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "benchmark_alloc.h"
+#include "chipmunk.h"
+
+//MARK: Allocation Counting
+
+// Each allocation is prefixed with its size so frees and reallocs can be counted too.
+typedef union AllocHeader {
+	size_t size;
+	// Keep the memory handed to Chipmunk aligned for any type.
+	long double alignment;
+} AllocHeader;
+
+typedef struct AllocStats {
+	// Number of calls to cpcalloc() and cprealloc().
+	unsigned long allocs;
+	unsigned long frees;
+	// Bytes requested and currently live.
+	size_t bytes, liveBytes, peakBytes;
+} AllocStats;
+
+static AllocStats allocStats;
+
+static void
+CountAlloc(size_t size)
+{
+	allocStats.allocs++;
+	allocStats.bytes += size;
+	allocStats.liveBytes += size;
+	if(allocStats.liveBytes > allocStats.peakBytes) allocStats.peakBytes = allocStats.liveBytes;
+}
+
+void *
+cpBenchmarkCalloc(size_t count, size_t size)
+{
+	AllocHeader *header = (AllocHeader *)calloc(1, sizeof(AllocHeader) + count*size);
+	if(!header) return NULL;
+	
+	header->size = count*size;
+	CountAlloc(count*size);
+	
+	return header + 1;
+}
+
+void *
+cpBenchmarkRealloc(void *ptr, size_t size)
+{
+	AllocHeader *header = (ptr ? (AllocHeader *)ptr - 1 : NULL);
+	size_t oldSize = (header ? header->size : 0);
+	
+	header = (AllocHeader *)realloc(header, sizeof(AllocHeader) + size);
+	if(!header) return NULL;
+	
+	header->size = size;
+	allocStats.liveBytes -= oldSize;
+	CountAlloc(size);
+	
+	return header + 1;
+}
+
+void
+cpBenchmarkFree(void *ptr)
+{
+	if(ptr){
+		AllocHeader *header = (AllocHeader *)ptr - 1;
+		allocStats.frees++;
+		allocStats.liveBytes -= header->size;
+		free(header);
+	}
+}
+
+//MARK: Timing
+
+static double
+Seconds(void)
+{
+	return (double)clock()/(double)CLOCKS_PER_SEC;
+}
+
+//MARK: Scenes
+
+typedef enum IndexType {
+	INDEX_HASH,
+	INDEX_BBTREE,
+	INDEX_SWEEP,
+	NUM_INDEXES
+} IndexType;
+
+static const char *indexNames[] = {"hash", "bbtree", "sweep"};
+
+typedef struct Scene Scene;
+
+typedef struct SceneResult {
+	double msPerFrame;
+	// Allocations made while stepping, setup and teardown aren't counted.
+	unsigned long allocs;
+	size_t allocBytes;
+	// Largest amount of memory Chipmunk had allocated at once.
+	size_t peakBytes;
+} SceneResult;
+
+struct Scene {
+	const char *name;
+	// Create the scene's objects. Returns a typical shape size to use as the spatial hash cell size.
+	cpFloat (*init)(cpSpace *space);
+	// Optional work done every frame after stepping, like queries.
+	void (*frame)(cpSpace *space, int frame);
+	int steps;
+};
+
+// Simple LCG so the scenes are the same on every platform.
+static unsigned int randSeed;
+
+static cpFloat
+Rand01(void)
+{
+	randSeed = randSeed*1664525u + 1013904223u;
+	return (cpFloat)(randSeed >> 8)/(cpFloat)(1u << 24);
+}
+
+static void
+AddWalls(cpSpace *space, cpFloat width, cpFloat height)
+{
+	cpBody *staticBody = cpSpaceGetStaticBody(space);
+	cpVect verts[] = {cpv(-width, height), cpv(-width, 0), cpv(width, 0), cpv(width, height)};
+	
+	for(int i=0; i<3; i++){
+		cpShape *shape = cpSpaceAddShape(space, cpSegmentShapeNew(staticBody, verts[i], verts[i + 1], 0.0f));
+		cpShapeSetFriction(shape, 1.0f);
+	}
+}
+
+static cpBody *
+AddBox(cpSpace *space, cpVect pos, cpFloat size)
+{
+	cpBody *body = cpSpaceAddBody(space, cpBodyNew(1.0f, cpMomentForBox(1.0f, size, size)));
+	cpBodySetPos(body, pos);
+	
+	cpShape *shape = cpSpaceAddShape(space, cpBoxShapeNew(body, size, size));
+	cpShapeSetFriction(shape, 0.7f);
+	
+	return body;
+}
+
+// Four pyramids of 20 rows of boxes.
+static cpFloat
+InitPyramids(cpSpace *space)
+{
+	cpSpaceSetIterations(space, 20);
+	AddWalls(space, 1000.0f, 1000.0f);
+	
+	for(int p=0; p<4; p++){
+		for(int row=0; row<20; row++){
+			for(int i=0; i<20 - row; i++){
+				cpVect pos = cpv(-720.0f + p*480.0f + (i - (20 - row)*0.5f)*20.0f, (row + 0.5f)*20.0f);
+				AddBox(space, pos, 20.0f);
+			}
+		}
+	}
+	
+	return 20.0f;
+}
+
+// 10,000 circles dropped into a container.
+static cpFloat
+InitCircles(cpSpace *space)
+{
+	AddWalls(space, 460.0f, 2000.0f);
+	
+	for(int i=0; i<10000; i++){
+		cpFloat radius = 3.0f + Rand01()*2.0f;
+		cpVect pos = cpv(-450.0f + (i%100)*9.0f + Rand01(), 10.0f + (i/100)*11.0f);
+	
+		cpBody *body = cpSpaceAddBody(space, cpBodyNew(1.0f, cpMomentForCircle(1.0f, 0.0f, radius, cpvzero)));
+		cpBodySetPos(body, pos);
+	
+		cpShape *shape = cpSpaceAddShape(space, cpCircleShapeNew(body, radius, cpvzero));
+		cpShapeSetFriction(shape, 0.5f);
+	}
+	
+	return 8.0f;
+}
+
+// 40 chains of 40 links connected by pivot joints and rotary limits, swinging into each other.
+static cpFloat
+InitChains(cpSpace *space)
+{
+	cpBody *staticBody = cpSpaceGetStaticBody(space);
+	
+	for(int c=0; c<40; c++){
+		cpBody *prev = staticBody;
+		cpVect anchor = cpv(-800.0f + c*40.0f, 1000.0f);
+	
+		for(int i=0; i<40; i++){
+			cpVect pos = cpvadd(anchor, cpv(10.0f, 0.0f));
+			cpBody *body = cpSpaceAddBody(space, cpBodyNew(1.0f, cpMomentForSegment(1.0f, cpv(-10, 0), cpv(10, 0))));
+			cpBodySetPos(body, pos);
+	
+			cpShape *shape = cpSpaceAddShape(space, cpSegmentShapeNew(body, cpv(-10, 0), cpv(10, 0), 2.0f));
+			cpShapeSetGroup(shape, c + 1);
+	
+			cpSpaceAddConstraint(space, cpPivotJointNew(prev, body, anchor));
+			if(prev != staticBody) cpSpaceAddConstraint(space, cpRotaryLimitJointNew(prev, body, -0.5f, 0.5f));
+	
+			prev = body;
+			anchor = cpvadd(pos, cpv(10.0f, 0.0f));
+		}
+	}
+	
+	return 20.0f;
+}
+
+// 2000 boxes in separate stacks that fall asleep.
+static cpFloat
+InitSleeping(cpSpace *space)
+{
+	cpSpaceSetSleepTimeThreshold(space, 0.5f);
+	AddWalls(space, 1100.0f, 1000.0f);
+	
+	for(int i=0; i<2000; i++){
+		cpVect pos = cpv(-1000.0f + (i%100)*20.0f, 10.0f + (i/100)*21.0f);
+		AddBox(space, pos, 18.0f);
+	}
+	
+	return 20.0f;
+}
+
+// 2000 boxes resting in stacks that are rolled back to the same snapshot every frame, like a networked game resimulating.
+// After the boxes settle each frame costs one snapshot restore and one step.
+#define ROLLBACK_SETTLE_FRAMES 120
+
+static cpFloat
+InitRollback(cpSpace *space)
+{
+	cpSpaceSetDeterministic(space, cpTrue);
+	AddWalls(space, 1100.0f, 1000.0f);
+	
+	for(int i=0; i<2000; i++){
+		cpVect pos = cpv(-1000.0f + (i%100)*20.0f, 10.0f + (i/100)*21.0f);
+		AddBox(space, pos, 18.0f);
+	}
+	
+	return 20.0f;
+}
+
+static void
+FrameRollback(cpSpace *space, int frame)
+{
+	static void *snapshot = NULL;
+	static size_t snapshotSize = 0;
+	
+	if(frame == ROLLBACK_SETTLE_FRAMES){
+		snapshotSize = cpSpaceSaveSnapshot(space, NULL, 0);
+		snapshot = realloc(snapshot, snapshotSize);
+		cpSpaceSaveSnapshot(space, snapshot, snapshotSize);
+	} else if(frame > ROLLBACK_SETTLE_FRAMES){
+		cpSpaceRestoreSnapshot(space, snapshot, snapshotSize);
+	}
+}
+
+// Static boxes with circles bouncing between them and lots of segment and nearest point queries each frame.
+static cpFloat
+InitRaycasts(cpSpace *space)
+{
+	cpSpaceSetGravity(space, cpvzero);
+	cpBody *staticBody = cpSpaceGetStaticBody(space);
+	
+	for(int i=0; i<2000; i++){
+		cpVect center = cpv((Rand01() - 0.5f)*2000.0f, (Rand01() - 0.5f)*2000.0f);
+		cpVect rot = cpvforangle(Rand01()*6.0f);
+		cpVect corners[] = {cpv(-5, -5), cpv(-5, 5), cpv(5, 5), cpv(5, -5)};
+	
+		cpVect verts[4];
+		for(int j=0; j<4; j++) verts[j] = cpvadd(center, cpvrotate(corners[j], rot));
+		cpSpaceAddShape(space, cpPolyShapeNew(staticBody, 4, verts, cpvzero));
+	}
+	
+	for(int i=0; i<500; i++){
+		cpBody *body = cpSpaceAddBody(space, cpBodyNew(1.0f, cpMomentForCircle(1.0f, 0.0f, 5.0f, cpvzero)));
+		cpBodySetPos(body, cpv((Rand01() - 0.5f)*2000.0f, (Rand01() - 0.5f)*2000.0f));
+		cpBodySetVel(body, cpv((Rand01() - 0.5f)*200.0f, (Rand01() - 0.5f)*200.0f));
+	
+		cpShape *shape = cpSpaceAddShape(space, cpCircleShapeNew(body, 5.0f, cpvzero));
+		cpShapeSetElasticity(shape, 1.0f);
+	}
+	
+	return 10.0f;
+}
+
+static void
+FrameRaycasts(cpSpace *space, int frame)
+{
+	for(int i=0; i<500; i++){
+		cpFloat angle = (i + frame*0.01f)*0.0126f;
+		cpVect start = cpvmult(cpvforangle(angle), 1200.0f);
+		cpVect end = cpvmult(cpvforangle(angle + 2.0f), 1200.0f);
+	
+		cpSegmentQueryInfo info;
+		cpSpaceSegmentQueryFirst(space, start, end, CP_ALL_LAYERS, CP_NO_GROUP, &info);
+	}
+	
+	for(int i=0; i<500; i++){
+		cpVect point = cpv(((i*37)%1000 - 500)*2.0f, ((i*53 + frame)%1000 - 500)*2.0f);
+		cpNearestPointQueryInfo info;
+		cpSpaceNearestPointQueryNearest(space, point, 50.0f, CP_ALL_LAYERS, CP_NO_GROUP, &info);
+	}
+}
+
+// A grid of point, nearest point and short segment queries, like a game might run for particles or a hover grid.
+// The same queries are run one at a time and as batches to compare the two.
+#define QUERY_GRID 48
+#define QUERY_COUNT (QUERY_GRID*QUERY_GRID)
+
+static void
+FrameQueryGrid(cpSpace *space, int frame, cpBool batch)
+{
+	static cpVect points[QUERY_COUNT], ends[QUERY_COUNT];
+	static cpShape *shapes[QUERY_COUNT];
+	static cpNearestPointQueryInfo nearest[QUERY_COUNT];
+	static cpSegmentQueryInfo segments[QUERY_COUNT];
+	
+	cpFloat spacing = 2000.0f/QUERY_GRID;
+	for(int y=0; y<QUERY_GRID; y++){
+		for(int x=0; x<QUERY_GRID; x++){
+			int i = y*QUERY_GRID + x;
+			points[i] = cpv(-1000.0f + (x + 0.5f)*spacing + frame%10, -1000.0f + (y + 0.5f)*spacing);
+			ends[i] = cpvadd(points[i], cpv(30.0f, 20.0f));
+		}
+	}
+	
+	if(batch){
+		cpSpacePointQueryFirstBatch(space, QUERY_COUNT, points, CP_ALL_LAYERS, CP_NO_GROUP, shapes);
+		cpSpaceNearestPointQueryNearestBatch(space, QUERY_COUNT, points, 20.0f, CP_ALL_LAYERS, CP_NO_GROUP, nearest);
+		cpSpaceSegmentQueryFirstBatch(space, QUERY_COUNT, points, ends, CP_ALL_LAYERS, CP_NO_GROUP, segments);
+	} else {
+		for(int i=0; i<QUERY_COUNT; i++) shapes[i] = cpSpacePointQueryFirst(space, points[i], CP_ALL_LAYERS, CP_NO_GROUP);
+		for(int i=0; i<QUERY_COUNT; i++) cpSpaceNearestPointQueryNearest(space, points[i], 20.0f, CP_ALL_LAYERS, CP_NO_GROUP, nearest + i);
+		for(int i=0; i<QUERY_COUNT; i++) cpSpaceSegmentQueryFirst(space, points[i], ends[i], CP_ALL_LAYERS, CP_NO_GROUP, segments + i);
+	}
+}
+
+static void FrameQueries(cpSpace *space, int frame){FrameQueryGrid(space, frame, cpFalse);}
+static void FrameBatchQueries(cpSpace *space, int frame){FrameQueryGrid(space, frame, cpTrue);}
+
+// A tile map style level made of 30,000 static segments with 1000 boxes and circles dropped onto it.
+// The baked version puts the whole level into a single cpStaticGeometry shape.
+static cpFloat
+InitTileMapLevel(cpSpace *space, cpBool baked)
+{
+	cpBody *staticBody = cpSpaceGetStaticBody(space);
+	cpShape *geometry = (baked ? cpStaticGeometryNew(staticBody) : NULL);
+	
+	// Height of each flat tile, used to drop the bodies just above the ground.
+	static cpFloat heights[15000];
+	
+	cpVect a = cpv(-240000.0f, 0.0f);
+	for(int i=0; i<30000; i++){
+		// Alternate between steps of up to two tiles and flat tiles.
+		cpVect b = (i&1 ? cpvadd(a, cpv(16.0f, 0.0f)) : cpvadd(a, cpv(0.0f, ((int)(Rand01()*5.0f) - 2)*16.0f)));
+		if(i&1) heights[i/2] = a.y;
+		
+		if(baked){
+			cpStaticGeometryAddSegment(geometry, a, b, 0.0f);
+		} else {
+			cpShape *shape = cpSpaceAddShape(space, cpSegmentShapeNew(staticBody, a, b, 0.0f));
+			cpShapeSetFriction(shape, 1.0f);
+		}
+		
+		a = b;
+	}
+	
+	if(baked){
+		cpShapeSetFriction(geometry, 1.0f);
+		cpSpaceAddShape(space, geometry);
+	}
+	
+	for(int i=0; i<1000; i++){
+		int tile = i*15 + 7;
+		cpVect pos = cpv(-240000.0f + tile*16.0f + 8.0f, heights[tile] + 40.0f);
+		
+		if(i&1){
+			AddBox(space, pos, 12.0f);
+		} else {
+			cpBody *body = cpSpaceAddBody(space, cpBodyNew(1.0f, cpMomentForCircle(1.0f, 0.0f, 6.0f, cpvzero)));
+			cpBodySetPos(body, pos);
+			
+			cpShape *shape = cpSpaceAddShape(space, cpCircleShapeNew(body, 6.0f, cpvzero));
+			cpShapeSetFriction(shape, 0.7f);
+		}
+	}
+	
+	return 16.0f;
+}
+
+static cpFloat InitTileMap(cpSpace *space){return InitTileMapLevel(space, cpFalse);}
+static cpFloat InitTileMapBaked(cpSpace *space){return InitTileMapLevel(space, cpTrue);}
+
+static const Scene scenes[] = {
+	{"pyramids", InitPyramids, NULL, 600},
+	{"circles10k", InitCircles, NULL, 200},
+	{"chains", InitChains, NULL, 600},
+	{"sleeping", InitSleeping, NULL, 900},
+	{"rollback", InitRollback, FrameRollback, 600},
+	{"raycasts", InitRaycasts, FrameRaycasts, 300},
+	{"querygrid", InitRaycasts, FrameQueries, 300},
+	{"querybatch", InitRaycasts, FrameBatchQueries, 300},
+	{"tilemap", InitTileMap, NULL, 300},
+	{"tilemapbaked", InitTileMapBaked, NULL, 300},
+};
+#define NUM_SCENES (int)(sizeof(scenes)/sizeof(*scenes))
+
+//MARK: Running Scenes
+
+typedef struct ObjectList {
+	void **arr;
+	int num, max;
+} ObjectList;
+
+static void
+PushObject(void *obj, ObjectList *list)
+{
+	if(list->num == list->max){
+		list->max = (list->max ? 2*list->max : 256);
+		list->arr = (void **)realloc(list->arr, list->max*sizeof(void *));
+	}
+	
+	list->arr[list->num++] = obj;
+}
+
+static void
+FreeSpace(cpSpace *space)
+{
+	ObjectList shapes = {}, bodies = {}, constraints = {};
+	cpSpaceEachShape(space, (cpSpaceShapeIteratorFunc)PushObject, &shapes);
+	cpSpaceEachBody(space, (cpSpaceBodyIteratorFunc)PushObject, &bodies);
+	cpSpaceEachConstraint(space, (cpSpaceConstraintIteratorFunc)PushObject, &constraints);
+	
+	for(int i=0; i<constraints.num; i++){
+		cpConstraint *constraint = (cpConstraint *)constraints.arr[i];
+		cpSpaceRemoveConstraint(space, constraint);
+		cpConstraintFree(constraint);
+	}
+	
+	for(int i=0; i<shapes.num; i++){
+		cpShape *shape = (cpShape *)shapes.arr[i];
+		if(cpBodyIsStatic(cpShapeGetBody(shape))){
+			cpSpaceRemoveStaticShape(space, shape);
+		} else {
+			cpSpaceRemoveShape(space, shape);
+		}
+		
+		cpShapeFree(shape);
+	}
+	
+	for(int i=0; i<bodies.num; i++){
+		cpBody *body = (cpBody *)bodies.arr[i];
+		cpSpaceRemoveBody(space, body);
+		cpBodyFree(body);
+	}
+	
+	free(shapes.arr);
+	free(bodies.arr);
+	free(constraints.arr);
+	cpSpaceFree(space);
+}
+
+static void
+CountShape(cpShape *shape, int *count)
+{
+	(*count)++;
+}
+
+static void
+RunScene(const Scene *scene, IndexType index, int steps, SceneResult *result)
+{
+	memset(&allocStats, 0, sizeof(allocStats));
+	randSeed = 5489u;
+	
+	cpResetShapeIdCounter();
+	cpSpace *space = cpSpaceNew();
+	cpSpaceSetIterations(space, 10);
+	cpSpaceSetGravity(space, cpv(0, -100));
+	
+	cpFloat cellSize = scene->init(space);
+	
+	if(index == INDEX_HASH){
+		int count = 0;
+		cpSpaceEachShape(space, (cpSpaceShapeIteratorFunc)CountShape, &count);
+		cpSpaceUseSpatialHash(space, cellSize, count);
+	} else if(index == INDEX_SWEEP){
+		cpSpaceUseSweep1D(space);
+	}
+	
+	AllocStats setup = allocStats;
+	double start = Seconds();
+	
+	for(int i=0; i<steps; i++){
+		cpSpaceStep(space, 1.0f/60.0f);
+		if(scene->frame) scene->frame(space, i);
+	}
+	
+	result->msPerFrame = 1e3*(Seconds() - start)/(double)steps;
+	result->allocs = allocStats.allocs - setup.allocs;
+	result->allocBytes = allocStats.bytes - setup.bytes;
+	result->peakBytes = allocStats.peakBytes;
+	
+	FreeSpace(space);
+}
+
+//MARK: Result Files
+
+static void
+WriteResult(FILE *file, const Scene *scene, IndexType index, const SceneResult *result)
+{
+	fprintf(file, "%s %s %.6f %lu %lu %lu\n", scene->name, indexNames[index], result->msPerFrame,
+		result->allocs, (unsigned long)result->allocBytes, (unsigned long)result->peakBytes);
+}
+
+// Find the result for a scene and index, returns 0 if it couldn't be found.
+static int
+ReadResult(FILE *file, const Scene *scene, IndexType index, SceneResult *result)
+{
+	char name[64], indexName[16];
+	unsigned long allocBytes, peakBytes;
+	
+	rewind(file);
+	while(fscanf(file, "%63s %15s %lf %lu %lu %lu", name, indexName, &result->msPerFrame, &result->allocs, &allocBytes, &peakBytes) == 6){
+		if(strcmp(name, scene->name) == 0 && strcmp(indexName, indexNames[index]) == 0){
+			result->allocBytes = allocBytes;
+			result->peakBytes = peakBytes;
+			return 1;
+		}
+	}
+	
+	return 0;
+}
+
+//MARK: Main
+
+static void
+Usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [--scene name] [--index hash|bbtree|sweep] [--steps n] [--quick] [--write results.txt | --compare results.txt]\n", name);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *sceneFilter = NULL, *indexFilter = NULL;
+	const char *writePath = NULL, *comparePath = NULL;
+	int steps = 0;
+	
+	for(int i=1; i<argc; i++){
+		if(strcmp(argv[i], "--scene") == 0 && i + 1 < argc){
+			sceneFilter = argv[++i];
+		} else if(strcmp(argv[i], "--index") == 0 && i + 1 < argc){
+			indexFilter = argv[++i];
+		} else if(strcmp(argv[i], "--steps") == 0 && i + 1 < argc){
+			steps = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--quick") == 0){
+			steps = 10;
+		} else if(strcmp(argv[i], "--write") == 0 && i + 1 < argc){
+			writePath = argv[++i];
+		} else if(strcmp(argv[i], "--compare") == 0 && i + 1 < argc){
+			comparePath = argv[++i];
+		} else {
+			Usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	
+	FILE *writeFile = (writePath ? fopen(writePath, "w") : NULL);
+	FILE *compareFile = (comparePath ? fopen(comparePath, "r") : NULL);
+	if((writePath && !writeFile) || (comparePath && !compareFile)){
+		fprintf(stderr, "Could not open results file.\n");
+		return EXIT_FAILURE;
+	}
+	
+	printf("Chipmunk %s benchmark, cpFloat is %s.\n", cpVersionString, sizeof(cpFloat) == sizeof(float) ? "float" : "double");
+	printf("%-12s %-7s %6s %10s %10s %12s %12s %10s  %s\n", "scene", "index", "steps", "ms/frame", "ref ms", "allocs", "alloc KB", "peak KB", "speedup");
+	
+	int ran = 0;
+	for(int i=0; i<NUM_SCENES; i++){
+		const Scene *scene = &scenes[i];
+		if(sceneFilter && strcmp(sceneFilter, scene->name) != 0) continue;
+	
+		for(int index=0; index<NUM_INDEXES; index++){
+			if(indexFilter && strcmp(indexFilter, indexNames[index]) != 0) continue;
+	
+			int sceneSteps = (steps > 0 ? steps : scene->steps);
+			SceneResult result, reference;
+			RunScene(scene, (IndexType)index, sceneSteps, &result);
+	
+			if(writeFile) WriteResult(writeFile, scene, (IndexType)index, &result);
+	
+			printf("%-12s %-7s %6d %10.3f", scene->name, indexNames[index], sceneSteps, result.msPerFrame);
+			if(compareFile && ReadResult(compareFile, scene, (IndexType)index, &reference)){
+				printf(" %10.3f", reference.msPerFrame);
+			} else {
+				printf(" %10s", "-");
+			}
+	
+			printf(" %12lu %12.1f %10.1f", result.allocs, result.allocBytes/1024.0, result.peakBytes/1024.0);
+			if(compareFile && ReadResult(compareFile, scene, (IndexType)index, &reference) && result.msPerFrame > 0.0){
+				printf("  %.2fx", reference.msPerFrame/result.msPerFrame);
+			}
+	
+			printf("\n");
+			fflush(stdout);
+			ran++;
+		}
+	}
+	
+	if(writeFile) fclose(writeFile);
+	if(compareFile) fclose(compareFile);
+	
+	if(!ran){
+		fprintf(stderr, "No scenes matched.\n");
+		Usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	
+	return EXIT_SUCCESS;
+}
@@ -95,11 +95,13 @@ typedef struct cpSpace cpSpace;
 
 #include "cpVect.h"
 #include "cpBB.h"
+#include "cpAllocator.h"
 #include "cpSpatialIndex.h"
 
 #include "cpBody.h"
 #include "cpShape.h"
 #include "cpPolyShape.h"
+#include "cpStaticGeometry.h"
 
 #include "cpArbiter.h"	
 #include "constraints/cpConstraint.h"
@@ -43,6 +43,30 @@ cpBool cpArrayContains(cpArray *arr, void *ptr);
 
 void cpArrayFreeEach(cpArray *arr, void (freeFunc)(void*));
 
+//MARK: Allocators
+
+// Pools only hand out fixed size blocks, so they can't be used for variable size buffers.
+cpBool cpAllocatorIsPool(const cpAllocator *allocator);
+// The allocator to use for an object of @c size bytes. Returns NULL (the heap) if it's a pool with smaller blocks.
+cpAllocator *cpAllocatorForObject(cpAllocator *allocator, size_t size);
+
+// Objects and buffers that don't belong to an allocator are allocated on the heap.
+static inline void *
+cpAllocatorAllocOrHeap(cpAllocator *allocator, size_t size, cpAllocatorCategory category)
+{
+	return (allocator ? cpAllocatorAllocBytes(allocator, size, category) : cpcalloc(1, size));
+}
+
+static inline void
+cpAllocatorFreeOrHeap(cpAllocator *allocator, void *ptr, size_t size, cpAllocatorCategory category)
+{
+	if(allocator){
+		cpAllocatorFreeBytes(allocator, ptr, size, category);
+	} else {
+		cpfree(ptr);
+	}
+}
+
 //MARK: Foreach loops
 
 static inline cpConstraint *
@@ -76,6 +100,8 @@ typedef void *(*cpHashSetTransFunc)(void *ptr, void *data);
 
 cpHashSet *cpHashSetNew(int size, cpHashSetEqlFunc eqlFunc);
 void cpHashSetSetDefaultValue(cpHashSet *set, void *default_value);
+// Set the allocator used for the set's bins. The set must be empty.
+void cpHashSetSetAllocator(cpHashSet *set, cpAllocator *allocator);
 
 void cpHashSetFree(cpHashSet *set);
 
@@ -95,6 +121,14 @@ void cpHashSetFilter(cpHashSet *set, cpHashSetFilterFunc func, void *data);
 void cpBodyAddShape(cpBody *body, cpShape *shape);
 void cpBodyRemoveShape(cpBody *body, cpShape *shape);
 void cpBodyRemoveConstraint(cpBody *body, cpConstraint *constraint);
+void cpBodyPushArbiter(cpBody *body, cpArbiter *arb);
+
+// Run the velocity and position integrators of all the bodies in the array.
+// Bodies using the default integrators take an inlined fast path instead of the indirect call.
+// In double precision builds with SSE2 the fast path does the x and y components of one body at a time in a single register.
+// Bodies are not gathered into batches, and float builds use the plain scalar code.
+void cpBodyIntegrateVelocities(cpArray *bodies, cpVect gravity, cpFloat damping, cpFloat dt);
+void cpBodyIntegratePositions(cpArray *bodies, cpFloat dt);
 
 
 //MARK: Shape/Collision Functions
@@ -109,6 +143,19 @@ cpClosetPointOnSegment(const cpVect p, const cpVect a, const cpVect b)
 }
 
 cpShape* cpShapeInit(cpShape *shape, const cpShapeClass *klass, cpBody *body);
+// Allocate a zeroed shape struct from @c allocator (NULL for the heap) and remember it for cpShapeFree().
+void *cpShapeAllocBytes(cpAllocator *allocator, size_t size);
+
+// Shape classes reused by the scratch child shapes of cpStaticGeometry and checked by snapshots.
+extern const cpShapeClass cpCircleShapeClass;
+extern const cpShapeClass cpSegmentShapeClass;
+extern const cpShapeClass cpPolyShapeClass;
+
+// Calls func for every child of a static geometry shape whose bounding box overlaps bb.
+// The child is a temporary segment or poly shape that is only valid during the callback.
+// childHash is unique for each child and is mixed into the contact hashes.
+typedef void (*cpStaticGeometryChildFunc)(const cpShape *child, cpHashValue childHash, void *data);
+void cpStaticGeometryEachChild(const cpShape *geometry, cpBB bb, cpStaticGeometryChildFunc func, void *data);
 
 static inline cpBool
 cpShapeActive(cpShape *shape)
@@ -178,6 +225,9 @@ cpPolyShapeContainsVertPartial(const cpPolyShape *poly, const cpVect v, const cp
 //MARK: Spatial Index Functions
 
 cpSpatialIndex *cpSpatialIndexInit(cpSpatialIndex *index, cpSpatialIndexClass *klass, cpSpatialIndexBBFunc bbfunc, cpSpatialIndex *staticIndex);
+cpBool cpSpaceHashIsSpaceHash(cpSpatialIndex *index);
+// Set the allocator used for the internal buffers of an empty spatial index.
+void cpSpatialIndexSetAllocator(cpSpatialIndex *index, cpAllocator *allocator);
 
 //MARK: Space Functions
 
@@ -185,11 +235,14 @@ extern cpCollisionHandler cpDefaultCollisionHandler;
 void cpSpaceProcessComponents(cpSpace *space, cpFloat dt);
 
 void cpSpacePushFreshContactBuffer(cpSpace *space);
+void cpSpaceExpireContactBuffers(cpSpace *space);
+void cpSpaceFreeBuffers(cpSpace *space);
 cpContact *cpContactBufferGetArray(cpSpace *space);
 void cpSpacePushContacts(cpSpace *space, int count);
 
 void *cpSpaceGetPostStepData(cpSpace *space, void *key);
 
+void *cpSpaceArbiterSetTrans(cpShape **shapes, cpSpace *space);
 cpBool cpSpaceArbiterSetFilter(cpArbiter *arb, cpSpace *space);
 void cpSpaceFilterArbiters(cpSpace *space, cpBody *body, cpShape *filter);
 
@@ -256,4 +309,5 @@ void cpArbiterUnthread(cpArbiter *arb);
 void cpArbiterUpdate(cpArbiter *arb, cpContact *contacts, int numContacts, struct cpCollisionHandler *handler, cpShape *a, cpShape *b);
 void cpArbiterPreStep(cpArbiter *arb, cpFloat dt, cpFloat bias, cpFloat slop);
 void cpArbiterApplyCachedImpulse(cpArbiter *arb, cpFloat dt_coef);
-void cpArbiterApplyImpulse(cpArbiter *arb);
+// Returns the largest change in accumulated impulse of any contact.
+cpFloat cpArbiterApplyImpulse(cpArbiter *arb);
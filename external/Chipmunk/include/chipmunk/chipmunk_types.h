@@ -24,6 +24,7 @@
 
 #ifndef CP_USE_DOUBLES
 	// use doubles by default for higher precision
+	// define CP_USE_DOUBLES as 0 to use single precision floats, tests/precision.c checks both profiles
 	#define CP_USE_DOUBLES 1
 #endif
 
@@ -45,6 +46,7 @@
 	#define cpfpow pow
 	#define cpffloor floor
 	#define cpfceil ceil
+	#define CPFLOAT_EPSILON 2.2204460492503131e-16
 #else
 	typedef float cpFloat;
 	#define cpfsqrt sqrtf
@@ -57,6 +59,37 @@
 	#define cpfpow powf
 	#define cpffloor floorf
 	#define cpfceil ceilf
+	#define CPFLOAT_EPSILON 1.19209290e-7f
+#endif
+
+#ifndef CP_DETERMINISTIC_MATH
+	// define CP_DETERMINISTIC_MATH as 1 to replace the libm transcendental functions with the portable ones in cpPortableMath.c
+	// Bit identical results across platforms also require SSE2 or NEON floating point and compiling Chipmunk
+	// with -ffp-contract=off, which the chipmunk_deterministic CMake targets do.
+	#define CP_DETERMINISTIC_MATH 0
+#endif
+
+#if CP_DETERMINISTIC_MATH
+	double cpPortableSin(double x);
+	double cpPortableCos(double x);
+	double cpPortableAcos(double x);
+	double cpPortableAtan2(double y, double x);
+	double cpPortableExp(double x);
+	double cpPortableLog(double x);
+	double cpPortablePow(double x, double y);
+	
+	#undef cpfsin
+	#undef cpfcos
+	#undef cpfacos
+	#undef cpfatan2
+	#undef cpfexp
+	#undef cpfpow
+	#define cpfsin(x) ((cpFloat)cpPortableSin(x))
+	#define cpfcos(x) ((cpFloat)cpPortableCos(x))
+	#define cpfacos(x) ((cpFloat)cpPortableAcos(x))
+	#define cpfatan2(y, x) ((cpFloat)cpPortableAtan2(y, x))
+	#define cpfexp(x) ((cpFloat)cpPortableExp(x))
+	#define cpfpow(x, y) ((cpFloat)cpPortablePow(x, y))
 #endif
 
 #ifndef INFINITY
@@ -57,6 +57,8 @@ struct cpConstraint {
 	CP_PRIVATE(cpConstraint *next_a);
 	CP_PRIVATE(cpConstraint *next_b);
 	
+	CP_PRIVATE(cpHashValue hashid);
+	
 	/// The maximum force that this constraint is allowed to use.
 	/// Defaults to infinity.
 	cpFloat maxForce;
@@ -80,6 +82,11 @@ struct cpConstraint {
 	/// Generally this points to your the game object class so you can access it
 	/// when given a cpConstraint reference in a callback.
 	cpDataPointer data;
+	
+	/// @private
+	/// Size of the impulse applied by the last applyImpulse() call, read by the adaptive solver.
+	/// Constraint classes that don't write it are treated as never converging.
+	CP_PRIVATE(cpFloat impulseDelta);
 };
 
 /// Destroy a constraint.
@@ -87,6 +94,11 @@ void cpConstraintDestroy(cpConstraint *constraint);
 /// Destroy and free a constraint.
 void cpConstraintFree(cpConstraint *constraint);
 
+/// Like shapes, constraints get their hash value from a counter when initialized.
+/// Deterministic spaces solve constraints in hash value order, so reset the counter along
+/// with cpResetShapeIdCounter() when recreating a space.
+void cpResetConstraintIdCounter(void);
+
 /// @private
 static inline void cpConstraintActivateBodies(cpConstraint *constraint)
 {
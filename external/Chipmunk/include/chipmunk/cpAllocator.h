@@ -0,0 +1,170 @@
+/* Copyright (c) 2012 Scott Lembcke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/**
+	@defgroup cpAllocator cpAllocator
+	
+	Allocators let you control where a space gets the memory for its internal buffers
+	(arbiters, contacts, spatial indexes and hash sets) and where bodies and shapes are allocated.
+	Every allocator keeps track of the number of bytes it has handed out in each category.
+	
+	Spaces use their own heap allocator unless you set one with cpSpaceSetAllocator().
+	Bodies and shapes come from the heap unless they are created with an allocator
+	(cpBodyNewWithAllocator(), cpPolyShapeNewWithAllocator(), etc.), and remember it so that
+	cpBodyFree() and cpShapeFree() return them to it. There is no global allocator,
+	so spaces on different threads can each use their own.
+	
+	Chipmunk provides a heap allocator (the default), an arena allocator that frees everything at once
+	and is well suited for short lived spaces, and a fixed size pool allocator for bodies and shapes.
+	Allocators aren't locked, so only use one from one thread at a time.
+	
+	Allocators should be treated as opaque structs, except for the byte counts.
+	@{
+*/
+
+/// Categories used to report allocated bytes.
+typedef enum cpAllocatorCategory {
+	CP_ALLOCATOR_MISC,
+	CP_ALLOCATOR_BODIES,
+	CP_ALLOCATOR_SHAPES,
+	CP_ALLOCATOR_ARBITERS,
+	CP_ALLOCATOR_CONTACTS,
+	CP_ALLOCATOR_NUM_CATEGORIES
+} cpAllocatorCategory;
+
+typedef struct cpAllocatorClass cpAllocatorClass;
+typedef struct cpAllocator cpAllocator;
+
+/// @private
+struct cpAllocator {
+	const cpAllocatorClass *klass;
+	
+	/// Number of bytes currently allocated in each category.
+	size_t bytes[CP_ALLOCATOR_NUM_CATEGORIES];
+	/// Highest total number of bytes allocated at once.
+	size_t peakBytes;
+};
+
+//MARK: Heap Allocator
+
+/// Initialize a heap allocator. It passes allocations through to cpcalloc() and cpfree().
+cpAllocator* cpHeapAllocatorInit(cpAllocator *allocator);
+/// Allocate and initialize a heap allocator.
+cpAllocator* cpHeapAllocatorNew(void);
+
+//MARK: Arena Allocator
+
+typedef struct cpArenaAllocator cpArenaAllocator;
+
+/// Allocate an arena allocator.
+cpArenaAllocator* cpArenaAllocatorAlloc(void);
+/// Initialize an arena allocator.
+/// Memory is handed out from chunks of @c chunkSize bytes and is only returned when the arena is reset or destroyed,
+/// so the byte counts only go down on reset.
+/// Arenas are meant for objects and spaces that are all freed together. A long running space keeps reallocating its
+/// buffers as it grows and shrinks, and an arena would hold on to every one of them until the space is freed.
+cpAllocator* cpArenaAllocatorInit(cpArenaAllocator *arena, size_t chunkSize);
+/// Allocate and initialize an arena allocator.
+cpAllocator* cpArenaAllocatorNew(size_t chunkSize);
+
+/// Release all of the memory allocated from the arena at once, keeping the first chunk for reuse.
+/// Only call this once nothing is using the memory anymore. (e.g. after freeing the space that used it)
+void cpArenaAllocatorReset(cpAllocator *allocator);
+
+//MARK: Pool Allocator
+
+typedef struct cpPoolAllocator cpPoolAllocator;
+
+/// Allocate a pool allocator.
+cpPoolAllocator* cpPoolAllocatorAlloc(void);
+/// Initialize a pool allocator that hands out fixed size blocks of @c blockSize bytes.
+/// Freed blocks are kept and reused by later allocations.
+/// Memory you allocate from a pool yourself and initialize with cpBodyInit() or a shape init function
+/// must be released with the matching destroy function and cpAllocatorFreeBytes(), not cpBodyFree() or cpShapeFree().
+cpAllocator* cpPoolAllocatorInit(cpPoolAllocator *pool, size_t blockSize);
+/// Allocate and initialize a pool allocator.
+cpAllocator* cpPoolAllocatorNew(size_t blockSize);
+
+//MARK: Allocator Implementation
+
+typedef void (*cpAllocatorDestroyImpl)(cpAllocator *allocator);
+typedef void *(*cpAllocatorAllocImpl)(cpAllocator *allocator, size_t size);
+typedef void (*cpAllocatorFreeImpl)(cpAllocator *allocator, void *ptr, size_t size);
+
+struct cpAllocatorClass {
+	cpAllocatorDestroyImpl destroy;
+	
+	/// Must return zeroed memory.
+	cpAllocatorAllocImpl alloc;
+	/// Optional. Allocators that only release their memory all at once (like arenas) leave it NULL,
+	/// and freed bytes stay counted until they reset the counts.
+	cpAllocatorFreeImpl free;
+};
+
+/// Initialize the byte counts of a custom allocator.
+cpAllocator* cpAllocatorInit(cpAllocator *allocator, const cpAllocatorClass *klass);
+/// Destroy and free an allocator.
+void cpAllocatorFree(cpAllocator *allocator);
+
+/// Destroy an allocator.
+static inline void cpAllocatorDestroy(cpAllocator *allocator)
+{
+	if(allocator->klass) allocator->klass->destroy(allocator);
+}
+
+/// Allocate @c size bytes of zeroed memory and count them against @c category.
+static inline void *cpAllocatorAllocBytes(cpAllocator *allocator, size_t size, cpAllocatorCategory category)
+{
+	allocator->bytes[category] += size;
+	
+	size_t total = 0;
+	for(int i=0; i<CP_ALLOCATOR_NUM_CATEGORIES; i++) total += allocator->bytes[i];
+	if(total > allocator->peakBytes) allocator->peakBytes = total;
+	
+	return allocator->klass->alloc(allocator, size);
+}
+
+/// Free memory returned by cpAllocatorAllocBytes(). @c size and @c category must match the values it was allocated with.
+static inline void cpAllocatorFreeBytes(cpAllocator *allocator, void *ptr, size_t size, cpAllocatorCategory category)
+{
+	if(allocator->klass->free){
+		allocator->bytes[category] -= size;
+		allocator->klass->free(allocator, ptr, size);
+	}
+}
+
+/// Get the number of bytes currently allocated in a category.
+static inline size_t cpAllocatorGetBytes(const cpAllocator *allocator, cpAllocatorCategory category)
+{
+	return allocator->bytes[category];
+}
+
+/// Get the total number of bytes currently allocated.
+static inline size_t cpAllocatorGetTotalBytes(const cpAllocator *allocator)
+{
+	size_t total = 0;
+	for(int i=0; i<CP_ALLOCATOR_NUM_CATEGORIES; i++) total += allocator->bytes[i];
+	
+	return total;
+}
+
+///@}
@@ -36,6 +36,14 @@ typedef struct cpComponentNode {
 	cpBody *root;
 	cpBody *next;
 	cpFloat idleTime;
+	
+	// Union-find forest of the awake bodies that is kept across steps.
+	cpBody *parent;
+	// Last step a body in the set was active, only valid for the root of a set.
+	cpTimestamp activeStamp;
+	
+	// Index of the body in the space's body array while the adaptive solver builds islands.
+	int island;
 } cpComponentNode;
 
 /// Chipmunk's rigid body struct.
@@ -91,6 +99,7 @@ struct cpBody {
 	CP_PRIVATE(cpFloat w_bias);
 	
 	CP_PRIVATE(cpSpace *space);
+	CP_PRIVATE(cpAllocator *allocator);
 	
 	CP_PRIVATE(cpShape *shapeList);
 	CP_PRIVATE(cpArbiter *arbiterList);
@@ -106,6 +115,12 @@ cpBody* cpBodyInit(cpBody *body, cpFloat m, cpFloat i);
 /// Allocate and initialize a cpBody.
 cpBody* cpBodyNew(cpFloat m, cpFloat i);
 
+/// Allocate a cpBody from @c allocator. (NULL for the heap)
+/// cpBodyFree() returns it to the allocator, which must outlive the body.
+cpBody* cpBodyAllocWithAllocator(cpAllocator *allocator);
+/// Allocate a cpBody from @c allocator and initialize it.
+cpBody* cpBodyNewWithAllocator(cpAllocator *allocator, cpFloat m, cpFloat i);
+
 /// Initialize a static cpBody.
 cpBody* cpBodyInitStatic(cpBody *body);
 /// Allocate and initialize a static cpBody.
@@ -45,6 +45,10 @@ cpPolyShape* cpPolyShapeInit(cpPolyShape *poly, cpBody *body, int numVerts, cpVe
 /// Allocate and initialize a polygon shape.
 /// A convex hull will be created from the vertexes.
 cpShape* cpPolyShapeNew(cpBody *body, int numVerts, cpVect *verts, cpVect offset);
+/// Allocate a polygon shape from @c allocator (NULL for the heap) and initialize it.
+/// cpShapeFree() returns it to the allocator, which must outlive the shape.
+/// The vertex arrays are always allocated on the heap.
+cpShape* cpPolyShapeNewWithAllocator(cpAllocator *allocator, cpBody *body, int numVerts, cpVect *verts, cpVect offset);
 
 /// Initialize a box shaped polygon shape.
 cpPolyShape* cpBoxShapeInit(cpPolyShape *poly, cpBody *body, cpFloat width, cpFloat height);
@@ -54,6 +58,8 @@ cpPolyShape* cpBoxShapeInit2(cpPolyShape *poly, cpBody *body, cpBB box);
 cpShape* cpBoxShapeNew(cpBody *body, cpFloat width, cpFloat height);
 /// Allocate and initialize an offset box shaped polygon shape.
 cpShape* cpBoxShapeNew2(cpBody *body, cpBB box);
+/// Allocate a box shaped polygon shape from @c allocator (NULL for the heap) and initialize it.
+cpShape* cpBoxShapeNewWithAllocator(cpAllocator *allocator, cpBody *body, cpFloat width, cpFloat height);
 
 /// Check that a set of vertexes is convex and has a clockwise winding.
 /// NOTE: Due to floating point precision issues, hulls created with cpQuickHull() are not guaranteed to validate!
@@ -50,6 +50,7 @@ typedef enum cpShapeType{
 	CP_CIRCLE_SHAPE,
 	CP_SEGMENT_SHAPE,
 	CP_POLY_SHAPE,
+	CP_STATIC_GEOMETRY_SHAPE,
 	CP_NUM_SHAPES
 } cpShapeType;
 
@@ -66,6 +67,9 @@ struct cpShapeClass {
 	cpShapeDestroyImpl destroy;
 	cpShapeNearestPointQueryImpl nearestPointQuery;
 	cpShapeSegmentQueryImpl segmentQuery;
+	
+	// Size of the shape struct, used to return it to the allocator it came from.
+	size_t size;
 };
 
 /// Opaque collision shape struct.
@@ -102,6 +106,7 @@ struct cpShape {
 	cpLayers layers;
 	
 	CP_PRIVATE(cpSpace *space);
+	CP_PRIVATE(cpAllocator *allocator);
 	
 	CP_PRIVATE(cpShape *next);
 	CP_PRIVATE(cpShape *prev);
@@ -193,6 +198,9 @@ cpCircleShape* cpCircleShapeAlloc(void);
 cpCircleShape* cpCircleShapeInit(cpCircleShape *circle, cpBody *body, cpFloat radius, cpVect offset);
 /// Allocate and initialize a circle shape.
 cpShape* cpCircleShapeNew(cpBody *body, cpFloat radius, cpVect offset);
+/// Allocate a circle shape from @c allocator (NULL for the heap) and initialize it.
+/// cpShapeFree() returns it to the allocator, which must outlive the shape.
+cpShape* cpCircleShapeNewWithAllocator(cpAllocator *allocator, cpBody *body, cpFloat radius, cpVect offset);
 
 CP_DeclareShapeGetter(cpCircleShape, cpVect, Offset);
 CP_DeclareShapeGetter(cpCircleShape, cpFloat, Radius);
@@ -217,6 +225,9 @@ cpSegmentShape* cpSegmentShapeAlloc(void);
 cpSegmentShape* cpSegmentShapeInit(cpSegmentShape *seg, cpBody *body, cpVect a, cpVect b, cpFloat radius);
 /// Allocate and initialize a segment shape.
 cpShape* cpSegmentShapeNew(cpBody *body, cpVect a, cpVect b, cpFloat radius);
+/// Allocate a segment shape from @c allocator (NULL for the heap) and initialize it.
+/// cpShapeFree() returns it to the allocator, which must outlive the shape.
+cpShape* cpSegmentShapeNewWithAllocator(cpAllocator *allocator, cpBody *body, cpVect a, cpVect b, cpFloat radius);
 
 void cpSegmentShapeSetNeighbors(cpShape *shape, cpVect prev, cpVect next);
 
@@ -25,6 +25,68 @@
 typedef struct cpContactBufferHeader cpContactBufferHeader;
 typedef void (*cpSpaceArbiterApplyImpulseFunc)(cpArbiter *arb);
 
+/// Timings and counters recorded by cpSpaceStep() when a profile is set on the space.
+/// Times are in seconds and all values are reset at the start of each step.
+typedef struct cpSpaceProfile {
+	/// Total time spent in cpSpaceStep().
+	cpFloat step;
+	/// Time spent integrating body positions.
+	cpFloat integratePositions;
+	/// Time spent updating shapes and running the broadphase and narrowphase collision detection.
+	cpFloat reindexQuery;
+	/// Time spent building the contact graph and putting components to sleep.
+	cpFloat processComponents;
+	/// Time spent filtering out old cached arbiters and calling separate callbacks.
+	cpFloat arbiterFilter;
+	/// Time spent prestepping arbiters and constraints.
+	cpFloat preStep;
+	/// Time spent integrating body velocities.
+	cpFloat integrateVelocities;
+	/// Time spent applying cached impulses and running the solver iterations.
+	cpFloat solve;
+	/// Time spent in constraint and collision post-solve callbacks.
+	cpFloat postSolve;
+	
+	/// Number of shape pairs passed from the broadphase to the narrowphase.
+	unsigned int pairsTested;
+	/// Number of new arbiters created for colliding pairs.
+	unsigned int arbitersCreated;
+	/// Number of cached arbiters reused for colliding pairs.
+	unsigned int arbitersReused;
+	/// Number of awake components found. Only counted when sleeping is enabled.
+	unsigned int awakeComponents;
+	/// Number of sleeping components at the end of the step.
+	unsigned int sleepingComponents;
+	/// Number of times the awake components were rebuilt from scratch (0 or 1).
+	unsigned int componentRebuilds;
+	/// Number of component unions performed for new arbiters and constraints.
+	unsigned int componentUnions;
+	/// Number of bodies visited while flood filling components to put them to sleep.
+	unsigned int componentBodiesVisited;
+	/// Number of islands solved separately. Only counted when the adaptive solver is enabled.
+	unsigned int islands;
+	/// Total number of solver iterations run, summed over all the islands when the adaptive solver is enabled.
+	unsigned int solverIterations;
+} cpSpaceProfile;
+
+/// Contact buffer usage reported by cpSpaceGetContactBufferStats().
+typedef struct cpContactBufferStats {
+	/// Number of buffers holding contacts that cached arbiters may still reference.
+	int activeBuffers;
+	/// Number of expired buffers kept for reuse.
+	int pooledBuffers;
+	/// Bytes currently allocated for contact buffers.
+	size_t bytes;
+	/// Highest number of bytes allocated for contact buffers at once.
+	size_t peakBytes;
+	/// Number of buffers recycled before their contacts expired to stay within the contact budget.
+	unsigned long evictions;
+	/// Number of buffers allocated over the contact budget because every buffer held contacts from the current step.
+	unsigned long overBudget;
+	/// Number of expired buffers returned to the allocator because more were pooled than in use.
+	unsigned long trimmedBuffers;
+} cpContactBufferStats;
+
 /// Basic Unit of Simulation in Chipmunk
 struct cpSpace {
 	/// Number of iterations to use in the impulse solver to solve contacts.
@@ -83,17 +145,37 @@ struct cpSpace {
 	CP_PRIVATE(cpArray *bodies);
 	CP_PRIVATE(cpArray *rousedBodies);
 	CP_PRIVATE(cpArray *sleepingComponents);
+	CP_PRIVATE(cpBool rebuildComponents);
+	CP_PRIVATE(cpBool staleComponents);
+	CP_PRIVATE(cpTimestamp componentsStamp);
 	
 	CP_PRIVATE(cpSpatialIndex *staticShapes);
 	CP_PRIVATE(cpSpatialIndex *activeShapes);
 	
 	CP_PRIVATE(cpArray *arbiters);
 	CP_PRIVATE(cpContactBufferHeader *contactBuffersHead);
+	CP_PRIVATE(cpContactBufferHeader *pooledContactBuffers);
+	CP_PRIVATE(size_t contactBudget);
+	CP_PRIVATE(cpContactBufferStats contactBufferStats);
 	CP_PRIVATE(cpHashSet *cachedArbiters);
 	CP_PRIVATE(cpArray *pooledArbiters);
 	CP_PRIVATE(cpArray *constraints);
 	
 	CP_PRIVATE(cpArray *allocatedBuffers);
+	CP_PRIVATE(cpAllocator *allocator);
+	CP_PRIVATE(cpAllocator _heapAllocator);
+	
+	CP_PRIVATE(cpSpaceProfile *profile);
+	CP_PRIVATE(cpBool deterministic);
+	
+	CP_PRIVATE(cpFloat solverTolerance);
+	CP_PRIVATE(int minIterations);
+	CP_PRIVATE(int lastIterations);
+	CP_PRIVATE(void *islandBuffer);
+	CP_PRIVATE(size_t islandBufferSize);
+	
+	CP_PRIVATE(cpArray *sortedArbiters);
+	CP_PRIVATE(cpArray *sortedConstraints);
 	CP_PRIVATE(int locked);
 	
 	CP_PRIVATE(cpHashSet *collisionHandlers);
@@ -138,6 +220,45 @@ CP_DefineSpaceStructProperty(cpTimestamp, collisionPersistence, CollisionPersist
 CP_DefineSpaceStructProperty(cpBool, enableContactGraph, EnableContactGraph);
 CP_DefineSpaceStructProperty(cpDataPointer, data, UserData);
 CP_DefineSpaceStructGetter(cpBody*, staticBody, StaticBody);
+CP_DefineSpaceStructGetter(cpAllocator*, CP_PRIVATE(allocator), Allocator);
+
+/// Set a profile struct to be filled in by each call to cpSpaceStep(), or NULL to disable profiling (the default).
+/// The struct is owned by the caller and must remain valid while it is set.
+CP_DefineSpaceStructProperty(cpSpaceProfile*, CP_PRIVATE(profile), Profile);
+
+/// Process arbiters, constraints and separate callbacks in an order that only depends on the shape and constraint hash values.
+/// Without it the order can depend on memory addresses and the spatial index's hash width.
+/// Disabled by default. Combine with cpResetShapeIdCounter(), cpResetConstraintIdCounter() and a CP_DETERMINISTIC_MATH build
+/// to get bit identical simulations across platforms.
+CP_DefineSpaceStructProperty(cpBool, CP_PRIVATE(deterministic), Deterministic);
+
+/// Limit on the number of bytes used for contact buffers, or 0 for no limit (the default).
+/// Contacts are kept for collisionPersistence steps so separating shapes can reuse their cached impulses.
+/// When the budget is reached, the oldest buffer is recycled early and the arbiters using it lose their cached impulses.
+/// Contacts from the current step are never dropped, so the budget can still be exceeded by a single step with a lot of contacts.
+/// Expired buffers above the number in use are returned to the allocator so memory shrinks after a spike.
+CP_DefineSpaceStructProperty(size_t, CP_PRIVATE(contactBudget), ContactBudget);
+/// Impulse tolerance of the adaptive solver, or 0 to always run cpSpace.iterations passes (the default).
+/// When set, the arbiters and constraints are split into islands of connected bodies and each island is solved separately.
+/// An island stops iterating once no contact or constraint impulse changed by more than the tolerance during a pass.
+/// cpSpace.iterations becomes the maximum number of iterations for each island.
+/// The tolerance is an impulse, so it should scale with the masses in the space.
+CP_DefineSpaceStructProperty(cpFloat, CP_PRIVATE(solverTolerance), SolverTolerance);
+/// Minimum number of iterations the adaptive solver runs for each island. Defaults to 1.
+CP_DefineSpaceStructProperty(int, CP_PRIVATE(minIterations), MinIterations);
+/// Largest number of iterations any island needed during the last step.
+/// Equal to cpSpace.iterations unless the adaptive solver is enabled.
+CP_DefineSpaceStructGetter(int, CP_PRIVATE(lastIterations), LastIterations);
+
+/// Get the contact buffer usage of a space.
+CP_DefineSpaceStructGetter(cpContactBufferStats, CP_PRIVATE(contactBufferStats), ContactBufferStats);
+
+/// Set the allocator the space uses for its arbiter and contact buffers, spatial indexes and hash sets.
+/// New spaces use their own heap allocator, passing NULL restores it.
+/// This must be set before adding shapes or collision handlers or stepping the space, and the allocator must outlive the space.
+/// Pool allocators can't be used here since the space allocates buffers of several sizes.
+/// Arena allocators only suit spaces that are freed soon after they are created, since nothing the space frees is reused until the arena is reset.
+void cpSpaceSetAllocator(cpSpace *space, cpAllocator *allocator);
 CP_DefineSpaceStructGetter(cpFloat, CP_PRIVATE(curr_dt), CurrentTimeStep);
 
 /// returns true from inside a callback and objects cannot be added/removed.
@@ -234,6 +355,42 @@ typedef void (*cpSpaceBBQueryFunc)(cpShape *shape, void *data);
 /// Only the shape's bounding boxes are checked for overlap, not their full shape.
 void cpSpaceBBQuery(cpSpace *space, cpBB bb, cpLayers layers, cpGroup group, cpSpaceBBQueryFunc func, void *data);
 
+/// @defgroup cpSpaceBatchQueries Batch Queries
+/// Batch queries run many queries of the same kind in a single call and write the results into flat arrays.
+/// They don't call any user callbacks and don't modify the space, so a large batch can be split into
+/// slices and run from several threads at once as long as the space isn't being stepped or modified.
+/// This only applies to the cpBBTree and cpSweep1D spatial indexes. cpSpaceHash modifies itself while querying.
+/// Each batch query returns the same results as running its single query version once per entry.
+/// Neighboring entries in a batch share their traversals of the spatial indexes, so batches run
+/// fastest when nearby queries are next to each other in the arrays (rows of a grid, sorted particles, etc).
+/// Spaces using cpSpaceHash run the queries one at a time.
+/// @{
+
+/// Point query @c count points and store the shape cpSpacePointQueryFirst() would return for each in @c out.
+/// Entries are set to NULL for points that didn't hit anything.
+void cpSpacePointQueryFirstBatch(cpSpace *space, int count, const cpVect *points, cpLayers layers, cpGroup group, cpShape **out);
+/// Find the nearest shape to each of @c count points and store the query info for each in @c out.
+/// The shape member of an entry is NULL if nothing was within @c maxDistance.
+void cpSpaceNearestPointQueryNearestBatch(cpSpace *space, int count, const cpVect *points, cpFloat maxDistance, cpLayers layers, cpGroup group, cpNearestPointQueryInfo *out);
+/// Find the first shape hit by each of @c count segments going from @c starts[i] to @c ends[i].
+/// The shape member of an entry is NULL if the segment didn't hit anything.
+void cpSpaceSegmentQueryFirstBatch(cpSpace *space, int count, const cpVect *starts, const cpVect *ends, cpLayers layers, cpGroup group, cpSegmentQueryInfo *out);
+
+/// Hit record for cpSpaceBBQueryBatch().
+typedef struct cpBBQueryBatchHit {
+	/// Index of the bounding box in the batch.
+	int index;
+	/// The shape that was found.
+	cpShape *shape;
+} cpBBQueryBatchHit;
+
+/// Perform a rectangle query for each of @c count bounding boxes and append a hit to @c hits for each shape found.
+/// Hits are grouped by query index in increasing order. At most @c maxHits hits are written.
+/// Returns the total number of hits found, which can be larger than @c maxHits if the hit array was too small.
+int cpSpaceBBQueryBatch(cpSpace *space, int count, const cpBB *bbs, cpLayers layers, cpGroup group, cpBBQueryBatchHit *hits, int maxHits);
+
+/// @}
+
 /// Shape query callback function type.
 typedef void (*cpSpaceShapeQueryFunc)(cpShape *shape, cpContactPointSet *points, void *data);
 /// Query a space for any shapes overlapping the given shape and call @c func for each shape found.
@@ -267,6 +424,29 @@ void cpSpaceReindexShapesForBody(cpSpace *space, cpBody *body);
 
 /// Switch the space to use a spatial has as it's spatial index.
 void cpSpaceUseSpatialHash(cpSpace *space, cpFloat dim, int count);
+/// Switch the space to use a 1D sort and sweep as it's active spatial index.
+/// Static shapes are kept in a bounding box tree.
+void cpSpaceUseSweep1D(cpSpace *space);
+
+/// Save the state of the space's bodies, constraints, shapes, cached collisions and sleeping components to @c buffer.
+/// Shape properties (sensor, friction, elasticity, surface velocity, collision type, group and layers) are saved
+/// along with the geometry of circle, segment and poly shapes that can be changed with chipmunk_unsafe.h.
+/// Returns the size of the snapshot in bytes. Nothing is written if @c buffer is NULL or @c capacity is too small,
+/// so you can call it once with a NULL buffer to find out how much memory to allocate.
+/// Snapshots reference the objects in the space by pointer and can only be restored to the same space.
+size_t cpSpaceSaveSnapshot(cpSpace *space, void *buffer, size_t capacity);
+/// Restore a snapshot created by cpSpaceSaveSnapshot().
+/// The space must contain the same bodies, constraints and shapes it did when the snapshot was saved.
+/// Restoring a snapshot to a space that isn't deterministic is fine for reloading a level.
+/// Stepping after a restore only replays the original steps exactly if the space is deterministic (see cpSpaceSetDeterministic()).
+/// Otherwise the order collision pairs are found in depends on the spatial index's internal state, which isn't saved.
+/// Returns false without modifying the space if the snapshot doesn't match the space.
+cpBool cpSpaceRestoreSnapshot(cpSpace *space, const void *buffer, size_t size);
+
+/// Returns a checksum of the positions and velocities of the bodies in the space and the impulses applied by its contacts.
+/// The checksum doesn't depend on the order of the bodies or memory addresses, so it can be compared between
+/// peers in a lockstep simulation or between builds to find the step where two simulations diverged.
+uint64_t cpSpaceGetChecksum(cpSpace *space);
 
 /// Step the space forward in time by @c dt.
 void cpSpaceStep(cpSpace *space, cpFloat dt);
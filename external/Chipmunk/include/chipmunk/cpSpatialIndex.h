@@ -61,6 +61,9 @@ struct cpSpatialIndex {
 	cpSpatialIndexBBFunc bbfunc;
 	
 	cpSpatialIndex *staticIndex, *dynamicIndex;
+	
+	// Allocator used for the index's internal buffers, or NULL to use the heap.
+	cpAllocator *allocator;
 };
 
 
@@ -103,6 +106,8 @@ void cpBBTreeSetVelocityFunc(cpSpatialIndex *index, cpBBTreeVelocityFunc func);
 
 //MARK: Single Axis Sweep
 
+// The sweep picks whichever axis has the larger spread and keeps its table sorted between steps.
+
 typedef struct cpSweep1D cpSweep1D;
 
 /// Allocate a 1D sort and sweep broadphase.
@@ -112,6 +117,12 @@ cpSpatialIndex* cpSweep1DInit(cpSweep1D *sweep, cpSpatialIndexBBFunc bbfunc, cpS
 /// Allocate and initialize a 1D sort and sweep broadphase.
 cpSpatialIndex* cpSweep1DNew(cpSpatialIndexBBFunc bbfunc, cpSpatialIndex *staticIndex);
 
+/// Get the axis the sweep is currently sorted along. 0 for the x-axis, 1 for the y-axis.
+/// The axis is picked automatically on each reindex based on the spread of the objects.
+int cpSweep1DGetAxis(cpSpatialIndex *index);
+/// Get the number of candidate pairs that were tested during the last reindex query.
+unsigned int cpSweep1DGetPairTests(cpSpatialIndex *index);
+
 //MARK: Spatial Index Implementation
 
 typedef void (*cpSpatialIndexDestroyImpl)(cpSpatialIndex *index);
@@ -130,6 +141,8 @@ typedef void (*cpSpatialIndexReindexQueryImpl)(cpSpatialIndex *index, cpSpatialI
 typedef void (*cpSpatialIndexQueryImpl)(cpSpatialIndex *index, void *obj, cpBB bb, cpSpatialIndexQueryFunc func, void *data);
 typedef void (*cpSpatialIndexSegmentQueryImpl)(cpSpatialIndex *index, void *obj, cpVect a, cpVect b, cpFloat t_exit, cpSpatialIndexSegmentQueryFunc func, void *data);
 
+typedef void (*cpSpatialIndexSetAllocatorImpl)(cpSpatialIndex *index, cpAllocator *allocator);
+
 struct cpSpatialIndexClass {
 	cpSpatialIndexDestroyImpl destroy;
 	
@@ -146,6 +159,9 @@ struct cpSpatialIndexClass {
 	
 	cpSpatialIndexQueryImpl query;
 	cpSpatialIndexSegmentQueryImpl segmentQuery;
+	
+	// Optional, called when the allocator of an empty index changes and before index->allocator is updated.
+	cpSpatialIndexSetAllocatorImpl setAllocator;
 };
 
 /// Destroy and free a spatial index.
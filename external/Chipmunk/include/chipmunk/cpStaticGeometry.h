@@ -0,0 +1,59 @@
+/* Copyright (c) 2007 Scott Lembcke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/// @defgroup cpStaticGeometry cpStaticGeometry
+/// Static geometry shapes bake thousands of segments and convex polygons into a single shape.
+/// The children are stored in flat arrays and indexed by a private bounding volume hierarchy,
+/// so a large level only costs one entry in the space's static index.
+/// Collisions and queries are dispatched to the children that overlap the other shape.
+/// Children can only be added while the shape is not in a space.
+/// Static geometry never collides with other static geometry.
+/// @{
+
+/// @private
+typedef struct cpStaticGeometry cpStaticGeometry;
+
+/// Allocate a static geometry shape.
+cpStaticGeometry* cpStaticGeometryAlloc(void);
+/// Initialize an empty static geometry shape.
+cpStaticGeometry* cpStaticGeometryInit(cpStaticGeometry *geometry, cpBody *body);
+/// Allocate and initialize an empty static geometry shape.
+cpShape* cpStaticGeometryNew(cpBody *body);
+/// Allocate an empty static geometry shape from @c allocator (NULL for the heap) and initialize it.
+/// The child and hierarchy arrays are counted as shape bytes and come from the same allocator, or the heap if it's a pool.
+/// cpShapeFree() returns everything to the allocator, which must outlive the shape.
+cpShape* cpStaticGeometryNewWithAllocator(cpAllocator *allocator, cpBody *body);
+
+/// Add a segment child and return its index.
+int cpStaticGeometryAddSegment(cpShape *shape, cpVect a, cpVect b, cpFloat radius);
+/// Set the neighbors of a segment child to avoid colliding with the endcaps of connected segments.
+/// See cpSegmentShapeSetNeighbors().
+void cpStaticGeometrySetSegmentNeighbors(cpShape *shape, int idx, cpVect prev, cpVect next);
+/// Add a convex polygon child and return its index.
+/// The vertexes must be convex with a clockwise winding like cpPolyShapeNew().
+int cpStaticGeometryAddPoly(cpShape *shape, int numVerts, const cpVect *verts, cpVect offset);
+
+/// Get the number of segment children.
+int cpStaticGeometryGetNumSegments(cpShape *shape);
+/// Get the number of polygon children.
+int cpStaticGeometryGetNumPolys(cpShape *shape);
+
+/// @}
@@ -35,6 +35,14 @@ cpConstraintFree(cpConstraint *constraint)
 	}
 }
 
+static cpHashValue cpConstraintIDCounter = 0;
+
+void
+cpResetConstraintIdCounter(void)
+{
+	cpConstraintIDCounter = 0;
+}
+
 // *** declared in util.h TODO move declaration to chipmunk_private.h
 
 void
@@ -49,9 +57,13 @@ cpConstraintInit(cpConstraint *constraint, const cpConstraintClass *klass, cpBod
 	constraint->next_a = NULL;
 	constraint->next_b = NULL;
 	
+	constraint->hashid = cpConstraintIDCounter;
+	cpConstraintIDCounter++;
+	
 	constraint->maxForce = (cpFloat)INFINITY;
 	constraint->errorBias = cpfpow(1.0f - 0.1f, 60.0f);
 	constraint->maxBias = (cpFloat)INFINITY;
+	constraint->impulseDelta = (cpFloat)INFINITY;
 	
 	constraint->preSolve = NULL;
 	constraint->postSolve = NULL;
@@ -66,6 +66,8 @@ applyImpulse(cpDampedRotarySpring *spring)
 	cpFloat j_damp = w_damp*spring->iSum;
 	a->w += j_damp*a->i_inv;
 	b->w -= j_damp*b->i_inv;
+	
+	spring->constraint.impulseDelta = cpfabs(j_damp);
 }
 
 static cpFloat
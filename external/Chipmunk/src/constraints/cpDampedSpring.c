@@ -72,6 +72,8 @@ applyImpulse(cpDampedSpring *spring)
 	spring->target_vrn = vrn + v_damp;
 	
 	apply_impulses(a, b, spring->r1, spring->r2, cpvmult(spring->n, v_damp*spring->nMass));
+	
+	spring->constraint.impulseDelta = cpfabs(v_damp*spring->nMass);
 }
 
 static cpFloat
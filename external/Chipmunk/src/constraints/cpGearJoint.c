@@ -68,6 +68,8 @@ applyImpulse(cpGearJoint *joint)
 	// apply impulse
 	a->w -= j*a->i_inv*joint->ratio_inv;
 	b->w += j*b->i_inv;
+	
+	joint->constraint.impulseDelta = cpfabs(j);
 }
 
 static cpFloat
@@ -99,6 +99,8 @@ applyImpulse(cpGrooveJoint *joint)
 	
 	// apply impulse
 	apply_impulses(a, b, joint->r1, joint->r2, j);
+	
+	joint->constraint.impulseDelta = cpvlength(j);
 }
 
 static cpFloat
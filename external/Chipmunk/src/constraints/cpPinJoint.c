@@ -74,6 +74,8 @@ applyImpulse(cpPinJoint *joint)
 	
 	// apply impulse
 	apply_impulses(a, b, joint->r1, joint->r2, cpvmult(n, jn));
+	
+	joint->constraint.impulseDelta = cpfabs(jn);
 }
 
 static cpFloat
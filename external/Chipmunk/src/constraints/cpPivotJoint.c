@@ -71,6 +71,8 @@ applyImpulse(cpPivotJoint *joint)
 	
 	// apply impulse
 	apply_impulses(a, b, joint->r1, joint->r2, j);
+	
+	joint->constraint.impulseDelta = cpvlength(j);
 }
 
 static cpFloat
@@ -70,7 +70,10 @@ applyCachedImpulse(cpRatchetJoint *joint, cpFloat dt_coef)
 static void
 applyImpulse(cpRatchetJoint *joint)
 {
-	if(!joint->bias) return; // early exit
+	if(!joint->bias){ // early exit
+		joint->constraint.impulseDelta = 0.0f;
+		return;
+	}
 
 	cpBody *a = joint->constraint.a;
 	cpBody *b = joint->constraint.b;
@@ -88,6 +91,8 @@ applyImpulse(cpRatchetJoint *joint)
 	// apply impulse
 	a->w -= j*a->i_inv;
 	b->w += j*b->i_inv;
+	
+	joint->constraint.impulseDelta = cpfabs(j);
 }
 
 static cpFloat
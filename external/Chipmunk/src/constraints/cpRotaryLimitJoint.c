@@ -64,7 +64,10 @@ applyCachedImpulse(cpRotaryLimitJoint *joint, cpFloat dt_coef)
 static void
 applyImpulse(cpRotaryLimitJoint *joint)
 {
-	if(!joint->bias) return; // early exit
+	if(!joint->bias){ // early exit
+		joint->constraint.impulseDelta = 0.0f;
+		return;
+	}
 
 	cpBody *a = joint->constraint.a;
 	cpBody *b = joint->constraint.b;
@@ -85,6 +88,8 @@ applyImpulse(cpRotaryLimitJoint *joint)
 	// apply impulse
 	a->w -= j*a->i_inv;
 	b->w += j*b->i_inv;
+	
+	joint->constraint.impulseDelta = cpfabs(j);
 }
 
 static cpFloat
@@ -64,6 +64,8 @@ applyImpulse(cpSimpleMotor *joint)
 	// apply impulse
 	a->w -= j*a->i_inv;
 	b->w += j*b->i_inv;
+	
+	joint->constraint.impulseDelta = cpfabs(j);
 }
 
 static cpFloat
@@ -69,7 +69,10 @@ applyCachedImpulse(cpSlideJoint *joint, cpFloat dt_coef)
 static void
 applyImpulse(cpSlideJoint *joint)
 {
-	if(cpveql(joint->n, cpvzero)) return;  // early exit
+	if(cpveql(joint->n, cpvzero)){ // early exit
+		joint->constraint.impulseDelta = 0.0f;
+		return;
+	}
 
 	cpBody *a = joint->constraint.a;
 	cpBody *b = joint->constraint.b;
@@ -90,6 +93,8 @@ applyImpulse(cpSlideJoint *joint)
 	
 	// apply impulse
 	apply_impulses(a, b, joint->r1, joint->r2, cpvmult(n, jn));
+	
+	joint->constraint.impulseDelta = cpfabs(jn);
 }
 
 static cpFloat
@@ -0,0 +1,310 @@
+/* Copyright (c) 2012 Scott Lembcke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <string.h>
+
+#include "chipmunk_private.h"
+
+// All blocks are aligned to 16 bytes so they are safe to use for any Chipmunk struct.
+#define ALLOCATOR_ALIGN(size) (((size) + 15) & ~(size_t)15)
+
+cpAllocator *
+cpAllocatorInit(cpAllocator *allocator, const cpAllocatorClass *klass)
+{
+	allocator->klass = klass;
+	
+	for(int i=0; i<CP_ALLOCATOR_NUM_CATEGORIES; i++) allocator->bytes[i] = 0;
+	allocator->peakBytes = 0;
+	
+	return allocator;
+}
+
+void
+cpAllocatorFree(cpAllocator *allocator)
+{
+	if(allocator){
+		cpAllocatorDestroy(allocator);
+		cpfree(allocator);
+	}
+}
+
+//MARK: Heap Allocator
+
+static void HeapDestroy(cpAllocator *allocator){}
+static void *HeapAlloc(cpAllocator *allocator, size_t size){return cpcalloc(1, size);}
+static void HeapFree(cpAllocator *allocator, void *ptr, size_t size){cpfree(ptr);}
+
+static const cpAllocatorClass HeapKlass = {
+	(cpAllocatorDestroyImpl)HeapDestroy,
+	(cpAllocatorAllocImpl)HeapAlloc,
+	(cpAllocatorFreeImpl)HeapFree,
+};
+
+cpAllocator *
+cpHeapAllocatorInit(cpAllocator *allocator)
+{
+	return cpAllocatorInit(allocator, &HeapKlass);
+}
+
+cpAllocator *
+cpHeapAllocatorNew(void)
+{
+	return cpHeapAllocatorInit((cpAllocator *)cpcalloc(1, sizeof(cpAllocator)));
+}
+
+//MARK: Arena Allocator
+
+struct cpArenaAllocator {
+	cpAllocator allocator;
+	
+	size_t chunkSize;
+	cpArray *chunks;
+	cpArray *largeChunks;
+	
+	char *cursor;
+	size_t remaining;
+};
+
+static const cpAllocatorClass ArenaKlass;
+
+cpArenaAllocator *
+cpArenaAllocatorAlloc(void)
+{
+	return (cpArenaAllocator *)cpcalloc(1, sizeof(cpArenaAllocator));
+}
+
+cpAllocator *
+cpArenaAllocatorInit(cpArenaAllocator *arena, size_t chunkSize)
+{
+	cpAllocatorInit((cpAllocator *)arena, &ArenaKlass);
+	
+	arena->chunkSize = ALLOCATOR_ALIGN(chunkSize ? chunkSize : 16*CP_BUFFER_BYTES);
+	arena->chunks = cpArrayNew(0);
+	arena->largeChunks = cpArrayNew(0);
+	
+	arena->cursor = NULL;
+	arena->remaining = 0;
+	
+	return (cpAllocator *)arena;
+}
+
+cpAllocator *
+cpArenaAllocatorNew(size_t chunkSize)
+{
+	return cpArenaAllocatorInit(cpArenaAllocatorAlloc(), chunkSize);
+}
+
+static void
+ArenaDestroy(cpArenaAllocator *arena)
+{
+	if(arena->chunks){
+		cpArrayFreeEach(arena->chunks, cpfree);
+		cpArrayFree(arena->chunks);
+		arena->chunks = NULL;
+	}
+	
+	if(arena->largeChunks){
+		cpArrayFreeEach(arena->largeChunks, cpfree);
+		cpArrayFree(arena->largeChunks);
+		arena->largeChunks = NULL;
+	}
+}
+
+static void *
+ArenaAlloc(cpArenaAllocator *arena, size_t size)
+{
+	size = ALLOCATOR_ALIGN(size);
+	
+	if(size > arena->remaining){
+		if(size > arena->chunkSize/4){
+			// Large allocations get their own chunk so they don't waste the rest of the current one.
+			char *chunk = (char *)cpcalloc(1, size);
+			cpArrayPush(arena->largeChunks, chunk);
+			
+			return chunk;
+		}
+		
+		char *chunk = (char *)cpcalloc(1, arena->chunkSize);
+		cpArrayPush(arena->chunks, chunk);
+		
+		arena->cursor = chunk;
+		arena->remaining = arena->chunkSize;
+	}
+	
+	void *ptr = arena->cursor;
+	arena->cursor += size;
+	arena->remaining -= size;
+	
+	return ptr;
+}
+
+// No free function, memory is released when the arena is reset.
+static const cpAllocatorClass ArenaKlass = {
+	(cpAllocatorDestroyImpl)ArenaDestroy,
+	(cpAllocatorAllocImpl)ArenaAlloc,
+	NULL,
+};
+
+void
+cpArenaAllocatorReset(cpAllocator *allocator)
+{
+	if(allocator->klass != &ArenaKlass){
+		cpAssertWarn(cpFalse, "Ignoring cpArenaAllocatorReset() call to non-arena allocator.");
+		return;
+	}
+	
+	cpArenaAllocator *arena = (cpArenaAllocator *)allocator;
+	
+	cpArray *largeChunks = arena->largeChunks;
+	for(int i=0; i<largeChunks->num; i++) cpfree(largeChunks->arr[i]);
+	largeChunks->num = 0;
+	
+	// Keep the first chunk around since it's very likely to be needed again.
+	cpArray *chunks = arena->chunks;
+	for(int i=1; i<chunks->num; i++) cpfree(chunks->arr[i]);
+	
+	if(chunks->num > 0){
+		chunks->num = 1;
+		
+		char *first = (char *)chunks->arr[0];
+		memset(first, 0, arena->chunkSize);
+		
+		arena->cursor = first;
+		arena->remaining = arena->chunkSize;
+	} else {
+		arena->cursor = NULL;
+		arena->remaining = 0;
+	}
+	
+	for(int i=0; i<CP_ALLOCATOR_NUM_CATEGORIES; i++) allocator->bytes[i] = 0;
+}
+
+//MARK: Pool Allocator
+
+typedef struct PoolBlock PoolBlock;
+struct PoolBlock { PoolBlock *next; };
+
+struct cpPoolAllocator {
+	cpAllocator allocator;
+	
+	size_t blockSize;
+	PoolBlock *pooledBlocks;
+	cpArray *allocatedBuffers;
+};
+
+static const cpAllocatorClass PoolKlass;
+
+cpPoolAllocator *
+cpPoolAllocatorAlloc(void)
+{
+	return (cpPoolAllocator *)cpcalloc(1, sizeof(cpPoolAllocator));
+}
+
+cpAllocator *
+cpPoolAllocatorInit(cpPoolAllocator *pool, size_t blockSize)
+{
+	cpAllocatorInit((cpAllocator *)pool, &PoolKlass);
+	
+	pool->blockSize = ALLOCATOR_ALIGN(blockSize > sizeof(PoolBlock) ? blockSize : sizeof(PoolBlock));
+	pool->pooledBlocks = NULL;
+	pool->allocatedBuffers = cpArrayNew(0);
+	
+	return (cpAllocator *)pool;
+}
+
+cpAllocator *
+cpPoolAllocatorNew(size_t blockSize)
+{
+	return cpPoolAllocatorInit(cpPoolAllocatorAlloc(), blockSize);
+}
+
+static void
+PoolDestroy(cpPoolAllocator *pool)
+{
+	if(pool->allocatedBuffers){
+		cpArrayFreeEach(pool->allocatedBuffers, cpfree);
+		cpArrayFree(pool->allocatedBuffers);
+		pool->allocatedBuffers = NULL;
+	}
+}
+
+static inline void
+PoolRecycle(cpPoolAllocator *pool, PoolBlock *block)
+{
+	block->next = pool->pooledBlocks;
+	pool->pooledBlocks = block;
+}
+
+static void *
+PoolAlloc(cpPoolAllocator *pool, size_t size)
+{
+	cpAssertHard(size <= pool->blockSize, "Allocation is larger than the block size of the pool.");
+	
+	PoolBlock *block = pool->pooledBlocks;
+	if(block){
+		pool->pooledBlocks = block->next;
+		memset(block, 0, pool->blockSize);
+		
+		return block;
+	} else {
+		// Pool is exhausted, make more
+		size_t blockSize = pool->blockSize;
+		int count = (int)(CP_BUFFER_BYTES/blockSize);
+		if(count < 8) count = 8;
+		
+		char *buffer = (char *)cpcalloc(count, blockSize);
+		cpArrayPush(pool->allocatedBuffers, buffer);
+		
+		// push all but the first one, return it instead
+		for(int i=1; i<count; i++) PoolRecycle(pool, (PoolBlock *)(buffer + i*blockSize));
+		return buffer;
+	}
+}
+
+static void
+PoolFree(cpPoolAllocator *pool, void *ptr, size_t size)
+{
+	if(ptr) PoolRecycle(pool, (PoolBlock *)ptr);
+}
+
+static const cpAllocatorClass PoolKlass = {
+	(cpAllocatorDestroyImpl)PoolDestroy,
+	(cpAllocatorAllocImpl)PoolAlloc,
+	(cpAllocatorFreeImpl)PoolFree,
+};
+
+cpBool
+cpAllocatorIsPool(const cpAllocator *allocator)
+{
+	return (allocator && allocator->klass == &PoolKlass);
+}
+
+cpAllocator *
+cpAllocatorForObject(cpAllocator *allocator, size_t size)
+{
+	if(cpAllocatorIsPool(allocator) && size > ((cpPoolAllocator *)allocator)->blockSize){
+		cpAssertWarn(cpFalse, "Object is larger than the block size of the pool, allocating it on the heap instead.");
+		return NULL;
+	} else {
+		return allocator;
+	}
+}
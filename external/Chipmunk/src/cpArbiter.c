@@ -298,13 +298,14 @@ cpArbiterApplyCachedImpulse(cpArbiter *arb, cpFloat dt_coef)
 
 // TODO is it worth splitting velocity/position correction?
 
-void
+cpFloat
 cpArbiterApplyImpulse(cpArbiter *arb)
 {
 	cpBody *a = arb->body_a;
 	cpBody *b = arb->body_b;
 	cpVect surface_vr = arb->surface_vr;
 	cpFloat friction = arb->u;
+	cpFloat maxDelta = 0.0f;
 
 	for(int i=0; i<arb->numContacts; i++){
 		cpContact *con = &arb->contacts[i];
@@ -334,7 +335,14 @@ cpArbiterApplyImpulse(cpArbiter *arb)
 		cpFloat jtOld = con->jtAcc;
 		con->jtAcc = cpfclamp(jtOld + jt, -jtMax, jtMax);
 		
-		apply_bias_impulses(a, b, r1, r2, cpvmult(n, con->jBias - jbnOld));
-		apply_impulses(a, b, r1, r2, cpvrotate(n, cpv(con->jnAcc - jnOld, con->jtAcc - jtOld)));
+		cpFloat dBias = con->jBias - jbnOld;
+		cpFloat dn = con->jnAcc - jnOld;
+		cpFloat dt = con->jtAcc - jtOld;
+		apply_bias_impulses(a, b, r1, r2, cpvmult(n, dBias));
+		apply_impulses(a, b, r1, r2, cpvrotate(n, cpv(dn, dt)));
+		
+		maxDelta = cpfmax(maxDelta, cpfmax(cpfabs(dBias), cpfmax(cpfabs(dn), cpfabs(dt))));
 	}
+	
+	return maxDelta;
 }
@@ -84,8 +84,13 @@ GetBB(cpBBTree *tree, void *obj)
 	cpBBTreeVelocityFunc velocityFunc = tree->velocityFunc;
 	if(velocityFunc){
 		cpFloat coef = 0.1f;
-		cpFloat x = (bb.r - bb.l)*coef;
-		cpFloat y = (bb.t - bb.b)*coef;
+		
+		// Expand by at least a few ulps of the bb's coordinates.
+		// Otherwise small objects far from the origin would be reinserted every step
+		// due to rounding noise when using single precision floats.
+		cpFloat margin = 16.0f*CPFLOAT_EPSILON*cpfmax(cpfmax(cpfabs(bb.l), cpfabs(bb.r)), cpfmax(cpfabs(bb.b), cpfabs(bb.t)));
+		cpFloat x = cpfmax((bb.r - bb.l)*coef, margin);
+		cpFloat y = cpfmax((bb.t - bb.b)*coef, margin);
 		
 		cpVect v = cpvmult(velocityFunc(obj), 0.1f);
 		return cpBBNew(bb.l + cpfmin(-x, v.x), bb.b + cpfmin(-y, v.y), bb.r + cpfmax(x, v.x), bb.t + cpfmax(y, v.y));
@@ -145,7 +150,7 @@ PairFromPool(cpBBTree *tree)
 		int count = CP_BUFFER_BYTES/sizeof(Pair);
 		cpAssertHard(count, "Internal Error: Buffer size is too small.");
 		
-		Pair *buffer = (Pair *)cpcalloc(1, CP_BUFFER_BYTES);
+		Pair *buffer = (Pair *)cpAllocatorAllocOrHeap(tree->spatialIndex.allocator, CP_BUFFER_BYTES, CP_ALLOCATOR_MISC);
 		cpArrayPush(tree->allocatedBuffers, buffer);
 		
 		// push all but the first one, return the first instead
@@ -234,7 +239,7 @@ NodeFromPool(cpBBTree *tree)
 		int count = CP_BUFFER_BYTES/sizeof(Node);
 		cpAssertHard(count, "Internal Error: Buffer size is too small.");
 		
-		Node *buffer = (Node *)cpcalloc(1, CP_BUFFER_BYTES);
+		Node *buffer = (Node *)cpAllocatorAllocOrHeap(tree->spatialIndex.allocator, CP_BUFFER_BYTES, CP_ALLOCATOR_MISC);
 		cpArrayPush(tree->allocatedBuffers, buffer);
 		
 		// push all but the first one, return the first instead
@@ -580,15 +585,34 @@ cpBBTreeNew(cpSpatialIndexBBFunc bbfunc, cpSpatialIndex *staticIndex)
 	return cpBBTreeInit(cpBBTreeAlloc(), bbfunc, staticIndex);
 }
 
+static void
+FreeBuffers(cpBBTree *tree)
+{
+	cpArray *buffers = tree->allocatedBuffers;
+	for(int i=0; i<buffers->num; i++) cpAllocatorFreeOrHeap(tree->spatialIndex.allocator, buffers->arr[i], CP_BUFFER_BYTES, CP_ALLOCATOR_MISC);
+	buffers->num = 0;
+	
+	tree->pooledNodes = NULL;
+	tree->pooledPairs = NULL;
+}
+
 static void
 cpBBTreeDestroy(cpBBTree *tree)
 {
 	cpHashSetFree(tree->leaves);
 	
-	if(tree->allocatedBuffers) cpArrayFreeEach(tree->allocatedBuffers, cpfree);
+	FreeBuffers(tree);
 	cpArrayFree(tree->allocatedBuffers);
 }
 
+static void
+cpBBTreeSetAllocator(cpBBTree *tree, cpAllocator *allocator)
+{
+	// The tree is empty, but it may still have pooled nodes and pairs from the old allocator.
+	FreeBuffers(tree);
+	cpHashSetSetAllocator(tree->leaves, allocator);
+}
+
 //MARK: Insert/Remove
 
 static void
@@ -709,6 +733,8 @@ static cpSpatialIndexClass klass = {
 	
 	(cpSpatialIndexQueryImpl)cpBBTreeQuery,
 	(cpSpatialIndexSegmentQueryImpl)cpBBTreeSegmentQuery,
+	
+	(cpSpatialIndexSetAllocatorImpl)cpBBTreeSetAllocator,
 };
 
 static inline cpSpatialIndexClass *Klass(){return &klass;}
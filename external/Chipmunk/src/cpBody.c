@@ -22,6 +22,13 @@
 #include <float.h>
 
 #include "chipmunk_private.h"
+
+// cpVect is a pair of doubles that fits exactly in one SSE2 register.
+// The integrators below use it for the vector math of a single body. Float builds stay scalar.
+#if CP_USE_DOUBLES && (defined(__SSE2__) || defined(_M_X64))
+	#define CP_BODY_USE_SSE2 1
+	#include <emmintrin.h>
+#endif
 #include "constraints/util.h"
 
 // initialized in cpInitChipmunk()
@@ -30,7 +37,17 @@ cpBody cpStaticBodySingleton;
 cpBody*
 cpBodyAlloc(void)
 {
-	return (cpBody *)cpcalloc(1, sizeof(cpBody));
+	return cpBodyAllocWithAllocator(NULL);
+}
+
+cpBody*
+cpBodyAllocWithAllocator(cpAllocator *allocator)
+{
+	allocator = cpAllocatorForObject(allocator, sizeof(cpBody));
+	cpBody *body = (cpBody *)cpAllocatorAllocOrHeap(allocator, sizeof(cpBody), CP_ALLOCATOR_BODIES);
+	body->allocator = allocator;
+	
+	return body;
 }
 
 cpBody *
@@ -44,7 +61,7 @@ cpBodyInit(cpBody *body, cpFloat m, cpFloat i)
 	body->velocity_func = cpBodyUpdateVelocity;
 	body->position_func = cpBodyUpdatePosition;
 	
-	cpComponentNode node = {NULL, NULL, 0.0f};
+	cpComponentNode node = {NULL, NULL, 0.0f, NULL, 0};
 	body->node = node;
 	
 	body->p = cpvzero;
@@ -76,6 +93,12 @@ cpBodyNew(cpFloat m, cpFloat i)
 	return cpBodyInit(cpBodyAlloc(), m, i);
 }
 
+cpBody*
+cpBodyNewWithAllocator(cpAllocator *allocator, cpFloat m, cpFloat i)
+{
+	return cpBodyInit(cpBodyAllocWithAllocator(allocator), m, i);
+}
+
 cpBody *
 cpBodyInitStatic(cpBody *body)
 {
@@ -98,7 +121,7 @@ cpBodyFree(cpBody *body)
 {
 	if(body){
 		cpBodyDestroy(body);
-		cpfree(body);
+		cpAllocatorFreeOrHeap(body->allocator, body, sizeof(cpBody), CP_ALLOCATOR_BODIES);
 	}
 }
 
@@ -250,6 +273,89 @@ cpBodyUpdatePosition(cpBody *body, cpFloat dt)
 	cpBodySanityCheck(body);
 }
 
+//MARK: Batch Integration
+
+// Integrate the velocity of a body using the default integrator.
+// Must produce the same results as cpBodyUpdateVelocity().
+static inline void
+UpdateVelocityDefault(cpBody *body, cpVect gravity, cpFloat damping, cpFloat dt)
+{
+#if CP_BODY_USE_SSE2
+	__m128d f = _mm_loadu_pd(&body->f.x);
+	__m128d g = _mm_loadu_pd(&gravity.x);
+	__m128d v = _mm_loadu_pd(&body->v.x);
+	
+	__m128d a = _mm_add_pd(g, _mm_mul_pd(f, _mm_set1_pd(body->m_inv)));
+	v = _mm_add_pd(_mm_mul_pd(v, _mm_set1_pd(damping)), _mm_mul_pd(a, _mm_set1_pd(dt)));
+	_mm_storeu_pd(&body->v.x, v);
+	
+	body->v = cpvclamp(body->v, body->v_limit);
+#else
+	body->v = cpvclamp(cpvadd(cpvmult(body->v, damping), cpvmult(cpvadd(gravity, cpvmult(body->f, body->m_inv)), dt)), body->v_limit);
+#endif
+	
+	cpFloat w_limit = body->w_limit;
+	body->w = cpfclamp(body->w*damping + body->t*body->i_inv*dt, -w_limit, w_limit);
+	
+	cpBodySanityCheck(body);
+}
+
+// Integrate the position of a body using the default integrator.
+// Must produce the same results as cpBodyUpdatePosition().
+static inline void
+UpdatePositionDefault(cpBody *body, cpFloat dt)
+{
+#if CP_BODY_USE_SSE2
+	__m128d p = _mm_loadu_pd(&body->p.x);
+	__m128d v = _mm_add_pd(_mm_loadu_pd(&body->v.x), _mm_loadu_pd(&body->v_bias.x));
+	_mm_storeu_pd(&body->p.x, _mm_add_pd(p, _mm_mul_pd(v, _mm_set1_pd(dt))));
+	_mm_storeu_pd(&body->v_bias.x, _mm_setzero_pd());
+#else
+	body->p = cpvadd(body->p, cpvmult(cpvadd(body->v, body->v_bias), dt));
+	body->v_bias = cpvzero;
+#endif
+	
+	setAngle(body, body->a + (body->w + body->w_bias)*dt);
+	body->w_bias = 0.0f;
+	
+	cpBodySanityCheck(body);
+}
+
+void
+cpBodyIntegrateVelocities(cpArray *bodies, cpVect gravity, cpFloat damping, cpFloat dt)
+{
+	cpBody **arr = (cpBody **)bodies->arr;
+	
+	for(int i=0, count=bodies->num; i<count; i++){
+		cpBody *body = arr[i];
+		cpBodyVelocityFunc velocity_func = body->velocity_func;
+		
+		// Avoid the indirect call for the bodies using the default integrator.
+		if(velocity_func == cpBodyUpdateVelocity){
+			UpdateVelocityDefault(body, gravity, damping, dt);
+		} else {
+			velocity_func(body, gravity, damping, dt);
+		}
+	}
+}
+
+void
+cpBodyIntegratePositions(cpArray *bodies, cpFloat dt)
+{
+	cpBody **arr = (cpBody **)bodies->arr;
+	
+	for(int i=0, count=bodies->num; i<count; i++){
+		cpBody *body = arr[i];
+		cpBodyPositionFunc position_func = body->position_func;
+		
+		if(position_func == cpBodyUpdatePosition){
+			UpdatePositionDefault(body, dt);
+		} else {
+			position_func(body, dt);
+		}
+	}
+}
+
 void
 cpBodyResetForces(cpBody *body)
 {
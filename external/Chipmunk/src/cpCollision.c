@@ -322,16 +322,69 @@ circle2poly(const cpShape *shape1, const cpShape *shape2, cpContact *con)
 	}
 }
 
-static const collisionFunc builtinCollisionFuncs[9] = {
+struct GeometryContext {
+	const cpShape *shape;
+	cpContact *arr;
+	int count;
+};
+
+// Collide the shape against a single static geometry child and merge the contacts.
+static void
+shape2geometryChild(const cpShape *child, cpHashValue childHash, struct GeometryContext *context)
+{
+	const cpShape *shape = context->shape;
+	cpContact contacts[CP_MAX_CONTACTS_PER_ARBITER];
+	
+	// The contact normals must point from the shape towards the geometry.
+	cpBool swapped = (child->klass->type < shape->klass->type);
+	int count = (swapped ? cpCollideShapes(child, shape, contacts) : cpCollideShapes(shape, child, contacts));
+	
+	for(int i=0; i<count; i++){
+		cpContact con = contacts[i];
+		if(swapped) con.n = cpvneg(con.n);
+		// Contacts from different children must not share a hash or they would share cached impulses.
+		con.hash = CP_HASH_PAIR(con.hash, childHash);
+		
+		if(context->count < CP_MAX_CONTACTS_PER_ARBITER){
+			context->arr[context->count++] = con;
+		} else {
+			// Keep the deepest contacts when the arbiter is full.
+			int shallowest = 0;
+			for(int j=1; j<CP_MAX_CONTACTS_PER_ARBITER; j++){
+				if(context->arr[j].dist > context->arr[shallowest].dist) shallowest = j;
+			}
+			
+			if(con.dist < context->arr[shallowest].dist) context->arr[shallowest] = con;
+		}
+	}
+}
+
+static int
+shape2geometry(const cpShape *shape, const cpShape *geometry, cpContact *arr)
+{
+	struct GeometryContext context = {shape, arr, 0};
+	cpStaticGeometryEachChild(geometry, shape->bb, (cpStaticGeometryChildFunc)shape2geometryChild, &context);
+	
+	return context.count;
+}
+
+static const collisionFunc builtinCollisionFuncs[CP_NUM_SHAPES*CP_NUM_SHAPES] = {
 	circle2circle,
 	NULL,
 	NULL,
+	NULL,
 	(collisionFunc)circle2segment,
 	NULL,
 	NULL,
+	NULL,
 	circle2poly,
 	seg2poly,
 	poly2poly,
+	NULL,
+	shape2geometry,
+	shape2geometry,
+	shape2geometry,
+	NULL,
 };
 static const collisionFunc *colfuncs = builtinCollisionFuncs;
 
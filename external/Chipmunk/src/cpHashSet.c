@@ -37,16 +37,27 @@ struct cpHashSet {
 	cpHashSetBin **table;
 	cpHashSetBin *pooledBins;
 	
+	cpAllocator *allocator;
 	cpArray *allocatedBuffers;
 };
 
+static void
+FreeBuffers(cpHashSet *set)
+{
+	cpArray *buffers = set->allocatedBuffers;
+	for(int i=0; i<buffers->num; i++) cpAllocatorFreeOrHeap(set->allocator, buffers->arr[i], CP_BUFFER_BYTES, CP_ALLOCATOR_MISC);
+	buffers->num = 0;
+	
+	set->pooledBins = NULL;
+}
+
 void
 cpHashSetFree(cpHashSet *set)
 {
 	if(set){
 		cpfree(set->table);
 		
-		cpArrayFreeEach(set->allocatedBuffers, cpfree);
+		FreeBuffers(set);
 		cpArrayFree(set->allocatedBuffers);
 		
 		cpfree(set);
@@ -67,6 +78,7 @@ cpHashSetNew(int size, cpHashSetEqlFunc eqlFunc)
 	set->table = (cpHashSetBin **)cpcalloc(set->size, sizeof(cpHashSetBin *));
 	set->pooledBins = NULL;
 	
+	set->allocator = NULL;
 	set->allocatedBuffers = cpArrayNew(0);
 	
 	return set;
@@ -78,6 +90,16 @@ cpHashSetSetDefaultValue(cpHashSet *set, void *default_value)
 	set->default_value = default_value;
 }
 
+void
+cpHashSetSetAllocator(cpHashSet *set, cpAllocator *allocator)
+{
+	cpAssertHard(set->entries == 0, "Internal Error: Cannot change the allocator of a hash set that isn't empty.");
+	
+	// Return any pooled bins to the old allocator.
+	FreeBuffers(set);
+	set->allocator = allocator;
+}
+
 static int
 setIsFull(cpHashSet *set)
 {
@@ -134,7 +156,7 @@ getUnusedBin(cpHashSet *set)
 		int count = CP_BUFFER_BYTES/sizeof(cpHashSetBin);
 		cpAssertHard(count, "Internal Error: Buffer size is too small.");
 		
-		cpHashSetBin *buffer = (cpHashSetBin *)cpcalloc(1, CP_BUFFER_BYTES);
+		cpHashSetBin *buffer = (cpHashSetBin *)cpAllocatorAllocOrHeap(set->allocator, CP_BUFFER_BYTES, CP_ALLOCATOR_MISC);
 		cpArrayPush(set->allocatedBuffers, buffer);
 		
 		// push all but the first one, return it instead
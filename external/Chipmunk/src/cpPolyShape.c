@@ -22,54 +22,70 @@
 #include "chipmunk_private.h"
 #include "chipmunk_unsafe.h"
 
+// cpVect is a pair of doubles that fits exactly in one SSE2 register.
+#if CP_USE_DOUBLES && (defined(__SSE2__) || defined(_M_X64))
+	#define CP_POLY_USE_SSE2 1
+	#include <emmintrin.h>
+#endif
+
 cpPolyShape *
 cpPolyShapeAlloc(void)
 {
-	return (cpPolyShape *)cpcalloc(1, sizeof(cpPolyShape));
+	return (cpPolyShape *)cpShapeAllocBytes(NULL, sizeof(cpPolyShape));
 }
 
+// Transform the vertexes and splitting planes in a single pass over the contiguous arrays.
 static cpBB
-cpPolyShapeTransformVerts(cpPolyShape *poly, cpVect p, cpVect rot)
+cpPolyShapeCacheData(cpPolyShape *poly, cpVect p, cpVect rot)
 {
-	cpVect *src = poly->verts;
-	cpVect *dst = poly->tVerts;
+	int count = poly->numVerts;
+	cpVect *srcVerts = poly->verts, *dstVerts = poly->tVerts;
+	cpSplittingPlane *srcPlanes = poly->planes, *dstPlanes = poly->tPlanes;
 	
+#if CP_POLY_USE_SSE2
+	__m128d pos = _mm_loadu_pd(&p.x);
+	__m128d r = _mm_set_pd(rot.y, rot.x);
+	__m128d rperp = _mm_set_pd(rot.x, -rot.y);
+	__m128d min = _mm_set1_pd(INFINITY), max = _mm_set1_pd(-INFINITY);
+	
+	for(int i=0; i<count; i++){
+		// cpvrotate(v, rot) == v.x*rot + v.y*cpvperp(rot)
+		__m128d v = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(srcVerts[i].x), r), _mm_mul_pd(_mm_set1_pd(srcVerts[i].y), rperp));
+		v = _mm_add_pd(pos, v);
+		_mm_storeu_pd(&dstVerts[i].x, v);
+		min = _mm_min_pd(min, v);
+		max = _mm_max_pd(max, v);
+		
+		cpVect n = srcPlanes[i].n;
+		_mm_storeu_pd(&dstPlanes[i].n.x, _mm_add_pd(_mm_mul_pd(_mm_set1_pd(n.x), r), _mm_mul_pd(_mm_set1_pd(n.y), rperp)));
+		dstPlanes[i].d = cpvdot(p, dstPlanes[i].n) + srcPlanes[i].d;
+	}
+	
+	cpVect l, h;
+	_mm_storeu_pd(&l.x, min);
+	_mm_storeu_pd(&h.x, max);
+	cpBB bb = cpBBNew(l.x, l.y, h.x, h.y);
+#else
 	cpFloat l = (cpFloat)INFINITY, r = -(cpFloat)INFINITY;
 	cpFloat b = (cpFloat)INFINITY, t = -(cpFloat)INFINITY;
 	
-	for(int i=0; i<poly->numVerts; i++){
-		cpVect v = cpvadd(p, cpvrotate(src[i], rot));
-		
-		dst[i] = v;
+	for(int i=0; i<count; i++){
+		cpVect v = cpvadd(p, cpvrotate(srcVerts[i], rot));
+		dstVerts[i] = v;
 		l = cpfmin(l, v.x);
 		r = cpfmax(r, v.x);
 		b = cpfmin(b, v.y);
 		t = cpfmax(t, v.y);
+		
+		cpVect n = cpvrotate(srcPlanes[i].n, rot);
+		dstPlanes[i].n = n;
+		dstPlanes[i].d = cpvdot(p, n) + srcPlanes[i].d;
 	}
 	
-	return cpBBNew(l, b, r, t);
-}
-
-static void
-cpPolyShapeTransformAxes(cpPolyShape *poly, cpVect p, cpVect rot)
-{
-	cpSplittingPlane *src = poly->planes;
-	cpSplittingPlane *dst = poly->tPlanes;
-	
-	for(int i=0; i<poly->numVerts; i++){
-		cpVect n = cpvrotate(src[i].n, rot);
-		dst[i].n = n;
-		dst[i].d = cpvdot(p, n) + src[i].d;
-	}
-}
-
-static cpBB
-cpPolyShapeCacheData(cpPolyShape *poly, cpVect p, cpVect rot)
-{
-	cpPolyShapeTransformAxes(poly, p, rot);
-	cpBB bb = poly->shape.bb = cpPolyShapeTransformVerts(poly, p, rot);
+	cpBB bb = cpBBNew(l, b, r, t);
+#endif
 	
-	return bb;
+	return (poly->shape.bb = bb);
 }
 
 static void
@@ -91,9 +107,12 @@ cpPolyShapeNearestPointQuery(cpPolyShape *poly, cpVect p, cpNearestPointQueryInf
 	cpBool outside = cpFalse;
 	
 	for(int i=0; i<count; i++){
-		if(cpSplittingPlaneCompare(planes[i], p) > 0.0f) outside = cpTrue;
-		
 		cpVect v1 = verts[i];
+		
+		// Measure against a point on the plane instead of using the plane's distance from the origin.
+		// This avoids cancellation errors with single precision floats when the poly is far from the origin.
+		if(cpvdot(planes[i].n, cpvsub(p, v1)) > 0.0f) outside = cpTrue;
+		
 		cpVect closest = cpClosetPointOnSegment(p, v0, v1);
 		
 		cpFloat dist = cpvdist(p, closest);
@@ -117,34 +136,47 @@ cpPolyShapeSegmentQuery(cpPolyShape *poly, cpVect a, cpVect b, cpSegmentQueryInf
 	cpVect *verts = poly->tVerts;
 	int numVerts = poly->numVerts;
 	
+	cpVect delta = cpvsub(b, a);
+	cpFloat deltaSize = cpfabs(delta.x) + cpfabs(delta.y);
+	cpFloat tMin = INFINITY;
+	
+	// All values are calculated relative to the start of the edge to avoid cancellation errors
+	// when using single precision floats far from the origin.
 	for(int i=0; i<numVerts; i++){
 		cpVect n = axes[i].n;
-		cpFloat an = cpvdot(a, n);
-		if(axes[i].d > an) continue;
+		cpVect v0 = verts[i];
+		cpVect rel = cpvsub(a, v0);
+		
+		cpFloat an = cpvdot(rel, n);
+		if(an < 0.0f) continue;
 		
-		cpFloat bn = cpvdot(b, n);
-		cpFloat t = (axes[i].d - an)/(bn - an);
-		if(t < 0.0f || 1.0f < t) continue;
+		// Skip edges the segment is parallel to or moving away from.
+		cpFloat dn = cpvdot(delta, n);
+		if(dn >= 0.0f) continue;
 		
-		cpVect point = cpvlerp(a, b, t);
-		cpFloat dt = -cpvcross(n, point);
-		cpFloat dtMin = -cpvcross(n, verts[i]);
-		cpFloat dtMax = -cpvcross(n, verts[(i+1)%numVerts]);
+		cpFloat t = -an/dn;
+		if(1.0f < t || t >= tMin) continue;
 		
-		if(dtMin <= dt && dt <= dtMax){
+		// Allow a few ulps of slop so segments passing through a vertex can't slip between two edges.
+		cpFloat edgeLength = -cpvcross(n, cpvsub(verts[(i+1)%numVerts], v0));
+		cpFloat slop = 4.0f*CPFLOAT_EPSILON*(edgeLength + deltaSize);
+		cpFloat dt = -cpvcross(n, cpvadd(rel, cpvmult(delta, t)));
+		
+		if(-slop <= dt && dt <= edgeLength + slop){
 			info->shape = (cpShape *)poly;
-			info->t = t;
+			info->t = tMin = t;
 			info->n = n;
 		}
 	}
 }
 
-static const cpShapeClass polyClass = {
+const cpShapeClass cpPolyShapeClass = {
 	CP_POLY_SHAPE,
 	(cpShapeCacheDataImpl)cpPolyShapeCacheData,
 	(cpShapeDestroyImpl)cpPolyShapeDestroy,
 	(cpShapeNearestPointQueryImpl)cpPolyShapeNearestPointQuery,
 	(cpShapeSegmentQueryImpl)cpPolyShapeSegmentQuery,
+	sizeof(cpPolyShape),
 };
 
 cpBool
@@ -166,14 +198,14 @@ cpPolyValidate(const cpVect *verts, const int numVerts)
 int
 cpPolyShapeGetNumVerts(cpShape *shape)
 {
-	cpAssertHard(shape->klass == &polyClass, "Shape is not a poly shape.");
+	cpAssertHard(shape->klass == &cpPolyShapeClass, "Shape is not a poly shape.");
 	return ((cpPolyShape *)shape)->numVerts;
 }
 
 cpVect
 cpPolyShapeGetVert(cpShape *shape, int idx)
 {
-	cpAssertHard(shape->klass == &polyClass, "Shape is not a poly shape.");
+	cpAssertHard(shape->klass == &cpPolyShapeClass, "Shape is not a poly shape.");
 	cpAssertHard(0 <= idx && idx < cpPolyShapeGetNumVerts(shape), "Index out of range.");
 	
 	return ((cpPolyShape *)shape)->verts[idx];
@@ -186,6 +218,7 @@ setUpVerts(cpPolyShape *poly, int numVerts, cpVect *verts, cpVect offset)
 	// Fail if the user attempts to pass a concave poly, or a bad winding.
 	cpAssertHard(cpPolyValidate(verts, numVerts), "Polygon is concave or has a reversed winding. Consider using cpConvexHull() or CP_CONVEX_HULL().");
 	
+	// The size of these depends on the number of verts, so they always come from the heap even if the shape came from a pool.
 	poly->numVerts = numVerts;
 	poly->verts = (cpVect *)cpcalloc(2*numVerts, sizeof(cpVect));
 	poly->planes = (cpSplittingPlane *)cpcalloc(2*numVerts, sizeof(cpSplittingPlane));
@@ -208,7 +241,7 @@ cpPolyShape *
 cpPolyShapeInit(cpPolyShape *poly, cpBody *body, int numVerts, cpVect *verts, cpVect offset)
 {
 	setUpVerts(poly, numVerts, verts, offset);
-	cpShapeInit((cpShape *)poly, &polyClass, body);
+	cpShapeInit((cpShape *)poly, &cpPolyShapeClass, body);
 
 	return poly;
 }
@@ -219,6 +252,13 @@ cpPolyShapeNew(cpBody *body, int numVerts, cpVect *verts, cpVect offset)
 	return (cpShape *)cpPolyShapeInit(cpPolyShapeAlloc(), body, numVerts, verts, offset);
 }
 
+cpShape *
+cpPolyShapeNewWithAllocator(cpAllocator *allocator, cpBody *body, int numVerts, cpVect *verts, cpVect offset)
+{
+	cpPolyShape *poly = (cpPolyShape *)cpShapeAllocBytes(allocator, sizeof(cpPolyShape));
+	return (cpShape *)cpPolyShapeInit(poly, body, numVerts, verts, offset);
+}
+
 cpPolyShape *
 cpBoxShapeInit(cpPolyShape *poly, cpBody *body, cpFloat width, cpFloat height)
 {
@@ -253,12 +293,19 @@ cpBoxShapeNew2(cpBody *body, cpBB box)
 	return (cpShape *)cpBoxShapeInit2(cpPolyShapeAlloc(), body, box);
 }
 
+cpShape *
+cpBoxShapeNewWithAllocator(cpAllocator *allocator, cpBody *body, cpFloat width, cpFloat height)
+{
+	cpPolyShape *poly = (cpPolyShape *)cpShapeAllocBytes(allocator, sizeof(cpPolyShape));
+	return (cpShape *)cpBoxShapeInit(poly, body, width, height);
+}
+
 // Unsafe API (chipmunk_unsafe.h)
 
 void
 cpPolyShapeSetVerts(cpShape *shape, int numVerts, cpVect *verts, cpVect offset)
 {
-	cpAssertHard(shape->klass == &polyClass, "Shape is not a poly shape.");
+	cpAssertHard(shape->klass == &cpPolyShapeClass, "Shape is not a poly shape.");
 	cpPolyShapeDestroy((cpPolyShape *)shape);
 	setUpVerts((cpPolyShape *)shape, numVerts, verts, offset);
 }
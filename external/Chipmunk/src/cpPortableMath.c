@@ -0,0 +1,388 @@
+/* Copyright (c) 2012 Scott Lembcke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+	Portable transcendental functions used when Chipmunk is built with CP_DETERMINISTIC_MATH.
+
+	The system libm is free to return different results on different platforms, compilers or
+	even versions of the same library. These versions only use +, -, *, /, floor(), frexp() and
+	ldexp() which are exact or correctly rounded under IEEE 754, so they return bit identical
+	results anywhere doubles are evaluated as doubles (SSE2, NEON, VFP, but not x87) and the
+	compiler doesn't contract multiply-adds (-ffp-contract=off).
+
+	The argument reductions and polynomials are taken from fdlibm and are accurate to about 1 ulp,
+	pow() is computed as exp(y*log(x)) in extra precision and is accurate to a few ulp.
+	Trig functions lose accuracy (but not determinism) above 1e6 radians.
+*/
+
+#include <math.h>
+
+#include "chipmunk_private.h"
+
+// The portable functions are always built, even when CP_DETERMINISTIC_MATH doesn't map the cpf* functions onto them.
+double cpPortableSin(double x);
+double cpPortableCos(double x);
+double cpPortableAcos(double x);
+double cpPortableAtan2(double y, double x);
+double cpPortableExp(double x);
+double cpPortableLog(double x);
+double cpPortablePow(double x, double y);
+
+#ifdef __clang__
+	// Clang contracts a*b + c into fused multiply-adds by default on some targets, which would change the rounding.
+	// GCC ignores this pragma and needs -ffp-contract=off instead.
+	#pragma STDC FP_CONTRACT OFF
+#endif
+
+// Round to the nearest integer using only exact operations.
+static inline double
+RoundNearest(double x)
+{
+	return floor(x + 0.5);
+}
+
+//MARK: Sine and Cosine
+
+static const double PIO2_1  = 1.57079632673412561417e+00; // first 33 bits of pi/2
+static const double PIO2_2  = 6.07710050630396597660e-11; // second 33 bits of pi/2
+static const double PIO2_2T = 2.02226624879595063154e-21; // pi/2 - (PIO2_1 + PIO2_2)
+static const double INV_PIO2 = 6.36619772367581382433e-01;
+
+// Reduce x to y0 + y1 in [-pi/4, pi/4] and return the quadrant.
+static int
+ReducePio2(double x, double *y0, double *y1)
+{
+	double fn = RoundNearest(x*INV_PIO2);
+	
+	// Two step Cody-Waite reduction, the products are exact for |fn| < 2^20.
+	double t = x - fn*PIO2_1;
+	double w = fn*PIO2_2;
+	double r = t - w;
+	w = fn*PIO2_2T - ((t - r) - w);
+	
+	*y0 = r - w;
+	*y1 = (r - *y0) - w;
+	
+	return (int)fmod(fn, 4.0) & 3;
+}
+
+static double
+KernelSin(double x, double y)
+{
+	static const double S1 = -1.66666666666666324348e-01;
+	static const double S2 =  8.33333333332248946124e-03;
+	static const double S3 = -1.98412698298579493134e-04;
+	static const double S4 =  2.75573137070700676789e-06;
+	static const double S5 = -2.50507602534068634195e-08;
+	static const double S6 =  1.58969099521155010221e-10;
+	
+	double z = x*x;
+	double v = z*x;
+	double r = S2 + z*(S3 + z*(S4 + z*(S5 + z*S6)));
+	
+	return x - ((z*(0.5*y - v*r) - y) - v*S1);
+}
+
+static double
+KernelCos(double x, double y)
+{
+	static const double C1 =  4.16666666666666019037e-02;
+	static const double C2 = -1.38888888888741095749e-03;
+	static const double C3 =  2.48015872894767294178e-05;
+	static const double C4 = -2.75573143513906633035e-07;
+	static const double C5 =  2.08757232129817482790e-09;
+	static const double C6 = -1.13596475577881948265e-11;
+	
+	double z = x*x;
+	double w = z*z;
+	double r = z*(C1 + z*(C2 + z*C3)) + w*w*(C4 + z*(C5 + z*C6));
+	double hz = 0.5*z;
+	w = 1.0 - hz;
+	
+	return w + (((1.0 - w) - hz) + (z*r - x*y));
+}
+
+double
+cpPortableSin(double x)
+{
+	if(x != x || x - x != 0.0) return x - x; // NaN or infinity
+	
+	double y0, y1;
+	switch(ReducePio2(x, &y0, &y1)){
+		case 0: return  KernelSin(y0, y1);
+		case 1: return  KernelCos(y0, y1);
+		case 2: return -KernelSin(y0, y1);
+		default: return -KernelCos(y0, y1);
+	}
+}
+
+double
+cpPortableCos(double x)
+{
+	if(x != x || x - x != 0.0) return x - x; // NaN or infinity
+	
+	double y0, y1;
+	switch(ReducePio2(x, &y0, &y1)){
+		case 0: return  KernelCos(y0, y1);
+		case 1: return -KernelSin(y0, y1);
+		case 2: return -KernelCos(y0, y1);
+		default: return  KernelSin(y0, y1);
+	}
+}
+
+//MARK: Exponential and Logarithm
+
+static const double LN2_HI = 6.93147180369123816490e-01;
+static const double LN2_LO = 1.90821492927058770002e-10;
+
+double
+cpPortableExp(double x)
+{
+	static const double P1 =  1.66666666666666019037e-01;
+	static const double P2 = -2.77777777770155933842e-03;
+	static const double P3 =  6.61375632143793436117e-05;
+	static const double P4 = -1.65339022054652515390e-06;
+	static const double P5 =  4.13813679705723846039e-08;
+	
+	if(x != x) return x;
+	if(x > 7.09782712893383973096e+02) return INFINITY;
+	if(x < -7.45133219101941108420e+02) return 0.0;
+	
+	// x = k*ln2 + r, |r| <= 0.5*ln2
+	double k = RoundNearest(x*1.44269504088896338700e+00);
+	double hi = x - k*LN2_HI;
+	double lo = k*LN2_LO;
+	double r = hi - lo;
+	
+	double t = r*r;
+	double c = r - t*(P1 + t*(P2 + t*(P3 + t*(P4 + t*P5))));
+	double y = 1.0 - ((lo - (r*c)/(2.0 - c)) - hi);
+	
+	return ldexp(y, (int)k);
+}
+
+// Knuth's error free sum, returns a + b and stores the rounding error in err.
+static inline double
+TwoSum(double a, double b, double *err)
+{
+	double sum = a + b;
+	double bb = sum - a;
+	*err = (a - (sum - bb)) + (b - bb);
+	return sum;
+}
+
+// Returns log(x) as hi + *lo for x > 0.
+static double
+LogExtended(double x, double *lo)
+{
+	static const double LG1 = 6.666666666666735130e-01;
+	static const double LG2 = 3.999999999940941908e-01;
+	static const double LG3 = 2.857142874366239149e-01;
+	static const double LG4 = 2.222219843214978396e-01;
+	static const double LG5 = 1.818357216161805012e-01;
+	static const double LG6 = 1.531383769920937332e-01;
+	static const double LG7 = 1.479819860511658591e-01;
+	
+	// x = 2^e*m, sqrt(2)/2 <= m < sqrt(2)
+	int e;
+	double m = frexp(x, &e);
+	if(m < 7.07106781186547524401e-01){
+		m *= 2.0;
+		e--;
+	}
+	
+	double f = m - 1.0;
+	double s = f/(2.0 + f);
+	double z = s*s;
+	double w = z*z;
+	double R = z*(LG1 + w*(LG3 + w*(LG5 + w*LG7))) + w*(LG2 + w*(LG4 + w*LG6));
+	double hfsq = 0.5*f*f;
+	double dk = (double)e;
+	
+	// dk*LN2_HI and f are exact, sum the terms while keeping track of the rounding errors.
+	double c = (s*(hfsq + R) + dk*LN2_LO) - hfsq;
+	double a = dk*LN2_HI;
+	double sum = TwoSum(a, f, lo);
+	double err;
+	double hi = TwoSum(sum, c, &err);
+	
+	*lo += err;
+	return hi;
+}
+
+double
+cpPortableLog(double x)
+{
+	if(x != x || x == INFINITY) return x;
+	if(x == 0.0) return -INFINITY;
+	if(x < 0.0) return (x - x)/0.0; // NaN
+	
+	double lo, hi = LogExtended(x, &lo);
+	return hi + lo;
+}
+
+// Split a double into two halves with 26 significant bits each so their products are exact.
+static inline void
+Split(double x, double *hi, double *lo)
+{
+	double c = 134217729.0*x; // 2^27 + 1
+	*hi = c - (c - x);
+	*lo = x - *hi;
+}
+
+// exp(y*log(x)) for x > 0 with the product carried in extra precision.
+static double
+PowPositive(double x, double y)
+{
+	double llo, lhi = LogExtended(x, &llo);
+	
+	// Dekker's exact product of y*lhi.
+	double p = y*lhi;
+	double yh, yl, lh, ll;
+	Split(y, &yh, &yl);
+	Split(lhi, &lh, &ll);
+	double plo = (((yh*lh - p) + yh*ll) + yl*lh) + yl*ll;
+	plo += y*llo;
+	
+	double result = cpPortableExp(p);
+	return result + result*plo;
+}
+
+double
+cpPortablePow(double x, double y)
+{
+	if(y == 0.0 || x == 1.0) return 1.0;
+	if(x != x || y != y) return x + y;
+	
+	if(x == 0.0) return (y > 0.0 ? 0.0 : INFINITY);
+	if(x > 0.0) return PowPositive(x, y);
+	
+	// Negative bases are only defined for integer exponents.
+	if(floor(y) != y) return (x - x)/0.0;
+	double result = PowPositive(-x, y);
+	return (fmod(y, 2.0) == 0.0 ? result : -result);
+}
+
+//MARK: Inverse Trig Functions
+
+static const double PI    = 3.1415926535897931160e+00;
+static const double PI_LO = 1.2246467991473531772e-16;
+
+static double
+PortableAtan(double x)
+{
+	static const double ATAN_HI[] = {
+		4.63647609000806093515e-01, // atan(0.5)
+		7.85398163397448278999e-01, // atan(1.0)
+		9.82793723247329054082e-01, // atan(1.5)
+		1.57079632679489655800e+00, // atan(inf)
+	};
+	
+	static const double ATAN_LO[] = {
+		2.26987774529616870924e-17,
+		3.06161699786838301793e-17,
+		1.39033110312309984516e-17,
+		6.12323399573676603587e-17,
+	};
+	
+	static const double AT[] = {
+		 3.33333333333329318027e-01,
+		-1.99999999998764832476e-01,
+		 1.42857142725034663711e-01,
+		-1.11111104054623557880e-01,
+		 9.09088713343650656196e-02,
+		-7.69187620504482999495e-02,
+		 6.66107313738753120669e-02,
+		-5.83357013379057348645e-02,
+		 4.97687799461593236017e-02,
+		-3.65315727442169155270e-02,
+		 1.62858201153657823623e-02,
+	};
+	
+	cpBool negative = (x < 0.0);
+	double ax = (negative ? -x : x);
+	
+	int id;
+	if(ax >= 7.3786976294838206464e+19){ // 2^66
+		double z = ATAN_HI[3] + ATAN_LO[3];
+		return (negative ? -z : z);
+	} else if(ax < 0.4375){
+		if(ax < 7.4505805969238281e-09) return x; // 2^-27
+		id = -1;
+	} else if(ax < 0.6875){
+		id = 0; ax = (2.0*ax - 1.0)/(2.0 + ax);
+	} else if(ax < 1.1875){
+		id = 1; ax = (ax - 1.0)/(ax + 1.0);
+	} else if(ax < 2.4375){
+		id = 2; ax = (ax - 1.5)/(1.0 + 1.5*ax);
+	} else {
+		id = 3; ax = -1.0/ax;
+	}
+	
+	double z = ax*ax;
+	double w = z*z;
+	double s1 = z*(AT[0] + w*(AT[2] + w*(AT[4] + w*(AT[6] + w*(AT[8] + w*AT[10])))));
+	double s2 = w*(AT[1] + w*(AT[3] + w*(AT[5] + w*(AT[7] + w*AT[9]))));
+	
+	double result = (id < 0 ? ax - ax*(s1 + s2) : ATAN_HI[id] - ((ax*(s1 + s2) - ATAN_LO[id]) - ax));
+	return (negative ? -result : result);
+}
+
+double
+cpPortableAtan2(double y, double x)
+{
+	if(x != x || y != y) return x + y;
+	
+	if(y == 0.0){
+		// atan2(+-0, +0) = +-0 and atan2(+-0, -0) = +-pi
+		if(x > 0.0 || (x == 0.0 && 1.0/x > 0.0)) return y;
+		return (1.0/y > 0.0 ? PI : -PI);
+	}
+	
+	if(x == 0.0) return (y > 0.0 ? 0.5*PI : -0.5*PI);
+	
+	cpBool xinf = (x - x != 0.0), yinf = (y - y != 0.0);
+	if(xinf && yinf){
+		double z = (x > 0.0 ? 0.25*PI : 0.75*PI);
+		return (y > 0.0 ? z : -z);
+	} else if(xinf){
+		if(x > 0.0) return (y > 0.0 ? 0.0 : -0.0);
+		return (y > 0.0 ? PI : -PI);
+	} else if(yinf){
+		return (y > 0.0 ? 0.5*PI : -0.5*PI);
+	}
+	
+	double z = PortableAtan(fabs(y/x));
+	if(x > 0.0){
+		return (y > 0.0 ? z : -z);
+	} else {
+		return (y > 0.0 ? PI - (z - PI_LO) : (z - PI_LO) - PI);
+	}
+}
+
+double
+cpPortableAcos(double x)
+{
+	if(x != x) return x;
+	if(x > 1.0 || x < -1.0) return (x - x)/0.0;
+	
+	return cpPortableAtan2(sqrt((1.0 - x)*(1.0 + x)), x);
+}
@@ -77,10 +77,20 @@ cpShapeFree(cpShape *shape)
 {
 	if(shape){
 		cpShapeDestroy(shape);
-		cpfree(shape);
+		cpAllocatorFreeOrHeap(shape->allocator, shape, shape->klass->size, CP_ALLOCATOR_SHAPES);
 	}
 }
 
+void *
+cpShapeAllocBytes(cpAllocator *allocator, size_t size)
+{
+	allocator = cpAllocatorForObject(allocator, size);
+	cpShape *shape = (cpShape *)cpAllocatorAllocOrHeap(allocator, size, CP_ALLOCATOR_SHAPES);
+	shape->allocator = allocator;
+	
+	return shape;
+}
+
 void
 cpShapeSetBody(cpShape *shape, cpBody *body)
 {
@@ -140,7 +150,7 @@ cpShapeSegmentQuery(cpShape *shape, cpVect a, cpVect b, cpSegmentQueryInfo *info
 cpCircleShape *
 cpCircleShapeAlloc(void)
 {
-	return (cpCircleShape *)cpcalloc(1, sizeof(cpCircleShape));
+	return (cpCircleShape *)cpShapeAllocBytes(NULL, sizeof(cpCircleShape));
 }
 
 static cpBB
@@ -191,12 +201,13 @@ cpCircleShapeSegmentQuery(cpCircleShape *circle, cpVect a, cpVect b, cpSegmentQu
 	circleSegmentQuery((cpShape *)circle, circle->tc, circle->r, a, b, info);
 }
 
-static const cpShapeClass cpCircleShapeClass = {
+const cpShapeClass cpCircleShapeClass = {
 	CP_CIRCLE_SHAPE,
 	(cpShapeCacheDataImpl)cpCircleShapeCacheData,
 	NULL,
 	(cpShapeNearestPointQueryImpl)cpCicleShapeNearestPointQuery,
 	(cpShapeSegmentQueryImpl)cpCircleShapeSegmentQuery,
+	sizeof(cpCircleShape),
 };
 
 cpCircleShape *
@@ -216,13 +227,20 @@ cpCircleShapeNew(cpBody *body, cpFloat radius, cpVect offset)
 	return (cpShape *)cpCircleShapeInit(cpCircleShapeAlloc(), body, radius, offset);
 }
 
+cpShape *
+cpCircleShapeNewWithAllocator(cpAllocator *allocator, cpBody *body, cpFloat radius, cpVect offset)
+{
+	cpCircleShape *circle = (cpCircleShape *)cpShapeAllocBytes(allocator, sizeof(cpCircleShape));
+	return (cpShape *)cpCircleShapeInit(circle, body, radius, offset);
+}
+
 CP_DefineShapeGetter(cpCircleShape, cpVect, c, Offset)
 CP_DefineShapeGetter(cpCircleShape, cpFloat, r, Radius)
 
 cpSegmentShape *
 cpSegmentShapeAlloc(void)
 {
-	return (cpSegmentShape *)cpcalloc(1, sizeof(cpSegmentShape));
+	return (cpSegmentShape *)cpShapeAllocBytes(NULL, sizeof(cpSegmentShape));
 }
 
 static cpBB
@@ -307,12 +325,13 @@ cpSegmentShapeSegmentQuery(cpSegmentShape *seg, cpVect a, cpVect b, cpSegmentQue
 	}
 }
 
-static const cpShapeClass cpSegmentShapeClass = {
+const cpShapeClass cpSegmentShapeClass = {
 	CP_SEGMENT_SHAPE,
 	(cpShapeCacheDataImpl)cpSegmentShapeCacheData,
 	NULL,
 	(cpShapeNearestPointQueryImpl)cpSegmentShapeNearestPointQuery,
 	(cpShapeSegmentQueryImpl)cpSegmentShapeSegmentQuery,
+	sizeof(cpSegmentShape),
 };
 
 cpSegmentShape *
@@ -338,6 +357,13 @@ cpSegmentShapeNew(cpBody *body, cpVect a, cpVect b, cpFloat r)
 	return (cpShape *)cpSegmentShapeInit(cpSegmentShapeAlloc(), body, a, b, r);
 }
 
+cpShape*
+cpSegmentShapeNewWithAllocator(cpAllocator *allocator, cpBody *body, cpVect a, cpVect b, cpFloat r)
+{
+	cpSegmentShape *seg = (cpSegmentShape *)cpShapeAllocBytes(allocator, sizeof(cpSegmentShape));
+	return (cpShape *)cpSegmentShapeInit(seg, body, a, b, r);
+}
+
 CP_DefineShapeGetter(cpSegmentShape, cpVect, a, A)
 CP_DefineShapeGetter(cpSegmentShape, cpVect, b, B)
 CP_DefineShapeGetter(cpSegmentShape, cpVect, n, Normal)
@@ -105,10 +105,18 @@ cpSpaceInit(cpSpace *space)
 	cpBBTreeSetVelocityFunc(space->activeShapes, (cpBBTreeVelocityFunc)shapeVelocityFunc);
 	
 	space->allocatedBuffers = cpArrayNew(0);
+	cpHeapAllocatorInit(&space->_heapAllocator);
+	space->profile = NULL;
+	space->deterministic = cpFalse;
+	space->sortedArbiters = cpArrayNew(0);
+	space->sortedConstraints = cpArrayNew(0);
 	
 	space->bodies = cpArrayNew(0);
 	space->sleepingComponents = cpArrayNew(0);
 	space->rousedBodies = cpArrayNew(0);
+	space->rebuildComponents = cpTrue;
+	space->staleComponents = cpFalse;
+	space->componentsStamp = 0;
 	
 	space->sleepTimeThreshold = INFINITY;
 	space->idleSpeedThreshold = 0.0f;
@@ -117,7 +125,16 @@ cpSpaceInit(cpSpace *space)
 	space->arbiters = cpArrayNew(0);
 	space->pooledArbiters = cpArrayNew(0);
 	
+	space->solverTolerance = 0.0f;
+	space->minIterations = 1;
+	space->lastIterations = 0;
+	space->islandBuffer = NULL;
+	space->islandBufferSize = 0;
+	
 	space->contactBuffersHead = NULL;
+	space->pooledContactBuffers = NULL;
+	space->contactBudget = 0;
+	memset(&space->contactBufferStats, 0, sizeof(cpContactBufferStats));
 	space->cachedArbiters = cpHashSetNew(0, (cpHashSetEqlFunc)arbiterSetEql);
 	
 	space->constraints = cpArrayNew(0);
@@ -132,6 +149,9 @@ cpSpaceInit(cpSpace *space)
 	cpBodyInitStatic(&space->_staticBody);
 	space->staticBody = &space->_staticBody;
 	
+	space->allocator = NULL;
+	cpSpaceSetAllocator(space, NULL);
+	
 	return space;
 }
 
@@ -159,11 +179,11 @@ cpSpaceDestroy(cpSpace *space)
 	
 	cpArrayFree(space->arbiters);
 	cpArrayFree(space->pooledArbiters);
+	cpArrayFree(space->sortedArbiters);
+	cpArrayFree(space->sortedConstraints);
+	if(space->islandBuffer) cpAllocatorFreeBytes(space->allocator, space->islandBuffer, space->islandBufferSize, CP_ALLOCATOR_MISC);
 	
-	if(space->allocatedBuffers){
-		cpArrayFreeEach(space->allocatedBuffers, cpfree);
-		cpArrayFree(space->allocatedBuffers);
-	}
+	cpSpaceFreeBuffers(space);
 	
 	if(space->postStepCallbacks){
 		cpArrayFreeEach(space->postStepCallbacks, cpfree);
@@ -183,6 +203,27 @@ cpSpaceFree(cpSpace *space)
 	}
 }
 
+void
+cpSpaceSetAllocator(cpSpace *space, cpAllocator *allocator)
+{
+	cpAssertHard(
+		!space->contactBuffersHead && space->allocatedBuffers->num == 0 && !space->islandBuffer &&
+		cpSpatialIndexCount(space->staticShapes) == 0 && cpSpatialIndexCount(space->activeShapes) == 0 &&
+		cpHashSetCount(space->collisionHandlers) == 0,
+		"You cannot change the allocator of a space after adding shapes or collision handlers or stepping it."
+	);
+	
+	cpAssertHard(!cpAllocatorIsPool(allocator), "Pool allocators can't be used by spaces since they allocate buffers of several sizes.");
+	
+	allocator = (allocator ? allocator : &space->_heapAllocator);
+	space->allocator = allocator;
+	
+	cpSpatialIndexSetAllocator(space->staticShapes, allocator);
+	cpSpatialIndexSetAllocator(space->activeShapes, allocator);
+	cpHashSetSetAllocator(space->cachedArbiters, allocator);
+	cpHashSetSetAllocator(space->collisionHandlers, allocator);
+}
+
 #define cpAssertSpaceUnlocked(space) \
 	cpAssertHard(!space->locked, \
 		"This addition/removal cannot be done safely during a call to cpSpaceStep() or during a query. " \
@@ -296,6 +337,7 @@ cpSpaceAddBody(cpSpace *space, cpBody *body)
 	
 	cpArrayPush(space->bodies, body);
 	body->space = space;
+	space->rebuildComponents = cpTrue;
 	
 	return body;
 }
@@ -309,6 +351,7 @@ cpSpaceAddConstraint(cpSpace *space, cpConstraint *constraint)
 	cpBodyActivate(constraint->a);
 	cpBodyActivate(constraint->b);
 	cpArrayPush(space->constraints, constraint);
+	space->rebuildComponents = cpTrue;
 	
 	// Push onto the heads of the bodies' constraint lists
 	cpBody *a = constraint->a, *b = constraint->b;
@@ -401,6 +444,7 @@ cpSpaceRemoveBody(cpSpace *space, cpBody *body)
 //	cpSpaceFilterArbiters(space, body, NULL);
 	cpArrayDeleteObj(space->bodies, body);
 	body->space = NULL;
+	space->rebuildComponents = cpTrue;
 }
 
 void
@@ -412,6 +456,7 @@ cpSpaceRemoveConstraint(cpSpace *space, cpConstraint *constraint)
 	cpBodyActivate(constraint->a);
 	cpBodyActivate(constraint->b);
 	cpArrayDeleteObj(space->constraints, constraint);
+	space->staleComponents = cpTrue;
 	
 	cpBodyRemoveConstraint(constraint->a, constraint);
 	cpBodyRemoveConstraint(constraint->b, constraint);
@@ -537,11 +582,13 @@ copyShapes(cpShape *shape, cpSpatialIndex *index)
 	cpSpatialIndexInsert(index, shape, shape->hashid);
 }
 
-void
-cpSpaceUseSpatialHash(cpSpace *space, cpFloat dim, int count)
+static void
+cpSpaceSwapSpatialIndexes(cpSpace *space, cpSpatialIndex *staticShapes, cpSpatialIndex *activeShapes)
 {
-	cpSpatialIndex *staticShapes = cpSpaceHashNew(dim, count, (cpSpatialIndexBBFunc)cpShapeGetBB, NULL);
-	cpSpatialIndex *activeShapes = cpSpaceHashNew(dim, count, (cpSpatialIndexBBFunc)cpShapeGetBB, staticShapes);
+	cpAssertHard(!space->locked, "You cannot change the spatial index while the space is locked. Wait until the current query or step is complete.");
+	
+	cpSpatialIndexSetAllocator(staticShapes, space->allocator);
+	cpSpatialIndexSetAllocator(activeShapes, space->allocator);
 	
 	cpSpatialIndexEach(space->staticShapes, (cpSpatialIndexIteratorFunc)copyShapes, staticShapes);
 	cpSpatialIndexEach(space->activeShapes, (cpSpatialIndexIteratorFunc)copyShapes, activeShapes);
@@ -552,3 +599,21 @@ cpSpaceUseSpatialHash(cpSpace *space, cpFloat dim, int count)
 	space->staticShapes = staticShapes;
 	space->activeShapes = activeShapes;
 }
+
+void
+cpSpaceUseSpatialHash(cpSpace *space, cpFloat dim, int count)
+{
+	cpSpatialIndex *staticShapes = cpSpaceHashNew(dim, count, (cpSpatialIndexBBFunc)cpShapeGetBB, NULL);
+	cpSpatialIndex *activeShapes = cpSpaceHashNew(dim, count, (cpSpatialIndexBBFunc)cpShapeGetBB, staticShapes);
+	
+	cpSpaceSwapSpatialIndexes(space, staticShapes, activeShapes);
+}
+
+void
+cpSpaceUseSweep1D(cpSpace *space)
+{
+	cpSpatialIndex *staticShapes = cpBBTreeNew((cpSpatialIndexBBFunc)cpShapeGetBB, NULL);
+	cpSpatialIndex *activeShapes = cpSweep1DNew((cpSpatialIndexBBFunc)cpShapeGetBB, staticShapes);
+	
+	cpSpaceSwapSpatialIndexes(space, staticShapes, activeShapes);
+}
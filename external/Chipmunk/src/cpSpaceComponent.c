@@ -35,6 +35,7 @@ cpSpaceActivateBody(cpSpace *space, cpBody *body)
 		if(!cpArrayContains(space->rousedBodies, body)) cpArrayPush(space->rousedBodies, body);
 	} else {
 		cpArrayPush(space->bodies, body);
+		space->rebuildComponents = cpTrue;
 
 		CP_BODY_FOREACH_SHAPE(body, shape){
 			cpSpatialIndexRemove(space->staticShapes, shape, shape->hashid);
@@ -63,7 +64,7 @@ cpSpaceActivateBody(cpSpace *space, cpBody *body)
 				arb->handler = cpSpaceLookupHandler(space, a->collision_type, b->collision_type);
 				cpArrayPush(space->arbiters, arb);
 				
-				cpfree(contacts);
+				cpAllocatorFreeBytes(space->allocator, contacts, numContacts*sizeof(cpContact), CP_ALLOCATOR_CONTACTS);
 			}
 		}
 		
@@ -80,6 +81,7 @@ cpSpaceDeactivateBody(cpSpace *space, cpBody *body)
 	cpAssertHard(!cpBodyIsRogue(body), "Internal error: Attempting to deactivate a rouge body.");
 	
 	cpArrayDeleteObj(space->bodies, body);
+	space->rebuildComponents = cpTrue;
 	
 	CP_BODY_FOREACH_SHAPE(body, shape){
 		cpSpatialIndexRemove(space->activeShapes, shape, shape->hashid);
@@ -93,7 +95,7 @@ cpSpaceDeactivateBody(cpSpace *space, cpBody *body)
 			
 			// Save contact values to a new block of memory so they won't time out
 			size_t bytes = arb->numContacts*sizeof(cpContact);
-			cpContact *contacts = (cpContact *)cpcalloc(1, bytes);
+			cpContact *contacts = (cpContact *)cpAllocatorAllocBytes(space->allocator, bytes, CP_ALLOCATOR_CONTACTS);
 			memcpy(contacts, arb->contacts, bytes);
 			arb->contacts = contacts;
 		}
@@ -156,7 +158,7 @@ cpBodyActivateStatic(cpBody *body, cpShape *filter)
 	// TODO should also activate joints?
 }
 
-static inline void
+void
 cpBodyPushArbiter(cpBody *body, cpArbiter *arb)
 {
 	cpAssertSoft(cpArbiterThreadForBody(arb, body)->next == NULL, "Internal Error: Dangling contact graph pointers detected. (A)");
@@ -197,6 +199,104 @@ FloodFillComponent(cpBody *root, cpBody *body)
 	}
 }
 
+//MARK: Awake Component Tracking
+
+// The awake bodies are kept in a union-find forest across steps so that the contact graph
+// only needs to be flood filled for components that might fall asleep.
+// New arbiters are unioned as they appear. The forest is rebuilt right away when bodies are added, removed,
+// woken up or put to sleep, or when constraints are added.
+// Sets can't be split, so when arbiters or constraints go away the sets become supersets of the real components.
+// That only delays sleeping, so stale sets are rebuilt at most once per COMPONENT_REBUILD_FRACTION of the sleep time threshold.
+// This keeps stacks that never settle (and constantly lose and regain contacts) cheap.
+#define COMPONENT_REBUILD_FRACTION 0.25f
+
+static inline cpBody *
+ComponentFind(cpBody *body)
+{
+	cpBody *parent = body->node.parent;
+	
+	while(parent != body){
+		// Path halving
+		cpBody *grandparent = parent->node.parent;
+		body->node.parent = grandparent;
+		
+		body = grandparent;
+		parent = body->node.parent;
+	}
+	
+	return body;
+}
+
+static inline void
+ComponentUnion(cpSpace *space, cpBody *a, cpBody *b)
+{
+	// Rogue bodies never join components.
+	if(cpBodyIsRogue(a) || cpBodyIsRogue(b)) return;
+	
+	cpBody *rootA = ComponentFind(a);
+	cpBody *rootB = ComponentFind(b);
+	if(rootA != rootB){
+		rootA->node.parent = rootB;
+		if(space->profile) space->profile->componentUnions++;
+	}
+}
+
+static void
+ComponentsUpdate(cpSpace *space, cpFloat dt)
+{
+	cpArray *bodies = space->bodies;
+	cpArray *arbiters = space->arbiters;
+	cpArray *constraints = space->constraints;
+	
+	cpTimestamp stamp = space->stamp;
+	cpBool expired = (stamp - space->componentsStamp)*dt >= COMPONENT_REBUILD_FRACTION*space->sleepTimeThreshold;
+	
+	if(space->rebuildComponents || (space->staleComponents && expired)){
+		for(int i=0; i<bodies->num; i++){
+			cpBody *body = (cpBody *)bodies->arr[i];
+			body->node.parent = body;
+		}
+		
+		for(int i=0; i<arbiters->num; i++){
+			cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+			ComponentUnion(space, arb->body_a, arb->body_b);
+		}
+		
+		for(int i=0; i<constraints->num; i++){
+			cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
+			ComponentUnion(space, constraint->a, constraint->b);
+		}
+		
+		space->rebuildComponents = cpFalse;
+		space->staleComponents = cpFalse;
+		space->componentsStamp = stamp;
+		if(space->profile) space->profile->componentRebuilds++;
+	} else {
+		// Only arbiters that just started touching can connect new bodies.
+		// Adding constraints always causes a rebuild.
+		for(int i=0; i<arbiters->num; i++){
+			cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+			if(arb->state == cpArbiterStateFirstColl) ComponentUnion(space, arb->body_a, arb->body_b);
+		}
+	}
+}
+
+// Compare the kinetic energy of the body per unit mass against the squared idle speed.
+// Multiplying by the mass instead would lose precision (or overflow) for heavy bodies when using single precision floats.
+static inline cpBool
+BodyIsIdle(cpBody *body, cpFloat dvsq)
+{
+	cpFloat vsq = cpvdot(body->v, body->v);
+	cpFloat wsq = body->w*body->w;
+	
+	// Infinite mass bodies are idle unless there is no threshold and they are moving.
+	if(body->m == INFINITY) return (dvsq || (vsq == 0.0f && wsq == 0.0f));
+	
+	// Need to do some fudging to avoid NaNs
+	cpFloat rotational = (wsq ? wsq*body->i*body->m_inv : 0.0f);
+	return (vsq + rotational <= dvsq);
+}
+
 static inline cpBool
 ComponentActive(cpBody *root, cpFloat threshold)
 {
@@ -230,10 +330,7 @@ cpSpaceProcessComponents(cpSpace *space, cpFloat dt)
 		// update idling and reset component nodes
 		for(int i=0; i<bodies->num; i++){
 			cpBody *body = (cpBody*)bodies->arr[i];
-			
-			// Need to deal with infinite mass objects
-			cpFloat keThreshold = (dvsq ? body->m*dvsq : 0.0f);
-			body->node.idleTime = (cpBodyKineticEnergy(body) > keThreshold ? 0.0f : body->node.idleTime + dt);
+			body->node.idleTime = (BodyIsIdle(body, dvsq) ? body->node.idleTime + dt : 0.0f);
 		}
 	}
 	
@@ -263,31 +360,59 @@ cpSpaceProcessComponents(cpSpace *space, cpFloat dt)
 			if(cpBodyIsRogue(a) && !cpBodyIsStatic(a)) cpBodyActivate(b);
 		}
 		
-		// Generate components and deactivate sleeping ones
+		ComponentsUpdate(space, dt);
+		
+		// Mark the sets that contain an active body.
+		cpTimestamp stamp = space->stamp;
+		cpFloat threshold = space->sleepTimeThreshold;
+		for(int i=0; i<bodies->num; i++){
+			cpBody *body = (cpBody*)bodies->arr[i];
+			
+			if(body->node.idleTime < threshold){
+				cpBody *root = ComponentFind(body);
+				
+				if(root->node.activeStamp != stamp){
+					root->node.activeStamp = stamp;
+					if(space->profile) space->profile->awakeComponents++;
+				}
+			}
+		}
+		
+		// Generate components for the sets with no active bodies and deactivate them.
 		for(int i=0; i<bodies->num;){
 			cpBody *body = (cpBody*)bodies->arr[i];
 			
-			if(ComponentRoot(body) == NULL){
+			if(ComponentRoot(body) == NULL && ComponentFind(body)->node.activeStamp != stamp){
 				// Body not in a component yet. Perform a DFS to flood fill mark 
 				// the component in the contact graph using this body as the root.
 				FloodFillComponent(body, body);
 				
+				if(space->profile){
+					CP_BODY_FOREACH_COMPONENT(body, other) space->profile->componentBodiesVisited++;
+				}
+				
 				// Check if the component should be put to sleep.
-				if(!ComponentActive(body, space->sleepTimeThreshold)){
+				if(!ComponentActive(body, threshold)){
 					cpArrayPush(space->sleepingComponents, body);
 					CP_BODY_FOREACH_COMPONENT(body, other) cpSpaceDeactivateBody(space, other);
 					
 					// cpSpaceDeactivateBody() removed the current body from the list.
 					// Skip incrementing the index counter.
 					continue;
+				} else {
+					// The set was missing a connection to an active body. (e.g. an arbiter rejected by a
+					// pre-solve callback for a step) Clear the component and rebuild the sets next step.
+					for(cpBody *other = body, *next; other; other = next){
+						next = other->node.next;
+						other->node.root = NULL;
+						other->node.next = NULL;
+					}
+					
+					space->rebuildComponents = cpTrue;
 				}
 			}
 			
 			i++;
-			
-			// Only sleeping bodies retain their component node pointers.
-			body->node.root = NULL;
-			body->node.next = NULL;
 		}
 	}
 }
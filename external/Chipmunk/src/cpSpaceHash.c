@@ -79,7 +79,7 @@ handleSetTrans(void *obj, cpSpaceHash *hash)
 		int count = CP_BUFFER_BYTES/sizeof(cpHandle);
 		cpAssertHard(count, "Internal Error: Buffer size is too small.");
 		
-		cpHandle *buffer = (cpHandle *)cpcalloc(1, CP_BUFFER_BYTES);
+		cpHandle *buffer = (cpHandle *)cpAllocatorAllocOrHeap(hash->spatialIndex.allocator, CP_BUFFER_BYTES, CP_ALLOCATOR_MISC);
 		cpArrayPush(hash->allocatedBuffers, buffer);
 		
 		for(int i=0; i<count; i++) cpArrayPush(hash->pooledHandles, buffer + i);
@@ -141,7 +141,7 @@ getEmptyBin(cpSpaceHash *hash)
 		int count = CP_BUFFER_BYTES/sizeof(cpSpaceHashBin);
 		cpAssertHard(count, "Internal Error: Buffer size is too small.");
 		
-		cpSpaceHashBin *buffer = (cpSpaceHashBin *)cpcalloc(1, CP_BUFFER_BYTES);
+		cpSpaceHashBin *buffer = (cpSpaceHashBin *)cpAllocatorAllocOrHeap(hash->spatialIndex.allocator, CP_BUFFER_BYTES, CP_ALLOCATOR_MISC);
 		cpArrayPush(hash->allocatedBuffers, buffer);
 		
 		// push all but the first one, return the first instead
@@ -196,6 +196,17 @@ cpSpaceHashNew(cpFloat celldim, int cells, cpSpatialIndexBBFunc bbfunc, cpSpatia
 	return cpSpaceHashInit(cpSpaceHashAlloc(), celldim, cells, bbfunc, staticIndex);
 }
 
+static void
+FreeBuffers(cpSpaceHash *hash)
+{
+	cpArray *buffers = hash->allocatedBuffers;
+	for(int i=0; i<buffers->num; i++) cpAllocatorFreeOrHeap(hash->spatialIndex.allocator, buffers->arr[i], CP_BUFFER_BYTES, CP_ALLOCATOR_MISC);
+	buffers->num = 0;
+	
+	hash->pooledHandles->num = 0;
+	hash->pooledBins = NULL;
+}
+
 static void
 cpSpaceHashDestroy(cpSpaceHash *hash)
 {
@@ -204,11 +215,21 @@ cpSpaceHashDestroy(cpSpaceHash *hash)
 	
 	cpHashSetFree(hash->handleSet);
 	
-	cpArrayFreeEach(hash->allocatedBuffers, cpfree);
+	FreeBuffers(hash);
 	cpArrayFree(hash->allocatedBuffers);
 	cpArrayFree(hash->pooledHandles);
 }
 
+static void
+cpSpaceHashSetAllocator(cpSpaceHash *hash, cpAllocator *allocator)
+{
+	// The cells can still reference the handles of removed objects until the table is cleared.
+	clearTable(hash);
+	FreeBuffers(hash);
+	
+	cpHashSetSetAllocator(hash->handleSet, allocator);
+}
+
 //MARK: Helper Functions
 
 static inline cpBool
@@ -544,6 +565,12 @@ cpSpaceHashSegmentQuery(cpSpaceHash *hash, void *obj, cpVect a, cpVect b, cpFloa
 
 //MARK: Misc
 
+cpBool
+cpSpaceHashIsSpaceHash(cpSpatialIndex *index)
+{
+	return (index->klass == Klass());
+}
+
 void
 cpSpaceHashResize(cpSpaceHash *hash, cpFloat celldim, int numcells)
 {
@@ -586,6 +613,8 @@ static cpSpatialIndexClass klass = {
 	
 	(cpSpatialIndexQueryImpl)cpSpaceHashQuery,
 	(cpSpatialIndexSegmentQueryImpl)cpSpaceHashSegmentQuery,
+	
+	(cpSpatialIndexSetAllocatorImpl)cpSpaceHashSetAllocator,
 };
 
 static inline cpSpatialIndexClass *Klass(){return &klass;}
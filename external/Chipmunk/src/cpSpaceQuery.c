@@ -310,3 +310,282 @@ cpSpaceShapeQuery(cpSpace *space, cpShape *shape, cpSpaceShapeQueryFunc func, vo
 	
 	return context.anyCollision;
 }
+
+//MARK: Batch Query Functions
+
+// The batch queries don't call any user callbacks so there is no need to lock the space.
+// Each query is independent and only reads from the space and its spatial indexes.
+
+// Consecutive queries in a batch are grouped into clusters that share a single traversal of each spatial index.
+// The shapes found for the cluster's bounding box are filtered once and then tested against each query in the cluster.
+// Clusters shrink when they find too many shapes (the queries are spread out) and grow again when they find few.
+#define BATCH_CLUSTER_MAX 16
+#define BATCH_CANDIDATES 64
+
+// The cost of a spatial hash query grows with the area of the cells it covers instead of the shapes it finds,
+// so a cluster's bounding box costs more than its queries would one at a time.
+static inline int
+BatchClusterMax(cpSpace *space)
+{
+	return (cpSpaceHashIsSpaceHash(space->activeShapes) || cpSpaceHashIsSpaceHash(space->staticShapes) ? 1 : BATCH_CLUSTER_MAX);
+}
+
+struct BatchCandidates {
+	cpLayers layers;
+	cpGroup group;
+	cpBool sensors;
+	
+	int count;
+	cpShape *shapes[BATCH_CANDIDATES];
+};
+
+static void
+CollectCandidate(struct BatchCandidates *candidates, cpShape *shape, void *unused)
+{
+	if(
+		!(shape->group && candidates->group == shape->group) && (candidates->layers&shape->layers) &&
+		(candidates->sensors || !shape->sensor)
+	){
+		if(candidates->count < BATCH_CANDIDATES) candidates->shapes[candidates->count] = shape;
+		candidates->count++;
+	}
+}
+
+// Collect the shapes in both spatial indexes overlapping bb, in the same order the single queries find them.
+// Returns false if there were too many to hold and the cluster's queries need to be run one at a time.
+static cpBool
+CollectCandidates(cpSpatialIndex *first, cpSpatialIndex *second, cpBB bb, struct BatchCandidates *candidates, int *clusterSize, int clusterMax)
+{
+	if(clusterMax == 1) return cpFalse;
+	
+	candidates->count = 0;
+	cpSpatialIndexQuery(first, candidates, bb, (cpSpatialIndexQueryFunc)CollectCandidate, NULL);
+	cpSpatialIndexQuery(second, candidates, bb, (cpSpatialIndexQueryFunc)CollectCandidate, NULL);
+	
+	int count = candidates->count;
+	if(count > BATCH_CANDIDATES){
+		if(*clusterSize > 1) (*clusterSize) /= 2;
+		return cpFalse;
+	} else {
+		if(count <= BATCH_CANDIDATES/4 && *clusterSize < clusterMax) (*clusterSize) *= 2;
+		return cpTrue;
+	}
+}
+
+static void
+PointQueryFirstBatch(struct PointQueryContext *context, cpShape *shape, cpShape **out)
+{
+	if(
+		!shape->sensor &&
+		!(shape->group && context->group == shape->group) && (context->layers&shape->layers) &&
+		cpShapePointQuery(shape, context->point)
+	){
+		(*out) = shape;
+	}
+}
+
+void
+cpSpacePointQueryFirstBatch(cpSpace *space, int count, const cpVect *points, cpLayers layers, cpGroup group, cpShape **out)
+{
+	struct PointQueryContext context = {cpvzero, layers, group, NULL, NULL};
+	struct BatchCandidates candidates = {layers, group, cpFalse};
+	cpSpatialIndex *activeShapes = space->activeShapes, *staticShapes = space->staticShapes;
+	int clusterMax = BatchClusterMax(space), clusterSize = clusterMax;
+	
+	for(int first=0; first<count;){
+		int last = (count - first > clusterSize ? first + clusterSize : count);
+		
+		cpBB bb = cpBBNewForCircle(points[first], 0.0f);
+		for(int i=first+1; i<last; i++) bb = cpBBMerge(bb, cpBBNewForCircle(points[i], 0.0f));
+		
+		if(CollectCandidates(activeShapes, staticShapes, bb, &candidates, &clusterSize, clusterMax)){
+			for(int i=first; i<last; i++){
+				cpVect point = points[i];
+				out[i] = NULL;
+				
+				for(int j=0; j<candidates.count; j++){
+					cpShape *shape = candidates.shapes[j];
+					if(cpBBContainsVect(shape->bb, point) && cpShapePointQuery(shape, point)) out[i] = shape;
+				}
+			}
+		} else {
+			for(int i=first; i<last; i++){
+				context.point = points[i];
+				bb = cpBBNewForCircle(context.point, 0.0f);
+				
+				out[i] = NULL;
+				cpSpatialIndexQuery(activeShapes, &context, bb, (cpSpatialIndexQueryFunc)PointQueryFirstBatch, out + i);
+				cpSpatialIndexQuery(staticShapes, &context, bb, (cpSpatialIndexQueryFunc)PointQueryFirstBatch, out + i);
+			}
+		}
+		
+		first = last;
+	}
+}
+
+void
+cpSpaceNearestPointQueryNearestBatch(cpSpace *space, int count, const cpVect *points, cpFloat maxDistance, cpLayers layers, cpGroup group, cpNearestPointQueryInfo *out)
+{
+	struct NearestPointQueryContext context = {cpvzero, maxDistance, layers, group, NULL};
+	struct BatchCandidates candidates = {layers, group, cpFalse};
+	cpSpatialIndex *activeShapes = space->activeShapes, *staticShapes = space->staticShapes;
+	cpFloat radius = cpfmax(maxDistance, 0.0f);
+	int clusterMax = BatchClusterMax(space), clusterSize = clusterMax;
+	
+	for(int first=0; first<count;){
+		int last = (count - first > clusterSize ? first + clusterSize : count);
+		
+		cpBB bb = cpBBNewForCircle(points[first], radius);
+		for(int i=first+1; i<last; i++) bb = cpBBMerge(bb, cpBBNewForCircle(points[i], radius));
+		
+		if(CollectCandidates(activeShapes, staticShapes, bb, &candidates, &clusterSize, clusterMax)){
+			for(int i=first; i<last; i++){
+				cpNearestPointQueryInfo nearest = {NULL, cpvzero, maxDistance};
+				cpVect point = points[i];
+				cpBB queryBB = cpBBNewForCircle(point, radius);
+				
+				for(int j=0; j<candidates.count; j++){
+					cpShape *shape = candidates.shapes[j];
+					if(!cpBBIntersects(queryBB, shape->bb)) continue;
+					
+					cpNearestPointQueryInfo info;
+					cpShapeNearestPointQuery(shape, point, &info);
+					if(info.d < nearest.d) nearest = info;
+				}
+				
+				out[i] = nearest;
+			}
+		} else {
+			for(int i=first; i<last; i++){
+				cpNearestPointQueryInfo info = {NULL, cpvzero, maxDistance};
+				out[i] = info;
+				
+				context.point = points[i];
+				bb = cpBBNewForCircle(context.point, radius);
+				cpSpatialIndexQuery(activeShapes, &context, bb, (cpSpatialIndexQueryFunc)NearestPointQueryNearest, out + i);
+				cpSpatialIndexQuery(staticShapes, &context, bb, (cpSpatialIndexQueryFunc)NearestPointQueryNearest, out + i);
+			}
+		}
+		
+		first = last;
+	}
+}
+
+void
+cpSpaceSegmentQueryFirstBatch(cpSpace *space, int count, const cpVect *starts, const cpVect *ends, cpLayers layers, cpGroup group, cpSegmentQueryInfo *out)
+{
+	struct SegmentQueryContext context = {cpvzero, cpvzero, layers, group, NULL};
+	struct BatchCandidates candidates = {layers, group, cpFalse};
+	cpSpatialIndex *activeShapes = space->activeShapes, *staticShapes = space->staticShapes;
+	int clusterMax = BatchClusterMax(space), clusterSize = clusterMax;
+	
+	for(int first=0; first<count;){
+		int last = (count - first > clusterSize ? first + clusterSize : count);
+		
+		cpBB bb = cpBBNew(starts[first].x, starts[first].y, starts[first].x, starts[first].y);
+		for(int i=first; i<last; i++) bb = cpBBExpand(cpBBExpand(bb, starts[i]), ends[i]);
+		
+		// Static shapes first to match cpSpaceSegmentQueryFirst() when two shapes are hit at the same distance.
+		if(CollectCandidates(staticShapes, activeShapes, bb, &candidates, &clusterSize, clusterMax)){
+			for(int i=first; i<last; i++){
+				cpSegmentQueryInfo hit = {NULL, 1.0f, cpvzero};
+				cpVect start = starts[i], end = ends[i];
+				
+				for(int j=0; j<candidates.count; j++){
+					cpShape *shape = candidates.shapes[j];
+					if(!cpBBIntersectsSegment(shape->bb, start, end)) continue;
+					
+					cpSegmentQueryInfo info;
+					if(cpShapeSegmentQuery(shape, start, end, &info) && info.t < hit.t) hit = info;
+				}
+				
+				out[i] = hit;
+			}
+		} else {
+			for(int i=first; i<last; i++){
+				cpSegmentQueryInfo info = {NULL, 1.0f, cpvzero};
+				out[i] = info;
+				
+				cpVect start = starts[i], end = ends[i];
+				context.start = start;
+				context.end = end;
+				
+				// Static geometry usually blocks most rays, so query it first to shorten the active query.
+				cpSpatialIndexSegmentQuery(staticShapes, &context, start, end, 1.0f, (cpSpatialIndexSegmentQueryFunc)SegmentQueryFirst, out + i);
+				cpSpatialIndexSegmentQuery(activeShapes, &context, start, end, out[i].t, (cpSpatialIndexSegmentQueryFunc)SegmentQueryFirst, out + i);
+			}
+		}
+		
+		first = last;
+	}
+}
+
+struct BBQueryBatchContext {
+	struct BBQueryContext query;
+	int index;
+	cpBBQueryBatchHit *hits;
+	int maxHits, numHits;
+};
+
+static inline void
+PushBBQueryBatchHit(struct BBQueryBatchContext *context, cpShape *shape)
+{
+	if(context->numHits < context->maxHits){
+		cpBBQueryBatchHit hit = {context->index, shape};
+		context->hits[context->numHits] = hit;
+	}
+	
+	context->numHits++;
+}
+
+static void
+BBQueryBatch(struct BBQueryBatchContext *context, cpShape *shape, void *unused)
+{
+	struct BBQueryContext *query = &context->query;
+	
+	if(
+		!(shape->group && query->group == shape->group) && (query->layers&shape->layers) &&
+		cpBBIntersects(query->bb, shape->bb)
+	){
+		PushBBQueryBatchHit(context, shape);
+	}
+}
+
+int
+cpSpaceBBQueryBatch(cpSpace *space, int count, const cpBB *bbs, cpLayers layers, cpGroup group, cpBBQueryBatchHit *hits, int maxHits)
+{
+	struct BBQueryBatchContext context = {{cpBBNew(0.0f, 0.0f, 0.0f, 0.0f), layers, group, NULL}, 0, hits, maxHits, 0};
+	struct BatchCandidates candidates = {layers, group, cpTrue};
+	cpSpatialIndex *activeShapes = space->activeShapes, *staticShapes = space->staticShapes;
+	int clusterMax = BatchClusterMax(space), clusterSize = clusterMax;
+	
+	for(int first=0; first<count;){
+		int last = (count - first > clusterSize ? first + clusterSize : count);
+		
+		cpBB bb = bbs[first];
+		for(int i=first+1; i<last; i++) bb = cpBBMerge(bb, bbs[i]);
+		
+		if(CollectCandidates(activeShapes, staticShapes, bb, &candidates, &clusterSize, clusterMax)){
+			for(int i=first; i<last; i++){
+				context.index = i;
+				
+				for(int j=0; j<candidates.count; j++){
+					cpShape *shape = candidates.shapes[j];
+					if(cpBBIntersects(bbs[i], shape->bb)) PushBBQueryBatchHit(&context, shape);
+				}
+			}
+		} else {
+			for(int i=first; i<last; i++){
+				context.query.bb = bbs[i];
+				context.index = i;
+				
+				cpSpatialIndexQuery(activeShapes, &context, bbs[i], (cpSpatialIndexQueryFunc)BBQueryBatch, NULL);
+				cpSpatialIndexQuery(staticShapes, &context, bbs[i], (cpSpatialIndexQueryFunc)BBQueryBatch, NULL);
+			}
+		}
+		
+		first = last;
+	}
+	
+	return context.numHits;
+}
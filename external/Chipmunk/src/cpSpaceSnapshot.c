@@ -0,0 +1,868 @@
+/* Copyright (c) 2007 Scott Lembcke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+ 
+ 
+#include <string.h>
+
+#include "chipmunk_private.h"
+#include "chipmunk_unsafe.h"
+
+// Snapshots store raw object pointers, so they can only be restored to the same space they were
+// taken from, and only while that space contains the exact same bodies, constraints and shapes.
+// The pointers are looked up in the space before they are used, so a snapshot of objects that were freed is rejected.
+// This is what rollback and fast reloads need, and keeps saving and restoring to a couple of memcpy()s per object.
+
+#define SNAPSHOT_MAGIC 0x63705353 // 'cpSS'
+#define SNAPSHOT_VERSION 3
+
+// Keep every record aligned to the largest member type.
+#define SNAPSHOT_ALIGN(size) (((size) + sizeof(cpFloat) - 1) & ~(sizeof(cpFloat) - 1))
+
+typedef struct SnapshotHeader {
+	unsigned int magic, version;
+	size_t size;
+	
+	int numBodies, numConstraints, numShapes, numArbiters;
+	
+	cpTimestamp stamp;
+	cpFloat curr_dt;
+} SnapshotHeader;
+
+typedef struct BodyRecord {
+	cpBody *body;
+	// Root of the sleeping component the body belongs to, NULL if it's awake.
+	cpBody *root;
+	
+	cpFloat m, m_inv, i, i_inv;
+	cpVect p, v, f;
+	cpFloat a, w, t;
+	cpVect rot;
+	
+	cpVect v_bias;
+	cpFloat w_bias;
+	cpFloat idleTime;
+} BodyRecord;
+
+typedef struct ConstraintRecord {
+	cpConstraint *constraint;
+	// Number of bytes of joint specific data following this record.
+	size_t bytes;
+} ConstraintRecord;
+
+typedef struct ShapeRecord {
+	cpShape *shape;
+	
+	cpBool sensor;
+	cpFloat e, u;
+	cpVect surface_v;
+	
+	cpCollisionType collision_type;
+	cpGroup group;
+	cpLayers layers;
+	
+	// Geometry that can be changed with chipmunk_unsafe.h. The radius of circles and segments,
+	// followed by numVerts vertexes: the center of a circle, the endpoints and neighbor tangents of a segment or the verts of a poly.
+	cpFloat r;
+	int numVerts;
+} ShapeRecord;
+
+enum {
+	ARBITER_ACTIVE = 1<<0,
+	ARBITER_SLEEPING = 1<<1,
+};
+
+typedef struct ArbiterRecord {
+	cpShape *a, *b;
+	
+	cpFloat e, u;
+	cpVect surface_vr;
+	
+	cpTimestamp stamp;
+	cpArbiterState state;
+	cpBool swappedColl;
+	int flags;
+	
+	// Number of contacts following this record.
+	int numContacts;
+} ArbiterRecord;
+
+//MARK: Constraint Helpers
+
+static size_t
+ConstraintJointBytes(cpConstraint *constraint)
+{
+	const cpConstraintClass *klass = constraint->klass;
+	size_t size = 0;
+	
+	if(klass == cpPinJointGetClass()){
+		size = sizeof(cpPinJoint);
+	} else if(klass == cpSlideJointGetClass()){
+		size = sizeof(cpSlideJoint);
+	} else if(klass == cpPivotJointGetClass()){
+		size = sizeof(cpPivotJoint);
+	} else if(klass == cpGrooveJointGetClass()){
+		size = sizeof(cpGrooveJoint);
+	} else if(klass == cpDampedSpringGetClass()){
+		size = sizeof(cpDampedSpring);
+	} else if(klass == cpDampedRotarySpringGetClass()){
+		size = sizeof(cpDampedRotarySpring);
+	} else if(klass == cpRotaryLimitJointGetClass()){
+		size = sizeof(cpRotaryLimitJoint);
+	} else if(klass == cpRatchetJointGetClass()){
+		size = sizeof(cpRatchetJoint);
+	} else if(klass == cpGearJointGetClass()){
+		size = sizeof(cpGearJoint);
+	} else if(klass == cpSimpleMotorGetClass()){
+		size = sizeof(cpSimpleMotor);
+	} else {
+		cpAssertWarn(cpFalse, "Unknown constraint type. Only the base constraint state will be saved to the snapshot.");
+		return 0;
+	}
+	
+	return size - sizeof(cpConstraint);
+}
+
+// Sleeping constraints are owned by the first awake or non-static body, same as cpSpaceDeactivateBody().
+#define CP_SLEEPING_COMPONENT_FOREACH_CONSTRAINT(body, var) \
+	CP_BODY_FOREACH_CONSTRAINT(body, var) if(body == var->a || cpBodyIsStatic(var->a))
+
+#define CP_SLEEPING_COMPONENT_FOREACH_ARBITER(body, var) \
+	CP_BODY_FOREACH_ARBITER(body, var) if(body == var->body_a || cpBodyIsStatic(var->body_a))
+
+//MARK: Saving
+
+typedef struct SnapshotWriter {
+	char *cursor;
+	size_t size;
+	cpBool write;
+} SnapshotWriter;
+
+static inline void *
+WriterReserve(SnapshotWriter *writer, size_t bytes)
+{
+	void *ptr = writer->cursor + writer->size;
+	writer->size += SNAPSHOT_ALIGN(bytes);
+	
+	return (writer->write ? ptr : NULL);
+}
+
+static void
+WriteBody(SnapshotWriter *writer, cpBody *body, cpBody *root)
+{
+	BodyRecord *record = (BodyRecord *)WriterReserve(writer, sizeof(BodyRecord));
+	if(!record) return;
+	
+	record->body = body;
+	record->root = root;
+	
+	record->m = body->m; record->m_inv = body->m_inv;
+	record->i = body->i; record->i_inv = body->i_inv;
+	record->p = body->p; record->v = body->v; record->f = body->f;
+	record->a = body->a; record->w = body->w; record->t = body->t;
+	record->rot = body->rot;
+	
+	record->v_bias = body->v_bias;
+	record->w_bias = body->w_bias;
+	record->idleTime = body->node.idleTime;
+}
+
+static void
+WriteConstraint(SnapshotWriter *writer, cpConstraint *constraint)
+{
+	size_t bytes = ConstraintJointBytes(constraint);
+	
+	ConstraintRecord *record = (ConstraintRecord *)WriterReserve(writer, sizeof(ConstraintRecord));
+	char *jointData = (char *)WriterReserve(writer, bytes);
+	if(!record) return;
+	
+	record->constraint = constraint;
+	record->bytes = bytes;
+	memcpy(jointData, constraint + 1, bytes);
+}
+
+static void
+WriteArbiter(SnapshotWriter *writer, cpArbiter *arb, int flags)
+{
+	int numContacts = (arb->contacts ? arb->numContacts : 0);
+	
+	ArbiterRecord *record = (ArbiterRecord *)WriterReserve(writer, sizeof(ArbiterRecord));
+	cpContact *contacts = (cpContact *)WriterReserve(writer, numContacts*sizeof(cpContact));
+	if(!record) return;
+	
+	record->a = arb->a; record->b = arb->b;
+	record->e = arb->e; record->u = arb->u;
+	record->surface_vr = arb->surface_vr;
+	
+	record->stamp = arb->stamp;
+	record->state = arb->state;
+	record->swappedColl = arb->swappedColl;
+	record->flags = flags;
+	
+	record->numContacts = numContacts;
+	memcpy(contacts, arb->contacts, numContacts*sizeof(cpContact));
+}
+
+static void
+WriteShape(cpShape *shape, SnapshotWriter *writer)
+{
+	const cpShapeClass *klass = shape->klass;
+	int numVerts = 0;
+	cpVect geometry[4];
+	const cpVect *verts = geometry;
+	cpFloat r = 0.0f;
+	
+	if(klass == &cpCircleShapeClass){
+		cpCircleShape *circle = (cpCircleShape *)shape;
+		r = circle->r;
+		geometry[0] = circle->c;
+		numVerts = 1;
+	} else if(klass == &cpSegmentShapeClass){
+		cpSegmentShape *seg = (cpSegmentShape *)shape;
+		r = seg->r;
+		geometry[0] = seg->a; geometry[1] = seg->b;
+		geometry[2] = seg->a_tangent; geometry[3] = seg->b_tangent;
+		numVerts = 4;
+	} else if(klass == &cpPolyShapeClass){
+		cpPolyShape *poly = (cpPolyShape *)shape;
+		verts = poly->verts;
+		numVerts = poly->numVerts;
+	}
+	
+	ShapeRecord *record = (ShapeRecord *)WriterReserve(writer, sizeof(ShapeRecord));
+	cpVect *recordVerts = (cpVect *)WriterReserve(writer, numVerts*sizeof(cpVect));
+	if(!record) return;
+	
+	record->shape = shape;
+	record->sensor = shape->sensor;
+	record->e = shape->e; record->u = shape->u;
+	record->surface_v = shape->surface_v;
+	
+	record->collision_type = shape->collision_type;
+	record->group = shape->group;
+	record->layers = shape->layers;
+	
+	record->r = r;
+	record->numVerts = numVerts;
+	memcpy(recordVerts, verts, numVerts*sizeof(cpVect));
+}
+
+typedef struct CachedArbiterContext {
+	SnapshotWriter *writer;
+	cpSpace *space;
+	int count;
+} CachedArbiterContext;
+
+static void
+WriteCachedArbiter(cpArbiter *arb, CachedArbiterContext *context)
+{
+	// Arbiters that were handed to the solver in the last step are the only ones with a current stamp and contacts.
+	cpBool active = (arb->stamp == context->space->stamp && arb->contacts && arb->state != cpArbiterStateIgnore);
+	
+	WriteArbiter(context->writer, arb, active ? ARBITER_ACTIVE : 0);
+	context->count++;
+}
+
+size_t
+cpSpaceSaveSnapshot(cpSpace *space, void *buffer, size_t capacity)
+{
+	cpAssertHard(!space->locked, "You cannot save a snapshot while the space is locked. Wait until the current query or step is complete.");
+	
+	// Run once to measure the size, then again to write if there is enough room.
+	for(int pass=0; pass<2; pass++){
+		SnapshotWriter writer = {(char *)buffer, 0, pass == 1};
+		SnapshotHeader *header = (SnapshotHeader *)WriterReserve(&writer, sizeof(SnapshotHeader));
+		
+		int numBodies = 0, numConstraints = 0, numArbiters = 0;
+		cpArray *components = space->sleepingComponents;
+		
+		// Awake bodies first, then the sleeping components in order.
+		cpArray *bodies = space->bodies;
+		for(int i=0; i<bodies->num; i++, numBodies++) WriteBody(&writer, (cpBody *)bodies->arr[i], NULL);
+		
+		for(int i=0; i<components->num; i++){
+			cpBody *root = (cpBody *)components->arr[i];
+			CP_BODY_FOREACH_COMPONENT(root, body){ WriteBody(&writer, body, root); numBodies++; }
+		}
+		
+		cpArray *constraints = space->constraints;
+		for(int i=0; i<constraints->num; i++, numConstraints++) WriteConstraint(&writer, (cpConstraint *)constraints->arr[i]);
+		
+		for(int i=0; i<components->num; i++){
+			CP_BODY_FOREACH_COMPONENT((cpBody *)components->arr[i], body){
+				CP_SLEEPING_COMPONENT_FOREACH_CONSTRAINT(body, constraint){ WriteConstraint(&writer, constraint); numConstraints++; }
+			}
+		}
+		
+		// Sleeping bodies keep their shapes in the static index.
+		int numShapes = cpSpatialIndexCount(space->activeShapes) + cpSpatialIndexCount(space->staticShapes);
+		cpSpatialIndexEach(space->activeShapes, (cpSpatialIndexIteratorFunc)WriteShape, &writer);
+		cpSpatialIndexEach(space->staticShapes, (cpSpatialIndexIteratorFunc)WriteShape, &writer);
+		
+		CachedArbiterContext context = {&writer, space, 0};
+		cpHashSetEach(space->cachedArbiters, (cpHashSetIteratorFunc)WriteCachedArbiter, &context);
+		numArbiters = context.count;
+		
+		for(int i=0; i<components->num; i++){
+			CP_BODY_FOREACH_COMPONENT((cpBody *)components->arr[i], body){
+				CP_SLEEPING_COMPONENT_FOREACH_ARBITER(body, arb){ WriteArbiter(&writer, arb, ARBITER_SLEEPING); numArbiters++; }
+			}
+		}
+		
+		if(header){
+			header->magic = SNAPSHOT_MAGIC;
+			header->version = SNAPSHOT_VERSION;
+			header->size = writer.size;
+			
+			header->numBodies = numBodies;
+			header->numConstraints = numConstraints;
+			header->numShapes = numShapes;
+			header->numArbiters = numArbiters;
+			
+			header->stamp = space->stamp;
+			header->curr_dt = space->curr_dt;
+		}
+		
+		// Stop after measuring if there isn't enough room.
+		if(pass == 1 || !buffer || writer.size > capacity) return writer.size;
+	}
+	
+	return 0;
+}
+
+//MARK: Restoring
+
+static inline const void *
+ReaderNext(const char **cursor, size_t bytes)
+{
+	const void *ptr = *cursor;
+	(*cursor) += SNAPSHOT_ALIGN(bytes);
+	
+	return ptr;
+}
+
+static int
+CountSpaceBodies(cpSpace *space)
+{
+	int count = space->bodies->num;
+	
+	cpArray *components = space->sleepingComponents;
+	for(int i=0; i<components->num; i++){
+		CP_BODY_FOREACH_COMPONENT((cpBody *)components->arr[i], body) count++;
+	}
+	
+	return count;
+}
+
+static int
+CountSpaceConstraints(cpSpace *space)
+{
+	int count = space->constraints->num;
+	
+	cpArray *components = space->sleepingComponents;
+	for(int i=0; i<components->num; i++){
+		CP_BODY_FOREACH_COMPONENT((cpBody *)components->arr[i], body){
+			CP_SLEEPING_COMPONENT_FOREACH_CONSTRAINT(body, constraint) count++;
+		}
+	}
+	
+	return count;
+}
+
+// Sorted addresses of the objects in the space, used to check the pointers in a snapshot before following them.
+typedef struct PointerSet {
+	void **ptrs;
+	// Set when a record for the object was found, so that each object is only restored once.
+	unsigned char *claimed;
+	int count;
+} PointerSet;
+
+static int
+ComparePointers(const void *a, const void *b)
+{
+	uintptr_t pa = (uintptr_t)*(void * const *)a, pb = (uintptr_t)*(void * const *)b;
+	return (pa < pb ? -1 : (pa > pb ? 1 : 0));
+}
+
+static void PointerSetAdd(void *ptr, PointerSet *set){set->ptrs[set->count++] = ptr;}
+
+static void
+PointerSetInit(PointerSet *set, int capacity)
+{
+	set->ptrs = (void **)cpcalloc(capacity ? capacity : 1, sizeof(void *));
+	set->claimed = (unsigned char *)cpcalloc(capacity ? capacity : 1, sizeof(unsigned char));
+	set->count = 0;
+}
+
+static void
+PointerSetDestroy(PointerSet *set)
+{
+	cpfree(set->ptrs);
+	cpfree(set->claimed);
+}
+
+static void **
+PointerSetFind(PointerSet *set, void *ptr)
+{
+	return (void **)bsearch(&ptr, set->ptrs, set->count, sizeof(void *), ComparePointers);
+}
+
+// Returns false if @c ptr isn't in the set or was already claimed.
+static cpBool
+PointerSetClaim(PointerSet *set, void *ptr)
+{
+	void **found = PointerSetFind(set, ptr);
+	if(!found) return cpFalse;
+	
+	unsigned char *claimed = set->claimed + (found - set->ptrs);
+	if(*claimed) return cpFalse;
+	
+	*claimed = 1;
+	return cpTrue;
+}
+
+static void
+CollectBodies(cpSpace *space, PointerSet *set)
+{
+	PointerSetInit(set, CountSpaceBodies(space));
+	
+	cpArray *bodies = space->bodies;
+	for(int i=0; i<bodies->num; i++) PointerSetAdd(bodies->arr[i], set);
+	
+	cpArray *components = space->sleepingComponents;
+	for(int i=0; i<components->num; i++){
+		CP_BODY_FOREACH_COMPONENT((cpBody *)components->arr[i], body) PointerSetAdd(body, set);
+	}
+	
+	qsort(set->ptrs, set->count, sizeof(void *), ComparePointers);
+}
+
+static void
+CollectConstraints(cpSpace *space, PointerSet *set)
+{
+	PointerSetInit(set, CountSpaceConstraints(space));
+	
+	cpArray *constraints = space->constraints;
+	for(int i=0; i<constraints->num; i++) PointerSetAdd(constraints->arr[i], set);
+	
+	cpArray *components = space->sleepingComponents;
+	for(int i=0; i<components->num; i++){
+		CP_BODY_FOREACH_COMPONENT((cpBody *)components->arr[i], body){
+			CP_SLEEPING_COMPONENT_FOREACH_CONSTRAINT(body, constraint) PointerSetAdd(constraint, set);
+		}
+	}
+	
+	qsort(set->ptrs, set->count, sizeof(void *), ComparePointers);
+}
+
+static void
+CollectShapes(cpSpace *space, PointerSet *set)
+{
+	PointerSetInit(set, cpSpatialIndexCount(space->activeShapes) + cpSpatialIndexCount(space->staticShapes));
+	cpSpatialIndexEach(space->activeShapes, (cpSpatialIndexIteratorFunc)PointerSetAdd, set);
+	cpSpatialIndexEach(space->staticShapes, (cpSpatialIndexIteratorFunc)PointerSetAdd, set);
+	
+	qsort(set->ptrs, set->count, sizeof(void *), ComparePointers);
+}
+
+// Checks that the records fit in the snapshot and that every pointer in them refers to an object in the space.
+// Nothing a record points to is read until it has been found in the space.
+static cpBool
+SnapshotRecordsAreValid(cpSpace *space, const SnapshotHeader *header)
+{
+	const char *cursor = (const char *)header + SNAPSHOT_ALIGN(sizeof(SnapshotHeader));
+	const char *end = (const char *)header + header->size;
+	cpBool valid = cpFalse;
+	
+	PointerSet bodies, constraints, shapes;
+	CollectBodies(space, &bodies);
+	CollectConstraints(space, &constraints);
+	CollectShapes(space, &shapes);
+	
+	for(int i=0; i<header->numBodies; i++){
+		const BodyRecord *record = (const BodyRecord *)ReaderNext(&cursor, sizeof(BodyRecord));
+		if(cursor > end || !PointerSetClaim(&bodies, record->body)) goto done;
+		if(record->root && !PointerSetFind(&bodies, record->root)) goto done;
+	}
+	
+	for(int i=0; i<header->numConstraints; i++){
+		const ConstraintRecord *record = (const ConstraintRecord *)ReaderNext(&cursor, sizeof(ConstraintRecord));
+		if(cursor > end || !PointerSetClaim(&constraints, record->constraint)) goto done;
+		if(record->bytes != ConstraintJointBytes(record->constraint)) goto done;
+		ReaderNext(&cursor, record->bytes);
+	}
+	
+	for(int i=0; i<header->numShapes; i++){
+		const ShapeRecord *record = (const ShapeRecord *)ReaderNext(&cursor, sizeof(ShapeRecord));
+		if(cursor > end || !PointerSetClaim(&shapes, record->shape)) goto done;
+		
+		const cpShapeClass *klass = record->shape->klass;
+		int numVerts = record->numVerts;
+		if(klass == &cpCircleShapeClass){
+			if(numVerts != 1) goto done;
+		} else if(klass == &cpSegmentShapeClass){
+			if(numVerts != 4) goto done;
+		} else if(klass == &cpPolyShapeClass){
+			if(numVerts < 3) goto done;
+		} else if(numVerts != 0){
+			goto done;
+		}
+		
+		ReaderNext(&cursor, numVerts*sizeof(cpVect));
+	}
+	
+	for(int i=0; i<header->numArbiters; i++){
+		const ArbiterRecord *record = (const ArbiterRecord *)ReaderNext(&cursor, sizeof(ArbiterRecord));
+		if(cursor > end || !PointerSetFind(&shapes, record->a) || !PointerSetFind(&shapes, record->b)) goto done;
+		if(record->numContacts < 0 || record->numContacts > CP_MAX_CONTACTS_PER_ARBITER) goto done;
+		ReaderNext(&cursor, record->numContacts*sizeof(cpContact));
+	}
+	
+	valid = (cursor == end);
+	
+done:
+	PointerSetDestroy(&bodies);
+	PointerSetDestroy(&constraints);
+	PointerSetDestroy(&shapes);
+	
+	return valid;
+}
+
+static cpBool
+SnapshotIsValid(cpSpace *space, const SnapshotHeader *header, size_t size)
+{
+	if(size < sizeof(SnapshotHeader) || header->magic != SNAPSHOT_MAGIC || header->version != SNAPSHOT_VERSION || header->size != size){
+		cpAssertWarn(cpFalse, "Snapshot data is invalid or was created by a different version of Chipmunk.");
+		return cpFalse;
+	}
+	
+	int numShapes = cpSpatialIndexCount(space->activeShapes) + cpSpatialIndexCount(space->staticShapes);
+	if(header->numBodies != CountSpaceBodies(space) || header->numConstraints != CountSpaceConstraints(space) || header->numShapes != numShapes){
+		cpAssertWarn(cpFalse, "Bodies, constraints or shapes were added or removed since the snapshot was saved.");
+		return cpFalse;
+	}
+	
+	if(!SnapshotRecordsAreValid(space, header)){
+		cpAssertWarn(cpFalse, "The snapshot refers to objects that are not in the space anymore.");
+		return cpFalse;
+	}
+	
+	return cpTrue;
+}
+
+static cpBool
+FlushArbiter(cpArbiter *arb, cpSpace *space)
+{
+	// Every arbiter in the contact graph is cached after waking up the sleeping components,
+	// so the whole graph is being thrown away and there is no need to unlink the arbiters one by one.
+	struct cpArbiterThread empty = {NULL, NULL};
+	arb->thread_a = arb->thread_b = empty;
+	arb->body_a->arbiterList = arb->body_b->arbiterList = NULL;
+	arb->contacts = NULL;
+	arb->numContacts = 0;
+	
+	cpArrayPush(space->pooledArbiters, arb);
+	return cpFalse;
+}
+
+// Most arbiters in a space share a handful of collision handlers, remember the last one looked up.
+typedef struct HandlerCache {
+	cpCollisionType a, b;
+	cpCollisionHandler *handler;
+} HandlerCache;
+
+// Returns true if the geometry of the shape changed.
+static cpBool
+RestoreShape(const ShapeRecord *record, const cpVect *verts)
+{
+	cpShape *shape = record->shape;
+	shape->sensor = record->sensor;
+	shape->e = record->e; shape->u = record->u;
+	shape->surface_v = record->surface_v;
+	
+	shape->collision_type = record->collision_type;
+	shape->group = record->group;
+	shape->layers = record->layers;
+	
+	const cpShapeClass *klass = shape->klass;
+	if(klass == &cpCircleShapeClass){
+		cpCircleShape *circle = (cpCircleShape *)shape;
+		if(circle->r == record->r && cpveql(circle->c, verts[0])) return cpFalse;
+		
+		circle->r = record->r;
+		circle->c = verts[0];
+	} else if(klass == &cpSegmentShapeClass){
+		cpSegmentShape *seg = (cpSegmentShape *)shape;
+		if(
+			seg->r == record->r && cpveql(seg->a, verts[0]) && cpveql(seg->b, verts[1]) &&
+			cpveql(seg->a_tangent, verts[2]) && cpveql(seg->b_tangent, verts[3])
+		) return cpFalse;
+		
+		cpSegmentShapeSetEndpoints(shape, verts[0], verts[1]);
+		seg->r = record->r;
+		seg->a_tangent = verts[2];
+		seg->b_tangent = verts[3];
+	} else if(klass == &cpPolyShapeClass){
+		cpPolyShape *poly = (cpPolyShape *)shape;
+		if(poly->numVerts == record->numVerts && memcmp(poly->verts, verts, record->numVerts*sizeof(cpVect)) == 0) return cpFalse;
+		
+		cpPolyShapeSetVerts(shape, record->numVerts, (cpVect *)verts, cpvzero);
+	} else {
+		return cpFalse;
+	}
+	
+	return cpTrue;
+}
+
+static void
+RestoreArbiter(cpSpace *space, const ArbiterRecord *record, const cpContact *contacts, HandlerCache *cache)
+{
+	cpShape *a = record->a, *b = record->b;
+	cpShape *shape_pair[] = {a, b};
+	cpHashValue arbHashID = CP_HASH_PAIR((cpHashValue)a, (cpHashValue)b);
+	cpArbiter *arb = (cpArbiter *)cpHashSetInsert(space->cachedArbiters, arbHashID, shape_pair, space, (cpHashSetTransFunc)cpSpaceArbiterSetTrans);
+	
+	arb->e = record->e; arb->u = record->u;
+	arb->surface_vr = record->surface_vr;
+	
+	arb->stamp = record->stamp;
+	arb->state = record->state;
+	arb->swappedColl = record->swappedColl;
+	
+	if(!cache->handler || cache->a != a->collision_type || cache->b != b->collision_type){
+		cache->a = a->collision_type;
+		cache->b = b->collision_type;
+		cache->handler = cpSpaceLookupHandler(space, cache->a, cache->b);
+	}
+	arb->handler = cache->handler;
+	
+	int numContacts = record->numContacts;
+	if(numContacts){
+		arb->contacts = cpContactBufferGetArray(space);
+		memcpy(arb->contacts, contacts, numContacts*sizeof(cpContact));
+		arb->numContacts = numContacts;
+		cpSpacePushContacts(space, numContacts);
+	}
+	
+	// Rebuild the contact graph as it was at the end of the step.
+	if(record->flags & (ARBITER_ACTIVE | ARBITER_SLEEPING)){
+		cpBodyPushArbiter(arb->body_a, arb);
+		cpBodyPushArbiter(arb->body_b, arb);
+	}
+	
+	if(record->flags & ARBITER_ACTIVE && !(record->flags & ARBITER_SLEEPING)){
+		cpArrayPush(space->arbiters, arb);
+	}
+}
+
+cpBool
+cpSpaceRestoreSnapshot(cpSpace *space, const void *buffer, size_t size)
+{
+	cpAssertHard(!space->locked, "You cannot restore a snapshot while the space is locked. Wait until the current query or step is complete.");
+	cpAssertWarn(space->deterministic, "Restoring a snapshot only replays exactly if the space is deterministic. Call cpSpaceSetDeterministic() before saving it.");
+	
+	const SnapshotHeader *header = (const SnapshotHeader *)buffer;
+	if(!SnapshotIsValid(space, header, size)) return cpFalse;
+	
+	// Wake everything up and throw away all of the collision data.
+	// This puts the space into a known state that the snapshot can be applied on top of.
+	cpArray *components = space->sleepingComponents;
+	while(components->num) cpBodyActivate((cpBody *)components->arr[0]);
+	
+	cpHashSetFilter(space->cachedArbiters, (cpHashSetFilterFunc)FlushArbiter, space);
+	space->arbiters->num = 0;
+	
+	space->stamp = header->stamp;
+	space->curr_dt = header->curr_dt;
+	cpSpaceExpireContactBuffers(space);
+	
+	const char *cursor = (const char *)buffer + SNAPSHOT_ALIGN(sizeof(SnapshotHeader));
+	
+	// The shapes come after the bodies and constraints in the snapshot, but their geometry has to be restored
+	// before the bodies update their bounding boxes.
+	const char *shapeCursor = cursor + header->numBodies*SNAPSHOT_ALIGN(sizeof(BodyRecord));
+	for(int i=0; i<header->numConstraints; i++){
+		const ConstraintRecord *record = (const ConstraintRecord *)ReaderNext(&shapeCursor, sizeof(ConstraintRecord));
+		ReaderNext(&shapeCursor, record->bytes);
+	}
+	
+	for(int i=0; i<header->numShapes; i++){
+		const ShapeRecord *record = (const ShapeRecord *)ReaderNext(&shapeCursor, sizeof(ShapeRecord));
+		const cpVect *verts = (const cpVect *)ReaderNext(&shapeCursor, record->numVerts*sizeof(cpVect));
+		
+		// Static and rogue shapes aren't updated with the bodies below.
+		if(RestoreShape(record, verts)) cpSpaceReindexShape(space, record->shape);
+	}
+	
+	// Restore the bodies in their original order. Sleeping bodies are always at the end.
+	const BodyRecord *bodyRecords = (const BodyRecord *)cursor;
+	cpArray *bodies = space->bodies;
+	bodies->num = 0;
+	
+	for(int i=0; i<header->numBodies; i++){
+		const BodyRecord *record = (const BodyRecord *)ReaderNext(&cursor, sizeof(BodyRecord));
+		cpBody *body = record->body;
+		
+		body->m = record->m; body->m_inv = record->m_inv;
+		body->i = record->i; body->i_inv = record->i_inv;
+		body->p = record->p; body->v = record->v; body->f = record->f;
+		body->a = record->a; body->w = record->w; body->t = record->t;
+		body->rot = record->rot;
+		
+		body->v_bias = record->v_bias;
+		body->w_bias = record->w_bias;
+		body->node.idleTime = record->idleTime;
+		
+		cpArrayPush(bodies, body);
+		
+		// Reindexing the shapes one at a time only does work for the ones that moved out of their cached bounds.
+		// A full reindex would also walk every cached pair in a cpBBTree.
+		cpSpatialIndex *activeShapes = space->activeShapes;
+		CP_BODY_FOREACH_SHAPE(body, shape){
+			cpShapeUpdate(shape, body->p, body->rot);
+			cpSpatialIndexReindexObject(activeShapes, shape, shape->hashid);
+		}
+	}
+	
+	cpArray *constraints = space->constraints;
+	constraints->num = 0;
+	
+	for(int i=0; i<header->numConstraints; i++){
+		const ConstraintRecord *record = (const ConstraintRecord *)ReaderNext(&cursor, sizeof(ConstraintRecord));
+		const void *jointData = ReaderNext(&cursor, record->bytes);
+		
+		cpConstraint *constraint = record->constraint;
+		memcpy(constraint + 1, jointData, record->bytes);
+		cpArrayPush(constraints, constraint);
+	}
+	
+	// Skip the shapes, they were restored first.
+	cursor = shapeCursor;
+	
+	HandlerCache handlerCache = {0, 0, NULL};
+	for(int i=0; i<header->numArbiters; i++){
+		const ArbiterRecord *record = (const ArbiterRecord *)ReaderNext(&cursor, sizeof(ArbiterRecord));
+		const cpContact *contacts = (const cpContact *)ReaderNext(&cursor, record->numContacts*sizeof(cpContact));
+		RestoreArbiter(space, record, contacts, &handlerCache);
+	}
+	
+	space->rebuildComponents = cpTrue;
+	
+	// Put the sleeping components back to sleep.
+	for(int i=0; i<header->numBodies;){
+		cpBody *root = bodyRecords[i].root;
+		if(!root){ i++; continue; }
+		
+		// Count the bodies in this component.
+		int count = 1;
+		while(i + count < header->numBodies && bodyRecords[i + count].root == root) count++;
+		
+		cpBodySleepWithGroup(root, NULL);
+		
+		// cpBodySleepWithGroup() links new bodies right after the root, add them in reverse to keep the original order.
+		for(int j=count-1; j>0; j--) cpBodySleepWithGroup(bodyRecords[i + j].body, root);
+		for(int j=0; j<count; j++) bodyRecords[i + j].body->node.idleTime = bodyRecords[i + j].idleTime;
+		
+		i += count;
+	}
+	
+	return cpTrue;
+}
+
+//MARK: Checksum
+
+#define CHECKSUM_FNV_OFFSET 0xcbf29ce484222325ULL
+#define CHECKSUM_FNV_PRIME 0x100000001b3ULL
+
+// FNV-1a over the bits of a float, least significant byte first so the result doesn't depend on endianness.
+static inline uint64_t
+ChecksumFloat(uint64_t hash, cpFloat f)
+{
+	// 0 and -0 behave identically, don't let them make two simulations look different.
+	if(f == 0.0f) f = 0.0f;
+	
+#if CP_USE_DOUBLES
+	uint64_t bits;
+#else
+	uint32_t bits;
+#endif
+	memcpy(&bits, &f, sizeof(bits));
+	
+	for(unsigned int i=0; i<sizeof(bits); i++){
+		hash ^= (uint64_t)((bits >> (8*i)) & 0xFF);
+		hash *= CHECKSUM_FNV_PRIME;
+	}
+	
+	return hash;
+}
+
+static inline uint64_t
+ChecksumInt(uint64_t hash, uint64_t value)
+{
+	for(unsigned int i=0; i<sizeof(value); i++){
+		hash ^= (value >> (8*i)) & 0xFF;
+		hash *= CHECKSUM_FNV_PRIME;
+	}
+	
+	return hash;
+}
+
+static void
+ChecksumBody(cpBody *body, uint64_t *sum)
+{
+	uint64_t hash = CHECKSUM_FNV_OFFSET;
+	hash = ChecksumFloat(hash, body->p.x);
+	hash = ChecksumFloat(hash, body->p.y);
+	hash = ChecksumFloat(hash, body->v.x);
+	hash = ChecksumFloat(hash, body->v.y);
+	hash = ChecksumFloat(hash, body->a);
+	hash = ChecksumFloat(hash, body->w);
+	hash = ChecksumInt(hash, cpBodyIsSleeping(body));
+	
+	// Sum the body hashes so the checksum doesn't depend on the order of the bodies.
+	(*sum) += hash;
+}
+
+uint64_t
+cpSpaceGetChecksum(cpSpace *space)
+{
+	uint64_t sum = 0;
+	cpSpaceEachBody(space, (cpSpaceBodyIteratorFunc)ChecksumBody, &sum);
+	
+	cpArray *arbiters = space->arbiters;
+	for(int i=0; i<arbiters->num; i++){
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		cpHashValue a = arb->a->hashid, b = arb->b->hashid;
+		
+		uint64_t hash = CHECKSUM_FNV_OFFSET;
+		hash = ChecksumInt(hash, (a < b ? a : b));
+		hash = ChecksumInt(hash, (a < b ? b : a));
+		
+		for(int j=0; j<arb->numContacts; j++){
+			cpContact *con = arb->contacts + j;
+			hash = ChecksumFloat(hash, con->jnAcc);
+			hash = ChecksumFloat(hash, con->jtAcc);
+		}
+		
+		sum += hash;
+	}
+	
+	return sum;
+}
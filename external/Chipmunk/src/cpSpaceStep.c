@@ -19,6 +19,17 @@
  * SOFTWARE.
  */
  
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__APPLE__)
+	#include <mach/mach_time.h>
+#elif defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
 #include "chipmunk_private.h"
 
 //MARK: Post Step Callback Functions
@@ -117,9 +128,18 @@ typedef struct cpContactBuffer {
 static cpContactBufferHeader *
 cpSpaceAllocContactBuffer(cpSpace *space)
 {
-	cpContactBuffer *buffer = (cpContactBuffer *)cpcalloc(1, sizeof(cpContactBuffer));
-	cpArrayPush(space->allocatedBuffers, buffer);
-	return (cpContactBufferHeader *)buffer;
+	cpContactBufferStats *stats = &space->contactBufferStats;
+	stats->bytes += sizeof(cpContactBuffer);
+	if(stats->bytes > stats->peakBytes) stats->peakBytes = stats->bytes;
+	
+	return (cpContactBufferHeader *)cpAllocatorAllocBytes(space->allocator, sizeof(cpContactBuffer), CP_ALLOCATOR_CONTACTS);
+}
+
+static void
+cpSpaceFreeContactBuffer(cpSpace *space, cpContactBufferHeader *buffer)
+{
+	space->contactBufferStats.bytes -= sizeof(cpContactBuffer);
+	cpAllocatorFreeBytes(space->allocator, buffer, sizeof(cpContactBuffer), CP_ALLOCATOR_CONTACTS);
 }
 
 static cpContactBufferHeader *
@@ -132,27 +152,179 @@ cpContactBufferHeaderInit(cpContactBufferHeader *header, cpTimestamp stamp, cpCo
 	return header;
 }
 
+static inline cpBool
+cpContactBufferExpired(cpSpace *space, cpContactBufferHeader *buffer)
+{
+	return (space->stamp - buffer->stamp > space->collisionPersistence);
+}
+
+static void
+InvalidateArbiterContacts(cpArbiter *arb, cpSpace *space)
+{
+	// Arbiters updated during this step always have their contacts in a buffer from this step.
+	if(arb->stamp != space->stamp){
+		arb->contacts = NULL;
+		arb->numContacts = 0;
+	}
+}
+
+// Recycle every buffer from previous steps at once so the cached arbiters are only walked once per step.
+// The arbiters lose their cached impulses but are otherwise unaffected.
+static void
+cpSpaceEvictContactBuffers(cpSpace *space)
+{
+	cpHashSetEach(space->cachedArbiters, (cpHashSetIteratorFunc)InvalidateArbiterContacts, space);
+	
+	cpTimestamp stamp = space->stamp;
+	cpTimestamp expired = stamp - space->collisionPersistence - 1;
+	
+	// The ring is ordered from the oldest buffer at the tail to the head.
+	cpContactBufferHeader *tail = space->contactBuffersHead->next;
+	cpContactBufferHeader *buffer = tail;
+	do {
+		if(buffer->stamp == stamp) break;
+		
+		buffer->stamp = expired;
+		space->contactBufferStats.evictions++;
+		buffer = buffer->next;
+	} while(buffer != tail);
+}
+
+// Find a buffer for a new head when the tail of the ring is still in use.
+// Returns NULL if the tail was expired early to stay within the budget.
+static cpContactBufferHeader *
+cpSpaceGetContactBuffer(cpSpace *space)
+{
+	cpContactBufferStats *stats = &space->contactBufferStats;
+	
+	cpContactBufferHeader *pooled = space->pooledContactBuffers;
+	if(pooled){
+		space->pooledContactBuffers = pooled->next;
+		stats->pooledBuffers--;
+		
+		return pooled;
+	}
+	
+	cpContactBufferHeader *head = space->contactBuffersHead;
+	size_t budget = space->contactBudget;
+	
+	if(budget && stats->bytes + sizeof(cpContactBuffer) > budget){
+		// Contacts from the current step can't be dropped, but older ones only hold cached impulses.
+		if(head && head->next->stamp != space->stamp){
+			cpSpaceEvictContactBuffers(space);
+			return NULL;
+		} else {
+			stats->overBudget++;
+		}
+	}
+	
+	return cpSpaceAllocContactBuffer(space);
+}
+
 void
 cpSpacePushFreshContactBuffer(cpSpace *space)
 {
 	cpTimestamp stamp = space->stamp;
 	
 	cpContactBufferHeader *head = space->contactBuffersHead;
+	cpContactBufferHeader *buffer = (head && cpContactBufferExpired(space, head->next) ? NULL : cpSpaceGetContactBuffer(space));
 	
-	if(!head){
-		// No buffers have been allocated, make one
-		space->contactBuffersHead = cpContactBufferHeaderInit(cpSpaceAllocContactBuffer(space), stamp, NULL);
-	} else if(stamp - head->next->stamp > space->collisionPersistence){
+	if(!buffer){
 		// The tail buffer is available, rotate the ring
-	cpContactBufferHeader *tail = head->next;
+		cpContactBufferHeader *tail = head->next;
 		space->contactBuffersHead = cpContactBufferHeaderInit(tail, stamp, tail);
+	} else if(!head){
+		// No buffers are in use, start a new ring
+		space->contactBuffersHead = cpContactBufferHeaderInit(buffer, stamp, NULL);
+		space->contactBufferStats.activeBuffers = 1;
 	} else {
-		// Allocate a new buffer and push it into the ring
-		cpContactBufferHeader *buffer = cpContactBufferHeaderInit(cpSpaceAllocContactBuffer(space), stamp, head);
-		space->contactBuffersHead = head->next = buffer;
+		// Push the new buffer into the ring
+		space->contactBuffersHead = head->next = cpContactBufferHeaderInit(buffer, stamp, head);
+		space->contactBufferStats.activeBuffers++;
 	}
 }
 
+// Move expired buffers from the tail of the ring into the pool,
+// then free the pooled buffers that outnumber the buffers in use.
+static void
+cpSpaceTrimContactBuffers(cpSpace *space)
+{
+	cpContactBufferStats *stats = &space->contactBufferStats;
+	cpContactBufferHeader *head = space->contactBuffersHead;
+	if(!head) return;
+	
+	for(cpContactBufferHeader *tail = head->next; tail != head && cpContactBufferExpired(space, tail); tail = head->next){
+		head->next = tail->next;
+		tail->next = space->pooledContactBuffers;
+		space->pooledContactBuffers = tail;
+		
+		stats->activeBuffers--;
+		stats->pooledBuffers++;
+	}
+	
+	while(stats->pooledBuffers > stats->activeBuffers){
+		cpContactBufferHeader *buffer = space->pooledContactBuffers;
+		space->pooledContactBuffers = buffer->next;
+		cpSpaceFreeContactBuffer(space, buffer);
+		
+		stats->pooledBuffers--;
+		stats->trimmedBuffers++;
+	}
+}
+
+void
+cpSpaceExpireContactBuffers(cpSpace *space)
+{
+	cpContactBufferHeader *head = space->contactBuffersHead;
+	if(head){
+		// Back date every buffer in the ring so they can all be recycled.
+		cpTimestamp expired = space->stamp - space->collisionPersistence - 1;
+		
+		cpContactBufferHeader *buffer = head;
+		do {
+			buffer->stamp = expired;
+			buffer = buffer->next;
+		} while(buffer != head);
+	}
+	
+	cpSpacePushFreshContactBuffer(space);
+}
+
+void
+cpSpaceFreeBuffers(cpSpace *space)
+{
+	cpAllocator *allocator = space->allocator;
+	
+	cpContactBufferHeader *head = space->contactBuffersHead;
+	if(head){
+		cpContactBufferHeader *buffer = head->next;
+		while(buffer != head){
+			cpContactBufferHeader *next = buffer->next;
+			cpSpaceFreeContactBuffer(space, buffer);
+			buffer = next;
+		}
+		
+		cpSpaceFreeContactBuffer(space, head);
+		space->contactBuffersHead = NULL;
+	}
+	
+	for(cpContactBufferHeader *buffer = space->pooledContactBuffers; buffer;){
+		cpContactBufferHeader *next = buffer->next;
+		cpSpaceFreeContactBuffer(space, buffer);
+		buffer = next;
+	}
+	space->pooledContactBuffers = NULL;
+	
+	space->contactBufferStats.activeBuffers = 0;
+	space->contactBufferStats.pooledBuffers = 0;
+	
+	cpArray *buffers = space->allocatedBuffers;
+	if(buffers){
+		for(int i=0; i<buffers->num; i++) cpAllocatorFreeBytes(allocator, buffers->arr[i], CP_BUFFER_BYTES, CP_ALLOCATOR_ARBITERS);
+		cpArrayFree(buffers);
+		space->allocatedBuffers = NULL;
+	}
+}
 
 cpContact *
 cpContactBufferGetArray(cpSpace *space)
@@ -180,7 +352,7 @@ cpSpacePopContacts(cpSpace *space, int count){
 
 //MARK: Collision Detection Functions
 
-static void *
+void *
 cpSpaceArbiterSetTrans(cpShape **shapes, cpSpace *space)
 {
 	if(space->pooledArbiters->num == 0){
@@ -188,12 +360,13 @@ cpSpaceArbiterSetTrans(cpShape **shapes, cpSpace *space)
 		int count = CP_BUFFER_BYTES/sizeof(cpArbiter);
 		cpAssertHard(count, "Internal Error: Buffer size too small.");
 		
-		cpArbiter *buffer = (cpArbiter *)cpcalloc(1, CP_BUFFER_BYTES);
+		cpArbiter *buffer = (cpArbiter *)cpAllocatorAllocBytes(space->allocator, CP_BUFFER_BYTES, CP_ALLOCATOR_ARBITERS);
 		cpArrayPush(space->allocatedBuffers, buffer);
 		
 		for(int i=0; i<count; i++) cpArrayPush(space->pooledArbiters, buffer + i);
 	}
 	
+	if(space->profile) space->profile->arbitersCreated++;
 	return cpArbiterInit((cpArbiter *)cpArrayPop(space->pooledArbiters), shapes[0], shapes[1]);
 }
 
@@ -218,6 +391,9 @@ queryReject(cpShape *a, cpShape *b)
 void
 cpSpaceCollideShapes(cpShape *a, cpShape *b, cpSpace *space)
 {
+	cpSpaceProfile *profile = space->profile;
+	if(profile) profile->pairsTested++;
+	
 	// Reject any of the simple cases
 	if(queryReject(a,b)) return;
 	
@@ -227,7 +403,11 @@ cpSpaceCollideShapes(cpShape *a, cpShape *b, cpSpace *space)
 	if(sensor && handler == &cpDefaultCollisionHandler) return;
 	
 	// Shape 'a' should have the lower shape type. (required by cpCollideShapes() )
-	if(a->klass->type > b->klass->type){
+	// Deterministic spaces also order shapes of the same type by hash value instead of by the order the spatial index found them.
+	if(
+		a->klass->type > b->klass->type ||
+		(space->deterministic && a->klass->type == b->klass->type && a->hashid > b->hashid)
+	){
 		cpShape *temp = a;
 		a = b;
 		b = temp;
@@ -243,7 +423,9 @@ cpSpaceCollideShapes(cpShape *a, cpShape *b, cpSpace *space)
 	// This is where the persistant contact magic comes from.
 	cpShape *shape_pair[] = {a, b};
 	cpHashValue arbHashID = CP_HASH_PAIR((cpHashValue)a, (cpHashValue)b);
+	unsigned int created = (profile ? profile->arbitersCreated : 0);
 	cpArbiter *arb = (cpArbiter *)cpHashSetInsert(space->cachedArbiters, arbHashID, shape_pair, space, (cpHashSetTransFunc)cpSpaceArbiterSetTrans);
+	if(profile && profile->arbitersCreated == created) profile->arbitersReused++;
 	cpArbiterUpdate(arb, contacts, numContacts, handler, a, b);
 	
 	// Call the begin function first if it's the first step
@@ -300,6 +482,9 @@ cpSpaceArbiterSetFilter(cpArbiter *arb, cpSpace *space)
 	}
 	
 	if(ticks >= space->collisionPersistence){
+		// The bodies might not be connected anymore.
+		space->staleComponents = cpTrue;
+		
 		arb->contacts = NULL;
 		arb->numContacts = 0;
 		
@@ -310,6 +495,311 @@ cpSpaceArbiterSetFilter(cpArbiter *arb, cpSpace *space)
 	return cpTrue;
 }
 
+//MARK: Deterministic Ordering Functions
+
+static int
+ArbiterOrder(const void *ptr1, const void *ptr2)
+{
+	const cpArbiter *arb1 = *(const cpArbiter **)ptr1;
+	const cpArbiter *arb2 = *(const cpArbiter **)ptr2;
+	
+	cpHashValue a1 = arb1->a->hashid, b1 = arb1->b->hashid;
+	cpHashValue a2 = arb2->a->hashid, b2 = arb2->b->hashid;
+	
+	// Compare the pairs as (min, max) so the order doesn't depend on which shape is 'a'.
+	cpHashValue min1 = (a1 < b1 ? a1 : b1), max1 = (a1 < b1 ? b1 : a1);
+	cpHashValue min2 = (a2 < b2 ? a2 : b2), max2 = (a2 < b2 ? b2 : a2);
+	
+	if(min1 != min2) return (min1 < min2 ? -1 : 1);
+	if(max1 != max2) return (max1 < max2 ? -1 : 1);
+	return 0;
+}
+
+static int
+ConstraintOrder(const void *ptr1, const void *ptr2)
+{
+	cpHashValue id1 = (*(const cpConstraint **)ptr1)->hashid;
+	cpHashValue id2 = (*(const cpConstraint **)ptr2)->hashid;
+	
+	return (id1 == id2 ? 0 : (id1 < id2 ? -1 : 1));
+}
+
+static void
+PushArbiter(cpArbiter *arb, cpArray *arr)
+{
+	cpArrayPush(arr, arb);
+}
+
+// Same as filtering the cachedArbiters set with cpSpaceArbiterSetFilter(),
+// but visits the arbiters in hash value order instead of in memory address order.
+static void
+cpSpaceFilterArbitersInOrder(cpSpace *space)
+{
+	cpArray *sorted = space->sortedArbiters;
+	sorted->num = 0;
+	
+	cpHashSetEach(space->cachedArbiters, (cpHashSetIteratorFunc)PushArbiter, sorted);
+	qsort(sorted->arr, sorted->num, sizeof(void *), ArbiterOrder);
+	
+	for(int i=0; i<sorted->num; i++){
+		cpArbiter *arb = (cpArbiter *)sorted->arr[i];
+		cpShape *a = arb->a, *b = arb->b;
+		
+		if(!cpSpaceArbiterSetFilter(arb, space)){
+			cpShape *shape_pair[] = {a, b};
+			cpHashSetRemove(space->cachedArbiters, CP_HASH_PAIR((cpHashValue)a, (cpHashValue)b), shape_pair);
+		}
+	}
+	
+	sorted->num = 0;
+}
+
+// Copy the awake constraints into sortedConstraints in hash value order.
+static cpArray *
+cpSpaceSortedConstraints(cpSpace *space)
+{
+	cpArray *constraints = space->constraints;
+	cpArray *sorted = space->sortedConstraints;
+	sorted->num = 0;
+	
+	for(int i=0; i<constraints->num; i++) cpArrayPush(sorted, constraints->arr[i]);
+	qsort(sorted->arr, sorted->num, sizeof(void *), ConstraintOrder);
+	
+	return sorted;
+}
+
+//MARK: Profiling Functions
+
+static double
+ProfileTime(void)
+{
+#if defined(__APPLE__)
+	static double ticksToSeconds = 0.0;
+	if(!ticksToSeconds){
+		mach_timebase_info_data_t info;
+		mach_timebase_info(&info);
+		ticksToSeconds = 1e-9*(double)info.numer/(double)info.denom;
+	}
+	
+	return (double)mach_absolute_time()*ticksToSeconds;
+#elif defined(_WIN32)
+	LARGE_INTEGER count, frequency;
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&frequency);
+	
+	return (double)count.QuadPart/(double)frequency.QuadPart;
+#else
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	
+	return (double)time.tv_sec + 1e-9*(double)time.tv_nsec;
+#endif
+}
+
+// Returns the time elapsed since the last lap and restarts the lap.
+static inline cpFloat
+ProfileLap(double *lap)
+{
+	double now = ProfileTime();
+	cpFloat elapsed = (cpFloat)(now - *lap);
+	(*lap) = now;
+	
+	return elapsed;
+}
+
+//MARK: Adaptive Solver
+
+// Index of a body in the awake body array, or -1 if the solver never changes its velocity.
+static inline int
+IslandBodyIndex(cpBody *body)
+{
+	return (cpBodyIsRogue(body) || cpBodyIsSleeping(body) || cpBodyIsStatic(body) ? -1 : body->node.island);
+}
+
+static inline int
+IslandFind(int *parents, int i)
+{
+	while(parents[i] != i){
+		// Path halving
+		parents[i] = parents[parents[i]];
+		i = parents[i];
+	}
+	
+	return i;
+}
+
+// Pairs without an awake body are all put in the set at index count.
+static inline int
+IslandUnion(int *parents, cpBody *a, cpBody *b, int count)
+{
+	int ia = IslandBodyIndex(a), ib = IslandBodyIndex(b);
+	if(ia < 0) ia = (ib < 0 ? count : ib);
+	if(ib < 0) ib = ia;
+	
+	int rootA = IslandFind(parents, ia), rootB = IslandFind(parents, ib);
+	if(rootA != rootB) parents[rootA] = rootB;
+	
+	return rootB;
+}
+
+static void *
+cpSpaceIslandBuffer(cpSpace *space, size_t size)
+{
+	if(size > space->islandBufferSize){
+		// The contents don't need to be kept, so free the old buffer instead of reallocating it.
+		cpAllocator *allocator = space->allocator;
+		if(space->islandBuffer) cpAllocatorFreeBytes(allocator, space->islandBuffer, space->islandBufferSize, CP_ALLOCATOR_MISC);
+		
+		space->islandBufferSize = size*3/2;
+		space->islandBuffer = cpAllocatorAllocBytes(allocator, space->islandBufferSize, CP_ALLOCATOR_MISC);
+	}
+	
+	return space->islandBuffer;
+}
+
+// Solve each island of connected bodies separately, stopping as soon as its impulses converge.
+// Islands are found with a union-find over the arbiters and constraints each step.
+// They are numbered in the order of their first arbiter or constraint so the solve order stays deterministic.
+static void
+cpSpaceSolveIslands(cpSpace *space, cpArray *constraints)
+{
+	cpArray *bodies = space->bodies;
+	cpArray *arbiters = space->arbiters;
+	
+	int numBodies = bodies->num;
+	int numArbiters = arbiters->num;
+	int numElements = numArbiters + constraints->num;
+	
+	// parents and islandOf have a slot for each body plus one for pairs without an awake body.
+	size_t intCount = 2*(numBodies + 1) + numElements + 2*(numElements + 1);
+	size_t size = intCount*sizeof(int) + numElements*sizeof(void *);
+	size = (size + sizeof(void *) - 1)/sizeof(void *)*sizeof(void *);
+	void **sorted = (void **)cpSpaceIslandBuffer(space, size);
+	int *parents = (int *)(sorted + numElements);
+	int *islandOf = parents + (numBodies + 1);
+	int *elementIsland = islandOf + (numBodies + 1);
+	int *arbiterStart = elementIsland + numElements;
+	int *constraintStart = arbiterStart + (numElements + 1);
+	
+	for(int i=0; i<numBodies; i++){
+		((cpBody *)bodies->arr[i])->node.island = i;
+		parents[i] = i;
+	}
+	parents[numBodies] = numBodies;
+	
+	for(int i=0; i<numArbiters; i++){
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		IslandUnion(parents, arb->body_a, arb->body_b, numBodies);
+	}
+	
+	for(int i=0; i<constraints->num; i++){
+		cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
+		IslandUnion(parents, constraint->a, constraint->b, numBodies);
+	}
+	
+	// Number the islands and count the arbiters and constraints in each.
+	for(int i=0; i<=numBodies; i++) islandOf[i] = -1;
+	
+	int numIslands = 0;
+	for(int i=0; i<numElements; i++){
+		cpBody *a, *b;
+		if(i < numArbiters){
+			cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+			a = arb->body_a; b = arb->body_b;
+		} else {
+			cpConstraint *constraint = (cpConstraint *)constraints->arr[i - numArbiters];
+			a = constraint->a; b = constraint->b;
+		}
+		
+		int root = IslandUnion(parents, a, b, numBodies);
+		if(islandOf[root] < 0){
+			islandOf[root] = numIslands;
+			arbiterStart[numIslands] = constraintStart[numIslands] = 0;
+			numIslands++;
+		}
+		
+		int island = elementIsland[i] = islandOf[root];
+		if(i < numArbiters){
+			arbiterStart[island]++;
+		} else {
+			constraintStart[island]++;
+		}
+	}
+	
+	// Turn the counts into offsets and sort the arbiters and constraints by island.
+	// The arbiters of all the islands come first, followed by the constraints.
+	int arbiterOffset = 0, constraintOffset = numArbiters;
+	for(int i=0; i<numIslands; i++){
+		int arbiterCount = arbiterStart[i], constraintCount = constraintStart[i];
+		arbiterStart[i] = arbiterOffset;
+		constraintStart[i] = constraintOffset;
+		arbiterOffset += arbiterCount;
+		constraintOffset += constraintCount;
+	}
+	arbiterStart[numIslands] = arbiterOffset;
+	constraintStart[numIslands] = constraintOffset;
+	
+	for(int i=0; i<numElements; i++){
+		int island = elementIsland[i];
+		
+		if(i < numArbiters){
+			sorted[arbiterStart[island]++] = arbiters->arr[i];
+		} else {
+			sorted[constraintStart[island]++] = constraints->arr[i - numArbiters];
+		}
+	}
+	
+	// Shift the offsets back to the start of each island.
+	for(int i=numIslands; i>0; i--){
+		arbiterStart[i] = arbiterStart[i - 1];
+		constraintStart[i] = constraintStart[i - 1];
+	}
+	arbiterStart[0] = 0;
+	constraintStart[0] = numArbiters;
+	
+	cpFloat tolerance = space->solverTolerance;
+	int minIterations = space->minIterations;
+	int maxIterations = space->iterations;
+	int totalIterations = 0, maxUsed = 0;
+	
+	for(int island=0; island<numIslands; island++){
+		cpArbiter **islandArbiters = (cpArbiter **)sorted + arbiterStart[island];
+		int islandArbiterCount = arbiterStart[island + 1] - arbiterStart[island];
+		cpConstraint **islandConstraints = (cpConstraint **)sorted + constraintStart[island];
+		int islandConstraintCount = constraintStart[island + 1] - constraintStart[island];
+		
+		int iterations = 0;
+		while(iterations < maxIterations){
+			cpFloat maxDelta = 0.0f;
+			
+			for(int j=0; j<islandArbiterCount; j++){
+				maxDelta = cpfmax(maxDelta, cpArbiterApplyImpulse(islandArbiters[j]));
+			}
+			
+			for(int j=0; j<islandConstraintCount; j++){
+				cpConstraint *constraint = islandConstraints[j];
+				constraint->impulseDelta = (cpFloat)INFINITY;
+				constraint->klass->applyImpulse(constraint);
+				maxDelta = cpfmax(maxDelta, constraint->impulseDelta);
+			}
+			
+			iterations++;
+			if(iterations >= minIterations && maxDelta <= tolerance) break;
+		}
+		
+		totalIterations += iterations;
+		if(iterations > maxUsed) maxUsed = iterations;
+	}
+	
+	space->lastIterations = maxUsed;
+	
+	cpSpaceProfile *profile = space->profile;
+	if(profile){
+		profile->islands = numIslands;
+		profile->solverIterations = totalIterations;
+	}
+}
+
 //MARK: All Important cpSpaceStep() Function
 
 void
@@ -325,6 +815,13 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 	// don't step if the timestep is 0!
 	if(dt == 0.0f) return;
 	
+	cpSpaceProfile *profile = space->profile;
+	double start = 0.0, lap = 0.0;
+	if(profile){
+		memset(profile, 0, sizeof(cpSpaceProfile));
+		start = lap = ProfileTime();
+	}
+	
 	space->stamp++;
 	
 	cpFloat prev_dt = space->curr_dt;
@@ -348,23 +845,46 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 
 	cpSpaceLock(space); {
 		// Integrate positions
-		for(int i=0; i<bodies->num; i++){
-			cpBody *body = (cpBody *)bodies->arr[i];
-			body->position_func(body, dt);
-		}
+		cpBodyIntegratePositions(bodies, dt);
+		
+		if(profile) profile->integratePositions = ProfileLap(&lap);
 		
 		// Find colliding pairs.
+		cpSpaceTrimContactBuffers(space);
 		cpSpacePushFreshContactBuffer(space);
 		cpSpatialIndexEach(space->activeShapes, (cpSpatialIndexIteratorFunc)cpShapeUpdateFunc, NULL);
 		cpSpatialIndexReindexQuery(space->activeShapes, (cpSpatialIndexQueryFunc)cpSpaceCollideShapes, space);
+		
+		if(profile) profile->reindexQuery = ProfileLap(&lap);
 	} cpSpaceUnlock(space, cpFalse);
 	
+	if(space->deterministic){
+		// The order the spatial index finds pairs in depends on the index and the platform's hash width.
+		qsort(arbiters->arr, arbiters->num, sizeof(void *), ArbiterOrder);
+	}
+	
 	// Rebuild the contact graph (and detect sleeping components if sleeping is enabled)
 	cpSpaceProcessComponents(space, dt);
 	
+	if(space->deterministic){
+		// Solve a sorted copy so the order cpSpaceEachConstraint() visits constraints in doesn't change.
+		constraints = cpSpaceSortedConstraints(space);
+	}
+	
+	if(profile){
+		profile->processComponents = ProfileLap(&lap);
+		profile->sleepingComponents = space->sleepingComponents->num;
+	}
+	
 	cpSpaceLock(space); {
 		// Clear out old cached arbiters and call separate callbacks
-		cpHashSetFilter(space->cachedArbiters, (cpHashSetFilterFunc)cpSpaceArbiterSetFilter, space);
+		if(space->deterministic){
+			cpSpaceFilterArbitersInOrder(space);
+		} else {
+			cpHashSetFilter(space->cachedArbiters, (cpHashSetFilterFunc)cpSpaceArbiterSetFilter, space);
+		}
+		
+		if(profile) profile->arbiterFilter = ProfileLap(&lap);
 
 		// Prestep the arbiters and constraints.
 		cpFloat slop = space->collisionSlop;
@@ -381,14 +901,14 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 			
 			constraint->klass->preStep(constraint, dt);
 		}
+		
+		if(profile) profile->preStep = ProfileLap(&lap);
 	
 		// Integrate velocities.
 		cpFloat damping = cpfpow(space->damping, dt);
-		cpVect gravity = space->gravity;
-		for(int i=0; i<bodies->num; i++){
-			cpBody *body = (cpBody *)bodies->arr[i];
-			body->velocity_func(body, gravity, damping, dt);
-		}
+		cpBodyIntegrateVelocities(bodies, space->gravity, damping, dt);
+		
+		if(profile) profile->integrateVelocities = ProfileLap(&lap);
 		
 		// Apply cached impulses
 		cpFloat dt_coef = (prev_dt == 0.0f ? 0.0f : dt/prev_dt);
@@ -402,17 +922,26 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 		}
 		
 		// Run the impulse solver.
-		for(int i=0; i<space->iterations; i++){
-			for(int j=0; j<arbiters->num; j++){
-				cpArbiterApplyImpulse((cpArbiter *)arbiters->arr[j]);
-			}
-				
-			for(int j=0; j<constraints->num; j++){
-				cpConstraint *constraint = (cpConstraint *)constraints->arr[j];
-				constraint->klass->applyImpulse(constraint);
+		if(space->solverTolerance > 0.0f){
+			cpSpaceSolveIslands(space, constraints);
+		} else {
+			for(int i=0; i<space->iterations; i++){
+				for(int j=0; j<arbiters->num; j++){
+					cpArbiterApplyImpulse((cpArbiter *)arbiters->arr[j]);
+				}
+					
+				for(int j=0; j<constraints->num; j++){
+					cpConstraint *constraint = (cpConstraint *)constraints->arr[j];
+					constraint->klass->applyImpulse(constraint);
+				}
 			}
+			
+			space->lastIterations = space->iterations;
+			if(profile) profile->solverIterations = space->iterations;
 		}
 		
+		if(profile) profile->solve = ProfileLap(&lap);
+		
 		// Run the constraint post-solve callbacks
 		for(int i=0; i<constraints->num; i++){
 			cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
@@ -428,5 +957,9 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 			cpCollisionHandler *handler = arb->handler;
 			handler->postSolve(arb, space, handler->data);
 		}
+		
+		if(profile) profile->postSolve = ProfileLap(&lap);
 	} cpSpaceUnlock(space, cpTrue);
+	
+	if(profile) profile->step = (cpFloat)(ProfileTime() - start);
 }
@@ -36,6 +36,7 @@ cpSpatialIndexInit(cpSpatialIndex *index, cpSpatialIndexClass *klass, cpSpatialI
 	index->klass = klass;
 	index->bbfunc = bbfunc;
 	index->staticIndex = staticIndex;
+	index->allocator = NULL;
 	
 	if(staticIndex){
 		cpAssertHard(!staticIndex->dynamicIndex, "This static index is already associated with a dynamic index.");
@@ -45,6 +46,16 @@ cpSpatialIndexInit(cpSpatialIndex *index, cpSpatialIndexClass *klass, cpSpatialI
 	return index;
 }
 
+void
+cpSpatialIndexSetAllocator(cpSpatialIndex *index, cpAllocator *allocator)
+{
+	cpAssertHard(cpSpatialIndexCount(index) == 0, "Internal Error: Cannot change the allocator of a spatial index that isn't empty.");
+	
+	// Let the index release any pooled buffers to the old allocator first.
+	if(index->klass->setAllocator) index->klass->setAllocator(index, allocator);
+	index->allocator = allocator;
+}
+
 typedef struct dynamicToStaticContext {
 	cpSpatialIndexBBFunc bbfunc;
 	cpSpatialIndex *staticIndex;
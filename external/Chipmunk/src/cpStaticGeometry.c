@@ -0,0 +1,643 @@
+/* Copyright (c) 2007 Scott Lembcke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+ 
+#include <string.h>
+
+#include "chipmunk_private.h"
+
+// Maximum number of children referenced by a leaf of the bounding volume hierarchy.
+#define LEAF_SIZE 4
+
+typedef struct Segment {
+	cpVect a, b, n;
+	cpVect ta, tb, tn;
+	cpVect a_tangent, b_tangent;
+	cpFloat r;
+} Segment;
+
+typedef struct Poly {
+	int numVerts, firstVert;
+} Poly;
+
+// The hierarchy is stored in preorder.
+// Leaves reference count children starting at start in the children array.
+// Internal nodes have a count of 0, their left child directly follows them and start is the index of their right child.
+typedef struct Node {
+	cpBB bb;
+	int start, count;
+} Node;
+
+struct cpStaticGeometry {
+	cpShape shape;
+	
+	// Allocator for the child and hierarchy arrays, NULL for the heap.
+	cpAllocator *allocator;
+	
+	int numSegments, maxSegments;
+	Segment *segments;
+	
+	int numPolys, maxPolys;
+	Poly *polys;
+	
+	// Vertexes and splitting planes of all the polys. The transformed copies use the same indexes.
+	int numVerts, maxVerts;
+	cpVect *verts, *tVerts;
+	cpSplittingPlane *planes, *tPlanes;
+	
+	// Transformed bounding boxes indexed by child id. Segment ids come first, followed by the poly ids.
+	cpBB *bbs;
+	// Child ids in the order they are referenced by the leaves.
+	int *children;
+	
+	// NULL until the hierarchy is built by the first call to cacheData().
+	int numNodes;
+	Node *nodes;
+};
+
+static inline int
+ChildCount(const cpStaticGeometry *geometry)
+{
+	return geometry->numSegments + geometry->numPolys;
+}
+
+//MARK: Buffers
+
+static inline void *
+BufferAlloc(cpStaticGeometry *geometry, size_t size)
+{
+	return cpAllocatorAllocOrHeap(geometry->allocator, size, CP_ALLOCATOR_SHAPES);
+}
+
+static inline void
+BufferFree(cpStaticGeometry *geometry, void *ptr, size_t size)
+{
+	if(ptr) cpAllocatorFreeOrHeap(geometry->allocator, ptr, size, CP_ALLOCATOR_SHAPES);
+}
+
+// Allocators can't resize, so growing a buffer copies it into a new one.
+static void *
+BufferGrow(cpStaticGeometry *geometry, void *ptr, size_t size, size_t newSize)
+{
+	void *grown = BufferAlloc(geometry, newSize);
+	
+	if(ptr){
+		memcpy(grown, ptr, size);
+		BufferFree(geometry, ptr, size);
+	}
+	
+	return grown;
+}
+
+// Adding children invalidates the hierarchy. It is rebuilt the next time the shape is cached.
+// Must be called before the child counts change, since they give the sizes of the hierarchy's buffers.
+static void
+ResetTree(cpStaticGeometry *geometry)
+{
+	int count = ChildCount(geometry);
+	BufferFree(geometry, geometry->bbs, count*sizeof(cpBB));
+	BufferFree(geometry, geometry->children, count*sizeof(int));
+	BufferFree(geometry, geometry->nodes, 2*count*sizeof(Node));
+	
+	geometry->bbs = NULL;
+	geometry->children = NULL;
+	geometry->numNodes = 0;
+	geometry->nodes = NULL;
+}
+
+// Returns the capacity needed to store count elements, growing geometrically like cpArray.
+static inline int
+GrowCapacity(int max, int count)
+{
+	int grown = 3*(max + 1)/2;
+	return (count > grown ? count : grown);
+}
+
+//MARK: Hierarchy
+
+static inline cpFloat
+ChildCenter(const cpBB *bbs, int child, cpBool splitX)
+{
+	cpBB bb = bbs[child];
+	return (splitX ? bb.l + bb.r : bb.b + bb.t);
+}
+
+// Partially sort the children so the nth child is in its sorted position along the split axis.
+static void
+SelectChildren(int *children, int count, int nth, const cpBB *bbs, cpBool splitX)
+{
+	int lo = 0, hi = count - 1;
+	
+	while(lo < hi){
+		cpFloat pivot = ChildCenter(bbs, children[(lo + hi)/2], splitX);
+		int i = lo, j = hi;
+		
+		while(i <= j){
+			while(ChildCenter(bbs, children[i], splitX) < pivot) i++;
+			while(ChildCenter(bbs, children[j], splitX) > pivot) j--;
+			
+			if(i <= j){
+				int tmp = children[i];
+				children[i] = children[j];
+				children[j] = tmp;
+				
+				i++; j--;
+			}
+		}
+		
+		if(nth <= j){
+			hi = j;
+		} else if(nth >= i){
+			lo = i;
+		} else {
+			break;
+		}
+	}
+}
+
+static int
+BuildSubtree(cpStaticGeometry *geometry, int start, int count)
+{
+	int index = geometry->numNodes++;
+	Node *node = geometry->nodes + index;
+	
+	int *children = geometry->children;
+	cpBB *bbs = geometry->bbs;
+	
+	cpBB bb = bbs[children[start]];
+	for(int i=1; i<count; i++) bb = cpBBMerge(bb, bbs[children[start + i]]);
+	node->bb = bb;
+	
+	if(count <= LEAF_SIZE){
+		node->start = start;
+		node->count = count;
+	} else {
+		// Split at the median child along the longest axis.
+		int half = count/2;
+		SelectChildren(children + start, count, half, bbs, (bb.r - bb.l) > (bb.t - bb.b));
+		
+		BuildSubtree(geometry, start, half);
+		node->start = BuildSubtree(geometry, start + half, count - half);
+		node->count = 0;
+	}
+	
+	return index;
+}
+
+static void
+BuildTree(cpStaticGeometry *geometry)
+{
+	int count = ChildCount(geometry);
+	
+	geometry->children = (int *)BufferAlloc(geometry, count*sizeof(int));
+	for(int i=0; i<count; i++) geometry->children[i] = i;
+	
+	// A binary tree with at most count leaves has fewer than 2*count nodes.
+	geometry->nodes = (Node *)BufferAlloc(geometry, 2*count*sizeof(Node));
+	geometry->numNodes = 0;
+	BuildSubtree(geometry, 0, count);
+}
+
+// Children always come after their parent, so the nodes can be refit in a single reverse pass.
+static void
+RefitTree(cpStaticGeometry *geometry)
+{
+	Node *nodes = geometry->nodes;
+	int *children = geometry->children;
+	cpBB *bbs = geometry->bbs;
+	
+	for(int i=geometry->numNodes - 1; i>=0; i--){
+		Node *node = nodes + i;
+		
+		if(node->count){
+			cpBB bb = bbs[children[node->start]];
+			for(int j=1; j<node->count; j++) bb = cpBBMerge(bb, bbs[children[node->start + j]]);
+			node->bb = bb;
+		} else {
+			node->bb = cpBBMerge(nodes[i + 1].bb, nodes[node->start].bb);
+		}
+	}
+}
+
+//MARK: Child Shapes
+
+// Temporary shapes used to run the regular segment and poly code on a child.
+typedef struct ChildShapes {
+	const cpStaticGeometry *geometry;
+	cpSegmentShape seg;
+	cpPolyShape poly;
+} ChildShapes;
+
+static void
+ChildShapesInit(ChildShapes *shapes, const cpStaticGeometry *geometry)
+{
+	shapes->geometry = geometry;
+	
+	// Copy the body, material properties and hashid of the geometry.
+	shapes->seg.shape = geometry->shape;
+	shapes->seg.shape.klass = &cpSegmentShapeClass;
+	
+	shapes->poly.shape = geometry->shape;
+	shapes->poly.shape.klass = &cpPolyShapeClass;
+}
+
+static cpShape *
+ChildShapesGet(ChildShapes *shapes, int child)
+{
+	const cpStaticGeometry *geometry = shapes->geometry;
+	int numSegments = geometry->numSegments;
+	
+	if(child < numSegments){
+		cpSegmentShape *seg = &shapes->seg;
+		const Segment *src = geometry->segments + child;
+		
+		seg->shape.bb = geometry->bbs[child];
+		seg->a = src->a;
+		seg->b = src->b;
+		seg->n = src->n;
+		seg->ta = src->ta;
+		seg->tb = src->tb;
+		seg->tn = src->tn;
+		seg->r = src->r;
+		seg->a_tangent = src->a_tangent;
+		seg->b_tangent = src->b_tangent;
+		
+		return (cpShape *)seg;
+	} else {
+		cpPolyShape *poly = &shapes->poly;
+		const Poly *src = geometry->polys + (child - numSegments);
+		int first = src->firstVert;
+		
+		poly->shape.bb = geometry->bbs[child];
+		poly->numVerts = src->numVerts;
+		poly->verts = geometry->verts + first;
+		poly->tVerts = geometry->tVerts + first;
+		poly->planes = geometry->planes + first;
+		poly->tPlanes = geometry->tPlanes + first;
+		
+		return (cpShape *)poly;
+	}
+}
+
+typedef struct EachChildContext {
+	ChildShapes shapes;
+	cpBB bb;
+	cpStaticGeometryChildFunc func;
+	void *data;
+} EachChildContext;
+
+static void
+EachChildSubtree(EachChildContext *context, int index)
+{
+	const cpStaticGeometry *geometry = context->shapes.geometry;
+	const Node *node = geometry->nodes + index;
+	if(!cpBBIntersects(node->bb, context->bb)) return;
+	
+	if(node->count){
+		for(int i=node->start, end=node->start + node->count; i<end; i++){
+			int child = geometry->children[i];
+			
+			if(cpBBIntersects(geometry->bbs[child], context->bb)){
+				context->func(ChildShapesGet(&context->shapes, child), (cpHashValue)(child + 1), context->data);
+			}
+		}
+	} else {
+		EachChildSubtree(context, index + 1);
+		EachChildSubtree(context, node->start);
+	}
+}
+
+void
+cpStaticGeometryEachChild(const cpShape *shape, cpBB bb, cpStaticGeometryChildFunc func, void *data)
+{
+	const cpStaticGeometry *geometry = (const cpStaticGeometry *)shape;
+	if(!geometry->nodes) return;
+	
+	EachChildContext context;
+	ChildShapesInit(&context.shapes, geometry);
+	context.bb = bb;
+	context.func = func;
+	context.data = data;
+	EachChildSubtree(&context, 0);
+}
+
+//MARK: Shape Class
+
+static cpBB
+cpStaticGeometryCacheData(cpStaticGeometry *geometry, cpVect p, cpVect rot)
+{
+	int count = ChildCount(geometry);
+	if(count == 0) return (geometry->shape.bb = cpBBNew(p.x, p.y, p.x, p.y));
+	
+	if(!geometry->bbs) geometry->bbs = (cpBB *)BufferAlloc(geometry, count*sizeof(cpBB));
+	cpBB *bbs = geometry->bbs;
+	
+	for(int i=0, numSegments=geometry->numSegments; i<numSegments; i++){
+		Segment *seg = geometry->segments + i;
+		cpVect ta = seg->ta = cpvadd(p, cpvrotate(seg->a, rot));
+		cpVect tb = seg->tb = cpvadd(p, cpvrotate(seg->b, rot));
+		seg->tn = cpvrotate(seg->n, rot);
+		
+		cpFloat rad = seg->r;
+		bbs[i] = cpBBNew(cpfmin(ta.x, tb.x) - rad, cpfmin(ta.y, tb.y) - rad, cpfmax(ta.x, tb.x) + rad, cpfmax(ta.y, tb.y) + rad);
+	}
+	
+	// Reuse the regular poly transform on each child.
+	ChildShapes shapes;
+	ChildShapesInit(&shapes, geometry);
+	
+	for(int i=geometry->numSegments; i<count; i++){
+		cpShape *poly = ChildShapesGet(&shapes, i);
+		bbs[i] = cpPolyShapeClass.cacheData(poly, p, rot);
+	}
+	
+	if(geometry->nodes){
+		RefitTree(geometry);
+	} else {
+		BuildTree(geometry);
+	}
+	
+	return (geometry->shape.bb = geometry->nodes[0].bb);
+}
+
+static void
+cpStaticGeometryDestroy(cpStaticGeometry *geometry)
+{
+	ResetTree(geometry);
+	
+	int maxVerts = geometry->maxVerts;
+	BufferFree(geometry, geometry->segments, geometry->maxSegments*sizeof(Segment));
+	BufferFree(geometry, geometry->polys, geometry->maxPolys*sizeof(Poly));
+	BufferFree(geometry, geometry->verts, maxVerts*sizeof(cpVect));
+	BufferFree(geometry, geometry->tVerts, maxVerts*sizeof(cpVect));
+	BufferFree(geometry, geometry->planes, maxVerts*sizeof(cpSplittingPlane));
+	BufferFree(geometry, geometry->tPlanes, maxVerts*sizeof(cpSplittingPlane));
+}
+
+static inline cpFloat
+BBDistance(cpBB bb, cpVect p)
+{
+	cpFloat dx = cpfmax(cpfmax(bb.l - p.x, p.x - bb.r), 0.0f);
+	cpFloat dy = cpfmax(cpfmax(bb.b - p.y, p.y - bb.t), 0.0f);
+	return cpfsqrt(dx*dx + dy*dy);
+}
+
+static void
+NearestPointQuerySubtree(ChildShapes *shapes, int index, cpVect p, cpNearestPointQueryInfo *info)
+{
+	const cpStaticGeometry *geometry = shapes->geometry;
+	const Node *node = geometry->nodes + index;
+	
+	// Skip subtrees that can't contain a point closer than the best one so far.
+	// Subtrees containing the point are always visited since a child could report a deeper negative distance.
+	cpFloat dist = BBDistance(node->bb, p);
+	if(dist > 0.0f && dist >= info->d) return;
+	
+	if(node->count){
+		for(int i=node->start, end=node->start + node->count; i<end; i++){
+			int child = geometry->children[i];
+			cpFloat childDist = BBDistance(geometry->bbs[child], p);
+			if(childDist > 0.0f && childDist >= info->d) continue;
+			
+			cpShape *shape = ChildShapesGet(shapes, child);
+			cpNearestPointQueryInfo childInfo = {NULL, cpvzero, INFINITY};
+			shape->klass->nearestPointQuery(shape, p, &childInfo);
+			
+			if(childInfo.d < info->d){
+				info->shape = (cpShape *)geometry;
+				info->p = childInfo.p;
+				info->d = childInfo.d;
+			}
+		}
+	} else {
+		NearestPointQuerySubtree(shapes, index + 1, p, info);
+		NearestPointQuerySubtree(shapes, node->start, p, info);
+	}
+}
+
+static void
+cpStaticGeometryNearestPointQuery(cpStaticGeometry *geometry, cpVect p, cpNearestPointQueryInfo *info)
+{
+	cpNearestPointQueryInfo best = {NULL, cpvzero, INFINITY};
+	
+	if(geometry->nodes){
+		ChildShapes shapes;
+		ChildShapesInit(&shapes, geometry);
+		NearestPointQuerySubtree(&shapes, 0, p, &best);
+	}
+	
+	(*info) = best;
+}
+
+static void
+SegmentQuerySubtree(ChildShapes *shapes, int index, cpVect a, cpVect b, cpSegmentQueryInfo *info)
+{
+	const cpStaticGeometry *geometry = shapes->geometry;
+	const Node *node = geometry->nodes + index;
+	
+	// Skip subtrees the segment enters after the closest hit so far.
+	if(cpBBSegmentQuery(node->bb, a, b) >= info->t) return;
+	
+	if(node->count){
+		for(int i=node->start, end=node->start + node->count; i<end; i++){
+			int child = geometry->children[i];
+			if(cpBBSegmentQuery(geometry->bbs[child], a, b) >= info->t) continue;
+			
+			cpShape *shape = ChildShapesGet(shapes, child);
+			cpSegmentQueryInfo childInfo = {NULL, 0.0f, cpvzero};
+			shape->klass->segmentQuery(shape, a, b, &childInfo);
+			
+			if(childInfo.shape && childInfo.t < info->t){
+				info->shape = (cpShape *)geometry;
+				info->t = childInfo.t;
+				info->n = childInfo.n;
+			}
+		}
+	} else {
+		SegmentQuerySubtree(shapes, index + 1, a, b, info);
+		SegmentQuerySubtree(shapes, node->start, a, b, info);
+	}
+}
+
+static void
+cpStaticGeometrySegmentQuery(cpStaticGeometry *geometry, cpVect a, cpVect b, cpSegmentQueryInfo *info)
+{
+	cpSegmentQueryInfo best = {NULL, INFINITY, cpvzero};
+	
+	if(geometry->nodes){
+		ChildShapes shapes;
+		ChildShapesInit(&shapes, geometry);
+		SegmentQuerySubtree(&shapes, 0, a, b, &best);
+	}
+	
+	if(best.shape) (*info) = best;
+}
+
+static const cpShapeClass cpStaticGeometryClass = {
+	CP_STATIC_GEOMETRY_SHAPE,
+	(cpShapeCacheDataImpl)cpStaticGeometryCacheData,
+	(cpShapeDestroyImpl)cpStaticGeometryDestroy,
+	(cpShapeNearestPointQueryImpl)cpStaticGeometryNearestPointQuery,
+	(cpShapeSegmentQueryImpl)cpStaticGeometrySegmentQuery,
+	sizeof(cpStaticGeometry),
+};
+
+//MARK: Constructors
+
+cpStaticGeometry *
+cpStaticGeometryAlloc(void)
+{
+	return (cpStaticGeometry *)cpShapeAllocBytes(NULL, sizeof(cpStaticGeometry));
+}
+
+cpStaticGeometry *
+cpStaticGeometryInit(cpStaticGeometry *geometry, cpBody *body)
+{
+	// Keep the allocator that cpShapeAllocBytes() stored so cpShapeFree() can return the struct to it.
+	cpAllocator *shapeAllocator = geometry->shape.allocator;
+	memset(geometry, 0, sizeof(cpStaticGeometry));
+	geometry->shape.allocator = shapeAllocator;
+	
+	cpShapeInit((cpShape *)geometry, &cpStaticGeometryClass, body);
+	
+	return geometry;
+}
+
+cpShape *
+cpStaticGeometryNew(cpBody *body)
+{
+	return (cpShape *)cpStaticGeometryInit(cpStaticGeometryAlloc(), body);
+}
+
+cpShape *
+cpStaticGeometryNewWithAllocator(cpAllocator *allocator, cpBody *body)
+{
+	cpStaticGeometry *geometry = (cpStaticGeometry *)cpShapeAllocBytes(allocator, sizeof(cpStaticGeometry));
+	cpStaticGeometryInit(geometry, body);
+	
+	// The child arrays grow, so they can't come from a pool's fixed size blocks.
+	geometry->allocator = (cpAllocatorIsPool(allocator) ? NULL : allocator);
+	
+	return (cpShape *)geometry;
+}
+
+//MARK: Children
+
+static cpStaticGeometry *
+cpStaticGeometryCheckMutable(cpShape *shape)
+{
+	cpAssertHard(shape->klass == &cpStaticGeometryClass, "Shape is not a static geometry shape.");
+	cpAssertHard(!shape->space, "Children cannot be added to a static geometry shape that is in a space. Remove it first.");
+	
+	return (cpStaticGeometry *)shape;
+}
+
+int
+cpStaticGeometryAddSegment(cpShape *shape, cpVect a, cpVect b, cpFloat radius)
+{
+	cpStaticGeometry *geometry = cpStaticGeometryCheckMutable(shape);
+	ResetTree(geometry);
+	
+	int idx = geometry->numSegments++;
+	if(idx == geometry->maxSegments){
+		int maxSegments = GrowCapacity(idx, idx + 1);
+		geometry->segments = (Segment *)BufferGrow(geometry, geometry->segments, idx*sizeof(Segment), maxSegments*sizeof(Segment));
+		geometry->maxSegments = maxSegments;
+	}
+	
+	Segment *seg = geometry->segments + idx;
+	seg->a = seg->ta = a;
+	seg->b = seg->tb = b;
+	seg->n = seg->tn = cpvperp(cpvnormalize(cpvsub(b, a)));
+	seg->a_tangent = cpvzero;
+	seg->b_tangent = cpvzero;
+	seg->r = radius;
+	
+	return idx;
+}
+
+void
+cpStaticGeometrySetSegmentNeighbors(cpShape *shape, int idx, cpVect prev, cpVect next)
+{
+	cpStaticGeometry *geometry = cpStaticGeometryCheckMutable(shape);
+	cpAssertHard(0 <= idx && idx < geometry->numSegments, "Index out of range.");
+	
+	Segment *seg = geometry->segments + idx;
+	seg->a_tangent = cpvsub(prev, seg->a);
+	seg->b_tangent = cpvsub(next, seg->b);
+}
+
+int
+cpStaticGeometryAddPoly(cpShape *shape, int numVerts, const cpVect *verts, cpVect offset)
+{
+	cpStaticGeometry *geometry = cpStaticGeometryCheckMutable(shape);
+	
+	// Fail if the user attempts to pass a concave poly, or a bad winding.
+	cpAssertHard(cpPolyValidate(verts, numVerts), "Polygon is concave or has a reversed winding. Consider using cpConvexHull() or CP_CONVEX_HULL().");
+	ResetTree(geometry);
+	
+	int idx = geometry->numPolys++;
+	if(idx == geometry->maxPolys){
+		int maxPolys = GrowCapacity(idx, idx + 1);
+		geometry->polys = (Poly *)BufferGrow(geometry, geometry->polys, idx*sizeof(Poly), maxPolys*sizeof(Poly));
+		geometry->maxPolys = maxPolys;
+	}
+	
+	int first = geometry->numVerts;
+	int count = geometry->numVerts = first + numVerts;
+	if(count > geometry->maxVerts){
+		int oldVerts = geometry->maxVerts;
+		int maxVerts = geometry->maxVerts = GrowCapacity(oldVerts, count);
+		geometry->verts = (cpVect *)BufferGrow(geometry, geometry->verts, oldVerts*sizeof(cpVect), maxVerts*sizeof(cpVect));
+		geometry->tVerts = (cpVect *)BufferGrow(geometry, geometry->tVerts, oldVerts*sizeof(cpVect), maxVerts*sizeof(cpVect));
+		geometry->planes = (cpSplittingPlane *)BufferGrow(geometry, geometry->planes, oldVerts*sizeof(cpSplittingPlane), maxVerts*sizeof(cpSplittingPlane));
+		geometry->tPlanes = (cpSplittingPlane *)BufferGrow(geometry, geometry->tPlanes, oldVerts*sizeof(cpSplittingPlane), maxVerts*sizeof(cpSplittingPlane));
+	}
+	
+	geometry->polys[idx].numVerts = numVerts;
+	geometry->polys[idx].firstVert = first;
+	
+	for(int i=0; i<numVerts; i++){
+		cpVect a = cpvadd(offset, verts[i]);
+		cpVect b = cpvadd(offset, verts[(i+1)%numVerts]);
+		cpVect n = cpvnormalize(cpvperp(cpvsub(b, a)));
+		
+		geometry->verts[first + i] = geometry->tVerts[first + i] = a;
+		geometry->planes[first + i].n = n;
+		geometry->planes[first + i].d = cpvdot(n, a);
+		geometry->tPlanes[first + i] = geometry->planes[first + i];
+	}
+	
+	return idx;
+}
+
+int
+cpStaticGeometryGetNumSegments(cpShape *shape)
+{
+	cpAssertHard(shape->klass == &cpStaticGeometryClass, "Shape is not a static geometry shape.");
+	return ((cpStaticGeometry *)shape)->numSegments;
+}
+
+int
+cpStaticGeometryGetNumPolys(cpShape *shape)
+{
+	cpAssertHard(shape->klass == &cpStaticGeometryClass, "Shape is not a static geometry shape.");
+	return ((cpStaticGeometry *)shape)->numPolys;
+}
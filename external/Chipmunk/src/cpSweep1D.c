@@ -19,6 +19,8 @@
  * SOFTWARE.
  */
 
+#include <string.h>
+
 #include "chipmunk_private.h"
 
 static inline cpSpatialIndexClass *Klass();
@@ -29,9 +31,18 @@ typedef struct Bounds {
 	cpFloat min, max;
 } Bounds;
 
+typedef struct Handle {
+	void *obj;
+	// Index of the object's cell in the table.
+	int index;
+} Handle;
+
 typedef struct TableCell {
+	// NULL for cells whose object was removed or moved to the end of the table.
 	void *obj;
-	Bounds bounds;
+	Handle *handle;
+	// Bounds along the sweep axis and the cross axis.
+	Bounds bounds, cross;
 } TableCell;
 
 struct cpSweep1D
@@ -41,6 +52,25 @@ struct cpSweep1D
 	int num;
 	int max;
 	TableCell *table;
+	TableCell *scratch;
+	
+	// The first 'sorted' cells are sorted by bounds.min. Cells after them were inserted
+	// or reindexed since the last reindex and are kept in an unsorted tail.
+	int sorted;
+	// Number of empty cells left in the table by Remove() and ReindexObject().
+	int empty;
+	// Widest bounds along the sweep axis of any sorted cell.
+	// Lets queries binary search for the first cell that can overlap them.
+	cpFloat maxSpan;
+	
+	cpHashSet *handleSet;
+	cpArray *pooledHandles;
+	cpArray *allocatedBuffers;
+	
+	// Axis the table is sorted along. 0 for x, 1 for y.
+	int axis;
+	// Number of candidate pairs tested by the last reindex query.
+	unsigned int pairTests;
 };
 
 static inline cpBool
@@ -53,16 +83,59 @@ static inline Bounds
 BBToBounds(cpSweep1D *sweep, cpBB bb)
 {
 	Bounds bounds = {bb.l, bb.r};
+	if(sweep->axis){
+		bounds.min = bb.b;
+		bounds.max = bb.t;
+	}
+	
 	return bounds;
 }
 
+static inline Bounds
+BBToCross(cpSweep1D *sweep, cpBB bb)
+{
+	Bounds cross = {bb.b, bb.t};
+	if(sweep->axis){
+		cross.min = bb.l;
+		cross.max = bb.r;
+	}
+	
+	return cross;
+}
+
 static inline TableCell
-MakeTableCell(cpSweep1D *sweep, void *obj)
+MakeTableCell(cpSweep1D *sweep, Handle *handle)
 {
-	TableCell cell = {obj, BBToBounds(sweep, sweep->spatialIndex.bbfunc(obj))};
+	cpBB bb = sweep->spatialIndex.bbfunc(handle->obj);
+	TableCell cell = {handle->obj, handle, BBToBounds(sweep, bb), BBToCross(sweep, bb)};
 	return cell;
 }
 
+//MARK: Handle Functions
+
+static int handleSetEql(void *obj, Handle *handle){return (obj == handle->obj);}
+
+static void *
+handleSetTrans(void *obj, cpSweep1D *sweep)
+{
+	if(sweep->pooledHandles->num == 0){
+		// handle pool is exhausted, make more
+		int count = CP_BUFFER_BYTES/sizeof(Handle);
+		cpAssertHard(count, "Internal Error: Buffer size is too small.");
+		
+		Handle *buffer = (Handle *)cpAllocatorAllocOrHeap(sweep->spatialIndex.allocator, CP_BUFFER_BYTES, CP_ALLOCATOR_MISC);
+		cpArrayPush(sweep->allocatedBuffers, buffer);
+		
+		for(int i=0; i<count; i++) cpArrayPush(sweep->pooledHandles, buffer + i);
+	}
+	
+	Handle *handle = (Handle *)cpArrayPop(sweep->pooledHandles);
+	handle->obj = obj;
+	handle->index = -1;
+	
+	return handle;
+}
+
 //MARK: Memory Management Functions
 
 cpSweep1D *
@@ -76,6 +149,7 @@ ResizeTable(cpSweep1D *sweep, int size)
 {
 	sweep->max = size;
 	sweep->table = (TableCell *)cprealloc(sweep->table, size*sizeof(TableCell));
+	sweep->scratch = (TableCell *)cprealloc(sweep->scratch, size*sizeof(TableCell));
 }
 
 cpSpatialIndex *
@@ -84,8 +158,21 @@ cpSweep1DInit(cpSweep1D *sweep, cpSpatialIndexBBFunc bbfunc, cpSpatialIndex *sta
 	cpSpatialIndexInit((cpSpatialIndex *)sweep, Klass(), bbfunc, staticIndex);
 	
 	sweep->num = 0;
+	sweep->table = NULL;
+	sweep->scratch = NULL;
 	ResizeTable(sweep, 32);
 	
+	sweep->sorted = 0;
+	sweep->empty = 0;
+	sweep->maxSpan = 0.0f;
+	
+	sweep->handleSet = cpHashSetNew(0, (cpHashSetEqlFunc)handleSetEql);
+	sweep->pooledHandles = cpArrayNew(0);
+	sweep->allocatedBuffers = cpArrayNew(0);
+	
+	sweep->axis = 0;
+	sweep->pairTests = 0;
+	
 	return (cpSpatialIndex *)sweep;
 }
 
@@ -95,11 +182,66 @@ cpSweep1DNew(cpSpatialIndexBBFunc bbfunc, cpSpatialIndex *staticIndex)
 	return cpSweep1DInit(cpSweep1DAlloc(), bbfunc, staticIndex);
 }
 
+static void
+FreeBuffers(cpSweep1D *sweep)
+{
+	cpArray *buffers = sweep->allocatedBuffers;
+	for(int i=0; i<buffers->num; i++) cpAllocatorFreeOrHeap(sweep->spatialIndex.allocator, buffers->arr[i], CP_BUFFER_BYTES, CP_ALLOCATOR_MISC);
+	buffers->num = 0;
+	
+	sweep->pooledHandles->num = 0;
+}
+
 static void
 cpSweep1DDestroy(cpSweep1D *sweep)
 {
 	cpfree(sweep->table);
 	sweep->table = NULL;
+	cpfree(sweep->scratch);
+	sweep->scratch = NULL;
+	
+	cpHashSetFree(sweep->handleSet);
+	
+	FreeBuffers(sweep);
+	cpArrayFree(sweep->allocatedBuffers);
+	cpArrayFree(sweep->pooledHandles);
+}
+
+static void
+cpSweep1DSetAllocator(cpSweep1D *sweep, cpAllocator *allocator)
+{
+	// The sweep is empty, but the empty cells left by Remove() still point at pooled handles.
+	sweep->num = 0;
+	sweep->sorted = 0;
+	sweep->empty = 0;
+	sweep->maxSpan = 0.0f;
+	FreeBuffers(sweep);
+	
+	cpHashSetSetAllocator(sweep->handleSet, allocator);
+}
+
+static inline cpSweep1D *
+GetSweep(cpSpatialIndex *index)
+{
+	return (index && index->klass == Klass() ? (cpSweep1D *)index : NULL);
+}
+
+int
+cpSweep1DGetAxis(cpSpatialIndex *index)
+{
+	cpSweep1D *sweep = GetSweep(index);
+	cpAssertWarn(sweep, "Ignoring cpSweep1DGetAxis() call to non-sweep spatial index.");
+	
+	return (sweep ? sweep->axis : 0);
+}
+
+unsigned int
+cpSweep1DGetPairTests(cpSpatialIndex *index)
+{
+	cpSweep1D *sweep = GetSweep(index);
+	cpAssertWarn(sweep, "Ignoring cpSweep1DGetPairTests() call to non-sweep spatial index.");
+	
+	return (sweep ? sweep->pairTests : 0);
 }
 
 //MARK: Misc
@@ -107,51 +249,218 @@ cpSweep1DDestroy(cpSweep1D *sweep)
 static int
 cpSweep1DCount(cpSweep1D *sweep)
 {
-	return sweep->num;
+	return cpHashSetCount(sweep->handleSet);
 }
 
 static void
 cpSweep1DEach(cpSweep1D *sweep, cpSpatialIndexIteratorFunc func, void *data)
 {
 	TableCell *table = sweep->table;
-	for(int i=0, count=sweep->num; i<count; i++) func(table[i].obj, data);
+	for(int i=0, count=sweep->num; i<count; i++){
+		if(table[i].obj) func(table[i].obj, data);
+	}
 }
 
 static int
 cpSweep1DContains(cpSweep1D *sweep, void *obj, cpHashValue hashid)
 {
+	return (cpHashSetFind(sweep->handleSet, hashid, obj) != NULL);
+}
+
+//MARK: Sorting
+
+// Switch axes only when the other one is spread out this much more than the current one.
+// Keeps the sweep from flip-flopping (and throwing away its sort order) every step.
+#define AXIS_HYSTERESIS 1.5f
+
+// Past this many cells the unsorted tail is merge sorted instead of insertion sorted.
+#define TAIL_INSERTION_SORT 16
+
+static void
+CompactTable(cpSweep1D *sweep)
+{
+	if(sweep->empty == 0) return;
+	
 	TableCell *table = sweep->table;
+	int sorted = 0, num = 0;
+	
 	for(int i=0, count=sweep->num; i<count; i++){
-		if(table[i].obj == obj) return cpTrue;
+		if(table[i].obj){
+			if(i < sweep->sorted) sorted++;
+			table[num++] = table[i];
+		}
+	}
+	
+	sweep->num = num;
+	sweep->sorted = sorted;
+	sweep->empty = 0;
+}
+
+static void
+UpdateTable(cpSweep1D *sweep)
+{
+	TableCell *table = sweep->table;
+	int count = sweep->num;
+	if(count == 0) return;
+	
+	cpSpatialIndexBBFunc bbfunc = sweep->spatialIndex.bbfunc;
+	
+	// Update the bounds and accumulate the variance of the centers along each axis.
+	cpFloat sx = 0.0f, sy = 0.0f, sxx = 0.0f, syy = 0.0f;
+	for(int i=0; i<count; i++){
+		cpBB bb = bbfunc(table[i].obj);
+		table[i].bounds = BBToBounds(sweep, bb);
+		table[i].cross = BBToCross(sweep, bb);
+		
+		cpFloat x = (bb.l + bb.r)*0.5f, y = (bb.b + bb.t)*0.5f;
+		sx += x; sxx += x*x;
+		sy += y; syy += y*y;
 	}
 	
-	return cpFalse;
+	cpFloat varx = sxx - sx*sx/count;
+	cpFloat vary = syy - sy*sy/count;
+	
+	// Sweep along the axis where the objects are spread out the most.
+	cpFloat curr = (sweep->axis ? vary : varx);
+	cpFloat other = (sweep->axis ? varx : vary);
+	if(other > curr*AXIS_HYSTERESIS){
+		sweep->axis = !sweep->axis;
+		
+		for(int i=0; i<count; i++){
+			Bounds swap = table[i].bounds;
+			table[i].bounds = table[i].cross;
+			table[i].cross = swap;
+		}
+		
+		// The old order is useless along the new axis.
+		sweep->sorted = 0;
+	}
+}
+
+static void
+InsertionSort(TableCell *table, int count)
+{
+	for(int i=1; i<count; i++){
+		TableCell cell = table[i];
+		cpFloat min = cell.bounds.min;
+		
+		int j = i;
+		while(j > 0 && table[j - 1].bounds.min > min){
+			table[j] = table[j - 1];
+			j--;
+		}
+		
+		table[j] = cell;
+	}
+}
+
+static inline int IntMin(int a, int b){return (a < b ? a : b);}
+
+// Stable merge of two sorted runs into dst.
+static void
+MergeRuns(TableCell *dst, TableCell *a, int countA, TableCell *b, int countB)
+{
+	int i = 0, j = 0;
+	while(i < countA && j < countB){
+		*dst++ = (b[j].bounds.min < a[i].bounds.min ? b[j++] : a[i++]);
+	}
+	
+	while(i < countA) *dst++ = a[i++];
+	while(j < countB) *dst++ = b[j++];
+}
+
+// Stable bottom up merge sort. Returns whichever of table or scratch holds the result.
+static TableCell *
+MergeSort(TableCell *table, TableCell *scratch, int count)
+{
+	int run = TAIL_INSERTION_SORT;
+	for(int i=0; i<count; i+=run) InsertionSort(table + i, IntMin(run, count - i));
+	
+	for(; run<count; run*=2){
+		for(int i=0; i<count; i+=2*run){
+			int countA = IntMin(run, count - i);
+			int countB = IntMin(run, count - i - countA);
+			MergeRuns(scratch + i, table + i, countA, table + i + countA, countB);
+		}
+		
+		TableCell *swap = table; table = scratch; scratch = swap;
+	}
+	
+	return table;
+}
+
+static void
+SortTable(cpSweep1D *sweep)
+{
+	TableCell *table = sweep->table;
+	int count = sweep->num;
+	int sorted = sweep->sorted;
+	
+	// The sorted cells only moved a little since the last step so they only need to be fixed up.
+	// Insertion sort is O(n) for nearly sorted data, which is the common case.
+	InsertionSort(table, sorted);
+	
+	// Newly inserted or reindexed objects (or the whole table after an axis switch) are in no particular order.
+	// Sort them separately and merge them in so they don't degrade the insertion sort to O(n^2).
+	int tail = count - sorted;
+	if(tail > 0){
+		TableCell *sortedTail = MergeSort(table + sorted, sweep->scratch + sorted, tail);
+		if(sorted > 0){
+			memcpy(sweep->scratch, table, sorted*sizeof(TableCell));
+			MergeRuns(table, sweep->scratch, sorted, sortedTail, tail);
+		} else if(sortedTail != table){
+			memcpy(table, sortedTail, count*sizeof(TableCell));
+		}
+	}
+	
+	// Fix up the handle indexes and find the widest cell for the queries.
+	cpFloat maxSpan = 0.0f;
+	for(int i=0; i<count; i++){
+		table[i].handle->index = i;
+		maxSpan = cpfmax(maxSpan, table[i].bounds.max - table[i].bounds.min);
+	}
+	
+	sweep->sorted = count;
+	sweep->maxSpan = maxSpan;
 }
 
 //MARK: Basic Operations
 
 static void
-cpSweep1DInsert(cpSweep1D *sweep, void *obj, cpHashValue hashid)
+AppendCell(cpSweep1D *sweep, Handle *handle)
 {
-	if(sweep->num == sweep->max) ResizeTable(sweep, sweep->max*2);
+	if(sweep->num == sweep->max){
+		// Compact instead of growing if enough of the table is empty cells.
+		CompactTable(sweep);
+		for(int i=0, count=sweep->num; i<count; i++) sweep->table[i].handle->index = i;
+		
+		if(sweep->num*2 > sweep->max) ResizeTable(sweep, sweep->max*2);
+	}
 	
-	sweep->table[sweep->num] = MakeTableCell(sweep, obj);
+	// Appended to the unsorted tail, the next reindex will sort it into place.
+	handle->index = sweep->num;
+	sweep->table[sweep->num] = MakeTableCell(sweep, handle);
 	sweep->num++;
 }
 
+static void
+cpSweep1DInsert(cpSweep1D *sweep, void *obj, cpHashValue hashid)
+{
+	Handle *handle = (Handle *)cpHashSetInsert(sweep->handleSet, hashid, obj, sweep, (cpHashSetTransFunc)handleSetTrans);
+	AppendCell(sweep, handle);
+}
+
 static void
 cpSweep1DRemove(cpSweep1D *sweep, void *obj, cpHashValue hashid)
 {
-	TableCell *table = sweep->table;
-	for(int i=0, count=sweep->num; i<count; i++){
-		if(table[i].obj == obj){
-			int num = --sweep->num;
-			
-			table[i] = table[num];
-			table[num].obj = NULL;
-			
-			return;
-		}
+	Handle *handle = (Handle *)cpHashSetRemove(sweep->handleSet, hashid, obj);
+	if(handle){
+		// Leave an empty cell behind to keep the table sorted, the next reindex will compact it.
+		sweep->table[handle->index].obj = NULL;
+		sweep->empty++;
+		
+		handle->obj = NULL;
+		cpArrayPush(sweep->pooledHandles, handle);
 	}
 }
 
@@ -160,30 +469,84 @@ cpSweep1DRemove(cpSweep1D *sweep, void *obj, cpHashValue hashid)
 static void
 cpSweep1DReindexObject(cpSweep1D *sweep, void *obj, cpHashValue hashid)
 {
-	// Nothing to do here
+	Handle *handle = (Handle *)cpHashSetFind(sweep->handleSet, hashid, obj);
+	if(!handle) return;
+	
+	TableCell *table = sweep->table;
+	int i = handle->index;
+	TableCell cell = MakeTableCell(sweep, handle);
+	
+	if(i >= sweep->sorted){
+		// Cells in the unsorted tail can simply be updated.
+		table[i] = cell;
+	} else {
+		// Update the cell in place if it would stay sorted, otherwise move it to the tail.
+		cpFloat min = cell.bounds.min;
+		cpBool fits = (
+			(i == 0 || table[i - 1].bounds.min <= min) &&
+			(i + 1 == sweep->sorted || min <= table[i + 1].bounds.min) &&
+			cell.bounds.max - min <= sweep->maxSpan
+		);
+		
+		if(fits){
+			table[i] = cell;
+		} else {
+			table[i].obj = NULL;
+			sweep->empty++;
+			AppendCell(sweep, handle);
+		}
+	}
 }
 
 static void
 cpSweep1DReindex(cpSweep1D *sweep)
 {
-	// Nothing to do here
-	// Could perform a sort, but queries are not accelerated anyway.
+	CompactTable(sweep);
+	UpdateTable(sweep);
+	SortTable(sweep);
 }
 
 //MARK: Query Functions
 
+// Index of the first sorted cell whose bounds could reach min.
+static int
+FirstSortedCell(cpSweep1D *sweep, cpFloat min)
+{
+	// Any cell starting before this can't reach min.
+	cpFloat limit = min - sweep->maxSpan;
+	
+	TableCell *table = sweep->table;
+	int lo = 0, hi = sweep->sorted;
+	while(lo < hi){
+		int mid = (lo + hi)/2;
+		if(table[mid].bounds.min < limit){
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	
+	return lo;
+}
+
 static void
 cpSweep1DQuery(cpSweep1D *sweep, void *obj, cpBB bb, cpSpatialIndexQueryFunc func, void *data)
 {
-	// Implementing binary search here would allow you to find an upper limit
-	// but not a lower limit. Probably not worth the hassle.
-	
 	Bounds bounds = BBToBounds(sweep, bb);
+	Bounds cross = BBToCross(sweep, bb);
 	
 	TableCell *table = sweep->table;
-	for(int i=0, count=sweep->num; i<count; i++){
+	
+	// Binary search the sorted cells for a lower limit, the upper limit is where the cells start after the query ends.
+	for(int i=FirstSortedCell(sweep, bounds.min), count=sweep->sorted; i<count && table[i].bounds.min <= bounds.max; i++){
+		TableCell cell = table[i];
+		if(cell.obj && BoundsOverlap(bounds, cell.bounds) && BoundsOverlap(cross, cell.cross) && obj != cell.obj) func(obj, cell.obj, data);
+	}
+	
+	// Check the unsorted tail.
+	for(int i=sweep->sorted, count=sweep->num; i<count; i++){
 		TableCell cell = table[i];
-		if(BoundsOverlap(bounds, cell.bounds) && obj != cell.obj) func(obj, cell.obj, data);
+		if(cell.obj && BoundsOverlap(bounds, cell.bounds) && BoundsOverlap(cross, cell.cross) && obj != cell.obj) func(obj, cell.obj, data);
 	}
 }
 
@@ -192,44 +555,49 @@ cpSweep1DSegmentQuery(cpSweep1D *sweep, void *obj, cpVect a, cpVect b, cpFloat t
 {
 	cpBB bb = cpBBExpand(cpBBNew(a.x, a.y, a.x, a.y), b);
 	Bounds bounds = BBToBounds(sweep, bb);
+	Bounds cross = BBToCross(sweep, bb);
 	
 	TableCell *table = sweep->table;
-	for(int i=0, count=sweep->num; i<count; i++){
+	
+	for(int i=FirstSortedCell(sweep, bounds.min), count=sweep->sorted; i<count && table[i].bounds.min <= bounds.max; i++){
+		TableCell cell = table[i];
+		if(cell.obj && BoundsOverlap(bounds, cell.bounds) && BoundsOverlap(cross, cell.cross)) func(obj, cell.obj, data);
+	}
+	
+	for(int i=sweep->sorted, count=sweep->num; i<count; i++){
 		TableCell cell = table[i];
-		if(BoundsOverlap(bounds, cell.bounds)) func(obj, cell.obj, data);
+		if(cell.obj && BoundsOverlap(bounds, cell.bounds) && BoundsOverlap(cross, cell.cross)) func(obj, cell.obj, data);
 	}
 }
 
 //MARK: Reindex/Query
 
-static int
-TableSort(TableCell *a, TableCell *b)
-{
-	return (a->bounds.min < b->bounds.min ? -1 : (a->bounds.min > b->bounds.min ? 1 : 0));
-}
-
 static void
 cpSweep1DReindexQuery(cpSweep1D *sweep, cpSpatialIndexQueryFunc func, void *data)
 {
+	// Update bounds, pick the sweep axis and sort
+	cpSweep1DReindex(sweep);
+	
 	TableCell *table = sweep->table;
 	int count = sweep->num;
-	
-	// Update bounds and sort
-	for(int i=0; i<count; i++) table[i] = MakeTableCell(sweep, table[i].obj);
-	qsort(table, count, sizeof(TableCell), (int (*)(const void *, const void *))TableSort); // TODO use insertion sort instead
+	unsigned int pairTests = 0;
 	
 	for(int i=0; i<count; i++){
 		TableCell cell = table[i];
 		cpFloat max = cell.bounds.max;
 		
-		for(int j=i+1; table[j].bounds.min < max && j<count; j++){
-			func(cell.obj, table[j].obj, data);
+		for(int j=i+1; j<count && table[j].bounds.min <= max; j++){
+			pairTests++;
+			if(BoundsOverlap(cell.cross, table[j].cross)) func(cell.obj, table[j].obj, data);
 		}
 	}
 	
+	sweep->pairTests = pairTests;
+	
 	// Reindex query is also responsible for colliding against the static index.
 	// Fortunately there is a helper function for that.
-	cpSpatialIndexCollideStatic((cpSpatialIndex *)sweep, sweep->spatialIndex.staticIndex, func, data);
+	cpSpatialIndex *staticIndex = sweep->spatialIndex.staticIndex;
+	if(staticIndex) cpSpatialIndexCollideStatic((cpSpatialIndex *)sweep, staticIndex, func, data);
 }
 
 static cpSpatialIndexClass klass = {
@@ -248,6 +616,8 @@ static cpSpatialIndexClass klass = {
 	
 	(cpSpatialIndexQueryImpl)cpSweep1DQuery,
 	(cpSpatialIndexSegmentQueryImpl)cpSweep1DSegmentQuery,
+	
+	(cpSpatialIndexSetAllocatorImpl)cpSweep1DSetAllocator,
 };
 
 static inline cpSpatialIndexClass *Klass(){return &klass;}
@@ -0,0 +1,255 @@
+/* Copyright (c) 2013 Scott Lembcke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+	Adaptive solver test.
+	
+	Checks that the adaptive solver uses fewer iterations once a pile of boxes comes to rest, more while another
+	pile lands on it, that it never uses fewer than the minimum number of iterations, and that a pivot joint
+	whose impulse changes direction but not size isn't treated as converged.
+	
+	Usage: chipmunk_adaptivesolver
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "chipmunk.h"
+
+#define NUM_BOXES 100
+#define ITERATIONS 30
+
+static int failures = 0;
+
+static void
+Check(cpBool passed, const char *what, int step)
+{
+	if(!passed){
+		printf("FAILED: %s (step %d)\n", what, step);
+		failures++;
+	}
+}
+
+//MARK: Scene
+
+typedef struct Scene {
+	cpSpace *space;
+	cpShape *ground;
+	
+	cpBody *bodies[2*NUM_BOXES + 1];
+	cpShape *shapes[2*NUM_BOXES + 1];
+	int numBoxes;
+	
+	cpConstraint *joint;
+} Scene;
+
+static void
+SceneInit(Scene *scene)
+{
+	cpSpace *space = scene->space = cpSpaceNew();
+	cpSpaceSetGravity(space, cpv(0, -100));
+	cpSpaceSetIterations(space, ITERATIONS);
+	cpSpaceSetSolverTolerance(space, 1e-3f);
+	
+	scene->ground = cpSpaceAddShape(space, cpSegmentShapeNew(cpSpaceGetStaticBody(space), cpv(-500, 0), cpv(500, 0), 0.0f));
+	cpShapeSetFriction(scene->ground, 1.0f);
+	
+	scene->numBoxes = 0;
+	scene->joint = NULL;
+}
+
+// Adds rows of boxes starting at the given height.
+static void
+SceneAddBoxes(Scene *scene, cpFloat height)
+{
+	cpSpace *space = scene->space;
+	
+	for(int i=0; i<NUM_BOXES; i++){
+		cpBody *body = cpSpaceAddBody(space, cpBodyNew(1.0f, cpMomentForBox(1.0f, 10.0f, 10.0f)));
+		cpBodySetPos(body, cpv(-100.0f + (i%20)*10.5f, height + 5.0f + (i/20)*10.5f));
+		
+		cpShape *shape = cpSpaceAddShape(space, cpBoxShapeNew(body, 10.0f, 10.0f));
+		cpShapeSetFriction(shape, 1.0f);
+		
+		scene->bodies[scene->numBoxes] = body;
+		scene->shapes[scene->numBoxes] = shape;
+		scene->numBoxes++;
+	}
+}
+
+// A body pinned to a static pivot and spinning around it.
+static void
+SceneAddRotor(Scene *scene, cpFloat spin)
+{
+	cpSpace *space = scene->space;
+	cpVect pivot = cpv(0.0f, 1000.0f);
+	
+	cpBody *body = cpSpaceAddBody(space, cpBodyNew(1.0f, cpMomentForCircle(1.0f, 0.0f, 2.0f, cpvzero)));
+	cpBodySetPos(body, cpvadd(pivot, cpv(10.0f, 0.0f)));
+	cpBodySetVel(body, cpv(0.0f, 10.0f*spin));
+	cpBodySetAngVel(body, spin);
+	
+	scene->joint = cpSpaceAddConstraint(space, cpPivotJointNew(cpSpaceGetStaticBody(space), body, pivot));
+	scene->bodies[scene->numBoxes] = body;
+	scene->shapes[scene->numBoxes] = NULL;
+	scene->numBoxes++;
+}
+
+static void
+SceneFree(Scene *scene)
+{
+	cpSpace *space = scene->space;
+	
+	if(scene->joint){
+		cpSpaceRemoveConstraint(space, scene->joint);
+		cpConstraintFree(scene->joint);
+	}
+	
+	for(int i=0; i<scene->numBoxes; i++){
+		if(scene->shapes[i]){
+			cpSpaceRemoveShape(space, scene->shapes[i]);
+			cpShapeFree(scene->shapes[i]);
+		}
+		
+		cpSpaceRemoveBody(space, scene->bodies[i]);
+		cpBodyFree(scene->bodies[i]);
+	}
+	
+	cpSpaceRemoveShape(space, scene->ground);
+	cpShapeFree(scene->ground);
+	cpSpaceFree(space);
+}
+
+//MARK: Tests
+
+static int
+StepMaxIterations(Scene *scene, int steps, int *step)
+{
+	int maxIterations = 0;
+	for(int i=0; i<steps; i++, (*step)++){
+		cpSpaceStep(scene->space, 1.0f/60.0f);
+		
+		int iterations = cpSpaceGetLastIterations(scene->space);
+		if(iterations > maxIterations) maxIterations = iterations;
+	}
+	
+	return maxIterations;
+}
+
+// A pile of boxes settles, then a second pile lands on top of it.
+static void
+RunPile(void)
+{
+	Scene scene;
+	SceneInit(&scene);
+	SceneAddBoxes(&scene, 0.0f);
+	
+	int step = 0;
+	int before = failures;
+	int settling = StepMaxIterations(&scene, 60, &step);
+	StepMaxIterations(&scene, 120, &step);
+	int resting = StepMaxIterations(&scene, 60, &step);
+	
+	Check(settling == ITERATIONS, "settling pile uses every iteration", step);
+	Check(resting <= 3, "resting pile converges in a few iterations", step);
+	printf("%-24s %s\n", "resting", failures > before ? "FAILED" : "passed");
+	
+	before = failures;
+	SceneAddBoxes(&scene, 200.0f);
+	
+	int falling = StepMaxIterations(&scene, 60, &step);
+	int landing = StepMaxIterations(&scene, 60, &step);
+	
+	Check(falling <= 3, "resting pile unaffected by falling boxes", step);
+	Check(landing == ITERATIONS, "pile-up uses every iteration", step);
+	printf("%-24s %s\n", "pile-up", failures > before ? "FAILED" : "passed");
+	
+	SceneFree(&scene);
+}
+
+static void
+RunMinIterations(void)
+{
+	Scene scene;
+	SceneInit(&scene);
+	SceneAddBoxes(&scene, 0.0f);
+	
+	int step = 0;
+	int before = failures;
+	StepMaxIterations(&scene, 180, &step);
+	
+	cpSpaceSetMinIterations(scene.space, 8);
+	for(int i=0; i<60; i++, step++){
+		cpSpaceStep(scene.space, 1.0f/60.0f);
+		Check(cpSpaceGetLastIterations(scene.space) == 8, "minimum iterations honoured", step);
+	}
+	
+	// The maximum wins over the minimum.
+	cpSpaceSetMinIterations(scene.space, 2*ITERATIONS);
+	cpSpaceStep(scene.space, 1.0f/60.0f);
+	Check(cpSpaceGetLastIterations(scene.space) == ITERATIONS, "maximum iterations honoured", step++);
+	
+	// Without a tolerance every iteration runs.
+	cpSpaceSetMinIterations(scene.space, 1);
+	cpSpaceSetSolverTolerance(scene.space, 0.0f);
+	cpSpaceStep(scene.space, 1.0f/60.0f);
+	Check(cpSpaceGetLastIterations(scene.space) == ITERATIONS, "fixed iterations without a tolerance", step++);
+	
+	printf("%-24s %s\n", "min iterations", failures > before ? "FAILED" : "passed");
+	SceneFree(&scene);
+}
+
+// A body spinning around a pivot needs an impulse of the same size every step, but in a rotated direction.
+// The warm started impulse points the wrong way, so the island can't be converged after the first pass.
+static void
+RunRotor(void)
+{
+	int before = failures;
+	
+	Scene scene;
+	SceneInit(&scene);
+	cpSpaceSetGravity(scene.space, cpvzero);
+	cpSpaceSetSolverTolerance(scene.space, 1e-2f);
+	SceneAddRotor(&scene, 2.0f);
+	
+	for(int step=0; step<120; step++){
+		cpSpaceStep(scene.space, 1.0f/60.0f);
+		Check(cpSpaceGetLastIterations(scene.space) == 2, "rotor checks its corrected impulse", step);
+	}
+	
+	printf("%-24s %s\n", "rotor", failures > before ? "FAILED" : "passed");
+	SceneFree(&scene);
+}
+
+//MARK: Main
+
+int
+main(int argc, char **argv)
+{
+	RunPile();
+	RunMinIterations();
+	RunRotor();
+	
+	return (failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
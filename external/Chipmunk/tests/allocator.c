@@ -0,0 +1,337 @@
+/* Copyright (c) 2013 Scott Lembcke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/*
+	Allocator test.
+	
+	Checks the per category byte counts of the heap, arena and pool allocators while bodies and shapes are created
+	from them and a space steps with each spatial index, and that everything is returned when freed.
+	Also checks that the arrays of static geometry shapes come from the shape's allocator.
+	
+	Usage: chipmunk_allocator
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chipmunk.h"
+
+#define NUM_BOXES 200
+
+static int failures = 0;
+
+static void
+Check(cpBool passed, const char *what, const char *scene)
+{
+	if(!passed){
+		printf("FAILED: %s (%s)\n", what, scene);
+		failures++;
+	}
+}
+
+static const char *categoryNames[] = {"misc", "bodies", "shapes", "arbiters", "contacts"};
+
+static void
+CheckEmpty(cpAllocator *allocator, const char *scene)
+{
+	for(int i=0; i<CP_ALLOCATOR_NUM_CATEGORIES; i++){
+		if(cpAllocatorGetBytes(allocator, (cpAllocatorCategory)i) != 0){
+			printf("FAILED: %lu %s bytes left over (%s)\n", (unsigned long)cpAllocatorGetBytes(allocator, (cpAllocatorCategory)i), categoryNames[i], scene);
+			failures++;
+		}
+	}
+}
+
+//MARK: Scene
+
+typedef struct Scene {
+	cpSpace *space;
+	cpBody *bodies[NUM_BOXES];
+	cpShape *shapes[NUM_BOXES + 1];
+} Scene;
+
+// Stacks of boxes on a static segment, with islands enabled so the island buffer is used too.
+// The bodies and shapes come from @c allocator, or the heap if it's NULL.
+static void
+SceneInit(Scene *scene, cpAllocator *allocator)
+{
+	cpSpace *space = scene->space = cpSpaceNew();
+	cpSpaceSetGravity(space, cpv(0, -100));
+	cpSpaceSetSolverTolerance(space, 1e-3f);
+	
+	scene->shapes[NUM_BOXES] = cpSpaceAddShape(space, cpSegmentShapeNewWithAllocator(allocator, cpSpaceGetStaticBody(space), cpv(-500, 0), cpv(500, 0), 0.0f));
+	
+	for(int i=0; i<NUM_BOXES; i++){
+		cpBody *body = scene->bodies[i] = cpSpaceAddBody(space, cpBodyNewWithAllocator(allocator, 1.0f, cpMomentForBox(1.0f, 10.0f, 10.0f)));
+		cpBodySetPos(body, cpv(-400.0f + (i%40)*20.0f, 5.0f + (i/40)*11.0f));
+		scene->shapes[i] = cpSpaceAddShape(space, cpBoxShapeNewWithAllocator(allocator, body, 10.0f, 10.0f));
+	}
+}
+
+static void
+SceneFree(Scene *scene)
+{
+	cpSpace *space = scene->space;
+	
+	for(int i=0; i<=NUM_BOXES; i++){
+		cpSpaceRemoveShape(space, scene->shapes[i]);
+		cpShapeFree(scene->shapes[i]);
+	}
+	
+	for(int i=0; i<NUM_BOXES; i++){
+		cpSpaceRemoveBody(space, scene->bodies[i]);
+		cpBodyFree(scene->bodies[i]);
+	}
+	
+	cpSpaceFree(space);
+}
+
+//MARK: Tests
+
+typedef enum IndexType {INDEX_BBTREE, INDEX_HASH, INDEX_SWEEP} IndexType;
+
+// Everything, including the space's buffers, comes from one heap allocator.
+static void
+RunHeapAllocator(IndexType index, const char *name)
+{
+	int before = failures;
+	cpAllocator *allocator = cpHeapAllocatorNew();
+	
+	Scene scene;
+	SceneInit(&scene, allocator);
+	
+	// Switch the space over before anything was added to its indexes.
+	cpSpace *space = cpSpaceNew();
+	cpSpaceSetAllocator(space, allocator);
+	Check(cpSpaceGetAllocator(space) == allocator, "space uses the allocator", name);
+	
+	if(index == INDEX_HASH) cpSpaceUseSpatialHash(space, 10.0f, 1000);
+	if(index == INDEX_SWEEP) cpSpaceUseSweep1D(space);
+	
+	for(int i=0; i<=NUM_BOXES; i++) cpSpaceRemoveShape(scene.space, scene.shapes[i]);
+	for(int i=0; i<NUM_BOXES; i++) cpSpaceRemoveBody(scene.space, scene.bodies[i]);
+	cpShapeSetBody(scene.shapes[NUM_BOXES], cpSpaceGetStaticBody(space));
+	cpSpaceFree(scene.space);
+	scene.space = space;
+	
+	for(int i=0; i<NUM_BOXES; i++) cpSpaceAddBody(space, scene.bodies[i]);
+	for(int i=0; i<=NUM_BOXES; i++) cpSpaceAddShape(space, scene.shapes[i]);
+	cpSpaceSetGravity(space, cpv(0, -100));
+	
+	// Poly vertex arrays come from the heap.
+	Check(cpAllocatorGetBytes(allocator, CP_ALLOCATOR_BODIES) == NUM_BOXES*sizeof(cpBody), "body bytes", name);
+	Check(cpAllocatorGetBytes(allocator, CP_ALLOCATOR_SHAPES) == NUM_BOXES*sizeof(cpPolyShape) + sizeof(cpSegmentShape), "shape bytes", name);
+	Check(cpAllocatorGetBytes(allocator, CP_ALLOCATOR_MISC) > 0, "spatial index bytes", name);
+	
+	for(int i=0; i<60; i++) cpSpaceStep(scene.space, 1.0f/60.0f);
+	
+	Check(cpAllocatorGetBytes(allocator, CP_ALLOCATOR_ARBITERS) > 0, "arbiter bytes", name);
+	Check(cpAllocatorGetBytes(allocator, CP_ALLOCATOR_CONTACTS) > 0, "contact bytes", name);
+	Check(allocator->peakBytes >= cpAllocatorGetTotalBytes(allocator), "peak bytes", name);
+	
+	SceneFree(&scene);
+	CheckEmpty(allocator, name);
+	
+	cpAllocatorFree(allocator);
+	printf("%-24s %s\n", name, failures > before ? "FAILED" : "passed");
+}
+
+// A space with its own arena while the objects are allocated from the heap.
+static void
+RunArena(void)
+{
+	int before = failures;
+	
+	Scene scene;
+	SceneInit(&scene, NULL);
+	Check(scene.bodies[0]->CP_PRIVATE(allocator) == NULL, "objects use the heap without an allocator", "arena");
+	
+	cpSpace *space = cpSpaceNew();
+	cpAllocator *arena = cpArenaAllocatorNew(0);
+	cpSpaceSetAllocator(space, arena);
+	
+	// Move the objects over to the space using the arena.
+	for(int i=0; i<=NUM_BOXES; i++) cpSpaceRemoveShape(scene.space, scene.shapes[i]);
+	for(int i=0; i<NUM_BOXES; i++) cpSpaceRemoveBody(scene.space, scene.bodies[i]);
+	cpShapeSetBody(scene.shapes[NUM_BOXES], cpSpaceGetStaticBody(space));
+	cpSpaceFree(scene.space);
+	scene.space = space;
+	
+	for(int i=0; i<NUM_BOXES; i++) cpSpaceAddBody(space, scene.bodies[i]);
+	for(int i=0; i<=NUM_BOXES; i++) cpSpaceAddShape(space, scene.shapes[i]);
+	cpSpaceSetGravity(space, cpv(0, -100));
+	
+	for(int i=0; i<60; i++) cpSpaceStep(space, 1.0f/60.0f);
+	
+	Check(cpAllocatorGetBytes(arena, CP_ALLOCATOR_BODIES) == 0, "arena body bytes", "arena");
+	Check(cpAllocatorGetBytes(arena, CP_ALLOCATOR_MISC) > 0, "arena spatial index bytes", "arena");
+	Check(cpAllocatorGetBytes(arena, CP_ALLOCATOR_CONTACTS) > 0, "arena contact bytes", "arena");
+	
+	// Arenas keep everything until they are reset.
+	size_t held = cpAllocatorGetTotalBytes(arena);
+	SceneFree(&scene);
+	Check(cpAllocatorGetTotalBytes(arena) == held, "arena bytes are held until reset", "arena");
+	
+	cpArenaAllocatorReset(arena);
+	CheckEmpty(arena, "arena");
+	cpAllocatorFree(arena);
+	printf("%-24s %s\n", "arena", failures > before ? "FAILED" : "passed");
+}
+
+// Bodies, circles and boxes allocated from one pool, with the space using its own heap allocator.
+static void
+RunPool(void)
+{
+	int before = failures;
+	
+	size_t blockSize = sizeof(cpBody);
+	if(sizeof(cpPolyShape) > blockSize) blockSize = sizeof(cpPolyShape);
+	if(sizeof(cpCircleShape) > blockSize) blockSize = sizeof(cpCircleShape);
+	cpAllocator *pool = cpPoolAllocatorNew(blockSize);
+	
+	cpSpace *space = cpSpaceNew();
+	cpSpaceSetGravity(space, cpv(0, -100));
+	cpShape *ground = cpSpaceAddShape(space, cpSegmentShapeNew(cpSpaceGetStaticBody(space), cpv(-500, 0), cpv(500, 0), 0.0f));
+	
+	cpBody *bodies[NUM_BOXES];
+	cpShape *shapes[NUM_BOXES];
+	size_t shapeBytes = 0;
+	
+	for(int i=0; i<NUM_BOXES; i++){
+		bodies[i] = cpSpaceAddBody(space, cpBodyNewWithAllocator(pool, 1.0f, cpMomentForCircle(1.0f, 0.0f, 5.0f, cpvzero)));
+		cpBodySetPos(bodies[i], cpv(-400.0f + (i%40)*20.0f, 5.0f + (i/40)*11.0f));
+		
+		if(i%2){
+			shapes[i] = cpSpaceAddShape(space, cpCircleShapeNewWithAllocator(pool, bodies[i], 5.0f, cpvzero));
+			shapeBytes += sizeof(cpCircleShape);
+		} else {
+			shapes[i] = cpSpaceAddShape(space, cpBoxShapeNewWithAllocator(pool, bodies[i], 10.0f, 10.0f));
+			shapeBytes += sizeof(cpPolyShape);
+		}
+	}
+	
+	Check(cpAllocatorGetBytes(pool, CP_ALLOCATOR_BODIES) == NUM_BOXES*sizeof(cpBody), "pool body bytes", "pool");
+	Check(cpAllocatorGetBytes(pool, CP_ALLOCATOR_SHAPES) == shapeBytes, "pool shape bytes", "pool");
+	
+	for(int i=0; i<30; i++) cpSpaceStep(space, 1.0f/60.0f);
+	
+	// Freeing the boxes and their bodies returns their blocks to the pool.
+	for(int i=0; i<NUM_BOXES; i+=2){
+		cpSpaceRemoveShape(space, shapes[i]);
+		cpShapeFree(shapes[i]);
+		cpSpaceRemoveBody(space, bodies[i]);
+		cpBodyFree(bodies[i]);
+	}
+	
+	Check(cpAllocatorGetBytes(pool, CP_ALLOCATOR_BODIES) == NUM_BOXES/2*sizeof(cpBody), "pool body bytes after free", "pool");
+	Check(cpAllocatorGetBytes(pool, CP_ALLOCATOR_SHAPES) == NUM_BOXES/2*sizeof(cpCircleShape), "pool shape bytes after free", "pool");
+	
+	for(int i=1; i<NUM_BOXES; i+=2){
+		cpSpaceRemoveShape(space, shapes[i]);
+		cpShapeFree(shapes[i]);
+		cpSpaceRemoveBody(space, bodies[i]);
+		cpBodyFree(bodies[i]);
+	}
+	
+	cpSpaceRemoveShape(space, ground);
+	cpShapeFree(ground);
+	cpSpaceFree(space);
+	
+	CheckEmpty(pool, "pool");
+	cpAllocatorFree(pool);
+	
+	// Objects that don't fit in the blocks of a pool fall back to the heap.
+	cpAllocator *small = cpPoolAllocatorNew(sizeof(cpVect));
+	cpBody *body = cpBodyNewWithAllocator(small, 1.0f, 1.0f);
+	cpShape *box = cpBoxShapeNewWithAllocator(small, body, 10.0f, 10.0f);
+	Check(body->CP_PRIVATE(allocator) == NULL && box->CP_PRIVATE(allocator) == NULL, "large objects use the heap", "pool");
+	cpShapeFree(box);
+	cpBodyFree(body);
+	
+	CheckEmpty(small, "small pool");
+	cpAllocatorFree(small);
+	
+	printf("%-24s %s\n", "pool", failures > before ? "FAILED" : "passed");
+}
+
+// Static geometry keeps its children in growing arrays, which count as shape bytes of the allocator it came from.
+static void
+RunStaticGeometry(void)
+{
+	int before = failures;
+	cpAllocator *allocator = cpHeapAllocatorNew();
+	cpAllocator *pool = cpPoolAllocatorNew(4096);
+	
+	cpSpace *space = cpSpaceNew();
+	cpShape *geometry = cpStaticGeometryNewWithAllocator(allocator, cpSpaceGetStaticBody(space));
+	cpShape *pooled = cpStaticGeometryNewWithAllocator(pool, cpSpaceGetStaticBody(space));
+	size_t emptyBytes = cpAllocatorGetBytes(allocator, CP_ALLOCATOR_SHAPES);
+	size_t pooledBytes = cpAllocatorGetBytes(pool, CP_ALLOCATOR_SHAPES);
+	
+	cpVect box[] = {cpv(-5, -5), cpv(-5, 5), cpv(5, 5), cpv(5, -5)};
+	for(int i=0; i<NUM_BOXES; i++){
+		cpVect offset = cpv(-500.0f + i*5.0f, 0.0f);
+		cpStaticGeometryAddSegment(geometry, offset, cpvadd(offset, cpv(5, 0)), 0.0f);
+		cpStaticGeometryAddPoly(geometry, 4, box, offset);
+		cpStaticGeometryAddSegment(pooled, offset, cpvadd(offset, cpv(5, 0)), 0.0f);
+		cpStaticGeometryAddPoly(pooled, 4, box, offset);
+	}
+	
+	size_t childBytes = cpAllocatorGetBytes(allocator, CP_ALLOCATOR_SHAPES);
+	Check(childBytes > emptyBytes, "child bytes", "static geometry");
+	
+	// Caching the shape builds the hierarchy.
+	cpSpaceAddShape(space, geometry);
+	cpSpaceAddShape(space, pooled);
+	Check(cpAllocatorGetBytes(allocator, CP_ALLOCATOR_SHAPES) > childBytes, "hierarchy bytes", "static geometry");
+	Check(cpAllocatorGetBytes(pool, CP_ALLOCATOR_SHAPES) == pooledBytes, "pool only holds the shape", "static geometry");
+	
+	cpSpaceRemoveShape(space, geometry);
+	cpSpaceRemoveShape(space, pooled);
+	cpShapeFree(geometry);
+	cpShapeFree(pooled);
+	cpSpaceFree(space);
+	
+	CheckEmpty(allocator, "static geometry");
+	CheckEmpty(pool, "static geometry pool");
+	cpAllocatorFree(allocator);
+	cpAllocatorFree(pool);
+	
+	printf("%-24s %s\n", "static geometry", failures > before ? "FAILED" : "passed");
+}
+
+//MARK: Main
+
+int
+main(int argc, char **argv)
+{
+	RunHeapAllocator(INDEX_BBTREE, "bbtree");
+	RunHeapAllocator(INDEX_HASH, "spatial hash");
+	RunHeapAllocator(INDEX_SWEEP, "sweep");
+	RunArena();
+	RunPool();
+	RunStaticGeometry();
+	
+	return (failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
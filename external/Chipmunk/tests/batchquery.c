@@ -0,0 +1,291 @@
+/* Copyright (c) 2013 Scott Lembcke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/*
+	Batch query test.
+	
+	Runs each batch query against a space full of static and active shapes, sensors, groups and layers
+	and checks that every entry matches what the single query version returns for it.
+	Each spatial index is tested with both spatially coherent (grid ordered) and scattered batches.
+	
+	Usage: chipmunk_batchquery
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chipmunk.h"
+
+#define GRID 40
+#define COUNT (GRID*GRID)
+#define MAX_HITS 20000
+
+typedef enum SceneIndex {
+	SCENE_BBTREE,
+	SCENE_SPATIAL_HASH,
+	SCENE_SWEEP,
+	NUM_SCENE_INDEXES,
+} SceneIndex;
+
+static const char *indexNames[] = {"bbtree", "hash", "sweep"};
+
+// Small deterministic generator so every run tests the same scenes.
+static unsigned int seed = 1;
+
+static cpFloat
+Random(cpFloat min, cpFloat max)
+{
+	seed = seed*1103515245 + 12345;
+	return min + (max - min)*(cpFloat)((seed >> 8) & 0xFFFF)/(cpFloat)0xFFFF;
+}
+
+static int failures = 0;
+
+static void
+Check(cpBool passed, const char *what, const char *scene, int index)
+{
+	if(!passed){
+		if(failures < 20) printf("FAILED: %s (%s, query %d)\n", what, scene, index);
+		failures++;
+	}
+}
+
+//MARK: Scene
+
+#define MAX_OBJECTS 2048
+
+typedef struct Scene {
+	cpSpace *space;
+	
+	cpBody *bodies[MAX_OBJECTS];
+	int numBodies;
+	cpShape *shapes[MAX_OBJECTS];
+	int numShapes;
+} Scene;
+
+static cpShape *
+AddShape(Scene *scene, cpShape *shape)
+{
+	// Mix in sensors, groups and layers for the filters to deal with.
+	int n = scene->numShapes;
+	cpShapeSetSensor(shape, n%13 == 0);
+	cpShapeSetGroup(shape, (cpGroup)(n%5));
+	cpShapeSetLayers(shape, (n%7 == 0 ? 2 : 1));
+	
+	scene->shapes[scene->numShapes++] = shape;
+	return cpSpaceAddShape(scene->space, shape);
+}
+
+static void
+SceneInit(Scene *scene, SceneIndex index)
+{
+	seed = 1;
+	scene->numBodies = scene->numShapes = 0;
+	
+	cpSpace *space = scene->space = cpSpaceNew();
+	cpBody *staticBody = cpSpaceGetStaticBody(space);
+	
+	// Static boxes and segments.
+	for(int i=0; i<600; i++){
+		cpVect center = cpv(Random(-500.0f, 500.0f), Random(-500.0f, 500.0f));
+		
+		if(i&1){
+			cpVect rot = cpvforangle(Random(0.0f, 6.0f));
+			cpVect corners[] = {cpv(-6, -6), cpv(-6, 6), cpv(6, 6), cpv(6, -6)};
+			
+			cpVect verts[4];
+			for(int j=0; j<4; j++) verts[j] = cpvadd(center, cpvrotate(corners[j], rot));
+			AddShape(scene, cpPolyShapeNew(staticBody, 4, verts, cpvzero));
+		} else {
+			cpVect end = cpvadd(center, cpv(Random(-30.0f, 30.0f), Random(-30.0f, 30.0f)));
+			AddShape(scene, cpSegmentShapeNew(staticBody, center, end, Random(0.0f, 3.0f)));
+		}
+	}
+	
+	// Active circles and boxes.
+	for(int i=0; i<600; i++){
+		cpBody *body = cpSpaceAddBody(space, cpBodyNew(1.0f, 1.0f));
+		cpBodySetPos(body, cpv(Random(-500.0f, 500.0f), Random(-500.0f, 500.0f)));
+		cpBodySetAngle(body, Random(0.0f, 6.0f));
+		scene->bodies[scene->numBodies++] = body;
+		
+		if(i&1){
+			AddShape(scene, cpCircleShapeNew(body, Random(2.0f, 10.0f), cpvzero));
+		} else {
+			AddShape(scene, cpBoxShapeNew(body, Random(4.0f, 20.0f), Random(4.0f, 20.0f)));
+		}
+	}
+	
+	if(index == SCENE_SPATIAL_HASH){
+		cpSpaceUseSpatialHash(space, 10.0f, 2000);
+	} else if(index == SCENE_SWEEP){
+		cpSpaceUseSweep1D(space);
+	}
+	
+	// Step once so the active shapes have their bounding boxes and the indexes are built.
+	cpSpaceStep(space, 1.0f/60.0f);
+}
+
+static void
+SceneDestroy(Scene *scene)
+{
+	cpSpaceFree(scene->space);
+	for(int i=0; i<scene->numShapes; i++) cpShapeFree(scene->shapes[i]);
+	for(int i=0; i<scene->numBodies; i++) cpBodyFree(scene->bodies[i]);
+}
+
+//MARK: Queries
+
+static cpVect points[COUNT], ends[COUNT];
+static cpBB bbs[COUNT];
+
+static cpShape *batchShapes[COUNT];
+static cpNearestPointQueryInfo batchNearest[COUNT];
+static cpSegmentQueryInfo batchSegments[COUNT];
+static cpBBQueryBatchHit batchHits[MAX_HITS];
+
+// Grid ordered queries share traversals, scattered ones make the clusters shrink back down.
+static void
+MakeQueries(cpBool scattered)
+{
+	for(int y=0; y<GRID; y++){
+		for(int x=0; x<GRID; x++){
+			int i = y*GRID + x;
+			cpVect p = cpv(-520.0f + (x + Random(0.0f, 1.0f))*1040.0f/GRID, -520.0f + (y + Random(0.0f, 1.0f))*1040.0f/GRID);
+			if(scattered) p = cpv(Random(-520.0f, 520.0f), Random(-520.0f, 520.0f));
+			
+			points[i] = p;
+			ends[i] = cpvadd(p, cpv(Random(-60.0f, 60.0f), Random(-60.0f, 60.0f)));
+			bbs[i] = cpBBNewForCircle(p, Random(0.0f, 15.0f));
+		}
+	}
+	
+	// A couple of long rays that cross the whole scene.
+	ends[7] = cpvneg(points[7]);
+	ends[COUNT - 3] = cpvmult(points[COUNT - 3], -2.0f);
+}
+
+struct BBQueryHits {
+	cpShape *shapes[256];
+	int count;
+};
+
+static void
+BBQueryHit(cpShape *shape, struct BBQueryHits *hits)
+{
+	if(hits->count < 256) hits->shapes[hits->count] = shape;
+	hits->count++;
+}
+
+static void
+CheckBatches(Scene *scene, const char *name, cpLayers layers, cpGroup group)
+{
+	cpSpace *space = scene->space;
+	cpFloat maxDistance = 12.0f;
+	
+	cpSpacePointQueryFirstBatch(space, COUNT, points, layers, group, batchShapes);
+	cpSpaceNearestPointQueryNearestBatch(space, COUNT, points, maxDistance, layers, group, batchNearest);
+	cpSpaceSegmentQueryFirstBatch(space, COUNT, points, ends, layers, group, batchSegments);
+	int numHits = cpSpaceBBQueryBatch(space, COUNT, bbs, layers, group, batchHits, MAX_HITS);
+	Check(numHits <= MAX_HITS, "hit array is big enough", name, 0);
+	
+	int hit = 0, anyPointHits = 0, anySegmentHits = 0;
+	for(int i=0; i<COUNT; i++){
+		cpShape *shape = cpSpacePointQueryFirst(space, points[i], layers, group);
+		Check(batchShapes[i] == shape, "point query batch matches cpSpacePointQueryFirst()", name, i);
+		if(shape) anyPointHits++;
+		
+		cpNearestPointQueryInfo nearest;
+		cpSpaceNearestPointQueryNearest(space, points[i], maxDistance, layers, group, &nearest);
+		Check(
+			batchNearest[i].shape == nearest.shape && batchNearest[i].d == nearest.d && cpveql(batchNearest[i].p, nearest.p),
+			"nearest point query batch matches cpSpaceNearestPointQueryNearest()", name, i
+		);
+		
+		cpSegmentQueryInfo segment;
+		cpSpaceSegmentQueryFirst(space, points[i], ends[i], layers, group, &segment);
+		Check(
+			batchSegments[i].shape == segment.shape && batchSegments[i].t == segment.t && cpveql(batchSegments[i].n, segment.n),
+			"segment query batch matches cpSpaceSegmentQueryFirst()", name, i
+		);
+		if(segment.shape) anySegmentHits++;
+		
+		// The BB hits are grouped by query index, compare them as sets since the index order can differ.
+		struct BBQueryHits hits = {{}, 0};
+		cpSpaceBBQuery(space, bbs[i], layers, group, (cpSpaceBBQueryFunc)BBQueryHit, &hits);
+		
+		int first = hit;
+		while(hit < numHits && batchHits[hit].index == i) hit++;
+		Check(hit - first == hits.count, "BB query batch finds as many shapes as cpSpaceBBQuery()", name, i);
+		
+		for(int j=first; j<hit; j++){
+			cpBool found = cpFalse;
+			for(int k=0; k<hits.count; k++) found = found || (hits.shapes[k] == batchHits[j].shape);
+			Check(found, "BB query batch finds the same shapes as cpSpaceBBQuery()", name, i);
+		}
+	}
+	
+	Check(hit == numHits, "BB query batch hits are grouped by query index", name, hit);
+	
+	// Make sure the scene actually exercises the queries.
+	Check(anyPointHits > COUNT/20 && anySegmentHits > COUNT/4, "queries hit shapes", name, 0);
+}
+
+// A hit array that is too small is filled up and the full count is still returned.
+static void
+CheckTruncatedHits(Scene *scene, const char *name)
+{
+	int numHits = cpSpaceBBQueryBatch(scene->space, COUNT, bbs, CP_ALL_LAYERS, CP_NO_GROUP, batchHits, MAX_HITS);
+	
+	static cpBBQueryBatchHit truncated[100];
+	int count = cpSpaceBBQueryBatch(scene->space, COUNT, bbs, CP_ALL_LAYERS, CP_NO_GROUP, truncated, 100);
+	Check(count == numHits, "truncated BB query batch returns the full hit count", name, 0);
+	Check(memcmp(truncated, batchHits, sizeof(truncated)) == 0, "truncated BB query batch keeps the first hits", name, 0);
+}
+
+//MARK: Main
+
+int
+main(int argc, char **argv)
+{
+	for(int index=0; index<NUM_SCENE_INDEXES; index++){
+		int before = failures;
+		
+		static Scene scene;
+		SceneInit(&scene, (SceneIndex)index);
+		
+		for(int scattered=0; scattered<2; scattered++){
+			MakeQueries(scattered);
+			CheckBatches(&scene, indexNames[index], CP_ALL_LAYERS, CP_NO_GROUP);
+			CheckBatches(&scene, indexNames[index], 1, 3);
+		}
+		
+		CheckTruncatedHits(&scene, indexNames[index]);
+		SceneDestroy(&scene);
+		
+		printf("%-24s %s\n", indexNames[index], failures > before ? "FAILED" : "passed");
+	}
+	
+	return (failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,252 @@
+/* Copyright (c) 2013 Scott Lembcke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+	Contact churn test.
+	
+	Steps a resting pile of boxes next to a tightly packed cluster of circles that is blown apart,
+	with a contact budget much smaller than the contacts the explosion generates.
+	Checks that the budget is exceeded only by the steps that need it, that old buffers are evicted,
+	that the arbiters that lost their contacts to an eviction get new ones when they are updated,
+	and that the buffers are trimmed back within the budget once the explosion is over.
+	
+	Usage: chipmunk_contactchurn
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "chipmunk.h"
+
+#define NUM_BOXES 40
+#define CLUSTER_SIZE 40
+#define NUM_CIRCLES (CLUSTER_SIZE*CLUSTER_SIZE)
+
+#define BUDGET (8*CP_BUFFER_BYTES)
+
+static int failures = 0;
+
+static void
+Check(cpBool passed, const char *what, int step)
+{
+	if(!passed){
+		printf("FAILED: %s (step %d)\n", what, step);
+		failures++;
+	}
+}
+
+//MARK: Scene
+
+typedef struct Scene {
+	cpSpace *space;
+	cpShape *ground;
+	
+	cpBody *boxes[NUM_BOXES];
+	cpShape *boxShapes[NUM_BOXES];
+	
+	cpBody *circles[NUM_CIRCLES];
+	cpShape *circleShapes[NUM_CIRCLES];
+	int numCircles;
+} Scene;
+
+// Columns of boxes resting on a static segment.
+static void
+SceneInit(Scene *scene)
+{
+	cpSpace *space = scene->space = cpSpaceNew();
+	cpSpaceSetGravity(space, cpv(0, -100));
+	cpSpaceSetIterations(space, 20);
+	cpSpaceSetContactBudget(space, BUDGET);
+	cpSpaceSetEnableContactGraph(space, cpTrue);
+	
+	scene->ground = cpSpaceAddShape(space, cpSegmentShapeNew(cpSpaceGetStaticBody(space), cpv(-500, 0), cpv(500, 0), 0.0f));
+	
+	for(int i=0; i<NUM_BOXES; i++){
+		cpBody *body = scene->boxes[i] = cpSpaceAddBody(space, cpBodyNew(1.0f, cpMomentForBox(1.0f, 10.0f, 10.0f)));
+		cpBodySetPos(body, cpv(-400.0f + (i%10)*20.0f, 5.0f + (i/10)*10.0f));
+		scene->boxShapes[i] = cpSpaceAddShape(space, cpBoxShapeNew(body, 10.0f, 10.0f));
+	}
+	
+	scene->numCircles = 0;
+}
+
+// A cluster of overlapping circles far above the ground, blown outwards from its center.
+static void
+SceneExplode(Scene *scene)
+{
+	cpSpace *space = scene->space;
+	cpVect center = cpv(0.0f, 2000.0f);
+	
+	for(int i=0; i<NUM_CIRCLES; i++){
+		cpVect offset = cpv((i%CLUSTER_SIZE - CLUSTER_SIZE/2)*8.0f + 4.0f, (i/CLUSTER_SIZE - CLUSTER_SIZE/2)*8.0f + 4.0f);
+		
+		cpBody *body = scene->circles[i] = cpSpaceAddBody(space, cpBodyNew(1.0f, cpMomentForCircle(1.0f, 0.0f, 5.0f, cpvzero)));
+		cpBodySetPos(body, cpvadd(center, offset));
+		cpBodySetVel(body, cpvmult(offset, 4.0f));
+		scene->circleShapes[i] = cpSpaceAddShape(space, cpCircleShapeNew(body, 5.0f, cpvzero));
+	}
+	
+	scene->numCircles = NUM_CIRCLES;
+}
+
+static void
+SceneRemoveCircles(Scene *scene)
+{
+	cpSpace *space = scene->space;
+	
+	for(int i=0; i<scene->numCircles; i++){
+		cpSpaceRemoveShape(space, scene->circleShapes[i]);
+		cpShapeFree(scene->circleShapes[i]);
+		cpSpaceRemoveBody(space, scene->circles[i]);
+		cpBodyFree(scene->circles[i]);
+	}
+	
+	scene->numCircles = 0;
+}
+
+static void
+SceneFree(Scene *scene)
+{
+	cpSpace *space = scene->space;
+	SceneRemoveCircles(scene);
+	
+	for(int i=0; i<NUM_BOXES; i++){
+		cpSpaceRemoveShape(space, scene->boxShapes[i]);
+		cpShapeFree(scene->boxShapes[i]);
+		cpSpaceRemoveBody(space, scene->boxes[i]);
+		cpBodyFree(scene->boxes[i]);
+	}
+	
+	cpSpaceRemoveShape(space, scene->ground);
+	cpShapeFree(scene->ground);
+	cpSpaceFree(space);
+}
+
+//MARK: Checks
+
+typedef struct ArbiterCheck {
+	int arbiters;
+	int missingContacts;
+} ArbiterCheck;
+
+static void
+CheckArbiter(cpBody *body, cpArbiter *arb, ArbiterCheck *check)
+{
+	check->arbiters++;
+	
+	int count = cpArbiterGetCount(arb);
+	if(count == 0) check->missingContacts++;
+	
+	for(int i=0; i<count; i++){
+		cpFloat depth = cpArbiterGetDepth(arb, i);
+		if(!(depth <= 0.0f && depth > -10.0f)) check->missingContacts++;
+	}
+}
+
+// Every arbiter in the contact graph was updated during the last step, so it has to have valid contacts.
+static ArbiterCheck
+CheckArbiters(Scene *scene)
+{
+	ArbiterCheck check = {};
+	for(int i=0; i<NUM_BOXES; i++) cpBodyEachArbiter(scene->boxes[i], (cpBodyArbiterIteratorFunc)CheckArbiter, &check);
+	for(int i=0; i<scene->numCircles; i++) cpBodyEachArbiter(scene->circles[i], (cpBodyArbiterIteratorFunc)CheckArbiter, &check);
+	
+	return check;
+}
+
+static cpFloat
+PileHeight(Scene *scene)
+{
+	cpFloat height = 0.0f;
+	for(int i=0; i<NUM_BOXES; i++) height += cpBodyGetPos(scene->boxes[i]).y;
+	
+	return height/NUM_BOXES;
+}
+
+//MARK: Main
+
+int
+main(int argc, char **argv)
+{
+	Scene scene;
+	SceneInit(&scene);
+	
+	int step = 0;
+	cpFloat dt = 1.0f/60.0f;
+	
+	// The resting pile fits within the budget on its own.
+	int before = failures;
+	for(; step<60; step++) cpSpaceStep(scene.space, dt);
+	
+	cpContactBufferStats stats = cpSpaceGetContactBufferStats(scene.space);
+	Check(stats.bytes <= BUDGET, "resting pile within the budget", step);
+	Check(stats.evictions == 0 && stats.overBudget == 0, "resting pile doesn't evict", step);
+	
+	cpFloat restingHeight = PileHeight(&scene);
+	printf("%-24s %s\n", "resting", failures > before ? "FAILED" : "passed");
+	
+	// The explosion needs more contacts in a single step than the budget allows.
+	before = failures;
+	SceneExplode(&scene);
+	
+	int evictionSteps = 0, rebuiltArbiters = 0;
+	for(int i=0; i<30; i++, step++){
+		unsigned long evictions = cpSpaceGetContactBufferStats(scene.space).evictions;
+		cpSpaceStep(scene.space, dt);
+		
+		ArbiterCheck check = CheckArbiters(&scene);
+		Check(check.missingContacts == 0, "updated arbiters have contacts", step);
+		
+		if(cpSpaceGetContactBufferStats(scene.space).evictions > evictions){
+			// Every arbiter from the previous steps was invalidated, so these all rebuilt their contacts.
+			evictionSteps++;
+			rebuiltArbiters += check.arbiters;
+		}
+	}
+	
+	stats = cpSpaceGetContactBufferStats(scene.space);
+	Check(stats.overBudget > 0, "explosion exceeds the budget", step);
+	Check(stats.peakBytes > BUDGET, "peak bytes over the budget", step);
+	Check(stats.evictions > 0 && evictionSteps > 0, "explosion evicts buffers", step);
+	Check(rebuiltArbiters > NUM_CIRCLES, "evicted arbiters rebuilt their contacts", step);
+	Check(cpfabs(PileHeight(&scene) - restingHeight) < 1.0f, "resting pile undisturbed", step);
+	printf("%-24s %s\n", "explosion", failures > before ? "FAILED" : "passed");
+	
+	// Once the debris is gone the memory goes back within the budget.
+	before = failures;
+	SceneRemoveCircles(&scene);
+	for(int i=0; i<30; i++, step++) cpSpaceStep(scene.space, dt);
+	
+	stats = cpSpaceGetContactBufferStats(scene.space);
+	Check(stats.bytes <= BUDGET, "memory returns within the budget", step);
+	Check(stats.trimmedBuffers > 0, "expired buffers trimmed", step);
+	Check(stats.pooledBuffers <= stats.activeBuffers, "pool no larger than the ring", step);
+	Check(CheckArbiters(&scene).missingContacts == 0, "resting arbiters have contacts", step);
+	Check(cpfabs(PileHeight(&scene) - restingHeight) < 1.0f, "resting pile still resting", step);
+	printf("%-24s %s\n", "recovery", failures > before ? "FAILED" : "passed");
+	
+	SceneFree(&scene);
+	
+	return (failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,529 @@
+/* Copyright (c) 2012 Scott Lembcke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+	Determinism test.
+
+	Runs a scene with stacked boxes, rolling circles, joints and springs in a deterministic space and
+	records a trail of cpSpaceGetChecksum() values along with a hash of the order separate callbacks were called in.
+
+	Within one run the scene is simulated with each spatial index and with the shapes spread out in memory,
+	all of which must produce the same trail. Each spatial index is also rolled back with a snapshot
+	partway through the scene and replayed after changing the properties and geometry of some shapes,
+	which must reproduce the rest of the trail exactly. A snapshot of a body that was freed must be rejected.
+	The trail can also be written to a file and compared against the
+	trail of another build (different compiler, optimization level or platform) of the same cpFloat type.
+
+	Usage: chipmunk_determinism [--write trail.txt | --compare trail.txt]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "chipmunk.h"
+#include "chipmunk_unsafe.h"
+
+#define STEPS 900
+#define CHECKPOINT_INTERVAL 30
+#define NUM_CHECKPOINTS (STEPS/CHECKPOINT_INTERVAL)
+
+#define MAX_OBJECTS 512
+
+typedef struct Trail {
+	uint64_t checksums[NUM_CHECKPOINTS];
+	uint64_t callbackOrder[NUM_CHECKPOINTS];
+} Trail;
+
+typedef enum SceneIndex {
+	SCENE_BBTREE,
+	SCENE_SPATIAL_HASH,
+	SCENE_SWEEP,
+} SceneIndex;
+
+typedef struct Scene {
+	cpSpace *space;
+	
+	cpBody *bodies[MAX_OBJECTS];
+	int numBodies;
+	cpShape *shapes[MAX_OBJECTS];
+	int numShapes;
+	cpConstraint *constraints[MAX_OBJECTS];
+	int numConstraints;
+	
+	// Allocations made between shapes to move them around in memory.
+	void *padding[MAX_OBJECTS];
+	int numPadding;
+	int padMemory;
+	
+	uint64_t callbackOrder;
+} Scene;
+
+//MARK: Scene Setup
+
+static void *
+Pad(Scene *scene)
+{
+	if(scene->padMemory && scene->numPadding < MAX_OBJECTS){
+		void *ptr = malloc(16 + 48*(scene->numPadding%7));
+		scene->padding[scene->numPadding++] = ptr;
+		return ptr;
+	}
+	
+	return NULL;
+}
+
+static cpBody *
+AddBody(Scene *scene, cpFloat mass, cpFloat moment, cpVect pos, cpFloat angle)
+{
+	Pad(scene);
+	cpBody *body = cpSpaceAddBody(scene->space, cpBodyNew(mass, moment));
+	cpBodySetPos(body, pos);
+	cpBodySetAngle(body, angle);
+	
+	scene->bodies[scene->numBodies++] = body;
+	return body;
+}
+
+static cpShape *
+AddShape(Scene *scene, cpShape *shape, cpFloat friction, cpCollisionType type)
+{
+	Pad(scene);
+	cpSpaceAddShape(scene->space, shape);
+	cpShapeSetFriction(shape, friction);
+	cpShapeSetCollisionType(shape, type);
+	
+	scene->shapes[scene->numShapes++] = shape;
+	return shape;
+}
+
+static cpConstraint *
+AddConstraint(Scene *scene, cpConstraint *constraint)
+{
+	cpSpaceAddConstraint(scene->space, constraint);
+	
+	scene->constraints[scene->numConstraints++] = constraint;
+	return constraint;
+}
+
+// Mix the shape ids of separating pairs into a hash that depends on the order the callbacks were called in.
+static void
+Separate(cpArbiter *arb, cpSpace *space, void *data)
+{
+	Scene *scene = (Scene *)data;
+	CP_ARBITER_GET_SHAPES(arb, a, b);
+	
+	uint64_t ids[] = {a->CP_PRIVATE(hashid), b->CP_PRIVATE(hashid)};
+	for(int i=0; i<2; i++){
+		scene->callbackOrder ^= ids[i];
+		scene->callbackOrder *= 0x100000001b3ULL;
+	}
+}
+
+static void
+SceneInit(Scene *scene, SceneIndex index, int padMemory)
+{
+	memset(scene, 0, sizeof(Scene));
+	scene->padMemory = padMemory;
+	scene->callbackOrder = 0xcbf29ce484222325ULL;
+	
+	cpResetShapeIdCounter();
+	cpResetConstraintIdCounter();
+	
+	cpSpace *space = scene->space = cpSpaceNew();
+	cpSpaceSetDeterministic(space, cpTrue);
+	cpSpaceSetIterations(space, 10);
+	cpSpaceSetGravity(space, cpv(0, -100));
+	cpSpaceSetSleepTimeThreshold(space, 0.5f);
+	cpSpaceSetDamping(space, 0.95f);
+	cpSpaceSetDefaultCollisionHandler(space, NULL, NULL, NULL, Separate, scene);
+	
+	if(index == SCENE_SPATIAL_HASH) cpSpaceUseSpatialHash(space, 20.0f, 1000);
+	if(index == SCENE_SWEEP) cpSpaceUseSweep1D(space);
+	
+	cpBody *staticBody = cpSpaceGetStaticBody(space);
+	AddShape(scene, cpSegmentShapeNew(staticBody, cpv(-320, 0), cpv(320, 0), 0.0f), 1.0f, 0);
+	AddShape(scene, cpSegmentShapeNew(staticBody, cpv(-320, 0), cpv(-320, 480), 0.0f), 1.0f, 0);
+	AddShape(scene, cpSegmentShapeNew(staticBody, cpv(320, 0), cpv(320, 480), 0.0f), 1.0f, 0);
+	AddShape(scene, cpSegmentShapeNew(staticBody, cpv(-320, 120), cpv(-100, 60), 2.0f), 0.8f, 0);
+	
+	// Pyramid of boxes.
+	for(int row=0; row<10; row++){
+		for(int i=0; i<=row; i++){
+			cpVect pos = cpv(100 + (i - row*0.5f)*21.0f, 300 - row*20.0f);
+			cpBody *body = AddBody(scene, 1.0f, cpMomentForBox(1.0f, 20.0f, 20.0f), pos, 0.0f);
+			AddShape(scene, cpBoxShapeNew(body, 20.0f, 20.0f), 0.7f, 1);
+		}
+	}
+	
+	// Circles rolling down the ramp into the pyramid.
+	for(int i=0; i<20; i++){
+		cpVect pos = cpv(-300 + (i%5)*22.0f, 160 + (i/5)*22.0f);
+		cpBody *body = AddBody(scene, 1.0f, cpMomentForCircle(1.0f, 0.0f, 10.0f, cpvzero), pos, i*0.37f);
+		cpBodySetAngVel(body, (i%3 - 1)*4.0f);
+		AddShape(scene, cpCircleShapeNew(body, 10.0f, cpvzero), 0.9f, 2);
+	}
+	
+	// A chain of bars hanging from the ceiling with springs pulling it sideways.
+	cpBody *prev = staticBody;
+	cpVect anchor = cpv(-100, 460);
+	for(int i=0; i<8; i++){
+		cpVect pos = cpv(-100 + i*24.0f + 12.0f, 460);
+		cpBody *body = AddBody(scene, 1.0f, cpMomentForSegment(1.0f, cpv(-12, 0), cpv(12, 0)), pos, 0.0f);
+		cpShape *shape = AddShape(scene, cpSegmentShapeNew(body, cpv(-12, 0), cpv(12, 0), 3.0f), 0.5f, 3);
+		cpShapeSetGroup(shape, 1);
+	
+		AddConstraint(scene, cpPivotJointNew(prev, body, anchor));
+		AddConstraint(scene, cpDampedRotarySpringNew(prev, body, 0.0f, 3000.0f, 60.0f));
+	
+		prev = body;
+		anchor = cpvadd(pos, cpv(12, 0));
+	}
+	
+	AddConstraint(scene, cpDampedSpringNew(staticBody, prev, cpv(300, 300), cpvzero, 100.0f, 40.0f, 1.5f));
+	AddConstraint(scene, cpSlideJointNew(staticBody, scene->bodies[0], cpv(200, 400), cpvzero, 0.0f, 250.0f));
+}
+
+static void
+SceneDestroy(Scene *scene)
+{
+	cpSpace *space = scene->space;
+	
+	for(int i=0; i<scene->numConstraints; i++){
+		cpSpaceRemoveConstraint(space, scene->constraints[i]);
+		cpConstraintFree(scene->constraints[i]);
+	}
+	
+	for(int i=0; i<scene->numShapes; i++){
+		cpShape *shape = scene->shapes[i];
+		if(cpBodyIsStatic(cpShapeGetBody(shape))){
+			cpSpaceRemoveStaticShape(space, shape);
+		} else {
+			cpSpaceRemoveShape(space, shape);
+		}
+	
+		cpShapeFree(shape);
+	}
+	
+	for(int i=0; i<scene->numBodies; i++){
+		cpSpaceRemoveBody(space, scene->bodies[i]);
+		cpBodyFree(scene->bodies[i]);
+	}
+	
+	for(int i=0; i<scene->numPadding; i++) free(scene->padding[i]);
+	
+	cpSpaceFree(space);
+}
+
+static void
+RunScene(SceneIndex index, int padMemory, Trail *trail)
+{
+	static Scene scene;
+	SceneInit(&scene, index, padMemory);
+	
+	for(int i=0; i<STEPS; i++){
+		cpSpaceStep(scene.space, 1.0f/60.0f);
+	
+		if((i + 1)%CHECKPOINT_INTERVAL == 0){
+			int checkpoint = i/CHECKPOINT_INTERVAL;
+			trail->checksums[checkpoint] = cpSpaceGetChecksum(scene.space);
+			trail->callbackOrder[checkpoint] = scene.callbackOrder;
+		}
+	}
+	
+	SceneDestroy(&scene);
+}
+
+// Save a snapshot partway through the scene, run to the end, then restore the snapshot and replay the rest of the scene.
+// The trail of the replay is returned, which should match the trail of an uninterrupted run.
+#define ROLLBACK_STEP 420
+
+static void
+RunRollback(SceneIndex index, Trail *trail)
+{
+	static Scene scene;
+	SceneInit(&scene, index, cpFalse);
+	
+	void *snapshot = NULL;
+	size_t snapshotSize = 0;
+	uint64_t callbackOrder = 0;
+	
+	for(int i=0; i<STEPS; i++){
+		if(i == ROLLBACK_STEP){
+			snapshotSize = cpSpaceSaveSnapshot(scene.space, NULL, 0);
+			snapshot = malloc(snapshotSize);
+			cpSpaceSaveSnapshot(scene.space, snapshot, snapshotSize);
+			callbackOrder = scene.callbackOrder;
+		}
+		
+		cpSpaceStep(scene.space, 1.0f/60.0f);
+	}
+	
+	// The snapshot has to roll back changes to the shapes too.
+	for(int i=0; i<scene.numShapes; i++){
+		cpShape *shape = scene.shapes[i];
+		cpShapeSetFriction(shape, 0.1f);
+		cpShapeSetElasticity(shape, 0.5f);
+		cpShapeSetSurfaceVelocity(shape, cpv(3.0f, 0.0f));
+		cpShapeSetLayers(shape, 1);
+	}
+	
+	cpShapeSetSensor(scene.shapes[0], cpTrue);
+	cpSegmentShapeSetEndpoints(scene.shapes[3], cpv(-320, 100), cpv(-100, 80));
+	cpSegmentShapeSetRadius(scene.shapes[3], 6.0f);
+	cpSpaceReindexShape(scene.space, scene.shapes[3]);
+	cpCircleShapeSetRadius(scene.shapes[scene.numShapes - 9], 4.0f);
+	
+	cpVect triangle[] = {cpv(-10, -10), cpv(0, 10), cpv(10, -10)};
+	cpPolyShapeSetVerts(scene.shapes[4], 3, triangle, cpvzero);
+	
+	if(!cpSpaceRestoreSnapshot(scene.space, snapshot, snapshotSize)) printf("Could not restore the snapshot.\n");
+	scene.callbackOrder = callbackOrder;
+	
+	for(int i=ROLLBACK_STEP; i<STEPS; i++){
+		cpSpaceStep(scene.space, 1.0f/60.0f);
+		
+		if((i + 1)%CHECKPOINT_INTERVAL == 0){
+			int checkpoint = i/CHECKPOINT_INTERVAL;
+			trail->checksums[checkpoint] = cpSpaceGetChecksum(scene.space);
+			trail->callbackOrder[checkpoint] = scene.callbackOrder;
+		}
+	}
+	
+	free(snapshot);
+	SceneDestroy(&scene);
+}
+
+// Replaces a body with a new one after saving a snapshot. The counts still match, so the snapshot can only be rejected
+// by looking up its pointers in the space instead of following them to the freed body.
+static int
+RunFreedBody(void)
+{
+	cpSpace *space = cpSpaceNew();
+	cpSpaceSetDeterministic(space, cpTrue);
+	
+	cpBody *body = cpSpaceAddBody(space, cpBodyNew(1.0f, 1.0f));
+	cpShape *shape = cpSpaceAddShape(space, cpCircleShapeNew(body, 10.0f, cpvzero));
+	
+	size_t size = cpSpaceSaveSnapshot(space, NULL, 0);
+	void *snapshot = malloc(size);
+	cpSpaceSaveSnapshot(space, snapshot, size);
+	
+	cpBody *replacement = cpBodyNew(1.0f, 1.0f);
+	cpSpaceRemoveShape(space, shape);
+	cpSpaceRemoveBody(space, body);
+	cpBodyFree(body);
+	cpSpaceAddBody(space, replacement);
+	cpShapeSetBody(shape, replacement);
+	cpSpaceAddShape(space, shape);
+	
+	cpBool restored = cpSpaceRestoreSnapshot(space, snapshot, size);
+	printf("%-24s %s\n", "freed body", restored ? "FAILED, snapshot was restored" : "ok");
+	
+	free(snapshot);
+	cpSpaceRemoveShape(space, shape);
+	cpShapeFree(shape);
+	cpSpaceRemoveBody(space, replacement);
+	cpBodyFree(replacement);
+	cpSpaceFree(space);
+	
+	return (restored ? 1 : 0);
+}
+
+static void
+PushConstraint(cpConstraint *constraint, void *data)
+{
+	cpConstraint ***cursor = (cpConstraint ***)data;
+	*(*cursor)++ = constraint;
+}
+
+// Adds constraints out of hash value order. Stepping solves them sorted, but must leave the order the space returns alone.
+static int
+RunConstraintOrder(void)
+{
+	cpSpace *space = cpSpaceNew();
+	cpSpaceSetDeterministic(space, cpTrue);
+	cpSpaceSetGravity(space, cpv(0.0f, -100.0f));
+	
+	cpBody *a = cpSpaceAddBody(space, cpBodyNew(1.0f, 1.0f));
+	cpBody *b = cpSpaceAddBody(space, cpBodyNew(1.0f, 1.0f));
+	cpBodySetPos(b, cpv(10.0f, 0.0f));
+	
+	cpConstraint *first = cpPinJointNew(space->staticBody, a, cpvzero, cpvzero);
+	cpConstraint *second = cpPinJointNew(a, b, cpvzero, cpvzero);
+	cpSpaceAddConstraint(space, second);
+	cpSpaceAddConstraint(space, first);
+	
+	for(int i=0; i<10; i++) cpSpaceStep(space, 1.0f/60.0f);
+	
+	cpConstraint *order[2], **cursor = order;
+	cpSpaceEachConstraint(space, PushConstraint, &cursor);
+	
+	cpBool ok = (order[0] == second && order[1] == first);
+	printf("%-24s %s\n", "constraint order", ok ? "ok" : "FAILED, stepping reordered the constraints");
+	
+	cpSpaceRemoveConstraint(space, first);
+	cpSpaceRemoveConstraint(space, second);
+	cpConstraintFree(first);
+	cpConstraintFree(second);
+	cpSpaceRemoveBody(space, a);
+	cpSpaceRemoveBody(space, b);
+	cpBodyFree(a);
+	cpBodyFree(b);
+	cpSpaceFree(space);
+	
+	return (ok ? 0 : 1);
+}
+
+//MARK: Trail Comparison
+
+// Returns the index of the first checkpoint where the trails differ or -1 if they match.
+static int
+CompareTrails(const Trail *a, const Trail *b)
+{
+	for(int i=0; i<NUM_CHECKPOINTS; i++){
+		if(a->checksums[i] != b->checksums[i] || a->callbackOrder[i] != b->callbackOrder[i]) return i;
+	}
+	
+	return -1;
+}
+
+static void
+WriteTrail(FILE *file, const Trail *trail)
+{
+	fprintf(file, "%s %d\n", sizeof(cpFloat) == sizeof(float) ? "float" : "double", NUM_CHECKPOINTS);
+	for(int i=0; i<NUM_CHECKPOINTS; i++){
+		fprintf(file, "%d %016" PRIx64 " %016" PRIx64 "\n", (i + 1)*CHECKPOINT_INTERVAL, trail->checksums[i], trail->callbackOrder[i]);
+	}
+}
+
+static int
+ReadTrail(FILE *file, Trail *trail)
+{
+	char type[16];
+	int count;
+	if(fscanf(file, "%15s %d", type, &count) != 2 || count != NUM_CHECKPOINTS) return 0;
+	
+	// Trails are only comparable between builds using the same cpFloat type.
+	if(strcmp(type, sizeof(cpFloat) == sizeof(float) ? "float" : "double") != 0) return 0;
+	
+	for(int i=0; i<NUM_CHECKPOINTS; i++){
+		int step;
+		if(fscanf(file, "%d %" SCNx64 " %" SCNx64, &step, &trail->checksums[i], &trail->callbackOrder[i]) != 3) return 0;
+	}
+	
+	return 1;
+}
+
+static int
+Check(const char *name, const Trail *trail, const Trail *reference)
+{
+	int diverged = CompareTrails(trail, reference);
+	if(diverged < 0){
+		printf("%-24s ok\n", name);
+		return 0;
+	} else {
+		printf("%-24s FAILED, diverged before step %d\n", name, (diverged + 1)*CHECKPOINT_INTERVAL);
+		return 1;
+	}
+}
+
+//MARK: Main
+
+int
+main(int argc, char **argv)
+{
+	const char *writePath = NULL, *comparePath = NULL;
+	
+	for(int i=1; i<argc; i++){
+		if(strcmp(argv[i], "--write") == 0 && i + 1 < argc){
+			writePath = argv[++i];
+		} else if(strcmp(argv[i], "--compare") == 0 && i + 1 < argc){
+			comparePath = argv[++i];
+		} else {
+			fprintf(stderr, "Usage: %s [--write trail.txt | --compare trail.txt]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	
+	static Trail trail, other, reference;
+	int failures = 0;
+	
+	printf("Chipmunk determinism test, cpFloat is %s, %s math.\n",
+		sizeof(cpFloat) == sizeof(float) ? "float" : "double",
+		CP_DETERMINISTIC_MATH ? "portable" : "system"
+	);
+	
+	RunScene(SCENE_BBTREE, cpFalse, &trail);
+	printf("final checksum %016" PRIx64 "\n", trail.checksums[NUM_CHECKPOINTS - 1]);
+	
+	RunScene(SCENE_BBTREE, cpFalse, &other);
+	failures += Check("repeat", &other, &trail);
+	
+	RunScene(SCENE_BBTREE, cpTrue, &other);
+	failures += Check("memory layout", &other, &trail);
+	
+	RunScene(SCENE_SPATIAL_HASH, cpTrue, &other);
+	failures += Check("spatial hash", &other, &trail);
+	
+	RunScene(SCENE_SWEEP, cpFalse, &other);
+	failures += Check("sweep", &other, &trail);
+	
+	// The replays only fill in the checkpoints after the rollback.
+	const char *rollbackNames[] = {"bbtree rollback", "spatial hash rollback", "sweep rollback"};
+	for(int index=SCENE_BBTREE; index<=SCENE_SWEEP; index++){
+		other = trail;
+		for(int i=ROLLBACK_STEP/CHECKPOINT_INTERVAL; i<NUM_CHECKPOINTS; i++) other.checksums[i] = other.callbackOrder[i] = 0;
+		
+		RunRollback((SceneIndex)index, &other);
+		failures += Check(rollbackNames[index], &other, &trail);
+	}
+	
+	failures += RunFreedBody();
+	failures += RunConstraintOrder();
+	
+	if(writePath){
+		FILE *file = fopen(writePath, "w");
+		if(!file){
+			fprintf(stderr, "Could not open trail file.\n");
+			return EXIT_FAILURE;
+		}
+	
+		WriteTrail(file, &trail);
+		fclose(file);
+	}
+	
+	if(comparePath){
+		FILE *file = fopen(comparePath, "r");
+		if(file && ReadTrail(file, &reference)){
+			failures += Check("reference build", &trail, &reference);
+		} else {
+			fprintf(stderr, "Could not read a matching trail from '%s'.\n", comparePath);
+			failures++;
+		}
+	
+		if(file) fclose(file);
+	}
+	
+	return (failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
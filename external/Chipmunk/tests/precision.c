@@ -0,0 +1,415 @@
+/* Copyright (c) 2012 Scott Lembcke
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+	Precision regression suite.
+	
+	Runs a set of scenes and checks that they stay stable. When built with CP_USE_DOUBLES=0 it can
+	compare the results against a reference file written by the double precision build and
+	reports the drift between the two profiles along with the step times.
+	
+	Usage: chipmunk_precision [--write reference.txt | --compare reference.txt]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "chipmunk.h"
+
+#define MAX_SAMPLES 65536
+#define CHECKPOINT_INTERVAL 60
+
+typedef struct Scene Scene;
+
+typedef struct SceneResult {
+	// Flattened samples (usually x, y, angle of every body at every checkpoint).
+	double samples[MAX_SAMPLES];
+	int numSamples;
+	
+	double msPerStep;
+	
+	// Scene specific stability error, must be less than the scene's tolerance.
+	double error;
+} SceneResult;
+
+struct Scene {
+	const char *name;
+	void (*run)(const Scene *scene, SceneResult *result);
+	
+	// Maximum allowed stability error for the scene.
+	double tolerance;
+	// Maximum allowed drift from the double precision reference, or 0 to only report it.
+	double maxDrift;
+	
+	cpVect offset;
+	int steps;
+};
+
+static void
+PushSample(SceneResult *result, double value)
+{
+	if(result->numSamples < MAX_SAMPLES) result->samples[result->numSamples++] = value;
+}
+
+static void
+PushBodySamples(SceneResult *result, cpBody **bodies, int count, cpVect offset)
+{
+	for(int i=0; i<count; i++){
+		cpVect p = cpvsub(cpBodyGetPos(bodies[i]), offset);
+		PushSample(result, p.x);
+		PushSample(result, p.y);
+		PushSample(result, cpBodyGetAngle(bodies[i]));
+	}
+}
+
+static cpSpace *
+NewGroundedSpace(cpVect offset)
+{
+	cpSpace *space = cpSpaceNew();
+	cpSpaceSetIterations(space, 20);
+	cpSpaceSetGravity(space, cpv(0, -100));
+	
+	cpShape *ground = cpSpaceAddShape(space, cpSegmentShapeNew(cpSpaceGetStaticBody(space), cpvadd(offset, cpv(-1000, 0)), cpvadd(offset, cpv(1000, 0)), 0.0f));
+	cpShapeSetFriction(ground, 1.0f);
+	
+	return space;
+}
+
+static cpBody *
+AddBox(cpSpace *space, cpVect pos, cpFloat size)
+{
+	cpBody *body = cpSpaceAddBody(space, cpBodyNew(1.0f, cpMomentForBox(1.0f, size, size)));
+	cpBodySetPos(body, pos);
+	
+	cpShape *shape = cpSpaceAddShape(space, cpBoxShapeNew(body, size, size));
+	cpShapeSetFriction(shape, 0.6f);
+	
+	return body;
+}
+
+static void
+FreeSpace(cpSpace *space, cpBody **bodies, int count)
+{
+	cpShape *ground = NULL;
+	
+	for(int i=0; i<count; i++){
+		cpBody *body = bodies[i];
+		cpShape *shape = body->CP_PRIVATE(shapeList);
+		
+		cpSpaceRemoveShape(space, shape);
+		cpSpaceRemoveBody(space, body);
+		cpShapeFree(shape);
+		cpBodyFree(body);
+	}
+	
+	ground = cpSpaceGetStaticBody(space)->CP_PRIVATE(shapeList);
+	if(ground){
+		cpSpaceRemoveStaticShape(space, ground);
+		cpShapeFree(ground);
+	}
+	
+	cpSpaceFree(space);
+}
+
+// Step the space, recording body samples at each checkpoint and the average step time.
+static void
+StepScene(const Scene *scene, cpSpace *space, cpBody **bodies, int count, SceneResult *result)
+{
+	clock_t elapsed = 0;
+	
+	for(int i=1; i<=scene->steps; i++){
+		clock_t start = clock();
+		cpSpaceStep(space, 1.0f/60.0f);
+		elapsed += clock() - start;
+		
+		if(i%CHECKPOINT_INTERVAL == 0) PushBodySamples(result, bodies, count, scene->offset);
+	}
+	
+	result->msPerStep = 1e3*(double)elapsed/(double)CLOCKS_PER_SEC/(double)scene->steps;
+}
+
+//MARK: Scenes
+
+#define PYRAMID_ROWS 14
+#define PYRAMID_COUNT (PYRAMID_ROWS*(PYRAMID_ROWS + 1)/2)
+#define BOX_SIZE 30.0f
+
+// A pyramid of boxes that must stay standing. Error is the relative height lost by the top box.
+static void
+RunPyramid(const Scene *scene, SceneResult *result)
+{
+	cpVect offset = scene->offset;
+	cpSpace *space = NewGroundedSpace(offset);
+	
+	cpBody *bodies[PYRAMID_COUNT];
+	int count = 0;
+	
+	for(int row=0; row<PYRAMID_ROWS; row++){
+		for(int i=0; i<PYRAMID_ROWS - row; i++){
+			cpVect pos = cpv((i - (PYRAMID_ROWS - row)*0.5f)*BOX_SIZE, (row + 0.5f)*BOX_SIZE);
+			bodies[count++] = AddBox(space, cpvadd(offset, pos), BOX_SIZE);
+		}
+	}
+	
+	cpBody *top = bodies[count - 1];
+	cpFloat startHeight = cpBodyGetPos(top).y - offset.y;
+	
+	StepScene(scene, space, bodies, count, result);
+	
+	cpFloat height = cpBodyGetPos(top).y - offset.y;
+	result->error = cpfabs(height - startHeight)/startHeight;
+	
+	FreeSpace(space, bodies, count);
+}
+
+#define PILE_COLUMNS 10
+#define PILE_COUNT (PILE_COLUMNS*PILE_COLUMNS)
+
+// A grid of boxes dropped onto the ground that must fall asleep. Error is the fraction of bodies left awake.
+static void
+RunSleep(const Scene *scene, SceneResult *result)
+{
+	cpVect offset = scene->offset;
+	cpSpace *space = NewGroundedSpace(offset);
+	cpSpaceSetSleepTimeThreshold(space, 0.5f);
+	
+	cpBody *bodies[PILE_COUNT];
+	int count = 0;
+	
+	for(int i=0; i<PILE_COUNT; i++){
+		cpVect pos = cpv((i%PILE_COLUMNS - PILE_COLUMNS*0.5f)*(BOX_SIZE + 2.0f), 20.0f + (i/PILE_COLUMNS)*(BOX_SIZE + 5.0f));
+		bodies[count++] = AddBox(space, cpvadd(offset, pos), BOX_SIZE);
+	}
+	
+	StepScene(scene, space, bodies, count, result);
+	
+	int awake = 0;
+	for(int i=0; i<count; i++) if(!cpBodyIsSleeping(bodies[i])) awake++;
+	result->error = (double)awake/(double)count;
+	
+	FreeSpace(space, bodies, count);
+}
+
+#define QUERY_BOXES 64
+#define QUERY_HALF_SIZE 10.0f
+
+// Segment and nearest point queries against rotated boxes with known answers.
+// Includes segments passing right next to the corners. Error is the largest absolute error, or 1 for a miss.
+static void
+RunQueries(const Scene *scene, SceneResult *result)
+{
+	cpSpace *space = cpSpaceNew();
+	cpBody *staticBody = cpSpaceGetStaticBody(space);
+	
+	cpShape *shapes[QUERY_BOXES];
+	cpVect centers[QUERY_BOXES];
+	cpVect rots[QUERY_BOXES];
+	
+	for(int i=0; i<QUERY_BOXES; i++){
+		cpVect center = cpvadd(scene->offset, cpv((i%8)*100.0f, (i/8)*100.0f));
+		cpVect rot = cpvforangle(i*0.3f);
+		
+		cpVect verts[4];
+		cpVect corners[] = {cpv(-1, -1), cpv(-1, 1), cpv(1, 1), cpv(1, -1)};
+		for(int j=0; j<4; j++) verts[j] = cpvadd(center, cpvrotate(cpvmult(corners[j], QUERY_HALF_SIZE), rot));
+		
+		shapes[i] = cpSpaceAddShape(space, cpPolyShapeNew(staticBody, 4, verts, cpvzero));
+		centers[i] = center;
+		rots[i] = rot;
+	}
+	
+	clock_t start = clock();
+	double error = 0.0;
+	int queries = 0;
+	
+	for(int i=0; i<QUERY_BOXES; i++){
+		cpShape *shape = shapes[i];
+		cpVect c = centers[i], rot = rots[i];
+		
+		// Segments along the local x axis at several heights, the last ones just inside the corners.
+		cpFloat graze = QUERY_HALF_SIZE - 0.01f;
+		cpFloat heights[] = {0.0f, 3.5f, -7.25f, graze, -graze};
+		for(int j=0; j<5; j++){
+			cpVect a = cpvadd(c, cpvrotate(cpv(-100.0f, heights[j]), rot));
+			cpVect b = cpvadd(c, cpvrotate(cpv( 100.0f, heights[j]), rot));
+			
+			cpSegmentQueryInfo info = {};
+			double expected = (100.0 - QUERY_HALF_SIZE)/200.0;
+			double err = (cpShapeSegmentQuery(shape, a, b, &info) ? cpfabs(info.t - expected) : 1.0);
+			
+			PushSample(result, info.t);
+			if(err > error) error = err;
+			queries++;
+		}
+		
+		// Nearest points outside each face and inside the box.
+		for(int j=0; j<4; j++){
+			cpVect n = cpvforangle(j*(cpFloat)M_PI*0.5f);
+			cpFloat dist = (j%2 ? 5.0f : 0.25f);
+			
+			cpVect outside = cpvadd(c, cpvrotate(cpvmult(n, QUERY_HALF_SIZE + dist), rot));
+			cpVect inside = cpvadd(c, cpvrotate(cpvmult(n, QUERY_HALF_SIZE - dist), rot));
+			
+			double errOut = cpfabs(cpShapeNearestPointQuery(shape, outside, NULL) - dist);
+			double errIn = cpfabs(cpShapeNearestPointQuery(shape, inside, NULL) + dist);
+			
+			PushSample(result, cpShapeNearestPointQuery(shape, outside, NULL));
+			PushSample(result, cpShapeNearestPointQuery(shape, inside, NULL));
+			if(errOut > error) error = errOut;
+			if(errIn > error) error = errIn;
+			queries += 2;
+		}
+	}
+	
+	result->msPerStep = 1e3*(double)(clock() - start)/(double)CLOCKS_PER_SEC/(double)queries;
+	result->error = error;
+	
+	for(int i=0; i<QUERY_BOXES; i++){
+		cpSpaceRemoveStaticShape(space, shapes[i]);
+		cpShapeFree(shapes[i]);
+	}
+	
+	cpSpaceFree(space);
+}
+
+static const Scene scenes[] = {
+	{"pyramid", RunPyramid, 0.02, 1.0, {0.0f, 0.0f}, 1200},
+	{"pyramid_far", RunPyramid, 0.02, 0.0, {5000.0f, 5000.0f}, 1200},
+	{"sleep", RunSleep, 0.05, 0.0, {0.0f, 0.0f}, 900},
+	{"sleep_far", RunSleep, 0.05, 0.0, {5000.0f, -5000.0f}, 900},
+	{"queries", RunQueries, 0.0, 1e-3, {0.0f, 0.0f}, 0},
+	{"queries_far", RunQueries, 0.0, 5e-3, {5000.0f, 5000.0f}, 0},
+};
+#define NUM_SCENES (int)(sizeof(scenes)/sizeof(*scenes))
+
+//MARK: Reference Files
+
+static void
+WriteReference(FILE *file, const Scene *scene, const SceneResult *result)
+{
+	fprintf(file, "%s %d %.17g\n", scene->name, result->numSamples, result->msPerStep);
+	for(int i=0; i<result->numSamples; i++) fprintf(file, "%.17g\n", result->samples[i]);
+}
+
+// Read the reference for a scene, returns 0 if it couldn't be found.
+static int
+ReadReference(FILE *file, const Scene *scene, SceneResult *reference)
+{
+	char name[64];
+	
+	rewind(file);
+	while(fscanf(file, "%63s %d %lf", name, &reference->numSamples, &reference->msPerStep) == 3){
+		int match = (strcmp(name, scene->name) == 0);
+		if(reference->numSamples > MAX_SAMPLES) return 0;
+		
+		for(int i=0; i<reference->numSamples; i++){
+			if(fscanf(file, "%lf", &reference->samples[i]) != 1) return 0;
+		}
+		
+		if(match) return 1;
+	}
+	
+	return 0;
+}
+
+//MARK: Main
+
+int
+main(int argc, char **argv)
+{
+	const char *writePath = NULL, *comparePath = NULL;
+	
+	for(int i=1; i<argc; i++){
+		if(strcmp(argv[i], "--write") == 0 && i + 1 < argc){
+			writePath = argv[++i];
+		} else if(strcmp(argv[i], "--compare") == 0 && i + 1 < argc){
+			comparePath = argv[++i];
+		} else {
+			fprintf(stderr, "Usage: %s [--write reference.txt | --compare reference.txt]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	
+	FILE *writeFile = (writePath ? fopen(writePath, "w") : NULL);
+	FILE *compareFile = (comparePath ? fopen(comparePath, "r") : NULL);
+	if((writePath && !writeFile) || (comparePath && !compareFile)){
+		fprintf(stderr, "Could not open reference file.\n");
+		return EXIT_FAILURE;
+	}
+	
+	static SceneResult result, reference;
+	int failures = 0;
+	
+	printf("Chipmunk precision suite, cpFloat is %s.\n", sizeof(cpFloat) == sizeof(float) ? "float" : "double");
+	printf("%-12s %10s %10s %12s %12s %12s %12s  %s\n", "scene", "ms/step", "ref ms", "error", "max drift", "mean drift", "speedup", "result");
+	
+	for(int i=0; i<NUM_SCENES; i++){
+		const Scene *scene = &scenes[i];
+		
+		memset(&result, 0, sizeof(result));
+		scene->run(scene, &result);
+		
+		int failed = !(result.error <= scene->tolerance || (scene->tolerance == 0.0 && result.error <= scene->maxDrift));
+		
+		double maxDrift = 0.0, meanDrift = 0.0;
+		double refMs = 0.0;
+		
+		if(writeFile) WriteReference(writeFile, scene, &result);
+		
+		for(int j=0; j<result.numSamples; j++){
+			if(result.samples[j] != result.samples[j]) failed = 1; // NaN
+		}
+		
+		if(compareFile){
+			if(ReadReference(compareFile, scene, &reference) && reference.numSamples == result.numSamples){
+				for(int j=0; j<result.numSamples; j++){
+					double drift = fabs(result.samples[j] - reference.samples[j]);
+					if(drift > maxDrift) maxDrift = drift;
+					meanDrift += drift;
+				}
+				
+				if(result.numSamples) meanDrift /= result.numSamples;
+				refMs = reference.msPerStep;
+				
+				if(scene->maxDrift > 0.0 && maxDrift > scene->maxDrift) failed = 1;
+			} else {
+				fprintf(stderr, "No matching reference for scene '%s'.\n", scene->name);
+				failed = 1;
+			}
+		}
+		
+		printf("%-12s %10.4f %10.4f %12.3g %12.3g %12.3g %12.2f  %s\n",
+			scene->name, result.msPerStep, refMs, result.error, maxDrift, meanDrift,
+			(refMs > 0.0 && result.msPerStep > 0.0 ? refMs/result.msPerStep : 0.0),
+			failed ? "FAILED" : "ok"
+		);
+		
+		failures += failed;
+	}
+	
+	if(writeFile) fclose(writeFile);
+	if(compareFile) fclose(compareFile);
+	
+	return (failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
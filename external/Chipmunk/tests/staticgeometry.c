@@ -0,0 +1,278 @@
+/* Copyright (c) 2013 Scott Lembcke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/*
+	Static geometry test.
+
+	Builds the same level twice, once baked into a single cpStaticGeometry shape and once as individual
+	segment and poly shapes, and checks that point, nearest point and segment queries and the contacts
+	generated against probe circles, segments and boxes match the brute force results from the individual shapes.
+
+	Usage: chipmunk_staticgeometry
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "chipmunk.h"
+
+#define NUM_SEGMENTS 1500
+#define NUM_POLYS 500
+#define NUM_PROBES 2000
+
+// Contacts are computed by the same functions, but allow for the scratch child shapes rounding differently.
+#define TOLERANCE 1e-6
+
+static int failures = 0;
+
+static void
+Check(cpBool passed, const char *what, int probe)
+{
+	if(!passed){
+		printf("FAILED: %s (probe %d)\n", what, probe);
+		failures++;
+	}
+}
+
+static cpBool Near(cpFloat a, cpFloat b){return cpfabs(a - b) <= TOLERANCE*(1.0f + cpfabs(a));}
+
+// Small deterministic generator so every run tests the same level.
+static unsigned int seed = 1;
+
+static cpFloat
+Random(cpFloat min, cpFloat max)
+{
+	seed = seed*1103515245 + 12345;
+	return min + (max - min)*(cpFloat)((seed >> 8) & 0xFFFF)/(cpFloat)0xFFFF;
+}
+
+//MARK: Level
+
+typedef struct Level {
+	// The level baked into one static geometry shape.
+	cpSpace *baked;
+	cpShape *geometry;
+
+	// The same level made of individual shapes.
+	cpSpace *individual;
+	cpShape *shapes[NUM_SEGMENTS + NUM_POLYS];
+	int numShapes;
+} Level;
+
+static void
+LevelInit(Level *level)
+{
+	seed = 1;
+
+	level->baked = cpSpaceNew();
+	level->individual = cpSpaceNew();
+	level->numShapes = 0;
+
+	cpBody *bakedBody = cpSpaceGetStaticBody(level->baked);
+	cpBody *individualBody = cpSpaceGetStaticBody(level->individual);
+	cpShape *geometry = level->geometry = cpStaticGeometryNew(bakedBody);
+
+	// A bumpy terrain line followed by scattered segments, some of them with a radius.
+	cpVect prev = cpv(-1000.0f, 0.0f);
+	for(int i=0; i<NUM_SEGMENTS; i++){
+		cpVect a, b;
+		cpFloat radius = 0.0f;
+
+		if(i < 500){
+			a = prev;
+			b = prev = cpv(-1000.0f + (i + 1)*4.0f, Random(-20.0f, 20.0f));
+		} else {
+			a = cpv(Random(-1000.0f, 1000.0f), Random(20.0f, 1000.0f));
+			b = cpvadd(a, cpv(Random(-40.0f, 40.0f), Random(-40.0f, 40.0f)));
+			radius = (i%3 ? 0.0f : Random(0.5f, 4.0f));
+		}
+
+		cpStaticGeometryAddSegment(geometry, a, b, radius);
+		level->shapes[level->numShapes++] = cpSpaceAddShape(level->individual, cpSegmentShapeNew(individualBody, a, b, radius));
+	}
+
+	// Rotated boxes and triangles.
+	for(int i=0; i<NUM_POLYS; i++){
+		cpVect center = cpv(Random(-1000.0f, 1000.0f), Random(20.0f, 1000.0f));
+		cpVect rot = cpvforangle(Random(0.0f, 6.0f));
+		cpFloat hw = Random(2.0f, 15.0f), hh = Random(2.0f, 15.0f);
+
+		cpVect corners[] = {cpv(-hw, -hh), cpv(-hw, hh), cpv(hw, hh), cpv(hw, -hh)};
+		int count = (i&1 ? 3 : 4);
+
+		cpVect verts[4];
+		for(int j=0; j<count; j++) verts[j] = cpvrotate(corners[j], rot);
+
+		cpStaticGeometryAddPoly(geometry, count, verts, center);
+		level->shapes[level->numShapes++] = cpSpaceAddShape(level->individual, cpPolyShapeNew(individualBody, count, verts, center));
+	}
+
+	cpSpaceAddShape(level->baked, geometry);
+}
+
+static void
+LevelFree(Level *level)
+{
+	cpSpaceRemoveShape(level->baked, level->geometry);
+	cpShapeFree(level->geometry);
+	cpSpaceFree(level->baked);
+
+	for(int i=0; i<level->numShapes; i++){
+		cpSpaceRemoveShape(level->individual, level->shapes[i]);
+		cpShapeFree(level->shapes[i]);
+	}
+	cpSpaceFree(level->individual);
+}
+
+//MARK: Queries
+
+static void
+RunQueries(Level *level)
+{
+	int before = failures;
+	int pointHits = 0, nearestHits = 0, segmentHits = 0;
+
+	for(int i=0; i<NUM_PROBES; i++){
+		cpVect point = cpv(Random(-1050.0f, 1050.0f), Random(-50.0f, 1050.0f));
+
+		cpShape *bakedPoint = cpSpacePointQueryFirst(level->baked, point, CP_ALL_LAYERS, CP_NO_GROUP);
+		cpShape *individualPoint = cpSpacePointQueryFirst(level->individual, point, CP_ALL_LAYERS, CP_NO_GROUP);
+		Check((bakedPoint == level->geometry) == (individualPoint != NULL), "point query", i);
+		if(individualPoint) pointHits++;
+
+		cpNearestPointQueryInfo bakedNearest, individualNearest;
+		cpSpaceNearestPointQueryNearest(level->baked, point, 30.0f, CP_ALL_LAYERS, CP_NO_GROUP, &bakedNearest);
+		cpSpaceNearestPointQueryNearest(level->individual, point, 30.0f, CP_ALL_LAYERS, CP_NO_GROUP, &individualNearest);
+		Check((bakedNearest.shape != NULL) == (individualNearest.shape != NULL), "nearest point query hit", i);
+		if(individualNearest.shape){
+			Check(Near(bakedNearest.d, individualNearest.d), "nearest point query distance", i);
+			nearestHits++;
+		}
+
+		cpVect end = cpvadd(point, cpv(Random(-200.0f, 200.0f), Random(-200.0f, 200.0f)));
+		cpSegmentQueryInfo bakedSegment, individualSegment;
+		cpSpaceSegmentQueryFirst(level->baked, point, end, CP_ALL_LAYERS, CP_NO_GROUP, &bakedSegment);
+		cpSpaceSegmentQueryFirst(level->individual, point, end, CP_ALL_LAYERS, CP_NO_GROUP, &individualSegment);
+		Check((bakedSegment.shape != NULL) == (individualSegment.shape != NULL), "segment query hit", i);
+		if(individualSegment.shape){
+			Check(Near(bakedSegment.t, individualSegment.t), "segment query t", i);
+			Check(Near(cpvdot(bakedSegment.n, individualSegment.n), 1.0f), "segment query normal", i);
+			segmentHits++;
+		}
+	}
+
+	// Make sure the probes actually hit the level.
+	Check(pointHits > NUM_PROBES/50 && nearestHits > NUM_PROBES/4 && segmentHits > NUM_PROBES/4, "enough query hits", 0);
+	printf("%-24s %s\n", "queries", failures > before ? "FAILED" : "passed");
+}
+
+//MARK: Collisions
+
+// Depths of the contacts against the level, sorted from deepest to shallowest.
+typedef struct Contacts {
+	cpFloat dists[1024];
+	int count;
+} Contacts;
+
+static void
+CollectContacts(cpShape *shape, cpContactPointSet *set, Contacts *contacts)
+{
+	for(int i=0; i<set->count && contacts->count < 1024; i++){
+		contacts->dists[contacts->count++] = set->points[i].dist;
+	}
+}
+
+static int
+CompareDists(const void *a, const void *b)
+{
+	cpFloat da = *(const cpFloat *)a, db = *(const cpFloat *)b;
+	return (da < db ? -1 : (da > db ? 1 : 0));
+}
+
+static void
+RunCollisions(Level *level)
+{
+	int before = failures;
+	int collisions = 0, merged = 0;
+
+	cpBody *body = cpBodyNewStatic();
+
+	for(int i=0; i<NUM_PROBES; i++){
+		cpBodySetPos(body, cpv(Random(-1050.0f, 1050.0f), Random(-50.0f, 1050.0f)));
+		cpBodySetAngle(body, Random(0.0f, 6.0f));
+
+		cpShape *probe;
+		switch(i%3){
+			case 0: probe = cpCircleShapeNew(body, Random(1.0f, 25.0f), cpvzero); break;
+			case 1: probe = cpSegmentShapeNew(body, cpv(-Random(5.0f, 40.0f), 0.0f), cpv(Random(5.0f, 40.0f), 0.0f), Random(0.0f, 5.0f)); break;
+			default: probe = cpBoxShapeNew(body, Random(2.0f, 50.0f), Random(2.0f, 50.0f)); break;
+		}
+
+		Contacts baked = {}, individual = {};
+		cpSpaceShapeQuery(level->baked, probe, (cpSpaceShapeQueryFunc)CollectContacts, &baked);
+		cpSpaceShapeQuery(level->individual, probe, (cpSpaceShapeQueryFunc)CollectContacts, &individual);
+
+		// The geometry keeps the deepest contacts of all the children it overlaps.
+		qsort(individual.dists, individual.count, sizeof(cpFloat), CompareDists);
+		qsort(baked.dists, baked.count, sizeof(cpFloat), CompareDists);
+
+		int expected = (individual.count < CP_MAX_CONTACTS_PER_ARBITER ? individual.count : CP_MAX_CONTACTS_PER_ARBITER);
+		Check(baked.count == expected, "contact count", i);
+
+		if(baked.count == expected){
+			for(int j=0; j<expected; j++) Check(Near(baked.dists[j], individual.dists[j]), "contact depth", i);
+		}
+
+		if(individual.count) collisions++;
+		if(individual.count > CP_MAX_CONTACTS_PER_ARBITER) merged++;
+
+		cpShapeFree(probe);
+	}
+
+	cpBodyFree(body);
+
+	// Make sure both the simple and the merging cases were tested.
+	Check(collisions > NUM_PROBES/10 && merged > 0, "enough collisions", 0);
+	printf("%-24s %s\n", "collisions", failures > before ? "FAILED" : "passed");
+}
+
+//MARK: Main
+
+int
+main(int argc, char **argv)
+{
+	Level level;
+	LevelInit(&level);
+
+	Check(cpStaticGeometryGetNumSegments(level.geometry) == NUM_SEGMENTS, "segment count", 0);
+	Check(cpStaticGeometryGetNumPolys(level.geometry) == NUM_POLYS, "poly count", 0);
+
+	RunQueries(&level);
+	RunCollisions(&level);
+
+	LevelFree(&level);
+
+	return (failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
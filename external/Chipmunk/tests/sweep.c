@@ -0,0 +1,307 @@
+/* Copyright (c) 2013 Scott Lembcke
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/*
+	Sweep and prune test.
+	
+	Compares the pairs found by cpSweep1D's reindex query, and the results of its bounding box and segment queries,
+	against brute force while objects are moved, inserted, removed and reindexed one at a time.
+	Also checks that the sweep picks the axis the objects are spread out along
+	and that the pair test counter matches the number of pairs overlapping along that axis.
+	
+	Usage: chipmunk_sweep
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chipmunk.h"
+
+#define MAX_OBJECTS 600
+#define STEPS 40
+
+typedef struct Object {
+	cpBB bb;
+	cpHashValue hashid;
+	cpBool inserted;
+} Object;
+
+static Object objects[MAX_OBJECTS];
+
+// Bit matrices of the pairs found by the index and by brute force.
+static unsigned char found[MAX_OBJECTS][MAX_OBJECTS];
+static unsigned char expected[MAX_OBJECTS][MAX_OBJECTS];
+
+static cpBB ObjectBB(Object *obj){return obj->bb;}
+
+// Small deterministic generator so every run tests the same scenes.
+static unsigned int seed = 1;
+
+static cpFloat
+Random(cpFloat min, cpFloat max)
+{
+	seed = seed*1103515245 + 12345;
+	return min + (max - min)*(cpFloat)((seed >> 8) & 0xFFFF)/(cpFloat)0xFFFF;
+}
+
+// Objects are scattered over a w by h area.
+static void
+RandomBB(Object *obj, cpFloat w, cpFloat h)
+{
+	cpFloat x = Random(0.0f, w), y = Random(0.0f, h);
+	cpFloat hw = Random(0.5f, 6.0f), hh = Random(0.5f, 6.0f);
+	
+	// A few long thin objects to stretch the maximum span the queries have to look back over.
+	if(obj->hashid%50 == 0) hw *= 10.0f;
+	
+	obj->bb = cpBBNew(x - hw, y - hh, x + hw, y + hh);
+}
+
+//MARK: Checks
+
+static int failures = 0;
+
+static void
+Check(cpBool passed, const char *what, int step)
+{
+	if(!passed){
+		printf("FAILED: %s (step %d)\n", what, step);
+		failures++;
+	}
+}
+
+static void
+PairFunc(Object *a, Object *b, void *data)
+{
+	int i = (int)(a - objects), j = (int)(b - objects);
+	found[i][j]++;
+	found[j][i]++;
+}
+
+static void
+QueryFunc(Object *query, Object *obj, void *data)
+{
+	found[0][obj - objects]++;
+}
+
+static cpFloat
+SegmentFunc(Object *query, Object *obj, void *data)
+{
+	found[0][obj - objects]++;
+	return 1.0f;
+}
+
+static void
+CheckReindexQuery(cpSpatialIndex *index, int count, int step)
+{
+	memset(found, 0, sizeof(found));
+	memset(expected, 0, sizeof(expected));
+	cpSpatialIndexReindexQuery(index, (cpSpatialIndexQueryFunc)PairFunc, NULL);
+	
+	// Brute force pairs, and the pairs that overlap along the sweep axis.
+	int axis = cpSweep1DGetAxis(index);
+	unsigned int axisPairs = 0;
+	
+	for(int i=0; i<count; i++){
+		if(!objects[i].inserted) continue;
+		
+		for(int j=i+1; j<count; j++){
+			if(!objects[j].inserted) continue;
+			
+			cpBB a = objects[i].bb, b = objects[j].bb;
+			if(cpBBIntersects(a, b)) expected[i][j] = expected[j][i] = 1;
+			
+			cpBool overlap = (axis ? (a.b <= b.t && b.b <= a.t) : (a.l <= b.r && b.l <= a.r));
+			if(overlap) axisPairs++;
+		}
+	}
+	
+	Check(memcmp(found, expected, sizeof(found)) == 0, "reindex query pairs match brute force", step);
+	Check(cpSweep1DGetPairTests(index) == axisPairs, "pair tests match the pairs overlapping along the sweep axis", step);
+}
+
+static void
+CheckQueries(cpSpatialIndex *index, int count, int step)
+{
+	for(int q=0; q<10; q++){
+		Object query = {cpBBNew(0.0f, 0.0f, 0.0f, 0.0f), 0, cpFalse};
+		RandomBB(&query, 400.0f, 400.0f);
+		query.bb.r += 20.0f;
+		
+		memset(found[0], 0, sizeof(found[0]));
+		cpSpatialIndexQuery(index, &query, query.bb, (cpSpatialIndexQueryFunc)QueryFunc, NULL);
+		
+		cpBool match = cpTrue;
+		for(int i=0; i<count; i++){
+			int hit = (objects[i].inserted && cpBBIntersects(query.bb, objects[i].bb));
+			if(found[0][i] != hit) match = cpFalse;
+		}
+		Check(match, "bounding box query matches brute force", step);
+		
+		cpVect a = cpv(Random(-20.0f, 420.0f), Random(-20.0f, 420.0f));
+		cpVect b = cpv(Random(-20.0f, 420.0f), Random(-20.0f, 420.0f));
+		cpBB segmentBB = cpBBExpand(cpBBNew(a.x, a.y, a.x, a.y), b);
+		
+		memset(found[0], 0, sizeof(found[0]));
+		cpSpatialIndexSegmentQuery(index, &query, a, b, 1.0f, (cpSpatialIndexSegmentQueryFunc)SegmentFunc, NULL);
+		
+		match = cpTrue;
+		for(int i=0; i<count; i++){
+			int hit = (objects[i].inserted && cpBBIntersects(segmentBB, objects[i].bb));
+			if(found[0][i] != hit) match = cpFalse;
+		}
+		Check(match, "segment query matches brute force", step);
+	}
+}
+
+//MARK: Scenes
+
+// Objects move around, are reindexed one at a time, removed and reinserted between reindex queries.
+// The queries are checked both right after the reindex and after the one at a time changes.
+static void
+RunChurn(void)
+{
+	seed = 1;
+	cpSpatialIndex *index = cpSweep1DNew((cpSpatialIndexBBFunc)ObjectBB, NULL);
+	
+	int count = 400;
+	for(int i=0; i<count; i++){
+		objects[i].hashid = (cpHashValue)i;
+		objects[i].inserted = cpTrue;
+		RandomBB(&objects[i], 400.0f, 400.0f);
+		cpSpatialIndexInsert(index, &objects[i], objects[i].hashid);
+	}
+	
+	for(int step=0; step<STEPS; step++){
+		// Everything drifts a little between steps.
+		for(int i=0; i<count; i++){
+			cpVect d = cpv(Random(-2.0f, 2.0f), Random(-2.0f, 2.0f));
+			cpBB bb = objects[i].bb;
+			objects[i].bb = cpBBNew(bb.l + d.x, bb.b + d.y, bb.r + d.x, bb.t + d.y);
+		}
+		
+		CheckReindexQuery(index, count, step);
+		CheckQueries(index, count, step);
+		
+		// Teleport a few objects and reindex just them.
+		for(int n=0; n<10; n++){
+			Object *obj = &objects[(int)Random(0.0f, (cpFloat)count - 1.0f)];
+			RandomBB(obj, 400.0f, 400.0f);
+			if(obj->inserted) cpSpatialIndexReindexObject(index, obj, obj->hashid);
+		}
+		
+		// Remove some objects, put others back and add new ones.
+		for(int n=0; n<10; n++){
+			Object *obj = &objects[(int)Random(0.0f, (cpFloat)count - 1.0f)];
+			if(obj->inserted){
+				cpSpatialIndexRemove(index, obj, obj->hashid);
+			} else {
+				cpSpatialIndexInsert(index, obj, obj->hashid);
+			}
+			
+			obj->inserted = !obj->inserted;
+		}
+		
+		if(count < MAX_OBJECTS){
+			Object *obj = &objects[count];
+			obj->hashid = (cpHashValue)count;
+			obj->inserted = cpTrue;
+			RandomBB(obj, 400.0f, 400.0f);
+			cpSpatialIndexInsert(index, obj, obj->hashid);
+			count++;
+		}
+		
+		int inserted = 0;
+		for(int i=0; i<count; i++){
+			if(objects[i].inserted){
+				inserted++;
+				Check(cpSpatialIndexContains(index, &objects[i], objects[i].hashid), "contains inserted objects", step);
+			} else {
+				Check(!cpSpatialIndexContains(index, &objects[i], objects[i].hashid), "doesn't contain removed objects", step);
+			}
+		}
+		
+		Check(cpSpatialIndexCount(index) == inserted, "count matches inserted objects", step);
+		CheckQueries(index, count, step);
+	}
+	
+	cpSpatialIndexFree(index);
+	printf("%-24s %s\n", "churn", failures ? "FAILED" : "passed");
+}
+
+// Objects spread along one axis should be swept along that axis, and the sweep should follow them
+// when they spread out along the other one. Sweeping along the right axis keeps the pair tests down.
+static void
+RunAxis(void)
+{
+	int before = failures;
+	
+	seed = 2;
+	cpSpatialIndex *index = cpSweep1DNew((cpSpatialIndexBBFunc)ObjectBB, NULL);
+	
+	int count = 500;
+	for(int i=0; i<count; i++){
+		objects[i].hashid = (cpHashValue)i;
+		objects[i].inserted = cpTrue;
+		RandomBB(&objects[i], 40.0f, 2000.0f);
+		cpSpatialIndexInsert(index, &objects[i], objects[i].hashid);
+	}
+	
+	CheckReindexQuery(index, count, 0);
+	Check(cpSweep1DGetAxis(index) == 1, "tall scene sweeps along y", 0);
+	
+	// A sweep along the wrong axis would test nearly every pair.
+	unsigned int allPairs = count*(count - 1)/2;
+	Check(cpSweep1DGetPairTests(index) < allPairs/10, "sweep along y tests few pairs", 0);
+	
+	// Rotate the scene onto its side.
+	for(int i=0; i<count; i++){
+		cpBB bb = objects[i].bb;
+		objects[i].bb = cpBBNew(bb.b, bb.l, bb.t, bb.r);
+	}
+	
+	CheckReindexQuery(index, count, 1);
+	Check(cpSweep1DGetAxis(index) == 0, "wide scene sweeps along x", 1);
+	Check(cpSweep1DGetPairTests(index) < allPairs/10, "sweep along x tests few pairs", 1);
+	CheckQueries(index, count, 1);
+	
+	// A square scene is ambiguous, the hysteresis should keep the current axis.
+	for(int i=0; i<count; i++) RandomBB(&objects[i], 1000.0f, 900.0f);
+	CheckReindexQuery(index, count, 2);
+	Check(cpSweep1DGetAxis(index) == 0, "square scene keeps the current axis", 2);
+	
+	cpSpatialIndexFree(index);
+	printf("%-24s %s\n", "axis", failures > before ? "FAILED" : "passed");
+}
+
+//MARK: Main
+
+int
+main(int argc, char **argv)
+{
+	RunChurn();
+	RunAxis();
+	
+	return (failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,875 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+	Kernel benchmark.
+
+	Times the core kazmath kernels on arrays of random input and reports nanoseconds per call.
+	Build it against the SIMD and the scalar (KM_NO_SIMD) library, write the results of one
+	and compare the other against them to measure the speedup.
+
+	Usage: kazmath_benchmark [--kernel name] [--iterations n] [--quick]
+	                         [--write results.txt | --compare results.txt]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "kazmath/kazmath.h"
+#include "kazmath/vec4.h"
+#include "kazmath/sse_matrix_impl.h"
+#include "kazmath/GL/matrix.h"
+
+// Number of distinct inputs, small enough to stay in the L1 cache.
+#define NUM_INPUTS 256
+#define DEFAULT_ITERATIONS 4000000
+
+static kmMat4 matrices[NUM_INPUTS];
+// Rotations followed by translations.
+static kmMat4 rigidMatrices[NUM_INPUTS];
+static kmMat3 mat3s[NUM_INPUTS];
+static kmVec2 vec2s[NUM_INPUTS];
+static kmVec3 vec3s[NUM_INPUTS];
+static kmVec4 vec4s[NUM_INPUTS];
+static kmQuaternion quaternions[NUM_INPUTS];
+static kmQuaternion unitQuaternions[NUM_INPUTS];
+
+// Same layout as cocos2d's ccV3F_C4B_T2F, used by the batch kernels.
+typedef struct Vertex {
+	kmVec3 position;
+	unsigned char color[4];
+	float u, v;
+} Vertex;
+
+#define NUM_VERTICES 100000
+
+static Vertex sourceVertices[NUM_VERTICES];
+static Vertex vertices[NUM_VERTICES];
+static kmVec4 sourceVec4s[NUM_VERTICES];
+static kmVec4 batchVec4s[NUM_VERTICES];
+
+// A scene graph of 2D nodes, each node's parent comes before it.
+#define NUM_NODES 1000
+
+static int nodeParents[NUM_NODES];
+static kmMat3x2 nodeTransforms[NUM_NODES];
+static kmMat4 nodeTransforms4[NUM_NODES];
+static kmMat3x2 worldTransforms[NUM_NODES];
+static kmMat4 worldTransforms4[NUM_NODES];
+
+// A scene of boxes, with points, rays and segments to query it with.
+#define NUM_QUERIES 1000
+
+static kmAABB queryBoxes[NUM_QUERIES];
+static kmVec3 queryPoints[NUM_QUERIES];
+static kmVec2 querySegments[2*NUM_QUERIES];
+static kmBool queryHits[NUM_QUERIES];
+static kmScalar queryDistances[NUM_QUERIES];
+static kmVec2 queryIntersections[NUM_QUERIES];
+static kmAABB queryBox;
+static kmRay3 queryRay;
+static kmRay2 queryRay2;
+static kmPlane queryFrustum[6];
+
+// Results are accumulated here so the compiler can't drop the calls.
+static volatile float sink;
+
+static double
+Seconds(void)
+{
+	return (double)clock()/(double)CLOCKS_PER_SEC;
+}
+
+static unsigned int randSeed = 5489u;
+
+static float
+RandomFloat(float min, float max)
+{
+	randSeed = randSeed*1664525u + 1013904223u;
+	return min + (max - min)*(float)(randSeed >> 8)/(float)(1 << 24);
+}
+
+static void
+InitInputs(void)
+{
+	for(int i=0; i<NUM_NODES; i++){
+		nodeParents[i] = (i ? (int)RandomFloat(0.0f, (float)i) : -1);
+
+		kmMat3x2 rotation, translation;
+		kmMat3x2Rotation(&rotation, RandomFloat(-0.5f, 0.5f));
+		kmMat3x2Translation(&translation, RandomFloat(-10.0f, 10.0f), RandomFloat(-10.0f, 10.0f));
+		kmMat3x2Multiply(&nodeTransforms[i], &translation, &rotation);
+
+		// Expanded the same way CCNode does with CGAffineToGL().
+		kmMat4AssignMat3x2(&nodeTransforms4[i], &nodeTransforms[i]);
+	}
+
+	for(int i=0; i<NUM_VERTICES; i++){
+		kmVec3Fill(&sourceVertices[i].position, RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), 0.0f);
+		kmVec4Fill(&sourceVec4s[i], RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), 1.0f);
+	}
+
+	for(int i=0; i<NUM_QUERIES; i++){
+		kmVec3Fill(&queryBoxes[i].min, RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f));
+		kmVec3Fill(&queryBoxes[i].max, queryBoxes[i].min.x + RandomFloat(0.0f, 20.0f), queryBoxes[i].min.y + RandomFloat(0.0f, 20.0f), queryBoxes[i].min.z + RandomFloat(0.0f, 20.0f));
+		kmVec3Fill(&queryPoints[i], RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f));
+		kmVec2Fill(&querySegments[2*i], RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f));
+		kmVec2Fill(&querySegments[2*i + 1], RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f));
+	}
+
+	kmVec3Fill(&queryBox.min, -50.0f, -50.0f, -50.0f);
+	kmVec3Fill(&queryBox.max, 50.0f, 50.0f, 50.0f);
+	// A touch: from the near plane straight into the scene.
+	kmRay3Fill(&queryRay, 10.0f, 20.0f, 150.0f, 0.0f, 0.0f, -300.0f);
+	kmRay2Fill(&queryRay2, -150.0f, 10.0f, 300.0f, 5.0f);
+
+	kmMat4 projection, view, viewProjection;
+	kmVec3 eye = {0.0f, 0.0f, 150.0f}, centre = {0.0f, 0.0f, 0.0f}, up = {0.0f, 1.0f, 0.0f};
+	kmMat4PerspectiveProjection(&projection, 45.0f, 1.5f, 1.0f, 200.0f);
+	kmMat4LookAt(&view, &eye, &centre, &up);
+	kmMat4Multiply(&viewProjection, &projection, &view);
+	kmPlaneExtractFrustum(queryFrustum, &viewProjection);
+
+	for(int i=0; i<NUM_INPUTS; i++){
+		for(int j=0; j<16; j++) matrices[i].mat[j] = RandomFloat(-10.0f, 10.0f);
+
+		kmMat4 rotation, translation;
+		kmVec3 axis = {RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(0.1f, 1.0f)};
+		kmMat4RotationAxisAngle(&rotation, kmVec3Normalize(&axis, &axis), RandomFloat(-3.0f, 3.0f));
+		kmMat4Translation(&translation, RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f));
+		kmMat4Multiply(&rigidMatrices[i], &translation, &rotation);
+
+		// Diagonally dominant so the inverse exists.
+		for(int j=0; j<9; j++) mat3s[i].mat[j] = RandomFloat(-10.0f, 10.0f) + (j%4 == 0 ? 40.0f : 0.0f);
+
+		kmVec2Fill(&vec2s[i], RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f));
+		kmVec3Fill(&vec3s[i], RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f));
+		kmVec4Fill(&vec4s[i], RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), 1.0f);
+		kmQuaternion q = {RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f)};
+		quaternions[i] = q;
+		kmQuaternionNormalize(&unitQuaternions[i], &q);
+	}
+}
+
+//MARK: Kernels
+
+typedef struct Kernel {
+	const char *name;
+	void (*run)(int iterations);
+} Kernel;
+
+static void
+RunMat4Multiply(int iterations)
+{
+	kmMat4 out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		kmMat4Multiply(&out, &matrices[i%NUM_INPUTS], &matrices[(i + 1)%NUM_INPUTS]);
+		sum += out.mat[i&15];
+	}
+
+	sink = sum;
+}
+
+static void
+RunMat4Transpose(int iterations)
+{
+	kmMat4 out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		kmMat4Transpose(&out, &matrices[i%NUM_INPUTS]);
+		sum += out.mat[i&15];
+	}
+
+	sink = sum;
+}
+
+static void
+RunMat4RotationAxisAngle(int iterations)
+{
+	kmMat4 out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		const kmVec3 *axis = (const kmVec3 *)&quaternions[i%NUM_INPUTS];
+		kmMat4RotationAxisAngle(&out, axis, (float)(i&255)*0.01f);
+		sum += out.mat[i&15];
+	}
+
+	sink = sum;
+}
+
+static void
+RunMat4RotationQuaternion(int iterations)
+{
+	kmMat4 out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		kmMat4RotationQuaternion(&out, &quaternions[i%NUM_INPUTS]);
+		sum += out.mat[i&15];
+	}
+
+	sink = sum;
+}
+
+static void
+RunMat4LookAt(int iterations)
+{
+	kmMat4 out;
+	kmVec3 up = {0.0f, 1.0f, 0.0f};
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		kmMat4LookAt(&out, &vec3s[i%NUM_INPUTS], &vec3s[(i + 1)%NUM_INPUTS], &up);
+		sum += out.mat[i&15];
+	}
+
+	sink = sum;
+}
+
+static void
+RunMat3Multiply(int iterations)
+{
+	kmMat3 out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		kmMat3Multiply(&out, &mat3s[i%NUM_INPUTS], &mat3s[(i + 1)%NUM_INPUTS]);
+		sum += out.mat[i%9];
+	}
+
+	sink = sum;
+}
+
+static void
+RunMat3Inverse(int iterations)
+{
+	kmMat3 out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		const kmMat3 *m = &mat3s[i%NUM_INPUTS];
+		if(kmMat3Inverse(&out, kmMat3Determinant(m), m)) sum += out.mat[i%9];
+	}
+
+	sink = sum;
+}
+
+// The Gauss-Jordan elimination kmMat4Inverse() used before, still exported by mat4.c.
+extern int gaussj(kmMat4 *a, kmMat4 *b);
+
+static void
+RunGaussJordan(int iterations)
+{
+	kmMat4 out, tmp;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		kmMat4Assign(&out, &matrices[i%NUM_INPUTS]);
+		kmMat4Identity(&tmp);
+		if(gaussj(&out, &tmp)) sum += out.mat[i&15];
+	}
+
+	sink = sum;
+}
+
+static void
+RunMat4Inverse(int iterations)
+{
+	kmMat4 out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		if(kmMat4Inverse(&out, &matrices[i%NUM_INPUTS])) sum += out.mat[i&15];
+	}
+
+	sink = sum;
+}
+
+// kmMat4Inverse() on affine input, includes the cost of detecting it.
+static void
+RunMat4InverseOfAffine(int iterations)
+{
+	kmMat4 out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		if(kmMat4Inverse(&out, &rigidMatrices[i%NUM_INPUTS])) sum += out.mat[i&15];
+	}
+
+	sink = sum;
+}
+
+static void
+RunMat4InverseAffine(int iterations)
+{
+	kmMat4 out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		if(kmMat4InverseAffine(&out, &rigidMatrices[i%NUM_INPUTS])) sum += out.mat[i&15];
+	}
+
+	sink = sum;
+}
+
+static void
+RunMat4InverseRigid(int iterations)
+{
+	kmMat4 out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		kmMat4InverseRigid(&out, &rigidMatrices[i%NUM_INPUTS]);
+		sum += out.mat[i&15];
+	}
+
+	sink = sum;
+}
+
+static void
+RunVec3Transform(int iterations)
+{
+	kmVec3 out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		kmVec3Transform(&out, &vec3s[i%NUM_INPUTS], &rigidMatrices[(i >> 8)%NUM_INPUTS]);
+		sum += out.x;
+	}
+
+	sink = sum;
+}
+
+static void
+RunVec4Transform(int iterations)
+{
+	kmVec4 out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		kmVec4Transform(&out, &vec4s[i%NUM_INPUTS], &matrices[(i >> 8)%NUM_INPUTS]);
+		sum += out.w;
+	}
+
+	sink = sum;
+}
+
+static void
+RunVec2Normalize(int iterations)
+{
+	kmVec2 out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		kmVec2Normalize(&out, &vec2s[i%NUM_INPUTS]);
+		sum += out.x;
+	}
+
+	sink = sum;
+}
+
+static void
+RunVec3Normalize(int iterations)
+{
+	kmVec3 out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		kmVec3Normalize(&out, &vec3s[i%NUM_INPUTS]);
+		sum += out.x;
+	}
+
+	sink = sum;
+}
+
+static void
+RunVec3Cross(int iterations)
+{
+	kmVec3 out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		kmVec3Cross(&out, &vec3s[i%NUM_INPUTS], &vec3s[(i + 1)%NUM_INPUTS]);
+		sum += out.x;
+	}
+
+	sink = sum;
+}
+
+static void
+RunVec4Dot(int iterations)
+{
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		sum += kmVec4Dot(&vec4s[i%NUM_INPUTS], &vec4s[(i + 1)%NUM_INPUTS]);
+	}
+
+	sink = sum;
+}
+
+// The batch kernels transform 100k vertices per call, iterations counts vertices
+// so the ns/call column is per vertex and comparable with the single vector kernels.
+static void
+RunVec3Loop(int iterations)
+{
+	float sum = 0.0f;
+
+	for(int done=0, n=0; done<iterations; done+=NUM_VERTICES, n++){
+		const kmMat4 *m = &rigidMatrices[n%NUM_INPUTS];
+		for(int i=0; i<NUM_VERTICES; i++) kmVec3Transform(&vertices[i].position, &sourceVertices[i].position, m);
+		sum += vertices[n%NUM_VERTICES].position.x;
+	}
+
+	sink = sum;
+}
+
+static void
+RunVec3Batch(int iterations)
+{
+	float sum = 0.0f;
+
+	for(int done=0, n=0; done<iterations; done+=NUM_VERTICES, n++){
+		kmVec3TransformStrided(&vertices[0].position, sizeof(Vertex), &sourceVertices[0].position, sizeof(Vertex), &rigidMatrices[n%NUM_INPUTS], NUM_VERTICES);
+		sum += vertices[n%NUM_VERTICES].position.x;
+	}
+
+	sink = sum;
+}
+
+static void
+RunVec4Batch(int iterations)
+{
+	float sum = 0.0f;
+
+	for(int done=0, n=0; done<iterations; done+=NUM_VERTICES, n++){
+		kmVec4TransformStrided(batchVec4s, 0, sourceVec4s, 0, &matrices[n%NUM_INPUTS], NUM_VERTICES);
+		sum += batchVec4s[n%NUM_VERTICES].w;
+	}
+
+	sink = sum;
+}
+
+static void
+RunQuaternionMultiply(int iterations)
+{
+	kmQuaternion out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		kmQuaternionMultiply(&out, &quaternions[i%NUM_INPUTS], &quaternions[(i + 1)%NUM_INPUTS]);
+		sum += out.w;
+	}
+
+	sink = sum;
+}
+
+static void
+RunQuaternionNormalize(int iterations)
+{
+	kmQuaternion out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		kmQuaternionNormalize(&out, &quaternions[i%NUM_INPUTS]);
+		sum += out.w;
+	}
+
+	sink = sum;
+}
+
+static void
+RunQuaternionSlerp(int iterations)
+{
+	kmQuaternion out;
+	float sum = 0.0f;
+
+	for(int i=0; i<iterations; i++){
+		kmQuaternionSlerp(&out, &unitQuaternions[i%NUM_INPUTS], &unitQuaternions[(i + 1)%NUM_INPUTS], (float)(i&255)/255.0f);
+		sum += out.w;
+	}
+
+	sink = sum;
+}
+
+// Composes the world transform of every node of the scene graph, iterations counts nodes.
+static void
+RunSceneGraphMat4(int iterations)
+{
+	float sum = 0.0f;
+
+	for(int done=0; done<iterations; done+=NUM_NODES){
+		worldTransforms4[0] = nodeTransforms4[0];
+		for(int i=1; i<NUM_NODES; i++){
+			kmMat4Multiply(&worldTransforms4[i], &worldTransforms4[nodeParents[i]], &nodeTransforms4[i]);
+		}
+
+		sum += worldTransforms4[NUM_NODES - 1].mat[12];
+	}
+
+	sink = sum;
+}
+
+static void
+RunSceneGraphMat3x2(int iterations)
+{
+	float sum = 0.0f;
+
+	for(int done=0; done<iterations; done+=NUM_NODES){
+		worldTransforms[0] = nodeTransforms[0];
+		for(int i=1; i<NUM_NODES; i++){
+			kmMat3x2Multiply(&worldTransforms[i], &worldTransforms[nodeParents[i]], &nodeTransforms[i]);
+		}
+
+		sum += worldTransforms[NUM_NODES - 1].mat[4];
+	}
+
+	sink = sum;
+}
+
+// The visit of a node: push, apply the node transform as CCNode does, pop.
+static void
+RunGLNodeMat4(int iterations)
+{
+	kmMat4 out;
+	float sum = 0.0f;
+
+	kmGLMatrixMode(KM_GL_MODELVIEW);
+	for(int i=0; i<iterations; i++){
+		kmGLPushMatrix();
+		kmGLMultMatrix(&nodeTransforms4[i%NUM_NODES]);
+		kmGLGetMatrix(KM_GL_MODELVIEW, &out);
+		kmGLPopMatrix();
+		sum += out.mat[12];
+	}
+
+	sink = sum;
+}
+
+static void
+RunGLNodeMat3x2(int iterations)
+{
+	kmMat4 out;
+	float sum = 0.0f;
+
+	kmGLMatrixMode(KM_GL_MODELVIEW);
+	for(int i=0; i<iterations; i++){
+		kmGLPushMatrix();
+		kmGLMultMatrix3x2(&nodeTransforms[i%NUM_NODES]);
+		kmGLGetMatrix(KM_GL_MODELVIEW, &out);
+		kmGLPopMatrix();
+		sum += out.mat[12];
+	}
+
+	sink = sum;
+}
+
+// A node visit: push, apply the node transform, pop, through the global kmGL API.
+static void
+RunGLPushPop(int iterations)
+{
+	kmMat4 out;
+	float sum = 0.0f;
+
+	kmGLMatrixMode(KM_GL_MODELVIEW);
+	for(int i=0; i<iterations; i++){
+		kmGLPushMatrix();
+		kmGLMultMatrix(&rigidMatrices[i%NUM_INPUTS]);
+		kmGLGetMatrix(KM_GL_MODELVIEW, &out);
+		kmGLPopMatrix();
+		sum += out.mat[12];
+	}
+
+	sink = sum;
+}
+
+// The query kernels test every item of the scene, iterations counts items.
+static void
+RunAABBPointsLoop(int iterations)
+{
+	unsigned int inside = 0;
+
+	for(int done=0; done<iterations; done+=NUM_QUERIES){
+		for(int i=0; i<NUM_QUERIES; i++){
+			inside += kmAABBContainsPoint(&queryPoints[i], &queryBox);
+		}
+	}
+
+	sink = (float)inside;
+}
+
+static void
+RunAABBPointsBatch(int iterations)
+{
+	unsigned int inside = 0;
+
+	for(int done=0; done<iterations; done+=NUM_QUERIES){
+		inside += kmAABBContainsPoints(queryHits, queryPoints, 0, NUM_QUERIES, &queryBox);
+	}
+
+	sink = (float)inside;
+}
+
+static void
+RunRayAABBLoop(int iterations)
+{
+	unsigned int hits = 0;
+
+	for(int done=0; done<iterations; done+=NUM_QUERIES){
+		for(int i=0; i<NUM_QUERIES; i++){
+			hits += kmRay3IntersectAABB(&queryRay, &queryBoxes[i], &queryDistances[i]);
+		}
+	}
+
+	sink = (float)hits;
+}
+
+static void
+RunRayAABBBatch(int iterations)
+{
+	unsigned int hits = 0;
+
+	for(int done=0; done<iterations; done+=NUM_QUERIES){
+		hits += kmRay3IntersectAABBs(queryHits, queryDistances, &queryRay, queryBoxes, NUM_QUERIES);
+	}
+
+	sink = (float)hits;
+}
+
+static void
+RunRaySegmentLoop(int iterations)
+{
+	unsigned int hits = 0;
+
+	for(int done=0; done<iterations; done+=NUM_QUERIES){
+		for(int i=0; i<NUM_QUERIES; i++){
+			hits += kmRay2IntersectLineSegment(&queryRay2, &querySegments[2*i], &querySegments[2*i + 1], &queryIntersections[i]);
+		}
+	}
+
+	sink = (float)hits;
+}
+
+static void
+RunRaySegmentBatch(int iterations)
+{
+	unsigned int hits = 0;
+
+	for(int done=0; done<iterations; done+=NUM_QUERIES){
+		hits += kmRay2IntersectLineSegments(queryHits, queryIntersections, &queryRay2, querySegments, NUM_QUERIES);
+	}
+
+	sink = (float)hits;
+}
+
+static void
+RunFrustumLoop(int iterations)
+{
+	unsigned int visible = 0;
+
+	for(int done=0; done<iterations; done+=NUM_QUERIES){
+		for(int i=0; i<NUM_QUERIES; i++){
+			visible += kmAABBIntersectsPlanes(&queryBoxes[i], queryFrustum, 6);
+		}
+	}
+
+	sink = (float)visible;
+}
+
+static void
+RunFrustumBatch(int iterations)
+{
+	unsigned int visible = 0;
+
+	for(int done=0; done<iterations; done+=NUM_QUERIES){
+		visible += kmAABBsIntersectPlanes(queryHits, queryBoxes, NUM_QUERIES, queryFrustum, 6);
+	}
+
+	sink = (float)visible;
+}
+
+static const Kernel kernels[] = {
+	{"mat4multiply", RunMat4Multiply},
+	{"mat4transpose", RunMat4Transpose},
+	{"mat4rotaxis", RunMat4RotationAxisAngle},
+	{"mat4rotquat", RunMat4RotationQuaternion},
+	{"mat4lookat", RunMat4LookAt},
+	{"mat3multiply", RunMat3Multiply},
+	{"mat3inverse", RunMat3Inverse},
+	{"gaussj", RunGaussJordan},
+	{"mat4inverse", RunMat4Inverse},
+	{"mat4inverse-aff", RunMat4InverseOfAffine},
+	{"inverseaffine", RunMat4InverseAffine},
+	{"inverserigid", RunMat4InverseRigid},
+	{"vec3transform", RunVec3Transform},
+	{"vec4transform", RunVec4Transform},
+	{"vec2normalize", RunVec2Normalize},
+	{"vec3normalize", RunVec3Normalize},
+	{"vec3cross", RunVec3Cross},
+	{"vec4dot", RunVec4Dot},
+	{"vec3loop-100k", RunVec3Loop},
+	{"vec3batch-100k", RunVec3Batch},
+	{"vec4batch-100k", RunVec4Batch},
+	{"quatmultiply", RunQuaternionMultiply},
+	{"quatnormalize", RunQuaternionNormalize},
+	{"quatslerp", RunQuaternionSlerp},
+	{"glpushpop", RunGLPushPop},
+	{"scenegraph-mat4", RunSceneGraphMat4},
+	{"scenegraph-3x2", RunSceneGraphMat3x2},
+	{"glnode-mat4", RunGLNodeMat4},
+	{"glnode-3x2", RunGLNodeMat3x2},
+	{"aabbpoints-loop", RunAABBPointsLoop},
+	{"aabbpoints-batch", RunAABBPointsBatch},
+	{"rayaabb-loop", RunRayAABBLoop},
+	{"rayaabb-batch", RunRayAABBBatch},
+	{"raysegment-loop", RunRaySegmentLoop},
+	{"raysegment-batch", RunRaySegmentBatch},
+	{"frustum-loop", RunFrustumLoop},
+	{"frustum-batch", RunFrustumBatch},
+};
+
+#define NUM_KERNELS (int)(sizeof(kernels)/sizeof(*kernels))
+
+//MARK: Result Files
+
+static void
+WriteResult(FILE *file, const Kernel *kernel, double nsPerCall)
+{
+	fprintf(file, "%s %.6f\n", kernel->name, nsPerCall);
+}
+
+// Find the result for a kernel, returns 0 if it couldn't be found.
+static int
+ReadResult(FILE *file, const Kernel *kernel, double *nsPerCall)
+{
+	char name[64];
+
+	rewind(file);
+	while(fscanf(file, "%63s %lf", name, nsPerCall) == 2){
+		if(strcmp(name, kernel->name) == 0) return 1;
+	}
+
+	return 0;
+}
+
+//MARK: Main
+
+static void
+Usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [--kernel name] [--iterations n] [--quick] [--write results.txt | --compare results.txt]\n", name);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *kernelFilter = NULL;
+	const char *writePath = NULL, *comparePath = NULL;
+	int iterations = DEFAULT_ITERATIONS;
+
+	for(int i=1; i<argc; i++){
+		if(strcmp(argv[i], "--kernel") == 0 && i + 1 < argc){
+			kernelFilter = argv[++i];
+		} else if(strcmp(argv[i], "--iterations") == 0 && i + 1 < argc){
+			iterations = atoi(argv[++i]);
+		} else if(strcmp(argv[i], "--quick") == 0){
+			iterations = 1000;
+		} else if(strcmp(argv[i], "--write") == 0 && i + 1 < argc){
+			writePath = argv[++i];
+		} else if(strcmp(argv[i], "--compare") == 0 && i + 1 < argc){
+			comparePath = argv[++i];
+		} else {
+			Usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	FILE *writeFile = (writePath ? fopen(writePath, "w") : NULL);
+	FILE *compareFile = (comparePath ? fopen(comparePath, "r") : NULL);
+	if((writePath && !writeFile) || (comparePath && !compareFile)){
+		fprintf(stderr, "Could not open results file.\n");
+		return EXIT_FAILURE;
+	}
+
+	InitInputs();
+
+#if KM_USE_SSE && defined(__AVX__)
+	printf("kazmath benchmark, SSE kernels with AVX.\n");
+#elif KM_USE_SSE
+	printf("kazmath benchmark, SSE kernels.\n");
+#elif defined(__ARM_NEON__) && !defined(KM_NO_SIMD)
+	printf("kazmath benchmark, NEON kernels.\n");
+#else
+	printf("kazmath benchmark, scalar kernels.\n");
+#endif
+	printf("%-16s %12s %10s %10s %10s  %s\n", "kernel", "iterations", "ns/call", "Mcalls/s", "ref ns", "speedup");
+
+	int ran = 0;
+	for(int i=0; i<NUM_KERNELS; i++){
+		const Kernel *kernel = &kernels[i];
+		if(kernelFilter && strcmp(kernelFilter, kernel->name) != 0) continue;
+
+		// Warm up the caches and branch predictors first.
+		kernel->run(iterations/10 + 1);
+
+		double start = Seconds();
+		kernel->run(iterations);
+		double nsPerCall = 1e9*(Seconds() - start)/(double)iterations;
+
+		if(writeFile) WriteResult(writeFile, kernel, nsPerCall);
+
+		double reference = 0.0;
+		int haveReference = (compareFile && ReadResult(compareFile, kernel, &reference));
+
+		printf("%-16s %12d %10.3f %10.1f", kernel->name, iterations, nsPerCall, nsPerCall > 0.0 ? 1e3/nsPerCall : 0.0);
+		if(haveReference){
+			printf(" %10.3f", reference);
+			if(nsPerCall > 0.0) printf("  %.2fx", reference/nsPerCall);
+		} else {
+			printf(" %10s", "-");
+		}
+
+		printf("\n");
+		fflush(stdout);
+		ran++;
+	}
+
+	if(writeFile) fclose(writeFile);
+	if(compareFile) fclose(compareFile);
+
+	if(!ran){
+		fprintf(stderr, "No kernels matched.\n");
+		Usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -29,7 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "../mat4.h"
 
 typedef struct km_mat4_stack {
-	int capacity; //The total item capacity
+	int capacity; //The total item capacity, doubled when a push finds the stack full
 	int item_count; //The number of items
 	kmMat4* top;
 	kmMat4* stack;
@@ -40,6 +40,7 @@ extern "C" {
 #endif
 
 void km_mat4_stack_initialize(km_mat4_stack* stack);
+void km_mat4_stack_initialize_with_capacity(km_mat4_stack* stack, int capacity);
 void km_mat4_stack_push(km_mat4_stack* stack, const kmMat4* item);
 void km_mat4_stack_pop(km_mat4_stack* stack, kmMat4* pOut);
 void km_mat4_stack_release(km_mat4_stack* stack);
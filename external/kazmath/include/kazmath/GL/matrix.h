@@ -34,11 +34,52 @@ typedef unsigned int kmGLEnum;
 
 #include "../mat4.h"
 #include "../vec3.h"
+#include "../mat3x2.h"
+#include "mat4stack.h"
+
+/*
+A context holds a modelview, projection and texture stack. The kmGLContext
+functions only touch the context they are given, so separate contexts can be
+used from separate threads (to build display lists or transform subtrees on
+worker threads) or for separate render passes.
+
+The kmGL functions without a context act on the current context of the calling
+thread, set with kmGLSetCurrentContext(). Threads that never set one share the
+default context, which is created on first use and freed by kmGLFreeAll().
+
+The modelview_matrix_stack, projection_matrix_stack, texture_matrix_stack and
+current_stack globals were replaced by the default context. Code that used them
+directly should use kmGLGetCurrentContext() instead.
+*/
+typedef struct kmGLContext {
+	km_mat4_stack modelview_matrix_stack;
+	km_mat4_stack projection_matrix_stack;
+	km_mat4_stack texture_matrix_stack;
+	km_mat4_stack* current_stack;
+} kmGLContext;
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+kmGLContext* kmGLContextInitialize(kmGLContext* context, int capacity); /** Each stack gets room for capacity matrices and starts with an identity matrix */
+void kmGLContextRelease(kmGLContext* context);
+
+void kmGLSetCurrentContext(kmGLContext* context); /** Sets the context of the calling thread, NULL selects the default context */
+kmGLContext* kmGLGetCurrentContext(void);
+
+void kmGLContextPushMatrix(kmGLContext* context);
+void kmGLContextPopMatrix(kmGLContext* context);
+void kmGLContextMatrixMode(kmGLContext* context, kmGLEnum mode);
+void kmGLContextLoadIdentity(kmGLContext* context);
+void kmGLContextLoadMatrix(kmGLContext* context, const kmMat4* pIn);
+void kmGLContextMultMatrix(kmGLContext* context, const kmMat4* pIn);
+void kmGLContextMultMatrix3x2(kmGLContext* context, const kmMat3x2* pIn);
+void kmGLContextTranslatef(kmGLContext* context, float x, float y, float z);
+void kmGLContextRotatef(kmGLContext* context, float angle, float x, float y, float z);
+void kmGLContextScalef(kmGLContext* context, float x, float y, float z);
+void kmGLContextGetMatrix(kmGLContext* context, kmGLEnum mode, kmMat4* pOut);
+
 void kmGLFreeAll(void);
 void kmGLPushMatrix(void);
 void kmGLPopMatrix(void);
@@ -46,6 +87,7 @@ void kmGLMatrixMode(kmGLEnum mode);
 void kmGLLoadIdentity(void);
 void kmGLLoadMatrix(const kmMat4* pIn);
 void kmGLMultMatrix(const kmMat4* pIn);
+void kmGLMultMatrix3x2(const kmMat3x2* pIn); /** Multiplies by a 2D affine transform, cheaper than kmGLMultMatrix() */
 void kmGLTranslatef(float x, float y, float z);
 void kmGLRotatef(float angle, float x, float y, float z);
 void kmGLScalef(float x, float y, float z);
@@ -26,9 +26,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef KAZMATH_AABB_H_INCLUDED
 #define KAZMATH_AABB_H_INCLUDED
 
+#include <stddef.h>
+
 #include "vec3.h"
 #include "utility.h"
 
+struct kmPlane;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -45,6 +49,9 @@ typedef struct kmAABB {
 const int kmAABBContainsPoint(const kmVec3* pPoint, const kmAABB* pBox);
 kmAABB* const kmAABBAssign(kmAABB* pOut, const kmAABB* pIn);
 kmAABB* const kmAABBScale(kmAABB* pOut, const kmAABB* pIn, kmScalar s);
+unsigned int kmAABBContainsPoints(kmBool* pOut, const kmVec3* pPoints, size_t stride, unsigned int count, const kmAABB* pBox); /** Tests an array of points, the stride is in bytes */
+const kmBool kmAABBIntersectsPlanes(const kmAABB* pBox, const struct kmPlane* pPlanes, unsigned int numPlanes); /** Returns KM_FALSE if the box is behind any of the planes */
+unsigned int kmAABBsIntersectPlanes(kmBool* pOut, const kmAABB* pBoxes, unsigned int count, const struct kmPlane* pPlanes, unsigned int numPlanes); /** Culls an array of boxes, e.g. against a frustum */
 
 #ifdef __cplusplus
 }
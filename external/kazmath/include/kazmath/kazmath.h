@@ -29,11 +29,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "vec2.h"
 #include "vec3.h"
 #include "mat3.h"
+#include "mat3x2.h"
 #include "mat4.h"
 #include "utility.h"
 #include "quaternion.h"
 #include "plane.h"
 #include "aabb.h"
 #include "ray2.h"
+#include "ray3.h"
 
 #endif // KAZMATH_H_INCLUDED
@@ -0,0 +1,78 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef MAT3X2_H_INCLUDED
+#define MAT3X2_H_INCLUDED
+
+#include <stddef.h>
+
+#include "utility.h"
+
+struct kmVec2;
+struct kmMat4;
+
+/*
+A 2D affine transformation, the top two rows of a 3x3 matrix. It has the same
+layout as a CGAffineTransform (a, b, c, d, tx, ty) and is stored in column
+major format like kmMat4:
+
+mat = | 0  2  4 |      x' = mat[0] * x + mat[2] * y + mat[4]
+      | 1  3  5 |      y' = mat[1] * x + mat[3] * y + mat[5]
+
+Most of a 2D scene graph only needs these 6 floats, use it instead of kmMat4
+to compose and invert node transforms.
+*/
+typedef struct kmMat3x2 {
+	kmScalar mat[6];
+} kmMat3x2;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+kmMat3x2* const kmMat3x2Fill(kmMat3x2* pOut, const kmScalar* pMat);
+kmMat3x2* const kmMat3x2Identity(kmMat3x2* pOut);
+kmMat3x2* const kmMat3x2Assign(kmMat3x2* pOut, const kmMat3x2* pIn);
+const int kmMat3x2IsIdentity(const kmMat3x2* pIn);
+const int kmMat3x2AreEqual(const kmMat3x2* pM1, const kmMat3x2* pM2);
+const kmScalar kmMat3x2Determinant(const kmMat3x2* pIn);
+kmMat3x2* const kmMat3x2Multiply(kmMat3x2* pOut, const kmMat3x2* pM1, const kmMat3x2* pM2);
+kmMat3x2* const kmMat3x2Inverse(kmMat3x2* pOut, const kmMat3x2* pM);
+
+kmMat3x2* const kmMat3x2Translation(kmMat3x2* pOut, const kmScalar x, const kmScalar y);
+kmMat3x2* const kmMat3x2Rotation(kmMat3x2* pOut, const kmScalar radians);
+kmMat3x2* const kmMat3x2Scaling(kmMat3x2* pOut, const kmScalar x, const kmScalar y);
+
+kmMat3x2* const kmMat3x2AssignMat4(kmMat3x2* pOut, const struct kmMat4* pIn); /** Keeps the x and y terms of pIn, the rest is dropped */
+struct kmMat4* const kmMat4AssignMat3x2(struct kmMat4* pOut, const kmMat3x2* pIn); /** Expands pIn to a 4x4 matrix that leaves z and w alone */
+struct kmMat4* const kmMat4MultiplyMat3x2(struct kmMat4* pOut, const struct kmMat4* pM1, const kmMat3x2* pM2); /** Same as multiplying pM1 by the expanded pM2, but cheaper */
+
+struct kmVec2* kmVec2TransformMat3x2(struct kmVec2* pOut, const struct kmVec2* pV, const kmMat3x2* pM);
+struct kmVec2* kmVec2TransformMat3x2Strided(struct kmVec2* pOut, size_t outStride, const struct kmVec2* pV, size_t vStride, const kmMat3x2* pM, unsigned int count); /** Strides are in bytes, 0 means tightly packed */
+
+#ifdef __cplusplus
+}
+#endif
+#endif // MAT3X2_H_INCLUDED
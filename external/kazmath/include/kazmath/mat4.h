@@ -56,6 +56,8 @@ kmMat4* const kmMat4Fill(kmMat4* pOut, const kmScalar* pMat);
 kmMat4* const kmMat4Identity(kmMat4* pOut);
 
 kmMat4* const kmMat4Inverse(kmMat4* pOut, const kmMat4* pM);
+kmMat4* const kmMat4InverseAffine(kmMat4* pOut, const kmMat4* pM);
+kmMat4* const kmMat4InverseRigid(kmMat4* pOut, const kmMat4* pM);
 
 
 const int kmMat4IsIdentity(const kmMat4* pIn);
@@ -58,6 +58,7 @@ const kmScalar kmPlaneDotCoord(const kmPlane* pP, const struct kmVec3* pV);
 const kmScalar kmPlaneDotNormal(const kmPlane* pP, const struct kmVec3* pV);
 kmPlane* const kmPlaneFromPointNormal(kmPlane* pOut, const struct kmVec3* pPoint, const struct kmVec3* pNormal);
 kmPlane* const kmPlaneFromPoints(kmPlane* pOut, const struct kmVec3* p1, const struct kmVec3* p2, const struct kmVec3* p3);
+kmPlane* const kmPlaneExtractFrustum(kmPlane* pOut, const struct kmMat4* pM); /** Fills pOut[6] with the planes of the frustum pM projects, indexed by KM_PLANE_LEFT... */
 kmVec3*  const kmPlaneIntersectLine(struct kmVec3* pOut, const kmPlane* pP, const struct kmVec3* pV1, const struct kmVec3* pV2);
 kmPlane* const kmPlaneNormalize(kmPlane* pOut, const kmPlane* pP);
 kmPlane* const kmPlaneScale(kmPlane* pOut, const kmPlane* pP, kmScalar s);
@@ -0,0 +1,56 @@
+/*
+Copyright (c) 2011, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef RAY_3_H
+#define RAY_3_H
+
+#include "utility.h"
+#include "vec3.h"
+
+struct kmAABB;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+Like kmRay2 the ray starts at start and ends at start + dir, a point on it
+is start + t * dir with 0 <= t <= 1. Unproject a touch at the near and far
+planes to get a ray through the scene.
+*/
+typedef struct kmRay3 {
+    kmVec3 start;
+    kmVec3 dir;
+} kmRay3;
+
+void kmRay3Fill(kmRay3* ray, kmScalar px, kmScalar py, kmScalar pz, kmScalar vx, kmScalar vy, kmScalar vz);
+kmBool kmRay3IntersectAABB(const kmRay3* ray, const struct kmAABB* pBox, kmScalar* pDistance);
+unsigned int kmRay3IntersectAABBs(kmBool* pHits, kmScalar* pDistances, const kmRay3* ray, const struct kmAABB* pBoxes, unsigned int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
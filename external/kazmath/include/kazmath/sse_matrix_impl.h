@@ -0,0 +1,109 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SSE_MATRIX_IMPL_H_INCLUDED
+#define SSE_MATRIX_IMPL_H_INCLUDED
+
+/*
+SSE kernels for x86 and x86-64, the counterpart of neon_matrix_impl.h.
+They are selected at compile time. SSE2 is part of x86-64, and the
+kmMat4Multiply kernel uses AVX when the compiler targets it (-mavx).
+Define KM_NO_SIMD to build the scalar code instead.
+
+Matrixes are stored in column major format like kmMat4. The products
+are accumulated in the same order as the scalar code, so the results
+match it exactly unless the compiler contracts the scalar code into
+fused multiply-adds.
+*/
+
+#if !defined(KM_NO_SIMD) && !defined(__ARM_NEON__) && \
+	(defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define KM_USE_SSE 1
+#else
+	#define KM_USE_SSE 0
+#endif
+
+#if KM_USE_SSE
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Multiplies two 4x4 matrices (a,b) outputing a 4x4 matrix (output = a*b)
+// The output may be the same as a or b.
+void SSE_Matrix4Mul(const float* a, const float* b, float* output);
+
+// Multiplies a 4x4 matrix (m) with a vector 4 (v), outputing a vector 4
+void SSE_Matrix4Vector4Mul(const float* m, const float* v, float* output);
+
+// Transforms the point (v, 1) by a 4x4 matrix (m), outputing a vector 3
+void SSE_Matrix4Vector3Transform(const float* m, const float* v, float* output);
+
+// Transforms count vectors 4 by a 4x4 matrix (m). Strides are in bytes, the output may be the same as the input.
+void SSE_Matrix4Vector4MulStrided(const float* m, const float* v, size_t vStride, float* output, size_t outStride, unsigned int count);
+
+// Transforms count points (v, 1) by a 4x4 matrix (m), outputing vectors 3. Strides are in bytes, the output may be the same as the input.
+void SSE_Matrix4Vector3TransformStrided(const float* m, const float* v, size_t vStride, float* output, size_t outStride, unsigned int count);
+
+// Transforms count vectors 2 by a 2D affine matrix (m, 6 floats in column major order). Strides are in bytes.
+void SSE_Mat3x2Vector2TransformStrided(const float* m, const float* v, size_t vStride, float* output, size_t outStride, unsigned int count);
+
+// Inverts a 4x4 matrix (m) using cofactors. Returns 0 if the matrix is singular.
+int SSE_Matrix4Inverse(const float* m, float* output);
+
+// Multiplies two quaternions stored as x, y, z, w (output = q1*q2)
+void SSE_QuaternionMul(const float* q1, const float* q2, float* output);
+
+/*
+The geometric query kernels below take a kmAABB (box) as min x, y, z
+followed by max x, y, z. Hits are written to out as one KM_TRUE or
+KM_FALSE byte per item and the number of hits is returned. The kernels
+working on boxes or segments do four at a time and only process count
+rounded down to a multiple of four, the caller finishes the rest with
+the scalar code.
+*/
+
+// Tests count points (v, strided in bytes) against a box.
+unsigned int SSE_AABBContainsPoints(const float* box, const float* v, size_t vStride, unsigned char* out, unsigned int count);
+
+// Intersects the ray start + t*dir, 0 <= t <= 1, with count boxes. distances, if not NULL, receives the entry t of each box that is hit.
+unsigned int SSE_AABBsIntersectRay(const float* boxes, unsigned int count, const float* start, const float* dir, unsigned char* out, float* distances);
+
+// Tests count boxes against planes (a, b, c, d), out is KM_FALSE for boxes entirely behind any plane.
+unsigned int SSE_AABBsIntersectPlanes(const float* boxes, unsigned int count, const float* planes, unsigned int numPlanes, unsigned char* out);
+
+// Intersects the 2D ray start + t*dir, 0 <= t <= 1, with count segments stored as point pairs (x1, y1, x2, y2).
+// intersections, if not NULL, receives the intersection point of each segment that is hit.
+unsigned int SSE_Ray2IntersectLineSegments(const float* start, const float* dir, const float* segments, unsigned int count, unsigned char* out, float* intersections);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+#endif /* SSE_MATRIX_IMPL_H_INCLUDED */
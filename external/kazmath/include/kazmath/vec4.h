@@ -26,6 +26,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #ifndef VEC4_H_INCLUDED
 #define VEC4_H_INCLUDED
 
+#include <stddef.h>
+
 #include "utility.h"
 
 struct kmMat4;
@@ -58,6 +60,8 @@ kmVec4* kmVec4Subtract(kmVec4* pOut, const kmVec4* pV1, const kmVec4* pV2);
 kmVec4* kmVec4Transform(kmVec4* pOut, const kmVec4* pV, const struct kmMat4* pM);
 kmVec4* kmVec4TransformArray(kmVec4* pOut, unsigned int outStride,
 			const kmVec4* pV, unsigned int vStride, const struct kmMat4* pM, unsigned int count);
+kmVec4* kmVec4TransformStrided(kmVec4* pOut, size_t outStride,
+			const kmVec4* pV, size_t vStride, const struct kmMat4* pM, unsigned int count);
 int 	kmVec4AreEqual(const kmVec4* p1, const kmVec4* p2);
 kmVec4* kmVec4Assign(kmVec4* pOut, const kmVec4* pIn);
 
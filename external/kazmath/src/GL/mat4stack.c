@@ -26,48 +26,57 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <stdlib.h>
 #include <memory.h>
 #include <assert.h>
-#include <stdio.h>
 
 #define INITIAL_SIZE 30
-#define INCREMENT 50
 
 #include "kazmath/GL/mat4stack.h"
 
 void km_mat4_stack_initialize(km_mat4_stack* stack) {
-	stack->stack = (kmMat4*) malloc(sizeof(kmMat4) * INITIAL_SIZE); //allocate the memory
-	stack->capacity = INITIAL_SIZE; //Set the capacity to 10
+	km_mat4_stack_initialize_with_capacity(stack, INITIAL_SIZE);
+}
+
+void km_mat4_stack_initialize_with_capacity(km_mat4_stack* stack, int capacity) {
+	if(capacity < 1) capacity = 1;
+
+	stack->stack = (kmMat4*) malloc(sizeof(kmMat4) * capacity); //allocate the memory up front
+	stack->capacity = capacity;
 	stack->top = NULL; //Set the top to NULL
 	stack->item_count = 0;
-};
+}
 
 void km_mat4_stack_push(km_mat4_stack* stack, const kmMat4* item)
 {
+    if(stack->item_count == stack->capacity)
+    {
+        //Double the capacity so pushes only allocate a logarithmic number of times
+        int capacity = (stack->capacity ? 2*stack->capacity : INITIAL_SIZE);
+        kmMat4* temp = (kmMat4*) realloc(stack->stack, capacity*sizeof(kmMat4));
+        assert(temp && "Out of memory");
+
+        stack->stack = temp;
+        stack->capacity = capacity;
+    }
+
     stack->top = &stack->stack[stack->item_count];
     kmMat4Assign(stack->top, item);
     stack->item_count++;
-
-    if(stack->item_count >= stack->capacity)
-    {
-		kmMat4* temp = NULL;
-        stack->capacity += INCREMENT;
-        temp = stack->stack;
-        stack->stack = (kmMat4*) malloc(stack->capacity*sizeof(kmMat4));
-        memcpy(stack->stack, temp, sizeof(kmMat4)*(stack->capacity - INCREMENT));
-        free(temp);
-        stack->top = &stack->stack[stack->item_count - 1];
-    }
 }
 
 void km_mat4_stack_pop(km_mat4_stack* stack, kmMat4* pOut)
 {
     assert(stack->item_count && "Cannot pop an empty stack");
 
+    if(pOut) {
+        kmMat4Assign(pOut, stack->top);
+    }
+
     stack->item_count--;
-    stack->top = &stack->stack[stack->item_count - 1];
+    stack->top = (stack->item_count ? &stack->stack[stack->item_count - 1] : NULL);
 }
 
 void km_mat4_stack_release(km_mat4_stack* stack) {
     free(stack->stack);
+	stack->stack = NULL;
 	stack->top = NULL;
 	stack->item_count = 0;
 	stack->capacity = 0;
@@ -29,56 +29,154 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "kazmath/GL/matrix.h"
 #include "kazmath/GL/mat4stack.h"
 
-km_mat4_stack modelview_matrix_stack;
-km_mat4_stack projection_matrix_stack;
-km_mat4_stack texture_matrix_stack;
+#if defined(_WIN32)
+	#include <windows.h>
 
-km_mat4_stack* current_stack = NULL;
+	typedef DWORD km_thread_key;
+	typedef INIT_ONCE km_once;
+	#define KM_ONCE_INIT INIT_ONCE_STATIC_INIT
+#else
+	#include <pthread.h>
 
-static unsigned char initialized = 0;
+	typedef pthread_key_t km_thread_key;
+	typedef pthread_once_t km_once;
+	#define KM_ONCE_INIT PTHREAD_ONCE_INIT
+#endif
 
-void lazyInitialize()
+//Holds the context set by kmGLSetCurrentContext() on each thread, NULL to use the default one
+static km_thread_key context_key;
+
+//The context used by threads that haven't set one, normally the main thread
+static kmGLContext default_context;
+
+static km_once initialize_once = KM_ONCE_INIT;
+
+//Set by kmGLFreeAll(), the default context is recreated if it is used again
+static unsigned char released = 0;
+
+static void initialize(void)
 {
+#if defined(_WIN32)
+	context_key = TlsAlloc();
+#else
+	pthread_key_create(&context_key, NULL);
+#endif
 
-	if (!initialized) {
-		kmMat4 identity; //Temporary identity matrix
+	kmGLContextInitialize(&default_context, 0);
+}
+
+#if defined(_WIN32)
+static BOOL CALLBACK initializeCallback(PINIT_ONCE once, PVOID parameter, PVOID* context)
+{
+	initialize();
+	return TRUE;
+}
+#endif
 
-		//Initialize all 3 stacks
-		//modelview_matrix_stack = (km_mat4_stack*) malloc(sizeof(km_mat4_stack));
-		km_mat4_stack_initialize(&modelview_matrix_stack);
+//Creates the thread key and the default context the first time any thread needs them
+static void initializeOnce(void)
+{
+#if defined(_WIN32)
+	InitOnceExecuteOnce(&initialize_once, initializeCallback, NULL, NULL);
+#else
+	pthread_once(&initialize_once, initialize);
+#endif
+}
 
-		//projection_matrix_stack = (km_mat4_stack*) malloc(sizeof(km_mat4_stack));
-		km_mat4_stack_initialize(&projection_matrix_stack);
+//Kept exported for code written before the contexts were added, the kmGL functions call it themselves
+void lazyInitialize(void)
+{
+	initializeOnce();
 
-		//texture_matrix_stack = (km_mat4_stack*) malloc(sizeof(km_mat4_stack));
-		km_mat4_stack_initialize(&texture_matrix_stack);
+	if (released) {
+		kmGLContextInitialize(&default_context, 0);
+		released = 0;
+	}
+}
 
-		current_stack = &modelview_matrix_stack;
-		initialized = 1;
+static kmGLContext* currentContext(void)
+{
+	initializeOnce();
 
-		kmMat4Identity(&identity);
+#if defined(_WIN32)
+	kmGLContext* context = (kmGLContext*) TlsGetValue(context_key);
+#else
+	kmGLContext* context = (kmGLContext*) pthread_getspecific(context_key);
+#endif
 
-		//Make sure that each stack has the identity matrix
-		km_mat4_stack_push(&modelview_matrix_stack, &identity);
-		km_mat4_stack_push(&projection_matrix_stack, &identity);
-		km_mat4_stack_push(&texture_matrix_stack, &identity);
+	if (!context) {
+		lazyInitialize();
+		context = &default_context;
 	}
+
+	return context;
 }
 
-void kmGLMatrixMode(kmGLEnum mode)
+kmGLContext* kmGLContextInitialize(kmGLContext* context, int capacity)
 {
-	lazyInitialize();
+	kmMat4 identity; //Temporary identity matrix
+
+	//Initialize all 3 stacks, 0 uses the default capacity
+	if (capacity > 0) {
+		km_mat4_stack_initialize_with_capacity(&context->modelview_matrix_stack, capacity);
+		km_mat4_stack_initialize_with_capacity(&context->projection_matrix_stack, capacity);
+		km_mat4_stack_initialize_with_capacity(&context->texture_matrix_stack, capacity);
+	} else {
+		km_mat4_stack_initialize(&context->modelview_matrix_stack);
+		km_mat4_stack_initialize(&context->projection_matrix_stack);
+		km_mat4_stack_initialize(&context->texture_matrix_stack);
+	}
+
+	context->current_stack = &context->modelview_matrix_stack;
+
+	kmMat4Identity(&identity);
+
+	//Make sure that each stack has the identity matrix
+	km_mat4_stack_push(&context->modelview_matrix_stack, &identity);
+	km_mat4_stack_push(&context->projection_matrix_stack, &identity);
+	km_mat4_stack_push(&context->texture_matrix_stack, &identity);
+
+	return context;
+}
+
+void kmGLContextRelease(kmGLContext* context)
+{
+	//Clear the matrix stacks
+	km_mat4_stack_release(&context->modelview_matrix_stack);
+	km_mat4_stack_release(&context->projection_matrix_stack);
+	km_mat4_stack_release(&context->texture_matrix_stack);
+
+	context->current_stack = NULL; //Set the current stack to point nowhere
+}
 
+void kmGLSetCurrentContext(kmGLContext* context)
+{
+	initializeOnce();
+
+#if defined(_WIN32)
+	TlsSetValue(context_key, context);
+#else
+	pthread_setspecific(context_key, context);
+#endif
+}
+
+kmGLContext* kmGLGetCurrentContext(void)
+{
+	return currentContext();
+}
+
+void kmGLContextMatrixMode(kmGLContext* context, kmGLEnum mode)
+{
 	switch(mode)
 	{
 		case KM_GL_MODELVIEW:
-			current_stack = &modelview_matrix_stack;
+			context->current_stack = &context->modelview_matrix_stack;
 		break;
 		case KM_GL_PROJECTION:
-			current_stack = &projection_matrix_stack;
+			context->current_stack = &context->projection_matrix_stack;
 		break;
 		case KM_GL_TEXTURE:
-			current_stack = &texture_matrix_stack;
+			context->current_stack = &context->texture_matrix_stack;
 		break;
 		default:
 			assert(0 && "Invalid matrix mode specified"); //TODO: Proper error handling
@@ -86,89 +184,72 @@ void kmGLMatrixMode(kmGLEnum mode)
 	}
 }
 
-void kmGLPushMatrix(void)
+void kmGLContextPushMatrix(kmGLContext* context)
 {
-	kmMat4 top;
+	km_mat4_stack* stack = context->current_stack;
 
-	lazyInitialize(); //Initialize the stacks if they haven't been already
-
-	//Duplicate the top of the stack (i.e the current matrix)
-	kmMat4Assign(&top, current_stack->top);
-	km_mat4_stack_push(current_stack, &top);
+	//Duplicate the top of the stack (i.e the current matrix). Copy it first, the push may move the stack.
+	kmMat4 top;
+	kmMat4Assign(&top, stack->top);
+	km_mat4_stack_push(stack, &top);
 }
 
-void kmGLPopMatrix(void)
+void kmGLContextPopMatrix(kmGLContext* context)
 {
-    assert(initialized && "Cannot Pop empty matrix stack");
-	//No need to lazy initialize, you shouldnt be popping first anyway!
-	km_mat4_stack_pop(current_stack, NULL);
+	km_mat4_stack_pop(context->current_stack, NULL);
 }
 
-void kmGLLoadIdentity()
+void kmGLContextLoadIdentity(kmGLContext* context)
 {
-	lazyInitialize();
-
-	kmMat4Identity(current_stack->top); //Replace the top matrix with the identity matrix
+	kmMat4Identity(context->current_stack->top); //Replace the top matrix with the identity matrix
 }
 
-void kmGLFreeAll()
+void kmGLContextMultMatrix(kmGLContext* context, const kmMat4* pIn)
 {
-	//Clear the matrix stacks
-	km_mat4_stack_release(&modelview_matrix_stack);
-	km_mat4_stack_release(&projection_matrix_stack);
-	km_mat4_stack_release(&texture_matrix_stack);
-
-	//Delete the matrices
-	initialized = 0; //Set to uninitialized
-
-	current_stack = NULL; //Set the current stack to point nowhere
+	kmMat4Multiply(context->current_stack->top, context->current_stack->top, pIn);
 }
 
-void kmGLMultMatrix(const kmMat4* pIn)
+void kmGLContextMultMatrix3x2(kmGLContext* context, const kmMat3x2* pIn)
 {
-	lazyInitialize();
-	kmMat4Multiply(current_stack->top, current_stack->top, pIn);
+	kmMat4MultiplyMat3x2(context->current_stack->top, context->current_stack->top, pIn);
 }
 
-void kmGLLoadMatrix(const kmMat4* pIn)
+void kmGLContextLoadMatrix(kmGLContext* context, const kmMat4* pIn)
 {
-	lazyInitialize();
-	kmMat4Assign(current_stack->top, pIn);
+	kmMat4Assign(context->current_stack->top, pIn);
 }
 
-void kmGLGetMatrix(kmGLEnum mode, kmMat4* pOut)
+void kmGLContextGetMatrix(kmGLContext* context, kmGLEnum mode, kmMat4* pOut)
 {
-	lazyInitialize();
-
 	switch(mode)
 	{
 		case KM_GL_MODELVIEW:
-			kmMat4Assign(pOut, modelview_matrix_stack.top);
+			kmMat4Assign(pOut, context->modelview_matrix_stack.top);
 		break;
 		case KM_GL_PROJECTION:
-			kmMat4Assign(pOut, projection_matrix_stack.top);
+			kmMat4Assign(pOut, context->projection_matrix_stack.top);
 		break;
 		case KM_GL_TEXTURE:
-			kmMat4Assign(pOut, texture_matrix_stack.top);
+			kmMat4Assign(pOut, context->texture_matrix_stack.top);
 		break;
 		default:
-			assert(1 && "Invalid matrix mode specified"); //TODO: Proper error handling
+			assert(0 && "Invalid matrix mode specified"); //TODO: Proper error handling
 		break;
 	}
 }
 
-void kmGLTranslatef(float x, float y, float z)
+void kmGLContextTranslatef(kmGLContext* context, float x, float y, float z)
 {
 	kmMat4 translation;
 
-	//Create a rotation matrix using the axis and the angle
+	//Create a translation matrix
 	kmMat4Translation(&translation,x,y,z);
 
-	//Multiply the rotation matrix by the current matrix
-	kmMat4Multiply(current_stack->top, current_stack->top, &translation);
+	//Multiply the translation matrix by the current matrix
+	kmMat4Multiply(context->current_stack->top, context->current_stack->top, &translation);
 }
 
-void kmGLRotatef(float angle, float x, float y, float z)
+void kmGLContextRotatef(kmGLContext* context, float angle, float x, float y, float z)
 {
 	kmVec3 axis;
 	kmMat4 rotation;
@@ -180,12 +261,80 @@ void kmGLRotatef(float angle, float x, float y, float z)
 	kmMat4RotationAxisAngle(&rotation, &axis, kmDegreesToRadians(angle));
 
 	//Multiply the rotation matrix by the current matrix
-	kmMat4Multiply(current_stack->top, current_stack->top, &rotation);
+	kmMat4Multiply(context->current_stack->top, context->current_stack->top, &rotation);
 }
 
-void kmGLScalef(float x, float y, float z)
+void kmGLContextScalef(kmGLContext* context, float x, float y, float z)
 {
 	kmMat4 scaling;
 	kmMat4Scaling(&scaling, x, y, z);
-	kmMat4Multiply(current_stack->top, current_stack->top, &scaling);
+	kmMat4Multiply(context->current_stack->top, context->current_stack->top, &scaling);
+}
+
+//The global API acts on the current context of the calling thread
+
+void kmGLMatrixMode(kmGLEnum mode)
+{
+	kmGLContextMatrixMode(currentContext(), mode);
+}
+
+void kmGLPushMatrix(void)
+{
+	kmGLContextPushMatrix(currentContext());
+}
+
+void kmGLPopMatrix(void)
+{
+	kmGLContextPopMatrix(currentContext());
+}
+
+void kmGLLoadIdentity()
+{
+	kmGLContextLoadIdentity(currentContext());
+}
+
+void kmGLFreeAll()
+{
+	//Only the default context is owned here, contexts set with kmGLSetCurrentContext() are released by their owners
+	initializeOnce();
+
+	if (!released) {
+		kmGLContextRelease(&default_context);
+		released = 1;
+	}
+}
+
+void kmGLMultMatrix(const kmMat4* pIn)
+{
+	kmGLContextMultMatrix(currentContext(), pIn);
+}
+
+void kmGLMultMatrix3x2(const kmMat3x2* pIn)
+{
+	kmGLContextMultMatrix3x2(currentContext(), pIn);
+}
+
+void kmGLLoadMatrix(const kmMat4* pIn)
+{
+	kmGLContextLoadMatrix(currentContext(), pIn);
+}
+
+void kmGLGetMatrix(kmGLEnum mode, kmMat4* pOut)
+{
+	kmGLContextGetMatrix(currentContext(), mode, pOut);
+}
+
+void kmGLTranslatef(float x, float y, float z)
+{
+	kmGLContextTranslatef(currentContext(), x, y, z);
+}
+
+void kmGLRotatef(float angle, float x, float y, float z)
+{
+	kmGLContextRotatef(currentContext(), angle, x, y, z);
+}
+
+void kmGLScalef(float x, float y, float z)
+{
+	kmGLContextScalef(currentContext(), x, y, z);
 }
@@ -24,6 +24,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "kazmath/aabb.h"
+#include "kazmath/plane.h"
+#include "kazmath/sse_matrix_impl.h"
 
 /**
  * Returns KM_TRUE if point is in the specified AABB, returns
@@ -59,5 +61,79 @@ kmAABB* const kmAABBScale(kmAABB* pOut, const kmAABB* pIn, kmScalar s)
 	return 0;
 }
 
+/**
+ * Tests count points against the box, pOut receives KM_TRUE for the
+ * points inside it and KM_FALSE for the others. The points may be part
+ * of larger structures (e.g. vertices), stride is the distance in bytes
+ * between them, or 0 if they are packed. Returns the number of points
+ * inside.
+ */
+unsigned int kmAABBContainsPoints(kmBool* pOut, const kmVec3* pPoints, size_t stride, unsigned int count, const kmAABB* pBox)
+{
+    if(stride == 0) stride = sizeof(kmVec3);
+
+#if KM_USE_SSE
+    return SSE_AABBContainsPoints(&pBox->min.x, &pPoints->x, stride, pOut, count);
+#else
+    const char* in = (const char*)pPoints;
+    unsigned int inside = 0;
+    unsigned int i;
+
+    for(i = 0; i < count; ++i, in += stride) {
+        pOut[i] = (kmBool)kmAABBContainsPoint((const kmVec3*)in, pBox);
+        inside += pOut[i];
+    }
+
+    return inside;
+#endif
+}
+
+/**
+ * Returns KM_FALSE if the box is entirely behind one of the planes, KM_TRUE
+ * otherwise. The planes must face inwards like the ones from
+ * kmPlaneExtractFrustum(), then KM_FALSE means the box is outside the
+ * frustum and can be culled. Boxes near a frustum corner may be kept even
+ * though they are outside.
+ */
+const kmBool kmAABBIntersectsPlanes(const kmAABB* pBox, const kmPlane* pPlanes, unsigned int numPlanes)
+{
+    unsigned int i;
+
+    for(i = 0; i < numPlanes; ++i) {
+        const kmPlane* p = &pPlanes[i];
 
+        //The corner furthest along the normal, if it's behind the whole box is
+        kmScalar x = (p->a >= 0.0f) ? pBox->max.x : pBox->min.x;
+        kmScalar y = (p->b >= 0.0f) ? pBox->max.y : pBox->min.y;
+        kmScalar z = (p->c >= 0.0f) ? pBox->max.z : pBox->min.z;
 
+        if(p->a * x + p->b * y + p->c * z + p->d < 0.0f) {
+            return KM_FALSE;
+        }
+    }
+
+    return KM_TRUE;
+}
+
+/**
+ * Tests count boxes against the planes like kmAABBIntersectsPlanes(), pOut
+ * receives the result for each box. Returns the number of boxes that
+ * aren't culled.
+ */
+unsigned int kmAABBsIntersectPlanes(kmBool* pOut, const kmAABB* pBoxes, unsigned int count, const kmPlane* pPlanes, unsigned int numPlanes)
+{
+    unsigned int i = 0;
+    unsigned int visible = 0;
+
+#if KM_USE_SSE
+    visible = SSE_AABBsIntersectPlanes(&pBoxes->min.x, count, &pPlanes->a, numPlanes, pOut);
+    i = count & ~3u;
+#endif
+
+    for(; i < count; ++i) {
+        pOut[i] = kmAABBIntersectsPlanes(&pBoxes[i], pPlanes, numPlanes);
+        visible += pOut[i];
+    }
+
+    return visible;
+}
@@ -74,9 +74,7 @@ kmMat3* const kmMat3Adjugate(kmMat3* pOut, const kmMat3* pIn)
     pOut->mat[4] = pIn->mat[0] * pIn->mat[8] - pIn->mat[2] * pIn->mat[6];
     pOut->mat[5] = pIn->mat[2] * pIn->mat[3] - pIn->mat[0] * pIn->mat[5];
     pOut->mat[6] = pIn->mat[3] * pIn->mat[7] - pIn->mat[4] * pIn->mat[6];
-
-	// XXX: pIn->mat[9] is invalid!
-//    pOut->mat[7] = pIn->mat[1] * pIn->mat[6] - pIn->mat[9] * pIn->mat[7];
+    pOut->mat[7] = pIn->mat[1] * pIn->mat[6] - pIn->mat[0] * pIn->mat[7];
     pOut->mat[8] = pIn->mat[0] * pIn->mat[4] - pIn->mat[1] * pIn->mat[3];
 
     return pOut;
@@ -243,19 +241,19 @@ kmMat3* const kmMat3RotationQuaternion(kmMat3* pOut, const kmQuaternion* pIn)
 	return NULL;
     }
 
-    // First row
+    // First column, same layout as kmMat4RotationQuaternion()
     pOut->mat[0] = 1.0f - 2.0f * (pIn->y * pIn->y + pIn->z * pIn->z);
-    pOut->mat[1] = 2.0f * (pIn->x * pIn->y - pIn->w * pIn->z);
-    pOut->mat[2] = 2.0f * (pIn->x * pIn->z + pIn->w * pIn->y);
+    pOut->mat[1] = 2.0f * (pIn->x * pIn->y + pIn->w * pIn->z);
+    pOut->mat[2] = 2.0f * (pIn->x * pIn->z - pIn->w * pIn->y);
 
-    // Second row
-    pOut->mat[3] = 2.0f * (pIn->x * pIn->y + pIn->w * pIn->z);
+    // Second column
+    pOut->mat[3] = 2.0f * (pIn->x * pIn->y - pIn->w * pIn->z);
     pOut->mat[4] = 1.0f - 2.0f * (pIn->x * pIn->x + pIn->z * pIn->z);
-    pOut->mat[5] = 2.0f * (pIn->y * pIn->z - pIn->w * pIn->x);
+    pOut->mat[5] = 2.0f * (pIn->y * pIn->z + pIn->w * pIn->x);
 
-    // Third row
-    pOut->mat[6] = 2.0f * (pIn->x * pIn->z - pIn->w * pIn->y);
-    pOut->mat[7] = 2.0f * (pIn->y * pIn->z + pIn->w * pIn->x);
+    // Third column
+    pOut->mat[6] = 2.0f * (pIn->x * pIn->z + pIn->w * pIn->y);
+    pOut->mat[7] = 2.0f * (pIn->y * pIn->z - pIn->w * pIn->x);
     pOut->mat[8] = 1.0f - 2.0f * (pIn->x * pIn->x + pIn->y * pIn->y);
 
     return pOut;
@@ -357,10 +355,10 @@ kmMat3* const kmMat3RotationZ(kmMat3* pOut, const float radians)
 	*/
 
 	pOut->mat[0] = cosf(radians);
-	pOut->mat[1] =-sinf(radians);
+	pOut->mat[1] = sinf(radians);
 	pOut->mat[2] = 0.0f;
 
-	pOut->mat[3] = sinf(radians);;
+	pOut->mat[3] = -sinf(radians);
 	pOut->mat[4] = cosf(radians);
 	pOut->mat[5] = 0.0f;
 
@@ -0,0 +1,245 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <memory.h>
+#include <math.h>
+
+#include "kazmath/utility.h"
+#include "kazmath/vec2.h"
+#include "kazmath/mat4.h"
+#include "kazmath/mat3x2.h"
+#include "kazmath/sse_matrix_impl.h"
+
+kmMat3x2* const kmMat3x2Fill(kmMat3x2* pOut, const kmScalar* pMat)
+{
+	memcpy(pOut->mat, pMat, sizeof(kmScalar) * 6);
+	return pOut;
+}
+
+/** Sets pOut to an identity matrix returns pOut*/
+kmMat3x2* const kmMat3x2Identity(kmMat3x2* pOut)
+{
+	pOut->mat[0] = 1.0f; pOut->mat[2] = 0.0f; pOut->mat[4] = 0.0f;
+	pOut->mat[1] = 0.0f; pOut->mat[3] = 1.0f; pOut->mat[5] = 0.0f;
+	return pOut;
+}
+
+kmMat3x2* const kmMat3x2Assign(kmMat3x2* pOut, const kmMat3x2* pIn)
+{
+	if (pOut != pIn) {
+		memcpy(pOut->mat, pIn->mat, sizeof(kmScalar) * 6);
+	}
+
+	return pOut;
+}
+
+const int kmMat3x2IsIdentity(const kmMat3x2* pIn)
+{
+	static const kmScalar identity[] = {1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f};
+
+	return (memcmp(identity, pIn->mat, sizeof(kmScalar) * 6) == 0);
+}
+
+/** Returns true if the 2 matrices are equal (approximately) */
+const int kmMat3x2AreEqual(const kmMat3x2* pM1, const kmMat3x2* pM2)
+{
+	int i;
+
+	for (i = 0; i < 6; ++i) {
+		if (!(pM1->mat[i] + kmEpsilon > pM2->mat[i] && pM1->mat[i] - kmEpsilon < pM2->mat[i])) {
+			return KM_FALSE;
+		}
+	}
+
+	return KM_TRUE;
+}
+
+/** The determinant of the linear part, the translation doesn't change it */
+const kmScalar kmMat3x2Determinant(const kmMat3x2* pIn)
+{
+	return pIn->mat[0] * pIn->mat[3] - pIn->mat[2] * pIn->mat[1];
+}
+
+/** Sets pOut to pM1 * pM2 (pM2 is applied first), pOut may be either input */
+kmMat3x2* const kmMat3x2Multiply(kmMat3x2* pOut, const kmMat3x2* pM1, const kmMat3x2* pM2)
+{
+	const kmScalar *m1 = pM1->mat, *m2 = pM2->mat;
+
+	kmScalar a = m1[0] * m2[0] + m1[2] * m2[1];
+	kmScalar b = m1[1] * m2[0] + m1[3] * m2[1];
+	kmScalar c = m1[0] * m2[2] + m1[2] * m2[3];
+	kmScalar d = m1[1] * m2[2] + m1[3] * m2[3];
+	kmScalar tx = m1[0] * m2[4] + m1[2] * m2[5] + m1[4];
+	kmScalar ty = m1[1] * m2[4] + m1[3] * m2[5] + m1[5];
+
+	pOut->mat[0] = a; pOut->mat[2] = c; pOut->mat[4] = tx;
+	pOut->mat[1] = b; pOut->mat[3] = d; pOut->mat[5] = ty;
+	return pOut;
+}
+
+/**
+ * Calculates the inverse of pM and stores the result in pOut.
+ * @Return Returns NULL if there is no inverse, else pOut
+ */
+kmMat3x2* const kmMat3x2Inverse(kmMat3x2* pOut, const kmMat3x2* pM)
+{
+	const kmScalar *m = pM->mat;
+	kmScalar det = kmMat3x2Determinant(pM);
+
+	if (det == 0.0f || !isfinite(1.0f / det)) {
+		return NULL;
+	}
+
+	kmScalar invDet = 1.0f / det;
+	kmScalar a = m[3] * invDet;
+	kmScalar b = -m[1] * invDet;
+	kmScalar c = -m[2] * invDet;
+	kmScalar d = m[0] * invDet;
+	kmScalar tx = -(a * m[4] + c * m[5]);
+	kmScalar ty = -(b * m[4] + d * m[5]);
+
+	pOut->mat[0] = a; pOut->mat[2] = c; pOut->mat[4] = tx;
+	pOut->mat[1] = b; pOut->mat[3] = d; pOut->mat[5] = ty;
+	return pOut;
+}
+
+kmMat3x2* const kmMat3x2Translation(kmMat3x2* pOut, const kmScalar x, const kmScalar y)
+{
+	kmMat3x2Identity(pOut);
+	pOut->mat[4] = x;
+	pOut->mat[5] = y;
+	return pOut;
+}
+
+/** Builds a counter clockwise rotation, like kmMat4RotationZ() */
+kmMat3x2* const kmMat3x2Rotation(kmMat3x2* pOut, const kmScalar radians)
+{
+	kmScalar c = cosf(radians), s = sinf(radians);
+
+	pOut->mat[0] = c; pOut->mat[2] = -s; pOut->mat[4] = 0.0f;
+	pOut->mat[1] = s; pOut->mat[3] = c; pOut->mat[5] = 0.0f;
+	return pOut;
+}
+
+kmMat3x2* const kmMat3x2Scaling(kmMat3x2* pOut, const kmScalar x, const kmScalar y)
+{
+	pOut->mat[0] = x; pOut->mat[2] = 0.0f; pOut->mat[4] = 0.0f;
+	pOut->mat[1] = 0.0f; pOut->mat[3] = y; pOut->mat[5] = 0.0f;
+	return pOut;
+}
+
+kmMat3x2* const kmMat3x2AssignMat4(kmMat3x2* pOut, const kmMat4* pIn)
+{
+	pOut->mat[0] = pIn->mat[0]; pOut->mat[2] = pIn->mat[4]; pOut->mat[4] = pIn->mat[12];
+	pOut->mat[1] = pIn->mat[1]; pOut->mat[3] = pIn->mat[5]; pOut->mat[5] = pIn->mat[13];
+	return pOut;
+}
+
+kmMat4* const kmMat4AssignMat3x2(kmMat4* pOut, const kmMat3x2* pIn)
+{
+	// | m[0] m[4] m[8]  m[12] |     | a c 0 tx |
+	// | m[1] m[5] m[9]  m[13] |     | b d 0 ty |
+	// | m[2] m[6] m[10] m[14] | <=> | 0 0 1  0 |
+	// | m[3] m[7] m[11] m[15] |     | 0 0 0  1 |
+
+	kmMat4Identity(pOut);
+	pOut->mat[0] = pIn->mat[0]; pOut->mat[4] = pIn->mat[2]; pOut->mat[12] = pIn->mat[4];
+	pOut->mat[1] = pIn->mat[1]; pOut->mat[5] = pIn->mat[3]; pOut->mat[13] = pIn->mat[5];
+	return pOut;
+}
+
+/**
+ * Multiplies pM1 by pM2 expanded to a 4x4 matrix, stores the result in pOut
+ * and returns pOut. Only the first, second and last columns of pM1 change, so
+ * this takes 24 multiplications instead of the 64 of kmMat4Multiply().
+ * pOut may be the same as pM1.
+ */
+kmMat4* const kmMat4MultiplyMat3x2(kmMat4* pOut, const kmMat4* pM1, const kmMat3x2* pM2)
+{
+	const kmScalar *m1 = pM1->mat, *m2 = pM2->mat;
+	kmScalar a = m2[0], b = m2[1], c = m2[2], d = m2[3], tx = m2[4], ty = m2[5];
+	kmScalar col0[4], col1[4], col3[4];
+	int i;
+
+	for (i = 0; i < 4; ++i) {
+		col0[i] = m1[i] * a + m1[i + 4] * b;
+		col1[i] = m1[i] * c + m1[i + 4] * d;
+		col3[i] = m1[i] * tx + m1[i + 4] * ty + m1[i + 12];
+	}
+
+	if (pOut != pM1) {
+		memcpy(&pOut->mat[8], &m1[8], sizeof(kmScalar) * 4);
+	}
+
+	memcpy(&pOut->mat[0], col0, sizeof(kmScalar) * 4);
+	memcpy(&pOut->mat[4], col1, sizeof(kmScalar) * 4);
+	memcpy(&pOut->mat[12], col3, sizeof(kmScalar) * 4);
+	return pOut;
+}
+
+kmVec2* kmVec2TransformMat3x2(kmVec2* pOut, const kmVec2* pV, const kmMat3x2* pM)
+{
+	const kmScalar *m = pM->mat;
+	kmScalar x = pV->x * m[0] + pV->y * m[2] + m[4];
+	kmScalar y = pV->x * m[1] + pV->y * m[3] + m[5];
+
+	pOut->x = x;
+	pOut->y = y;
+	return pOut;
+}
+
+/**
+ * Transforms count vectors by pM. The strides are the distances in bytes between
+ * consecutive vectors, 0 means they are tightly packed. Only the two floats of each
+ * output vector are written, so the positions of 3D vertices can be transformed in
+ * place without touching z. pOut is returned.
+ */
+kmVec2* kmVec2TransformMat3x2Strided(kmVec2* pOut, size_t outStride, const kmVec2* pV, size_t vStride, const kmMat3x2* pM, unsigned int count)
+{
+	if (outStride == 0) outStride = sizeof(kmVec2);
+	if (vStride == 0) vStride = sizeof(kmVec2);
+
+#if KM_USE_SSE
+	SSE_Mat3x2Vector2TransformStrided(&pM->mat[0], &pV->x, vStride, &pOut->x, outStride, count);
+#else
+	const kmScalar *m = pM->mat;
+	const char *in = (const char*)pV;
+	char *out = (char*)pOut;
+	unsigned int i;
+
+	for (i = 0; i < count; ++i, in += vStride, out += outStride) {
+		const kmVec2 *v = (const kmVec2*)in;
+		kmVec2 *o = (kmVec2*)out;
+
+		kmScalar x = v->x * m[0] + v->y * m[2] + m[4];
+		kmScalar y = v->x * m[1] + v->y * m[3] + m[5];
+
+		o->x = x;
+		o->y = y;
+	}
+#endif
+
+	return pOut;
+}
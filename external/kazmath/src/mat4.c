@@ -29,6 +29,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <memory.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <math.h>
 
 #include "kazmath/utility.h"
 #include "kazmath/vec3.h"
@@ -38,6 +39,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "kazmath/plane.h"
 
 #include "kazmath/neon_matrix_impl.h"
+#include "kazmath/sse_matrix_impl.h"
 
 /**
  * Fills a kmMat4 structure with the values from a 16
@@ -83,6 +85,7 @@ void swap(kmMat4 * pIn, int r1, int c1, int r2, int c2)
 }
 
 //Returns an upper and a lower triangular matrix which are L and R in the Gauss algorithm
+//No longer used by kmMat4Inverse(), kept for compatibility and as the benchmark baseline.
 int gaussj(kmMat4 *a, kmMat4 *b)
 {
     int i, icol = 0, irow = 0, j, k, l, ll, n = 4, m = 4;
@@ -161,24 +164,178 @@ int gaussj(kmMat4 *a, kmMat4 *b)
 
 /**
  * Calculates the inverse of pM and stores the result in
- * pOut.
+ * pOut. Affine matrices (bottom row 0, 0, 0, 1) are inverted
+ * with kmMat4InverseAffine(), others using cofactors.
  * @Return Returns NULL if there is no inverse, else pOut
  */
 kmMat4* const kmMat4Inverse(kmMat4* pOut, const kmMat4* pM)
 {
-    kmMat4 inv;
-    kmMat4Assign(&inv, pM);
+    if(pM->mat[3] == 0.0f && pM->mat[7] == 0.0f && pM->mat[11] == 0.0f && pM->mat[15] == 1.0f) {
+        return kmMat4InverseAffine(pOut, pM);
+    }
+
+#if KM_USE_SSE
+
+    float mat[16];
+
+    if(!SSE_Matrix4Inverse(&pM->mat[0], &mat[0])) {
+        return NULL;
+    }
+
+    memcpy(pOut->mat, mat, sizeof(float)*16);
+    return pOut;
+
+#else
+    /*
+        The inverse is the adjugate divided by the determinant. The cofactors are
+        built from the 2x2 determinants of the first two (s) and last two (c)
+        columns. The formula is written for row major matrices, but as the inverse
+        of the transpose is the transpose of the inverse it works unchanged.
+    */
+    const float *m = pM->mat;
+    float *inv = pOut->mat;
+
+    // Results are written straight to pOut, copy the input if it is the same matrix.
+    kmMat4 copy;
+    if(pOut == pM) {
+        copy = *pM;
+        m = copy.mat;
+    }
+
+    float s0 = m[0] * m[5] - m[4] * m[1];
+    float s1 = m[0] * m[6] - m[4] * m[2];
+    float s2 = m[0] * m[7] - m[4] * m[3];
+    float s3 = m[1] * m[6] - m[5] * m[2];
+    float s4 = m[1] * m[7] - m[5] * m[3];
+    float s5 = m[2] * m[7] - m[6] * m[3];
+
+    float c5 = m[10] * m[15] - m[14] * m[11];
+    float c4 = m[9] * m[15] - m[13] * m[11];
+    float c3 = m[9] * m[14] - m[13] * m[10];
+    float c2 = m[8] * m[15] - m[12] * m[11];
+    float c1 = m[8] * m[14] - m[12] * m[10];
+    float c0 = m[8] * m[13] - m[12] * m[9];
+
+    float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+    // Like the SSE version only reject matrices that are exactly singular or whose inverse would overflow.
+    if(det == 0.0f || !isfinite(1.0f / det)) {
+        return NULL;
+    }
+
+    float invDet = 1.0f / det;
+
+    inv[0] = ( m[5] * c5 - m[6] * c4 + m[7] * c3) * invDet;
+    inv[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * invDet;
+    inv[2] = ( m[13] * s5 - m[14] * s4 + m[15] * s3) * invDet;
+    inv[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * invDet;
+
+    inv[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * invDet;
+    inv[5] = ( m[0] * c5 - m[2] * c2 + m[3] * c1) * invDet;
+    inv[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * invDet;
+    inv[7] = ( m[8] * s5 - m[10] * s2 + m[11] * s1) * invDet;
+
+    inv[8] = ( m[4] * c4 - m[5] * c2 + m[7] * c0) * invDet;
+    inv[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * invDet;
+    inv[10] = ( m[12] * s4 - m[13] * s2 + m[15] * s0) * invDet;
+    inv[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * invDet;
+
+    inv[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * invDet;
+    inv[13] = ( m[0] * c3 - m[1] * c1 + m[2] * c0) * invDet;
+    inv[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * invDet;
+    inv[15] = ( m[8] * s3 - m[9] * s1 + m[10] * s0) * invDet;
+
+    return pOut;
+#endif
+}
+
+/**
+ * Calculates the inverse of an affine matrix (one whose bottom row
+ * is 0, 0, 0, 1, such as any combination of translations, rotations
+ * and scales) and stores the result in pOut. Only the upper 3x3 part
+ * is inverted, the translation is then transformed by it. The bottom
+ * row of pM is not checked.
+ * @Return Returns NULL if there is no inverse, else pOut
+ */
+kmMat4* const kmMat4InverseAffine(kmMat4* pOut, const kmMat4* pM)
+{
+    const float *m = pM->mat;
+    float *inv = pOut->mat;
+
+    kmMat4 copy;
+    if(pOut == pM) {
+        copy = *pM;
+        m = copy.mat;
+    }
 
-    kmMat4 tmp;
-    kmMat4Identity(&tmp);
+    // The rows of the inverse of the 3x3 part are the cross products of its columns divided by the determinant.
+    float r0x = m[5] * m[10] - m[6] * m[9];
+    float r0y = m[6] * m[8] - m[4] * m[10];
+    float r0z = m[4] * m[9] - m[5] * m[8];
 
-    if(gaussj(&inv, &tmp) == KM_FALSE) {
+    float det = m[0] * r0x + m[1] * r0y + m[2] * r0z;
+    if(det == 0.0f || !isfinite(1.0f / det)) {
         return NULL;
     }
 
-    kmMat4Assign(pOut, &inv);
+    float invDet = 1.0f / det;
+
+    float r1x = m[9] * m[2] - m[10] * m[1];
+    float r1y = m[10] * m[0] - m[8] * m[2];
+    float r1z = m[8] * m[1] - m[9] * m[0];
+
+    float r2x = m[1] * m[6] - m[2] * m[5];
+    float r2y = m[2] * m[4] - m[0] * m[6];
+    float r2z = m[0] * m[5] - m[1] * m[4];
+
+    float tx = m[12], ty = m[13], tz = m[14];
+
+    inv[0] = r0x * invDet; inv[4] = r0y * invDet; inv[8] = r0z * invDet;
+    inv[1] = r1x * invDet; inv[5] = r1y * invDet; inv[9] = r1z * invDet;
+    inv[2] = r2x * invDet; inv[6] = r2y * invDet; inv[10] = r2z * invDet;
+
+    inv[12] = -(inv[0] * tx + inv[4] * ty + inv[8] * tz);
+    inv[13] = -(inv[1] * tx + inv[5] * ty + inv[9] * tz);
+    inv[14] = -(inv[2] * tx + inv[6] * ty + inv[10] * tz);
+
+    inv[3] = inv[7] = inv[11] = 0.0f;
+    inv[15] = 1.0f;
+
     return pOut;
 }
+
+/**
+ * Calculates the inverse of a rigid transformation (a rotation
+ * followed by a translation, without scaling) and stores the result
+ * in pOut. The rotation is simply transposed, so the result is only
+ * correct if the upper 3x3 part of pM is orthonormal.
+ * Returns pOut.
+ */
+kmMat4* const kmMat4InverseRigid(kmMat4* pOut, const kmMat4* pM)
+{
+    const float *m = pM->mat;
+    float *inv = pOut->mat;
+
+    kmMat4 copy;
+    if(pOut == pM) {
+        copy = *pM;
+        m = copy.mat;
+    }
+
+    inv[0] = m[0]; inv[4] = m[1]; inv[8] = m[2];
+    inv[1] = m[4]; inv[5] = m[5]; inv[9] = m[6];
+    inv[2] = m[8]; inv[6] = m[9]; inv[10] = m[10];
+
+    inv[12] = -(m[0] * m[12] + m[1] * m[13] + m[2] * m[14]);
+    inv[13] = -(m[4] * m[12] + m[5] * m[13] + m[6] * m[14]);
+    inv[14] = -(m[8] * m[12] + m[9] * m[13] + m[10] * m[14]);
+
+    inv[3] = inv[7] = inv[11] = 0.0f;
+    inv[15] = 1.0f;
+
+    return pOut;
+}
+
 /**
  * Returns KM_TRUE if pIn is an identity matrix
  * KM_FALSE otherwise
@@ -215,13 +372,20 @@ kmMat4* const kmMat4Transpose(kmMat4* pOut, const kmMat4* pIn)
  */
 kmMat4* const kmMat4Multiply(kmMat4* pOut, const kmMat4* pM1, const kmMat4* pM2)
 {
-#if defined(__ARM_NEON__)
+#if defined(__ARM_NEON__) && !defined(KM_NO_SIMD)
 
 	float mat[16];
 
 	// Invert column-order with row-order
 	NEON_Matrix4Mul( &pM2->mat[0], &pM1->mat[0], &mat[0] );
 
+#elif KM_USE_SSE
+
+	// Safe when pOut aliases an input, SSE_Matrix4Mul() reads each column before writing it.
+	SSE_Matrix4Mul( &pM1->mat[0], &pM2->mat[0], &pOut->mat[0] );
+
+	return pOut;
+
 #else
 	float mat[16];
 
@@ -249,9 +413,11 @@ kmMat4* const kmMat4Multiply(kmMat4* pOut, const kmMat4* pM1, const kmMat4* pM2)
 
 #endif
 
+#if !KM_USE_SSE || (defined(__ARM_NEON__) && !defined(KM_NO_SIMD))
 	memcpy(pOut->mat, mat, sizeof(float)*16);
 
 	return pOut;
+#endif
 }
 
 /**
@@ -457,6 +623,7 @@ kmMat4* const kmMat4RotationPitchYawRoll(kmMat4* pOut, const kmScalar pitch, con
 	pOut->mat[10] = (kmScalar) cr * cp;
 
 	pOut->mat[3] = pOut->mat[7] = pOut->mat[11] = 0.0;
+	pOut->mat[12] = pOut->mat[13] = pOut->mat[14] = 0.0;
 	pOut->mat[15] = 1.0;
 
 	return pOut;
@@ -28,6 +28,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "kazmath/vec3.h"
 #include "kazmath/vec4.h"
+#include "kazmath/mat4.h"
 #include "kazmath/plane.h"
 
 const kmScalar kmPlaneDot(const kmPlane* pP, const kmVec4* pV)
@@ -102,6 +103,23 @@ kmPlane* const kmPlaneFromPoints(kmPlane* pOut, const kmVec3* p1, const kmVec3*
     return pOut;
 }
 
+/**
+ * Extracts the six clip planes of pM, a projection or projection * view
+ * matrix, into pOut which must have room for 6 planes, see
+ * kmMat4ExtractPlane(). The planes are normalized and face inwards, a point
+ * is inside the frustum when it's in front of all of them. Returns pOut.
+ */
+kmPlane* const kmPlaneExtractFrustum(kmPlane* pOut, const kmMat4* pM)
+{
+    kmEnum plane;
+
+    for(plane = KM_PLANE_LEFT; plane <= KM_PLANE_FAR; ++plane) {
+        kmMat4ExtractPlane(&pOut[plane], pM, plane);
+    }
+
+    return pOut;
+}
+
 kmVec3* const kmPlaneIntersectLine(kmVec3* pOut, const kmPlane* pP, const kmVec3* pV1, const kmVec3* pV2)
 {
     /*
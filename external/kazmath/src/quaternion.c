@@ -31,6 +31,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "kazmath/mat3.h"
 #include "kazmath/vec3.h"
 #include "kazmath/quaternion.h"
+#include "kazmath/sse_matrix_impl.h"
 
 ///< Returns pOut, sets pOut to the conjugate of pIn
 kmQuaternion* const kmQuaternionConjugate(kmQuaternion* pOut, const kmQuaternion* pIn)
@@ -80,7 +81,7 @@ kmQuaternion* kmQuaternionInverse(kmQuaternion* pOut,
 	kmScalar l = kmQuaternionLength(pIn);
     kmQuaternion tmp;
 
-	if (fabs(l) > kmEpsilon)
+	if (fabs(l) < kmEpsilon)
 	{
 		pOut->x = 0.0;
 		pOut->y = 0.0;
@@ -92,9 +93,9 @@ kmQuaternion* kmQuaternionInverse(kmQuaternion* pOut,
 
 
 
-	///Get the conjugute and divide by the length
+	///Get the conjugute and divide by the length squared
 	kmQuaternionScale(pOut,
-				kmQuaternionConjugate(&tmp, pIn), 1.0f / l);
+				kmQuaternionConjugate(&tmp, pIn), 1.0f / (l * l));
 
 	return pOut;
 }
@@ -140,10 +141,14 @@ kmQuaternion* kmQuaternionMultiply(kmQuaternion* pOut,
 								 const kmQuaternion* q1,
 								 const kmQuaternion* q2)
 {
+#if KM_USE_SSE
+	SSE_QuaternionMul(&q1->x, &q2->x, &pOut->x);
+#else
 	pOut->w = q1->w * q2->w - q1->x * q2->x - q1->y * q2->y - q1->z * q2->z;
 	pOut->x = q1->w * q2->x + q1->x * q2->w + q1->y * q2->z - q1->z * q2->y;
 	pOut->y = q1->w * q2->y + q1->y * q2->w + q1->z * q2->x - q1->x * q2->z;
 	pOut->z = q1->w * q2->z + q1->z * q2->w + q1->x * q2->y - q1->y * q2->x;
+#endif
 
 	return pOut;
 }
@@ -516,7 +521,7 @@ kmQuaternion* kmQuaternionRotationBetweenVec3(kmQuaternion* pOut, const kmVec3*
 	}
 
 	if (a < (1e-6f - 1.0f))	{
-		if (fabs(kmVec3LengthSq(fallback)) < kmEpsilon) {
+		if (fabs(kmVec3LengthSq(fallback)) > kmEpsilon) {
 			kmQuaternionRotationAxis(pOut, fallback, kmPI);
 		} else {
 			kmVec3 axis;
@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include "kazmath/ray2.h"
+#include "kazmath/sse_matrix_impl.h"
 
 void kmRay2Fill(kmRay2* ray, kmScalar px, kmScalar py, kmScalar vx, kmScalar vy) {
     ray->start.x = px;
@@ -106,6 +107,35 @@ kmBool kmRay2IntersectLineSegment(const kmRay2* ray, const kmVec2* p1, const kmV
     return KM_TRUE;*/
 }
 
+/**
+ * Intersects the ray with count line segments, segments holds the two end
+ * points of each one after the other. hits receives KM_TRUE or KM_FALSE for
+ * each segment, intersections, if not NULL, the intersection point of each
+ * segment that is hit. Returns the number of segments hit.
+ */
+unsigned int kmRay2IntersectLineSegments(kmBool* hits, kmVec2* intersections, const kmRay2* ray, const kmVec2* segments, unsigned int count) {
+    unsigned int i = 0;
+    unsigned int total = 0;
+
+#if KM_USE_SSE
+    total = SSE_Ray2IntersectLineSegments(&ray->start.x, &ray->dir.x, &segments->x, count, hits, (intersections ? &intersections->x : NULL));
+    i = count & ~3u;
+#endif
+
+    for(; i < count; ++i) {
+        kmVec2 intersection;
+
+        hits[i] = kmRay2IntersectLineSegment(ray, &segments[2 * i], &segments[2 * i + 1], &intersection);
+        if(hits[i] && intersections) {
+            intersections[i] = intersection;
+        }
+
+        total += hits[i];
+    }
+
+    return total;
+}
+
 void calculate_line_normal(kmVec2 p1, kmVec2 p2, kmVec2* normal_out) {
     kmVec2 tmp;
     kmVec2Subtract(&tmp, &p2, &p1); //Get direction vector
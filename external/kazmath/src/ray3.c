@@ -0,0 +1,94 @@
+/*
+Copyright (c) 2011, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "kazmath/ray3.h"
+#include "kazmath/aabb.h"
+#include "kazmath/sse_matrix_impl.h"
+
+void kmRay3Fill(kmRay3* ray, kmScalar px, kmScalar py, kmScalar pz, kmScalar vx, kmScalar vy, kmScalar vz) {
+    ray->start.x = px;
+    ray->start.y = py;
+    ray->start.z = pz;
+    ray->dir.x = vx;
+    ray->dir.y = vy;
+    ray->dir.z = vz;
+}
+
+/* Clips [tmin, tmax] against one slab of the box. A zero direction gives
+ * infinite t's, or a NaN when the ray lies on a face which then leaves
+ * the range alone. */
+static void clip_slab(kmScalar start, kmScalar invDir, kmScalar boxMin, kmScalar boxMax, kmScalar* tmin, kmScalar* tmax) {
+    kmScalar t1 = (boxMin - start) * invDir;
+    kmScalar t2 = (boxMax - start) * invDir;
+
+    *tmin = max(min(t1, t2), *tmin);
+    *tmax = min(max(t1, t2), *tmax);
+}
+
+/**
+ * Returns KM_TRUE if the ray hits the box. pDistance, if not NULL, is set to
+ * the t where the ray enters the box, 0 if it starts inside.
+ */
+kmBool kmRay3IntersectAABB(const kmRay3* ray, const kmAABB* pBox, kmScalar* pDistance) {
+    kmScalar tmin = 0.0f;
+    kmScalar tmax = 1.0f;
+
+    clip_slab(ray->start.x, 1.0f / ray->dir.x, pBox->min.x, pBox->max.x, &tmin, &tmax);
+    clip_slab(ray->start.y, 1.0f / ray->dir.y, pBox->min.y, pBox->max.y, &tmin, &tmax);
+    clip_slab(ray->start.z, 1.0f / ray->dir.z, pBox->min.z, pBox->max.z, &tmin, &tmax);
+
+    if(tmin <= tmax) {
+        if(pDistance) {
+            *pDistance = tmin;
+        }
+
+        return KM_TRUE;
+    }
+
+    return KM_FALSE;
+}
+
+/**
+ * Intersects the ray with count boxes, use it to resolve a touch against a
+ * whole scene. pHits receives KM_TRUE or KM_FALSE for each box, pDistances,
+ * if not NULL, the entry distance of each box that is hit. Returns the
+ * number of boxes hit.
+ */
+unsigned int kmRay3IntersectAABBs(kmBool* pHits, kmScalar* pDistances, const kmRay3* ray, const kmAABB* pBoxes, unsigned int count) {
+    unsigned int i = 0;
+    unsigned int hits = 0;
+
+#if KM_USE_SSE
+    hits = SSE_AABBsIntersectRay(&pBoxes->min.x, count, &ray->start.x, &ray->dir.x, pHits, pDistances);
+    i = count & ~3u;
+#endif
+
+    for(; i < count; ++i) {
+        pHits[i] = kmRay3IntersectAABB(ray, &pBoxes[i], (pDistances ? &pDistances[i] : NULL));
+        hits += pHits[i];
+    }
+
+    return hits;
+}
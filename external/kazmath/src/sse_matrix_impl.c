@@ -0,0 +1,456 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * @file sse_matrix_impl.c
+ */
+#include "kazmath/sse_matrix_impl.h"
+
+#if KM_USE_SSE
+
+#include <math.h>
+#include <emmintrin.h>
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#define KM_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+#define KM_SWIZZLE(v, x, y, z, w) KM_SHUFFLE(v, v, x, y, z, w)
+
+void SSE_Matrix4Mul(const float* a, const float* b, float* output)
+{
+#if defined(__AVX__)
+	// Compute two columns at once. The shuffles broadcast within each 128 bit lane.
+	__m128 c0 = _mm_loadu_ps(a + 0), c1 = _mm_loadu_ps(a + 4);
+	__m128 c2 = _mm_loadu_ps(a + 8), c3 = _mm_loadu_ps(a + 12);
+	__m256 a0 = _mm256_insertf128_ps(_mm256_castps128_ps256(c0), c0, 1);
+	__m256 a1 = _mm256_insertf128_ps(_mm256_castps128_ps256(c1), c1, 1);
+	__m256 a2 = _mm256_insertf128_ps(_mm256_castps128_ps256(c2), c2, 1);
+	__m256 a3 = _mm256_insertf128_ps(_mm256_castps128_ps256(c3), c3, 1);
+
+	for (int i = 0; i < 16; i += 8) {
+		__m256 col = _mm256_loadu_ps(b + i);
+		__m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(col, col, 0x00));
+		r = _mm256_add_ps(r, _mm256_mul_ps(a1, _mm256_shuffle_ps(col, col, 0x55)));
+		r = _mm256_add_ps(r, _mm256_mul_ps(a2, _mm256_shuffle_ps(col, col, 0xAA)));
+		r = _mm256_add_ps(r, _mm256_mul_ps(a3, _mm256_shuffle_ps(col, col, 0xFF)));
+		_mm256_storeu_ps(output + i, r);
+	}
+#else
+	__m128 a0 = _mm_loadu_ps(a + 0), a1 = _mm_loadu_ps(a + 4);
+	__m128 a2 = _mm_loadu_ps(a + 8), a3 = _mm_loadu_ps(a + 12);
+
+	for (int i = 0; i < 16; i += 4) {
+		__m128 r = _mm_mul_ps(a0, _mm_set1_ps(b[i + 0]));
+		r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(b[i + 1])));
+		r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(b[i + 2])));
+		r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(b[i + 3])));
+		_mm_storeu_ps(output + i, r);
+	}
+#endif
+}
+
+void SSE_Matrix4Vector4Mul(const float* m, const float* v, float* output)
+{
+	__m128 r = _mm_mul_ps(_mm_loadu_ps(m + 0), _mm_set1_ps(v[0]));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 4), _mm_set1_ps(v[1])));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 8), _mm_set1_ps(v[2])));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_set1_ps(v[3])));
+	_mm_storeu_ps(output, r);
+}
+
+void SSE_Matrix4Vector3Transform(const float* m, const float* v, float* output)
+{
+	float result[4];
+
+	__m128 r = _mm_mul_ps(_mm_loadu_ps(m + 0), _mm_set1_ps(v[0]));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 4), _mm_set1_ps(v[1])));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 8), _mm_set1_ps(v[2])));
+	r = _mm_add_ps(r, _mm_loadu_ps(m + 12));
+	_mm_storeu_ps(result, r);
+
+	// Only three floats may be written to the output.
+	output[0] = result[0];
+	output[1] = result[1];
+	output[2] = result[2];
+}
+
+void SSE_Matrix4Vector4MulStrided(const float* m, const float* v, size_t vStride, float* output, size_t outStride, unsigned int count)
+{
+	__m128 m0 = _mm_loadu_ps(m + 0), m1 = _mm_loadu_ps(m + 4);
+	__m128 m2 = _mm_loadu_ps(m + 8), m3 = _mm_loadu_ps(m + 12);
+
+	const char* in = (const char*)v;
+	char* out = (char*)output;
+
+	for (unsigned int i = 0; i < count; i++, in += vStride, out += outStride) {
+		const float* p = (const float*)in;
+
+		__m128 r = _mm_mul_ps(m0, _mm_set1_ps(p[0]));
+		r = _mm_add_ps(r, _mm_mul_ps(m1, _mm_set1_ps(p[1])));
+		r = _mm_add_ps(r, _mm_mul_ps(m2, _mm_set1_ps(p[2])));
+		r = _mm_add_ps(r, _mm_mul_ps(m3, _mm_set1_ps(p[3])));
+		_mm_storeu_ps((float*)out, r);
+	}
+}
+
+void SSE_Matrix4Vector3TransformStrided(const float* m, const float* v, size_t vStride, float* output, size_t outStride, unsigned int count)
+{
+	__m128 m0 = _mm_loadu_ps(m + 0), m1 = _mm_loadu_ps(m + 4);
+	__m128 m2 = _mm_loadu_ps(m + 8), m3 = _mm_loadu_ps(m + 12);
+
+	const char* in = (const char*)v;
+	char* out = (char*)output;
+
+	for (unsigned int i = 0; i < count; i++, in += vStride, out += outStride) {
+		const float* p = (const float*)in;
+
+		__m128 r = _mm_mul_ps(m0, _mm_set1_ps(p[0]));
+		r = _mm_add_ps(r, _mm_mul_ps(m1, _mm_set1_ps(p[1])));
+		r = _mm_add_ps(r, _mm_mul_ps(m2, _mm_set1_ps(p[2])));
+		r = _mm_add_ps(r, m3);
+
+		// Only three floats may be written, the rest of the vertex is left alone.
+		_mm_storel_pi((__m64*)out, r);
+		_mm_store_ss((float*)out + 2, _mm_movehl_ps(r, r));
+	}
+}
+
+void SSE_Mat3x2Vector2TransformStrided(const float* m, const float* v, size_t vStride, float* output, size_t outStride, unsigned int count)
+{
+	// Two vectors are transformed at a time, (x0, y0, x1, y1).
+	__m128 ab = _mm_setr_ps(m[0], m[1], m[0], m[1]);
+	__m128 cd = _mm_setr_ps(m[2], m[3], m[2], m[3]);
+	__m128 t = _mm_setr_ps(m[4], m[5], m[4], m[5]);
+
+	const char* in = (const char*)v;
+	char* out = (char*)output;
+	unsigned int i = 0;
+
+	for (; i + 1 < count; i += 2, in += 2*vStride, out += 2*outStride) {
+		__m128 p = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)in);
+		p = _mm_loadh_pi(p, (const __m64*)(in + vStride));
+
+		__m128 r = _mm_mul_ps(ab, KM_SWIZZLE(p, 0, 0, 2, 2));
+		r = _mm_add_ps(r, _mm_mul_ps(cd, KM_SWIZZLE(p, 1, 1, 3, 3)));
+		r = _mm_add_ps(r, t);
+
+		// The second input is loaded before the first output is stored so the transform can be done in place.
+		_mm_storel_pi((__m64*)out, r);
+		_mm_storeh_pi((__m64*)(out + outStride), r);
+	}
+
+	if (i < count) {
+		const float* p = (const float*)in;
+		float x = p[0] * m[0] + p[1] * m[2] + m[4];
+		float y = p[0] * m[1] + p[1] * m[3] + m[5];
+
+		((float*)out)[0] = x;
+		((float*)out)[1] = y;
+	}
+}
+
+/*
+The inverse is computed blockwise from the four 2x2 sub matrices
+A B / C D, each stored as (m00, m01, m10, m11) in one register.
+The inverse of the transpose is the transpose of the inverse, so the
+same code works for row and column major storage.
+*/
+
+// 2x2 matrix product a*b
+static inline __m128 Mat2Mul(__m128 a, __m128 b)
+{
+	return _mm_add_ps(_mm_mul_ps(a, KM_SWIZZLE(b, 0, 3, 0, 3)), _mm_mul_ps(KM_SWIZZLE(a, 1, 0, 3, 2), KM_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+// 2x2 matrix product adj(a)*b
+static inline __m128 Mat2AdjMul(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(_mm_mul_ps(KM_SWIZZLE(a, 3, 3, 0, 0), b), _mm_mul_ps(KM_SWIZZLE(a, 1, 1, 2, 2), KM_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+// 2x2 matrix product a*adj(b)
+static inline __m128 Mat2MulAdj(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(_mm_mul_ps(a, KM_SWIZZLE(b, 3, 0, 3, 0)), _mm_mul_ps(KM_SWIZZLE(a, 1, 0, 3, 2), KM_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+int SSE_Matrix4Inverse(const float* m, float* output)
+{
+	__m128 r0 = _mm_loadu_ps(m + 0), r1 = _mm_loadu_ps(m + 4);
+	__m128 r2 = _mm_loadu_ps(m + 8), r3 = _mm_loadu_ps(m + 12);
+
+	__m128 A = _mm_movelh_ps(r0, r1);
+	__m128 B = _mm_movehl_ps(r1, r0);
+	__m128 C = _mm_movelh_ps(r2, r3);
+	__m128 D = _mm_movehl_ps(r3, r2);
+
+	// Determinants of the sub matrices as (|A|, |B|, |C|, |D|)
+	__m128 detSub = _mm_sub_ps(
+		_mm_mul_ps(KM_SHUFFLE(r0, r2, 0, 2, 0, 2), KM_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+		_mm_mul_ps(KM_SHUFFLE(r0, r2, 1, 3, 1, 3), KM_SHUFFLE(r1, r3, 0, 2, 0, 2))
+	);
+	__m128 detA = KM_SWIZZLE(detSub, 0, 0, 0, 0);
+	__m128 detB = KM_SWIZZLE(detSub, 1, 1, 1, 1);
+	__m128 detC = KM_SWIZZLE(detSub, 2, 2, 2, 2);
+	__m128 detD = KM_SWIZZLE(detSub, 3, 3, 3, 3);
+
+	__m128 D_C = Mat2AdjMul(D, C);
+	__m128 A_B = Mat2AdjMul(A, B);
+
+	// Adjugates of the blocks of the inverse
+	__m128 X_ = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, D_C));
+	__m128 W_ = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, A_B));
+	__m128 Y_ = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, A_B));
+	__m128 Z_ = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, D_C));
+
+	// |M| = |A|*|D| + |B|*|C| - tr(adj(A)*B*adj(D)*C)
+	__m128 tr = _mm_mul_ps(A_B, KM_SWIZZLE(D_C, 0, 2, 1, 3));
+	tr = _mm_add_ps(tr, KM_SWIZZLE(tr, 1, 0, 3, 2));
+	tr = _mm_add_ps(tr, KM_SWIZZLE(tr, 2, 3, 0, 1));
+	__m128 detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+
+	// Like gaussj() only exactly singular matrices are rejected, or ones whose inverse would overflow.
+	float det = _mm_cvtss_f32(detM);
+	if (det == 0.0f || !isfinite(1.0f/det)) {
+		return 0;
+	}
+
+	__m128 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+	X_ = _mm_mul_ps(X_, rDetM);
+	Y_ = _mm_mul_ps(Y_, rDetM);
+	Z_ = _mm_mul_ps(Z_, rDetM);
+	W_ = _mm_mul_ps(W_, rDetM);
+
+	// Apply the adjugate shuffle and reassemble the rows.
+	_mm_storeu_ps(output + 0, KM_SHUFFLE(X_, Y_, 3, 1, 3, 1));
+	_mm_storeu_ps(output + 4, KM_SHUFFLE(X_, Y_, 2, 0, 2, 0));
+	_mm_storeu_ps(output + 8, KM_SHUFFLE(Z_, W_, 3, 1, 3, 1));
+	_mm_storeu_ps(output + 12, KM_SHUFFLE(Z_, W_, 2, 0, 2, 0));
+
+	return 1;
+}
+
+void SSE_QuaternionMul(const float* q1, const float* q2, float* output)
+{
+	__m128 a = _mm_loadu_ps(q1), b = _mm_loadu_ps(q2);
+	// Flips the sign of the w lane.
+	__m128 negW = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, (int)0x80000000));
+
+	// Lanes are (x, y, z, w) with the same terms and order as kmQuaternionMultiply().
+	__m128 r = _mm_mul_ps(KM_SWIZZLE(a, 3, 3, 3, 3), b);
+	r = _mm_add_ps(r, _mm_xor_ps(_mm_mul_ps(KM_SWIZZLE(a, 0, 1, 2, 0), KM_SWIZZLE(b, 3, 3, 3, 0)), negW));
+	r = _mm_add_ps(r, _mm_xor_ps(_mm_mul_ps(KM_SWIZZLE(a, 1, 2, 0, 1), KM_SWIZZLE(b, 2, 0, 1, 1)), negW));
+	r = _mm_sub_ps(r, _mm_mul_ps(KM_SWIZZLE(a, 2, 0, 1, 2), KM_SWIZZLE(b, 1, 2, 0, 2)));
+	_mm_storeu_ps(output, r);
+}
+
+// Loads (x, y, z, 0) without reading past the third float.
+static inline __m128 LoadVec3(const float* v)
+{
+	return _mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)v), _mm_load_ss(v + 2));
+}
+
+// Loads four boxes as structures of arrays.
+static inline void LoadAABBs(const float* boxes, __m128* min, __m128* max)
+{
+	// Each box is loaded as (min x, min y, min z, max x) and (min z, max x, max y, max z) so nothing is read past its end.
+	__m128 a0 = _mm_loadu_ps(boxes + 0), b0 = _mm_loadu_ps(boxes + 2);
+	__m128 a1 = _mm_loadu_ps(boxes + 6), b1 = _mm_loadu_ps(boxes + 8);
+	__m128 a2 = _mm_loadu_ps(boxes + 12), b2 = _mm_loadu_ps(boxes + 14);
+	__m128 a3 = _mm_loadu_ps(boxes + 18), b3 = _mm_loadu_ps(boxes + 20);
+
+	_MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+	_MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+
+	min[0] = a0; min[1] = a1; min[2] = a2;
+	max[0] = b1; max[1] = b2; max[2] = b3;
+}
+
+static inline unsigned int StoreHits(int mask, unsigned char* out)
+{
+	out[0] = (unsigned char)(mask & 1);
+	out[1] = (unsigned char)((mask >> 1) & 1);
+	out[2] = (unsigned char)((mask >> 2) & 1);
+	out[3] = (unsigned char)((mask >> 3) & 1);
+
+	return out[0] + out[1] + out[2] + out[3];
+}
+
+unsigned int SSE_AABBContainsPoints(const float* box, const float* v, size_t vStride, unsigned char* out, unsigned int count)
+{
+	__m128 min = LoadVec3(box), max = LoadVec3(box + 3);
+	const char* in = (const char*)v;
+	unsigned int inside = 0;
+
+	for (unsigned int i = 0; i < count; i++, in += vStride) {
+		__m128 p = LoadVec3((const float*)in);
+		int mask = _mm_movemask_ps(_mm_and_ps(_mm_cmple_ps(min, p), _mm_cmple_ps(p, max)));
+
+		out[i] = ((mask & 7) == 7);
+		inside += out[i];
+	}
+
+	return inside;
+}
+
+unsigned int SSE_AABBsIntersectRay(const float* boxes, unsigned int count, const float* start, const float* dir, unsigned char* out, float* distances)
+{
+	__m128 s[3], inv[3];
+	for (int k = 0; k < 3; k++) {
+		s[k] = _mm_set1_ps(start[k]);
+		inv[k] = _mm_set1_ps(1.0f / dir[k]);
+	}
+
+	unsigned int hits = 0;
+	for (unsigned int i = 0; i + 3 < count; i += 4, boxes += 24) {
+		__m128 min[3], max[3];
+		LoadAABBs(boxes, min, max);
+
+		// Same slab order as kmRay3IntersectAABB(), a NaN from a zero direction on a box face leaves tmin and tmax alone.
+		__m128 tmin = _mm_setzero_ps(), tmax = _mm_set1_ps(1.0f);
+		for (int k = 0; k < 3; k++) {
+			__m128 t1 = _mm_mul_ps(_mm_sub_ps(min[k], s[k]), inv[k]);
+			__m128 t2 = _mm_mul_ps(_mm_sub_ps(max[k], s[k]), inv[k]);
+			tmin = _mm_max_ps(_mm_min_ps(t1, t2), tmin);
+			tmax = _mm_min_ps(_mm_max_ps(t1, t2), tmax);
+		}
+
+		int mask = _mm_movemask_ps(_mm_cmple_ps(tmin, tmax));
+		hits += StoreHits(mask, out + i);
+
+		if (distances && mask) {
+			float t[4];
+			_mm_storeu_ps(t, tmin);
+
+			for (int k = 0; k < 4; k++) {
+				if (mask & (1 << k)) distances[i + k] = t[k];
+			}
+		}
+	}
+
+	return hits;
+}
+
+unsigned int SSE_AABBsIntersectPlanes(const float* boxes, unsigned int count, const float* planes, unsigned int numPlanes, unsigned char* out)
+{
+	unsigned int hits = 0;
+
+	for (unsigned int i = 0; i + 3 < count; i += 4, boxes += 24) {
+		__m128 min[3], max[3];
+		LoadAABBs(boxes, min, max);
+
+		__m128 behind = _mm_setzero_ps();
+		for (unsigned int j = 0; j < numPlanes; j++) {
+			const float* p = planes + 4*j;
+
+			// The corner furthest along the plane normal, as in kmAABBIntersectsPlanes().
+			__m128 x = (p[0] >= 0.0f ? max[0] : min[0]);
+			__m128 y = (p[1] >= 0.0f ? max[1] : min[1]);
+			__m128 z = (p[2] >= 0.0f ? max[2] : min[2]);
+
+			__m128 d = _mm_mul_ps(_mm_set1_ps(p[0]), x);
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(p[1]), y));
+			d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(p[2]), z));
+			d = _mm_add_ps(d, _mm_set1_ps(p[3]));
+
+			behind = _mm_or_ps(behind, _mm_cmplt_ps(d, _mm_setzero_ps()));
+		}
+
+		hits += StoreHits(_mm_movemask_ps(behind) ^ 0xF, out + i);
+	}
+
+	return hits;
+}
+
+// Lanes where v < lo - 1/64 or v > hi + 1/64. kmEpsilon is a double so kmRay2IntersectLineSegment() does these comparisons in double too.
+static inline int OutsideRange(__m128 v, __m128 lo, __m128 hi)
+{
+	__m128d e = _mm_set1_pd(1.0 / 64.0);
+	__m128d v0 = _mm_cvtps_pd(v), v1 = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+	__m128d lo0 = _mm_sub_pd(_mm_cvtps_pd(lo), e), lo1 = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(lo, lo)), e);
+	__m128d hi0 = _mm_add_pd(_mm_cvtps_pd(hi), e), hi1 = _mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(hi, hi)), e);
+
+	__m128d o0 = _mm_or_pd(_mm_cmplt_pd(v0, lo0), _mm_cmpgt_pd(v0, hi0));
+	__m128d o1 = _mm_or_pd(_mm_cmplt_pd(v1, lo1), _mm_cmpgt_pd(v1, hi1));
+
+	return _mm_movemask_pd(o0) | (_mm_movemask_pd(o1) << 2);
+}
+
+unsigned int SSE_Ray2IntersectLineSegments(const float* start, const float* dir, const float* segments, unsigned int count, unsigned char* out, float* intersections)
+{
+	// Same terms and order as kmRay2IntersectLineSegment(), the ray is the line (x1, y1) (x2, y2).
+	float fx2 = start[0] + dir[0], fy2 = start[1] + dir[1];
+	__m128 x1 = _mm_set1_ps(start[0]), y1 = _mm_set1_ps(start[1]);
+	__m128 x2 = _mm_set1_ps(fx2), y2 = _mm_set1_ps(fy2);
+	__m128 rayDx = _mm_sub_ps(x2, x1), rayDy = _mm_sub_ps(y2, y1);
+	__m128 rayMinX = _mm_min_ps(x1, x2), rayMaxX = _mm_max_ps(x1, x2);
+	__m128 rayMinY = _mm_min_ps(y1, y2), rayMaxY = _mm_max_ps(y1, y2);
+	__m128 eps = _mm_set1_ps(1.0f / 64.0f), negEps = _mm_set1_ps(-1.0f / 64.0f);
+
+	unsigned int hits = 0;
+	for (unsigned int i = 0; i + 3 < count; i += 4, segments += 16) {
+		// One segment per register, transposed into (x3, y3, x4, y4) of four segments.
+		__m128 x3 = _mm_loadu_ps(segments + 0), y3 = _mm_loadu_ps(segments + 4);
+		__m128 x4 = _mm_loadu_ps(segments + 8), y4 = _mm_loadu_ps(segments + 12);
+		_MM_TRANSPOSE4_PS(x3, y3, x4, y4);
+
+		__m128 dx = _mm_sub_ps(x4, x3), dy = _mm_sub_ps(y4, y3);
+		__m128 denom = _mm_sub_ps(_mm_mul_ps(dy, rayDx), _mm_mul_ps(dx, rayDy));
+		int parallel = _mm_movemask_ps(_mm_and_ps(_mm_cmpgt_ps(denom, negEps), _mm_cmplt_ps(denom, eps)));
+
+		__m128 ua = _mm_sub_ps(_mm_mul_ps(dx, _mm_sub_ps(y1, y3)), _mm_mul_ps(dy, _mm_sub_ps(x1, x3)));
+		ua = _mm_div_ps(ua, denom);
+
+		__m128 x = _mm_add_ps(x1, _mm_mul_ps(ua, rayDx));
+		__m128 y = _mm_add_ps(y1, _mm_mul_ps(ua, rayDy));
+
+		int outside = parallel;
+		outside |= OutsideRange(x, _mm_min_ps(x3, x4), _mm_max_ps(x3, x4));
+		outside |= OutsideRange(y, _mm_min_ps(y3, y4), _mm_max_ps(y3, y4));
+		outside |= OutsideRange(x, rayMinX, rayMaxX);
+		outside |= OutsideRange(y, rayMinY, rayMaxY);
+
+		int mask = outside ^ 0xF;
+		hits += StoreHits(mask, out + i);
+
+		if (intersections && mask) {
+			float xs[4], ys[4];
+			_mm_storeu_ps(xs, x);
+			_mm_storeu_ps(ys, y);
+
+			for (int k = 0; k < 4; k++) {
+				if (mask & (1 << k)) {
+					intersections[2*(i + k) + 0] = xs[k];
+					intersections[2*(i + k) + 1] = ys[k];
+				}
+			}
+		}
+	}
+
+	return hits;
+}
+
+#endif
@@ -34,6 +34,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "kazmath/vec4.h"
 #include "kazmath/mat4.h"
 #include "kazmath/vec3.h"
+#include "kazmath/sse_matrix_impl.h"
 
 /**
  * Fill a kmVec3 structure using 3 floating point values
@@ -164,6 +165,9 @@ kmVec3* kmVec3Transform(kmVec3* pOut, const kmVec3* pV, const kmMat4* pM)
 		Out = (bx, by, bz)
 	*/
 
+#if KM_USE_SSE
+	SSE_Matrix4Vector3Transform(&pM->mat[0], &pV->x, &pOut->x);
+#else
 	kmVec3 v;
 
 	v.x = pV->x * pM->mat[0] + pV->y * pM->mat[4] + pV->z * pM->mat[8] + pM->mat[12];
@@ -173,6 +177,44 @@ kmVec3* kmVec3Transform(kmVec3* pOut, const kmVec3* pV, const kmMat4* pM)
 	pOut->x = v.x;
 	pOut->y = v.y;
 	pOut->z = v.z;
+#endif
+
+	return pOut;
+}
+
+/**
+  * Transforms count vectors (x, y, z, 1) by a given matrix. The strides are
+  * the distances in bytes between consecutive vectors, 0 means they are
+  * tightly packed. This allows transforming the positions of interleaved
+  * vertices, such as a ccV3F_C4B_T2F_Quad array, in place. Only the three
+  * floats of each output vector are written. pOut is returned.
+  */
+kmVec3* kmVec3TransformStrided(kmVec3* pOut, size_t outStride, const kmVec3* pV, size_t vStride, const kmMat4* pM, unsigned int count)
+{
+	if (outStride == 0) outStride = sizeof(kmVec3);
+	if (vStride == 0) vStride = sizeof(kmVec3);
+
+#if KM_USE_SSE
+	SSE_Matrix4Vector3TransformStrided(&pM->mat[0], &pV->x, vStride, &pOut->x, outStride, count);
+#else
+	const float *m = pM->mat;
+	const char *in = (const char*)pV;
+	char *out = (char*)pOut;
+	unsigned int i;
+
+	for (i = 0; i < count; ++i, in += vStride, out += outStride) {
+		const kmVec3 *v = (const kmVec3*)in;
+		kmVec3 *o = (kmVec3*)out;
+
+		float x = v->x * m[0] + v->y * m[4] + v->z * m[8] + m[12];
+		float y = v->x * m[1] + v->y * m[5] + v->z * m[9] + m[13];
+		float z = v->x * m[2] + v->y * m[6] + v->z * m[10] + m[14];
+
+		o->x = x;
+		o->y = y;
+		o->z = z;
+	}
+#endif
 
 	return pOut;
 }
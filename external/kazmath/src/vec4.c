@@ -30,6 +30,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "kazmath/utility.h"
 #include "kazmath/vec4.h"
 #include "kazmath/mat4.h"
+#include "kazmath/sse_matrix_impl.h"
 
 
 kmVec4* kmVec4Fill(kmVec4* pOut, kmScalar x, kmScalar y, kmScalar z, kmScalar w)
@@ -82,10 +83,10 @@ kmVec4* kmVec4Lerp(kmVec4* pOut, const kmVec4* pV1, const kmVec4* pV2, kmScalar
 kmVec4* kmVec4Normalize(kmVec4* pOut, const kmVec4* pIn) {
 	kmScalar l = 1.0f / kmVec4Length(pIn);
 
-	pOut->x *= l;
-	pOut->y *= l;
-	pOut->z *= l;
-	pOut->w *= l;
+	pOut->x = pIn->x * l;
+	pOut->y = pIn->y * l;
+	pOut->z = pIn->z * l;
+	pOut->w = pIn->w * l;
 
 	return pOut;
 }
@@ -113,24 +114,66 @@ kmVec4* kmVec4Subtract(kmVec4* pOut, const kmVec4* pV1, const kmVec4* pV2) {
 
 /// Transforms a 4D vector by a matrix, the result is stored in pOut, and pOut is returned.
 kmVec4* kmVec4Transform(kmVec4* pOut, const kmVec4* pV, const kmMat4* pM) {
+#if KM_USE_SSE
+	SSE_Matrix4Vector4Mul(&pM->mat[0], &pV->x, &pOut->x);
+#else
 	pOut->x = pV->x * pM->mat[0] + pV->y * pM->mat[4] + pV->z * pM->mat[8] + pV->w * pM->mat[12];
 	pOut->y = pV->x * pM->mat[1] + pV->y * pM->mat[5] + pV->z * pM->mat[9] + pV->w * pM->mat[13];
 	pOut->z = pV->x * pM->mat[2] + pV->y * pM->mat[6] + pV->z * pM->mat[10] + pV->w * pM->mat[14];
     pOut->w = pV->x * pM->mat[3] + pV->y * pM->mat[7] + pV->z * pM->mat[11] + pV->w * pM->mat[15];
+#endif
 	return pOut;
 }
 
 /// Loops through an input array transforming each vec4 by the matrix.
+/// The strides are counted in kmVec4s, see kmVec4TransformStrided() for byte strides.
 kmVec4* kmVec4TransformArray(kmVec4* pOut, unsigned int outStride,
 			const kmVec4* pV, unsigned int vStride, const kmMat4* pM, unsigned int count) {
     unsigned int i = 0;
-    //Go through all of the vectors
-    while (i < count) {
-        const kmVec4* in = pV + (i * vStride); //Get a pointer to the current input
-        kmVec4* out = pOut + (i * outStride); //and the current output
-        kmVec4Transform(out, in, pM); //Perform transform on it
-        ++i;
+
+    // A stride of 0 repeats the same vector here, it means tightly packed to kmVec4TransformStrided().
+    if (outStride == 0 || vStride == 0) {
+        while (i < count) {
+            kmVec4Transform(pOut + (i * outStride), pV + (i * vStride), pM);
+            ++i;
+        }
+
+        return pOut;
+    }
+
+    return kmVec4TransformStrided(pOut, outStride * sizeof(kmVec4), pV, vStride * sizeof(kmVec4), pM, count);
+}
+
+/// Transforms count vec4s by the matrix. The strides are the distances in bytes
+/// between consecutive vectors, 0 means they are tightly packed. pOut may be the same as pV.
+kmVec4* kmVec4TransformStrided(kmVec4* pOut, size_t outStride,
+			const kmVec4* pV, size_t vStride, const kmMat4* pM, unsigned int count) {
+    if (outStride == 0) outStride = sizeof(kmVec4);
+    if (vStride == 0) vStride = sizeof(kmVec4);
+
+#if KM_USE_SSE
+    SSE_Matrix4Vector4MulStrided(&pM->mat[0], &pV->x, vStride, &pOut->x, outStride, count);
+#else
+    const float *m = pM->mat;
+    const char *in = (const char*)pV;
+    char *out = (char*)pOut;
+    unsigned int i;
+
+    for (i = 0; i < count; ++i, in += vStride, out += outStride) {
+        const kmVec4 *v = (const kmVec4*)in;
+        kmVec4 *o = (kmVec4*)out;
+
+        float x = v->x * m[0] + v->y * m[4] + v->z * m[8] + v->w * m[12];
+        float y = v->x * m[1] + v->y * m[5] + v->z * m[9] + v->w * m[13];
+        float z = v->x * m[2] + v->y * m[6] + v->z * m[10] + v->w * m[14];
+        float w = v->x * m[3] + v->y * m[7] + v->z * m[11] + v->w * m[15];
+
+        o->x = x;
+        o->y = y;
+        o->z = z;
+        o->w = w;
     }
+#endif
 
     return pOut;
 }
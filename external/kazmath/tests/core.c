@@ -0,0 +1,496 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+	Core operation test.
+
+	Checks the vector, matrix and quaternion operations against reference results,
+	either exact values worked out by hand or textbook formulas evaluated in double
+	precision. Run against the SIMD and the scalar library.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "kazmath/kazmath.h"
+#include "kazmath/vec4.h"
+
+#include "test_util.h"
+
+#define ITERATIONS 2000
+#define MAX_ERROR 1e-5
+
+static void
+RandomAxis(kmVec3 *axis)
+{
+	kmVec3Fill(axis, RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(0.1f, 1.0f));
+	kmVec3Normalize(axis, axis);
+}
+
+// Largest difference relative to the largest element of the reference.
+static double
+Error(const float *result, const double *reference, int count)
+{
+	double error = 0.0, scale = 1e-30;
+	for(int i=0; i<count; i++){
+		error = fmax(error, fabs(result[i] - reference[i]));
+		scale = fmax(scale, fabs(reference[i]));
+	}
+
+	return error/scale;
+}
+
+static void
+CheckWithin(const char *name, const float *result, const double *reference, int count, double maxError)
+{
+	double error = Error(result, reference, count);
+	if(!(error <= maxError)){
+		printf("FAIL %s: relative error %g\n", name, error);
+		failures++;
+	}
+}
+
+static void
+Check(const char *name, const float *result, const double *reference, int count)
+{
+	CheckWithin(name, result, reference, count, MAX_ERROR);
+}
+
+static void
+CheckScalar(const char *name, float result, double reference)
+{
+	Check(name, &result, &reference, 1);
+}
+
+//MARK: Reference implementations
+
+// Column major n x n product.
+static void
+RefMultiply(double *out, const float *a, const float *b, int n)
+{
+	for(int col=0; col<n; col++){
+		for(int row=0; row<n; row++){
+			double sum = 0.0;
+			for(int k=0; k<n; k++) sum += (double)a[k*n + row]*(double)b[col*n + k];
+			out[col*n + row] = sum;
+		}
+	}
+}
+
+// Rodrigues' rotation formula, column major 3x3.
+static void
+RefRotation(double *out, const kmVec3 *axis, double radians)
+{
+	double x = axis->x, y = axis->y, z = axis->z;
+	double c = cos(radians), s = sin(radians), t = 1.0 - c;
+
+	out[0] = t*x*x + c;   out[3] = t*x*y - s*z; out[6] = t*x*z + s*y;
+	out[1] = t*x*y + s*z; out[4] = t*y*y + c;   out[7] = t*y*z - s*x;
+	out[2] = t*x*z - s*y; out[5] = t*y*z + s*x; out[8] = t*z*z + c;
+}
+
+// 3x3 rotation expanded to a 4x4 matrix.
+static void
+RefExpand(double *out, const double *m3)
+{
+	for(int i=0; i<16; i++) out[i] = (i%5 == 0 ? 1.0 : 0.0);
+	for(int col=0; col<3; col++){
+		for(int row=0; row<3; row++) out[col*4 + row] = m3[col*3 + row];
+	}
+}
+
+static void
+RefQuaternionMultiply(double *out, const kmQuaternion *a, const kmQuaternion *b)
+{
+	out[0] = (double)a->w*b->x + (double)a->x*b->w + (double)a->y*b->z - (double)a->z*b->y;
+	out[1] = (double)a->w*b->y - (double)a->x*b->z + (double)a->y*b->w + (double)a->z*b->x;
+	out[2] = (double)a->w*b->z + (double)a->x*b->y - (double)a->y*b->x + (double)a->z*b->w;
+	out[3] = (double)a->w*b->w - (double)a->x*b->x - (double)a->y*b->y - (double)a->z*b->z;
+}
+
+//MARK: Vectors
+
+static void
+TestVectors(void)
+{
+	kmVec2 a2, b2, r2;
+	kmVec2Fill(&a2, 3.0f, 4.0f);
+	kmVec2Fill(&b2, -1.0f, 2.0f);
+	Expect(kmVec2Length(&a2) == 5.0f && kmVec2LengthSq(&a2) == 25.0f, "kmVec2Length: |(3, 4)| should be 5");
+	Expect(kmVec2Dot(&a2, &b2) == 5.0f, "kmVec2Dot: (3, 4).(-1, 2) should be 5");
+	kmVec2Add(&r2, &a2, &b2);
+	Expect(r2.x == 2.0f && r2.y == 6.0f, "kmVec2Add");
+	kmVec2Subtract(&r2, &a2, &b2);
+	Expect(r2.x == 4.0f && r2.y == 2.0f, "kmVec2Subtract");
+	kmVec2Scale(&r2, &a2, 0.5f);
+	Expect(r2.x == 1.5f && r2.y == 2.0f, "kmVec2Scale");
+	kmVec2Normalize(&r2, &a2);
+	Expect(kmVec2AreEqual(&r2, kmVec2Fill(&b2, 0.6f, 0.8f)) && fabsf(kmVec2Length(&r2) - 1.0f) < 1e-6f, "kmVec2Normalize");
+
+	kmMat3 m3;
+	kmMat3Translation(&m3, 10.0f, 20.0f);
+	kmVec2Transform(&r2, &a2, &m3);
+	Expect(r2.x == 13.0f && r2.y == 24.0f, "kmVec2Transform: translation");
+
+	kmVec3 a3, b3, r3;
+	kmVec3Fill(&a3, 1.0f, 2.0f, 2.0f);
+	kmVec3Fill(&b3, 3.0f, -1.0f, 4.0f);
+	Expect(kmVec3Length(&a3) == 3.0f && kmVec3LengthSq(&a3) == 9.0f, "kmVec3Length: |(1, 2, 2)| should be 3");
+	Expect(kmVec3Dot(&a3, &b3) == 9.0f, "kmVec3Dot");
+	kmVec3Cross(&r3, &a3, &b3);
+	Expect(r3.x == 10.0f && r3.y == 2.0f && r3.z == -7.0f, "kmVec3Cross: (1, 2, 2)x(3, -1, 4) should be (10, 2, -7)");
+	Expect(kmVec3Dot(&r3, &a3) == 0.0f && kmVec3Dot(&r3, &b3) == 0.0f, "kmVec3Cross: should be perpendicular to both");
+	kmVec3Add(&r3, &a3, &b3);
+	Expect(r3.x == 4.0f && r3.y == 1.0f && r3.z == 6.0f, "kmVec3Add");
+	kmVec3Subtract(&r3, &a3, &b3);
+	Expect(r3.x == -2.0f && r3.y == 3.0f && r3.z == -2.0f, "kmVec3Subtract");
+	kmVec3Scale(&r3, &a3, 2.0f);
+	Expect(r3.x == 2.0f && r3.y == 4.0f && r3.z == 4.0f, "kmVec3Scale");
+	kmVec3Normalize(&r3, &a3);
+	Expect(kmVec3AreEqual(&r3, kmVec3Fill(&b3, 1.0f/3.0f, 2.0f/3.0f, 2.0f/3.0f)), "kmVec3Normalize");
+	kmVec3Zero(&r3);
+	Expect(r3.x == 0.0f && r3.y == 0.0f && r3.z == 0.0f, "kmVec3Zero");
+
+	kmVec4 a4, b4, r4;
+	kmVec4Fill(&a4, 1.0f, 2.0f, 3.0f, 4.0f);
+	kmVec4Fill(&b4, -2.0f, 1.0f, 0.5f, 2.0f);
+	Expect(kmVec4Dot(&a4, &b4) == 9.5f, "kmVec4Dot");
+	Expect(kmVec4LengthSq(&a4) == 30.0f && fabsf(kmVec4Length(&a4) - sqrtf(30.0f)) < 1e-6f, "kmVec4Length");
+	kmVec4Add(&r4, &a4, &b4);
+	Expect(r4.x == -1.0f && r4.y == 3.0f && r4.z == 3.5f && r4.w == 6.0f, "kmVec4Add");
+	kmVec4Subtract(&r4, &a4, &b4);
+	Expect(r4.x == 3.0f && r4.y == 1.0f && r4.z == 2.5f && r4.w == 2.0f, "kmVec4Subtract");
+	kmVec4Normalize(&r4, &a4);
+	Expect(fabsf(kmVec4Length(&r4) - 1.0f) < 1e-6f && fabsf(r4.w*sqrtf(30.0f) - 4.0f) < 1e-5f, "kmVec4Normalize");
+	// Unlike kmVec3Scale() this scales to a length.
+	kmVec4Scale(&r4, &a4, 2.0f);
+	Expect(fabsf(kmVec4Length(&r4) - 2.0f) < 1e-5f && fabsf(kmVec4Dot(&r4, &a4) - 2.0f*sqrtf(30.0f)) < 1e-4f, "kmVec4Scale");
+}
+
+//MARK: Matrices
+
+static void
+TestMat3(void)
+{
+	for(int i=0; i<ITERATIONS; i++){
+		kmMat3 a, b, r;
+		double reference[9];
+		for(int j=0; j<9; j++){
+			a.mat[j] = RandomFloat(-10.0f, 10.0f);
+			b.mat[j] = RandomFloat(-10.0f, 10.0f);
+		}
+		// Keep the matrix well conditioned for the inverse.
+		a.mat[0] += 40.0f; a.mat[4] += 40.0f; a.mat[8] += 40.0f;
+
+		RefMultiply(reference, a.mat, b.mat, 3);
+		Check("kmMat3Multiply", kmMat3Multiply(&r, &a, &b)->mat, reference, 9);
+
+		for(int j=0; j<9; j++) reference[j] = (double)a.mat[j]*0.25;
+		Check("kmMat3ScalarMultiply", kmMat3ScalarMultiply(&r, &a, 0.25f)->mat, reference, 9);
+
+		for(int col=0; col<3; col++){
+			for(int row=0; row<3; row++) reference[col*3 + row] = a.mat[row*3 + col];
+		}
+		Check("kmMat3Transpose", kmMat3Transpose(&r, &a)->mat, reference, 9);
+
+		const float *m = a.mat;
+		double det = (double)m[0]*((double)m[4]*m[8] - (double)m[7]*m[5])
+			- (double)m[3]*((double)m[1]*m[8] - (double)m[7]*m[2])
+			+ (double)m[6]*((double)m[1]*m[5] - (double)m[4]*m[2]);
+		CheckScalar("kmMat3Determinant", kmMat3Determinant(&a), det);
+
+		// A * A^-1 = I
+		kmMat3 inverse;
+		kmMat3Inverse(&inverse, kmMat3Determinant(&a), &a);
+		kmMat3Multiply(&r, &a, &inverse);
+		for(int j=0; j<9; j++) reference[j] = (j%4 == 0 ? 1.0 : 0.0);
+		Check("kmMat3Inverse", r.mat, reference, 9);
+
+		kmVec3 axis;
+		RandomAxis(&axis);
+		float angle = RandomFloat(-3.0f, 3.0f);
+		RefRotation(reference, &axis, angle);
+		Check("kmMat3RotationAxisAngle", kmMat3RotationAxisAngle(&r, &axis, angle)->mat, reference, 9);
+
+		// Quaternion of the same rotation
+		kmQuaternion q;
+		kmQuaternionRotationAxis(&q, &axis, angle);
+		Check("kmMat3RotationQuaternion", kmMat3RotationQuaternion(&r, &q)->mat, reference, 9);
+
+		kmVec3 unitX = {1.0f, 0.0f, 0.0f}, unitY = {0.0f, 1.0f, 0.0f}, unitZ = {0.0f, 0.0f, 1.0f};
+		RefRotation(reference, &unitX, angle);
+		Check("kmMat3RotationX", kmMat3RotationX(&r, angle)->mat, reference, 9);
+		RefRotation(reference, &unitY, angle);
+		Check("kmMat3RotationY", kmMat3RotationY(&r, angle)->mat, reference, 9);
+		RefRotation(reference, &unitZ, angle);
+		Check("kmMat3RotationZ", kmMat3RotationZ(&r, angle)->mat, reference, 9);
+		Check("kmMat3Rotation", kmMat3Rotation(&r, angle)->mat, reference, 9);
+
+		if(failures) return;
+	}
+
+	kmMat3 m;
+	Expect(kmMat3IsIdentity(kmMat3Identity(&m)), "kmMat3Identity");
+	kmMat3Scaling(&m, 2.0f, 3.0f);
+	Expect(m.mat[0] == 2.0f && m.mat[4] == 3.0f && m.mat[8] == 1.0f && kmMat3Determinant(&m) == 6.0f, "kmMat3Scaling");
+	kmMat3Translation(&m, 2.0f, 3.0f);
+	Expect(m.mat[6] == 2.0f && m.mat[7] == 3.0f && m.mat[8] == 1.0f, "kmMat3Translation");
+	kmMat3Fill(&m, (const kmScalar[]){1, 2, 3, 4, 5, 6, 7, 8, 9});
+	Expect(kmMat3Inverse(&m, kmMat3Determinant(&m), &m) == NULL, "kmMat3Inverse: singular matrix should return NULL");
+}
+
+static void
+TestMat4(void)
+{
+	for(int i=0; i<ITERATIONS; i++){
+		kmMat4 a, b, r;
+		double reference[16], rotation[9];
+		for(int j=0; j<16; j++){
+			a.mat[j] = RandomFloat(-10.0f, 10.0f);
+			b.mat[j] = RandomFloat(-10.0f, 10.0f);
+		}
+
+		RefMultiply(reference, a.mat, b.mat, 4);
+		Check("kmMat4Multiply", kmMat4Multiply(&r, &a, &b)->mat, reference, 16);
+
+		for(int col=0; col<4; col++){
+			for(int row=0; row<4; row++) reference[col*4 + row] = a.mat[row*4 + col];
+		}
+		Check("kmMat4Transpose", kmMat4Transpose(&r, &a)->mat, reference, 16);
+
+		kmVec3 axis;
+		RandomAxis(&axis);
+		float angle = RandomFloat(-3.0f, 3.0f);
+		RefRotation(rotation, &axis, angle);
+		RefExpand(reference, rotation);
+		Check("kmMat4RotationAxisAngle", kmMat4RotationAxisAngle(&r, &axis, angle)->mat, reference, 16);
+
+		kmQuaternion q;
+		kmQuaternionRotationAxis(&q, &axis, angle);
+		Check("kmMat4RotationQuaternion", kmMat4RotationQuaternion(&r, &q)->mat, reference, 16);
+
+		// Rotation followed by a translation
+		kmMat3 r3;
+		kmVec3 t = {RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f)};
+		kmMat3RotationAxisAngle(&r3, &axis, angle);
+		kmMat4RotationTranslation(&r, &r3, &t);
+		reference[12] = t.x; reference[13] = t.y; reference[14] = t.z;
+		Check("kmMat4RotationTranslation", r.mat, reference, 16);
+
+		kmMat3 extracted;
+		Check("kmMat4ExtractRotation", kmMat4ExtractRotation(&extracted, &r)->mat, rotation, 9);
+
+		kmVec3 unitX = {1.0f, 0.0f, 0.0f}, unitY = {0.0f, 1.0f, 0.0f}, unitZ = {0.0f, 0.0f, 1.0f};
+		RefRotation(rotation, &unitX, angle);
+		RefExpand(reference, rotation);
+		Check("kmMat4RotationX", kmMat4RotationX(&r, angle)->mat, reference, 16);
+		RefRotation(rotation, &unitY, angle);
+		RefExpand(reference, rotation);
+		Check("kmMat4RotationY", kmMat4RotationY(&r, angle)->mat, reference, 16);
+		RefRotation(rotation, &unitZ, angle);
+		RefExpand(reference, rotation);
+		Check("kmMat4RotationZ", kmMat4RotationZ(&r, angle)->mat, reference, 16);
+
+		// Transforming vectors, w = 1 for points, w = 0 for normals.
+		kmVec3 v = {RandomFloat(-10.0f, 10.0f), RandomFloat(-10.0f, 10.0f), RandomFloat(-10.0f, 10.0f)}, rv;
+		kmVec4 v4 = {v.x, v.y, v.z, RandomFloat(-2.0f, 2.0f)}, rv4;
+		double point[4], normal[3];
+		for(int row=0; row<4; row++){
+			point[row] = (double)a.mat[row]*v.x + (double)a.mat[4 + row]*v.y + (double)a.mat[8 + row]*v.z;
+			if(row < 3) normal[row] = point[row];
+			point[row] += (double)a.mat[12 + row]*v4.w;
+		}
+		Check("kmVec4Transform", &kmVec4Transform(&rv4, &v4, &a)->x, point, 4);
+		Check("kmVec3TransformNormal", &kmVec3TransformNormal(&rv, &v, &a)->x, normal, 3);
+		for(int row=0; row<3; row++) point[row] = normal[row] + a.mat[12 + row];
+		Check("kmVec3Transform", &kmVec3Transform(&rv, &v, &a)->x, point, 3);
+
+		if(failures) return;
+	}
+
+	kmMat4 m, r;
+	double reference[16];
+	Expect(kmMat4IsIdentity(kmMat4Identity(&m)), "kmMat4Identity");
+
+	kmMat4Translation(&m, 1.0f, 2.0f, 3.0f);
+	Expect(m.mat[12] == 1.0f && m.mat[13] == 2.0f && m.mat[14] == 3.0f && m.mat[15] == 1.0f && m.mat[0] == 1.0f, "kmMat4Translation");
+	kmMat4Scaling(&m, 2.0f, 3.0f, 4.0f);
+	Expect(m.mat[0] == 2.0f && m.mat[5] == 3.0f && m.mat[10] == 4.0f && m.mat[15] == 1.0f && m.mat[12] == 0.0f, "kmMat4Scaling");
+
+	// glOrtho(-2, 6, -1, 3, 1, 9)
+	memset(reference, 0, sizeof(reference));
+	reference[0] = 2.0/8.0; reference[5] = 2.0/4.0; reference[10] = -2.0/8.0;
+	reference[12] = -4.0/8.0; reference[13] = -2.0/4.0; reference[14] = -10.0/8.0; reference[15] = 1.0;
+	Check("kmMat4OrthographicProjection", kmMat4OrthographicProjection(&m, -2.0f, 6.0f, -1.0f, 3.0f, 1.0f, 9.0f)->mat, reference, 16);
+
+	// gluPerspective(60, 1.5, 1, 100)
+	double f = 1.0/tan(30.0*M_PI/180.0);
+	memset(reference, 0, sizeof(reference));
+	reference[0] = f/1.5; reference[5] = f;
+	reference[10] = (100.0 + 1.0)/(1.0 - 100.0); reference[11] = -1.0;
+	reference[14] = 2.0*100.0*1.0/(1.0 - 100.0);
+	// kmDegreesToRadians() only uses 5 digits of pi / 180.
+	CheckWithin("kmMat4PerspectiveProjection", kmMat4PerspectiveProjection(&m, 60.0f, 1.5f, 1.0f, 100.0f)->mat, reference, 16, 1e-4);
+
+	// gluLookAt: the eye goes to the origin and the centre onto -z.
+	kmVec3 eye = {3.0f, 4.0f, 5.0f}, centre = {-1.0f, 2.0f, -3.0f}, up = {0.0f, 1.0f, 0.0f}, v;
+	kmMat4LookAt(&m, &eye, &centre, &up);
+	double origin[3] = {0.0, 0.0, 0.0};
+	Check("kmMat4LookAt: eye", &kmVec3Transform(&v, &eye, &m)->x, origin, 3);
+	kmVec3Transform(&v, &centre, &m);
+	double distance = sqrt(16.0 + 4.0 + 64.0);
+	double onAxis[3] = {0.0, 0.0, -distance};
+	Check("kmMat4LookAt: centre", &v.x, onAxis, 3);
+	Expect(fabsf(kmMat4ExtractRotation(&(kmMat3){{0}}, &m)->mat[0]) <= 1.0f, "kmMat4LookAt: rotation");
+
+	// The inverse is covered by the inverse test, check the identity round trip here.
+	kmMat4RotationPitchYawRoll(&m, 0.3f, -0.7f, 1.1f);
+	kmMat4Multiply(&r, &m, kmMat4Inverse(&r, &m));
+	for(int j=0; j<16; j++) reference[j] = (j%5 == 0 ? 1.0 : 0.0);
+	Check("kmMat4RotationPitchYawRoll: inverse", r.mat, reference, 16);
+	Check("kmMat4RotationPitchYawRoll: orthonormal", kmMat4Multiply(&r, &m, kmMat4Transpose(&r, &m))->mat, reference, 16);
+}
+
+//MARK: Quaternions
+
+static void
+TestQuaternions(void)
+{
+	for(int i=0; i<ITERATIONS; i++){
+		kmQuaternion a = {RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f)};
+		kmQuaternion b = {RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f)};
+		kmQuaternion r;
+		double reference[4];
+
+		RefQuaternionMultiply(reference, &a, &b);
+		Check("kmQuaternionMultiply", &kmQuaternionMultiply(&r, &a, &b)->x, reference, 4);
+
+		double lengthSq = (double)a.x*a.x + (double)a.y*a.y + (double)a.z*a.z + (double)a.w*a.w;
+		CheckScalar("kmQuaternionLengthSq", kmQuaternionLengthSq(&a), lengthSq);
+		CheckScalar("kmQuaternionLength", kmQuaternionLength(&a), sqrt(lengthSq));
+		// Relative to the lengths, the dot product itself may cancel out.
+		double dot = (double)a.x*b.x + (double)a.y*b.y + (double)a.z*b.z + (double)a.w*b.w;
+		if(fabs(kmQuaternionDot(&a, &b) - dot) > MAX_ERROR*sqrt(lengthSq*kmQuaternionLengthSq(&b))){
+			printf("FAIL kmQuaternionDot: %g should be %g\n", kmQuaternionDot(&a, &b), dot);
+			failures++;
+		}
+
+		double conjugate[4] = {-a.x, -a.y, -a.z, a.w};
+		Check("kmQuaternionConjugate", &kmQuaternionConjugate(&r, &a)->x, conjugate, 4);
+
+		// q * q^-1 = 1
+		double identity[4] = {0.0, 0.0, 0.0, 1.0};
+		kmQuaternion inverse;
+		kmQuaternionInverse(&inverse, &a);
+		Check("kmQuaternionInverse", &kmQuaternionMultiply(&r, &a, &inverse)->x, identity, 4);
+
+		double normalized[4] = {a.x/sqrt(lengthSq), a.y/sqrt(lengthSq), a.z/sqrt(lengthSq), a.w/sqrt(lengthSq)};
+		Check("kmQuaternionNormalize", &kmQuaternionNormalize(&r, &a)->x, normalized, 4);
+
+		// Rotating a vector must match the rotation matrix.
+		kmVec3 axis, v = {RandomFloat(-10.0f, 10.0f), RandomFloat(-10.0f, 10.0f), RandomFloat(-10.0f, 10.0f)}, rv;
+		RandomAxis(&axis);
+		float angle = RandomFloat(-3.0f, 3.0f);
+		double rotation[9], rotated[3];
+		RefRotation(rotation, &axis, angle);
+		for(int row=0; row<3; row++) rotated[row] = rotation[row]*v.x + rotation[3 + row]*v.y + rotation[6 + row]*v.z;
+		kmQuaternionRotationAxis(&r, &axis, angle);
+		Check("kmQuaternionMultiplyVec3", &kmQuaternionMultiplyVec3(&rv, &r, &v)->x, rotated, 3);
+
+		// Back to the axis and angle, the angle is returned in [0, 2 pi). Tiny rotations come back as no rotation.
+		kmVec3 axisOut;
+		kmScalar angleOut;
+		kmQuaternionToAxisAngle(&r, &axisOut, &angleOut);
+		double expectedAxis[3] = {axis.x, axis.y, axis.z};
+		if(angle < 0.0f){
+			for(int j=0; j<3; j++) expectedAxis[j] = -expectedAxis[j];
+		}
+		if(fabsf(angle) > 0.1f){
+			Check("kmQuaternionToAxisAngle: axis", &axisOut.x, expectedAxis, 3);
+			// acosf() of w near 1 is only good to about 1e-4 radians.
+			if(fabs(angleOut - fabs(angle)) > 1e-3){
+				printf("FAIL kmQuaternionToAxisAngle: angle %g should be %g\n", angleOut, fabs(angle));
+				failures++;
+			}
+		}
+
+		// From the rotation matrix, q and -q are the same rotation.
+		kmMat3 m3;
+		kmQuaternion fromMatrix;
+		kmMat3RotationAxisAngle(&m3, &axis, angle);
+		kmQuaternionRotationMatrix(&fromMatrix, &m3);
+		if(kmQuaternionDot(&fromMatrix, &r) < 0.0f) kmQuaternionScale(&fromMatrix, &fromMatrix, -1.0f);
+		double expectedQ[4] = {r.x, r.y, r.z, r.w};
+		Check("kmQuaternionRotationMatrix", &fromMatrix.x, expectedQ, 4);
+
+		// Slerp between two rotations about the same axis is a rotation by the interpolated angle.
+		kmQuaternion q1, q2, slerped, expected;
+		float angle2 = RandomFloat(-3.0f, 3.0f), t = RandomFloat(0.0f, 1.0f);
+		kmQuaternionRotationAxis(&q1, &axis, angle);
+		kmQuaternionRotationAxis(&q2, &axis, angle2);
+		kmQuaternionSlerp(&slerped, &q1, &q2, t);
+		kmQuaternionRotationAxis(&expected, &axis, angle + (angle2 - angle)*t);
+		double expectedSlerp[4] = {expected.x, expected.y, expected.z, expected.w};
+		// acosf() of the dot product limits the precision, nearly equal rotations lose the most.
+		if(fabsf(angle2 - angle) > 0.01f) CheckWithin("kmQuaternionSlerp", &slerped.x, expectedSlerp, 4, 1e-4);
+
+		// The shortest arc from v to the rotated v
+		kmVec3 to;
+		kmQuaternionMultiplyVec3(&to, &r, &v);
+		kmQuaternion between;
+		kmQuaternionRotationBetweenVec3(&between, &v, &to, &axis);
+		kmVec3 result;
+		kmQuaternionMultiplyVec3(&result, &between, &v);
+		double toRef[3] = {to.x, to.y, to.z};
+		if(fabsf(angle) > 0.01f) Check("kmQuaternionRotationBetweenVec3", &result.x, toRef, 3);
+
+		if(failures) return;
+	}
+
+	kmQuaternion q;
+	Expect(kmQuaternionIsIdentity(kmQuaternionIdentity(&q)), "kmQuaternionIdentity");
+
+	// Opposite vectors rotate half a turn around the fallback axis, or any perpendicular axis without one.
+	kmVec3 v = {1.0f, 0.0f, 0.0f}, opposite = {-1.0f, 0.0f, 0.0f}, fallback = {0.0f, 1.0f, 0.0f}, none = {0.0f, 0.0f, 0.0f}, result;
+	kmQuaternionRotationBetweenVec3(&q, &v, &opposite, &fallback);
+	kmQuaternionMultiplyVec3(&result, &q, &v);
+	Expect(kmVec3AreEqual(&result, &opposite) && fabsf(q.y) > 0.999f, "kmQuaternionRotationBetweenVec3: opposite vectors should use the fallback axis");
+	kmQuaternionRotationBetweenVec3(&q, &v, &opposite, &none);
+	kmQuaternionMultiplyVec3(&result, &q, &v);
+	Expect(kmVec3AreEqual(&result, &opposite), "kmQuaternionRotationBetweenVec3: opposite vectors without a fallback axis");
+}
+
+int
+main(int argc, char **argv)
+{
+	TestVectors();
+	TestMat3();
+	TestMat4();
+	TestQuaternions();
+
+	return TestResult();
+}
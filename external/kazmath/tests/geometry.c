@@ -0,0 +1,269 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+	Geometric query test.
+
+	Checks the batched point, ray, segment and frustum tests against the single item
+	functions, with random inputs as well as points and rays on the box faces.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "kazmath/kazmath.h"
+
+#include "test_util.h"
+
+#define ITERATIONS 200
+// Odd sizes exercise the scalar remainder of the SIMD kernels.
+#define NUM_ITEMS 1003
+
+// Small integer coordinates make rays graze box faces and edges now and then.
+static float
+RandomCoord(void)
+{
+	return ((seed & 0x300) ? RandomFloat(-100.0f, 100.0f) : floorf(RandomFloat(-4.0f, 4.0f)));
+}
+
+static void
+RandomAABB(kmAABB *box)
+{
+	kmVec3Fill(&box->min, RandomCoord(), RandomCoord(), RandomCoord());
+	kmVec3Fill(&box->max, box->min.x + RandomFloat(0.0f, 50.0f), box->min.y + RandomFloat(0.0f, 50.0f), box->min.z + RandomFloat(0.0f, 50.0f));
+}
+
+static void
+TestKnownCases(void)
+{
+	kmAABB box = {{-1.0f, -1.0f, -1.0f}, {1.0f, 1.0f, 1.0f}};
+	kmRay3 ray;
+	kmScalar t = -1.0f;
+
+	kmRay3Fill(&ray, -5.0f, 0.0f, 0.0f, 10.0f, 0.0f, 0.0f);
+	Expect(kmRay3IntersectAABB(&ray, &box, &t) && t == 0.4f, "kmRay3IntersectAABB: axis aligned ray should enter at t = 0.4");
+
+	kmRay3Fill(&ray, -5.0f, 0.0f, 0.0f, 3.0f, 0.0f, 0.0f);
+	Expect(!kmRay3IntersectAABB(&ray, &box, NULL), "kmRay3IntersectAABB: ray ending before the box should miss");
+
+	kmRay3Fill(&ray, 0.5f, 0.5f, 0.5f, 10.0f, 10.0f, 10.0f);
+	Expect(kmRay3IntersectAABB(&ray, &box, &t) && t == 0.0f, "kmRay3IntersectAABB: ray starting inside should hit at t = 0");
+
+	kmRay3Fill(&ray, -5.0f, 2.0f, 0.0f, 10.0f, 0.0f, 0.0f);
+	Expect(!kmRay3IntersectAABB(&ray, &box, NULL), "kmRay3IntersectAABB: parallel ray outside a slab should miss");
+
+	kmVec3 inside = {0.0f, 1.0f, -1.0f}, outside = {0.0f, 1.5f, 0.0f};
+	Expect(kmAABBContainsPoint(&inside, &box), "kmAABBContainsPoint: points on the faces are inside");
+	Expect(!kmAABBContainsPoint(&outside, &box), "kmAABBContainsPoint: point should be outside");
+
+	// A camera at the origin looking down -z.
+	kmMat4 projection;
+	kmPlane frustum[6];
+	kmMat4PerspectiveProjection(&projection, 60.0f, 1.5f, 1.0f, 100.0f);
+	kmPlaneExtractFrustum(frustum, &projection);
+
+	kmVec3 centre = {0.0f, 0.0f, -50.0f};
+	Expect(kmPlaneClassifyPoint(&frustum[KM_PLANE_NEAR], &centre) == POINT_INFRONT_OF_PLANE, "kmPlaneExtractFrustum: near plane should face inwards");
+	Expect(fabsf(kmPlaneDotCoord(&frustum[KM_PLANE_FAR], &centre) - 50.0f) < 1e-3f, "kmPlaneExtractFrustum: far plane should be 50 units away");
+
+	kmAABB visible = {{-1.0f, -1.0f, -11.0f}, {1.0f, 1.0f, -9.0f}};
+	kmAABB behind = {{-1.0f, -1.0f, 9.0f}, {1.0f, 1.0f, 11.0f}};
+	kmAABB left = {{-40.0f, -1.0f, -11.0f}, {-30.0f, 1.0f, -9.0f}};
+	kmAABB straddling = {{-20.0f, -1.0f, -11.0f}, {-5.0f, 1.0f, -9.0f}};
+	Expect(kmAABBIntersectsPlanes(&visible, frustum, 6), "kmAABBIntersectsPlanes: box in front of the camera is visible");
+	Expect(!kmAABBIntersectsPlanes(&behind, frustum, 6), "kmAABBIntersectsPlanes: box behind the camera is culled");
+	Expect(!kmAABBIntersectsPlanes(&left, frustum, 6), "kmAABBIntersectsPlanes: box left of the frustum is culled");
+	Expect(kmAABBIntersectsPlanes(&straddling, frustum, 6), "kmAABBIntersectsPlanes: box crossing a plane is visible");
+
+	kmRay2 ray2;
+	kmVec2 segment[2] = {{2.0f, -1.0f}, {2.0f, 1.0f}}, hit = {0.0f, 0.0f};
+	kmRay2Fill(&ray2, 0.0f, 0.5f, 4.0f, 0.0f);
+	Expect(kmRay2IntersectLineSegment(&ray2, &segment[0], &segment[1], &hit) && hit.x == 2.0f && hit.y == 0.5f, "kmRay2IntersectLineSegment: should hit at (2, 0.5)");
+}
+
+static void
+TestContainsPoints(void)
+{
+	static kmVec3 points[NUM_ITEMS];
+	static kmBool results[NUM_ITEMS];
+
+	for(int iteration=0; iteration<ITERATIONS; iteration++){
+		kmAABB box;
+		RandomAABB(&box);
+
+		// Around the box, some of them on its faces.
+		for(int i=0; i<NUM_ITEMS; i++){
+			kmVec3Fill(&points[i], RandomFloat(box.min.x - 10.0f, box.max.x + 10.0f), RandomFloat(box.min.y - 10.0f, box.max.y + 10.0f), RandomFloat(box.min.z - 10.0f, box.max.z + 10.0f));
+			if(i%7 == 0) points[i].x = box.max.x;
+			if(i%11 == 0) points[i].z = box.min.z;
+		}
+		// Every corner of the box counts as inside.
+		points[0] = box.min;
+		points[1] = box.max;
+
+		unsigned int count = NUM_ITEMS - iteration%4, expected = 0;
+		unsigned int inside = kmAABBContainsPoints(results, points, 0, count, &box);
+
+		for(unsigned int i=0; i<count; i++){
+			kmBool hit = kmAABBContainsPoint(&points[i], &box);
+			expected += hit;
+
+			if(results[i] != hit){
+				printf("FAIL kmAABBContainsPoints: point %d differs\n", i);
+				failures++;
+				return;
+			}
+		}
+
+		Expect(inside == expected, "kmAABBContainsPoints: wrong number of points inside");
+		Expect(results[0] && results[1], "kmAABBContainsPoints: box corners should be inside");
+	}
+}
+
+static void
+TestRay3(void)
+{
+	static kmAABB boxes[NUM_ITEMS];
+	static kmBool hits[NUM_ITEMS];
+	static kmScalar distances[NUM_ITEMS];
+
+	for(int iteration=0; iteration<ITERATIONS; iteration++){
+		kmRay3 ray;
+		kmRay3Fill(&ray, RandomCoord(), RandomCoord(), RandomCoord(), RandomFloat(-200.0f, 200.0f), RandomFloat(-200.0f, 200.0f), RandomFloat(-200.0f, 200.0f));
+
+		// Zero direction components, the ray is then parallel to some slabs or lies on their faces.
+		if(iteration%3 == 0) ray.dir.x = 0.0f;
+		if(iteration%5 == 0) ray.dir.z = 0.0f;
+
+		for(int i=0; i<NUM_ITEMS; i++) RandomAABB(&boxes[i]);
+
+		unsigned int count = NUM_ITEMS - iteration%4, expected = 0;
+		unsigned int total = kmRay3IntersectAABBs(hits, distances, &ray, boxes, count);
+
+		for(unsigned int i=0; i<count; i++){
+			kmScalar distance;
+			kmBool hit = kmRay3IntersectAABB(&ray, &boxes[i], &distance);
+			expected += hit;
+
+			if(hits[i] != hit || (hit && memcmp(&distances[i], &distance, sizeof(kmScalar)) != 0)){
+				printf("FAIL kmRay3IntersectAABBs: box %d differs\n", i);
+				failures++;
+				return;
+			}
+		}
+
+		Expect(total == expected, "kmRay3IntersectAABBs: wrong number of hits");
+	}
+}
+
+static void
+TestRay2(void)
+{
+	static kmVec2 segments[2*NUM_ITEMS], intersections[NUM_ITEMS];
+	static kmBool hits[NUM_ITEMS];
+
+	for(int iteration=0; iteration<ITERATIONS; iteration++){
+		kmRay2 ray;
+		kmRay2Fill(&ray, RandomCoord(), RandomCoord(), RandomFloat(-200.0f, 200.0f), RandomFloat(-200.0f, 200.0f));
+		if(iteration%3 == 0) ray.dir.y = 0.0f;
+
+		for(int i=0; i<2*NUM_ITEMS; i++){
+			kmVec2Fill(&segments[i], RandomCoord(), RandomCoord());
+		}
+		// Parallel to the ray
+		segments[3].x = segments[2].x + ray.dir.x;
+		segments[3].y = segments[2].y + ray.dir.y;
+
+		unsigned int count = NUM_ITEMS - iteration%4, expected = 0;
+		unsigned int total = kmRay2IntersectLineSegments(hits, intersections, &ray, segments, count);
+
+		for(unsigned int i=0; i<count; i++){
+			kmVec2 intersection;
+			kmBool hit = kmRay2IntersectLineSegment(&ray, &segments[2*i], &segments[2*i + 1], &intersection);
+			expected += hit;
+
+			if(hits[i] != hit || (hit && memcmp(&intersections[i], &intersection, sizeof(kmVec2)) != 0)){
+				printf("FAIL kmRay2IntersectLineSegments: segment %d differs\n", i);
+				failures++;
+				return;
+			}
+		}
+
+		Expect(total == expected, "kmRay2IntersectLineSegments: wrong number of hits");
+		Expect(kmRay2IntersectLineSegments(hits, NULL, &ray, segments, count) == total, "kmRay2IntersectLineSegments: intersections should be optional");
+	}
+}
+
+static void
+TestFrustum(void)
+{
+	static kmAABB boxes[NUM_ITEMS];
+	static kmBool results[NUM_ITEMS];
+
+	for(int iteration=0; iteration<ITERATIONS; iteration++){
+		kmMat4 projection, view, viewProjection;
+		kmVec3 eye = {RandomCoord(), RandomCoord(), RandomCoord()};
+		kmVec3 centre = {RandomCoord(), RandomCoord(), eye.z - 10.0f};
+		kmVec3 up = {0.0f, 1.0f, 0.0f};
+		kmMat4PerspectiveProjection(&projection, RandomFloat(30.0f, 90.0f), RandomFloat(0.5f, 2.0f), 0.1f, RandomFloat(50.0f, 500.0f));
+		kmMat4LookAt(&view, &eye, &centre, &up);
+		kmMat4Multiply(&viewProjection, &projection, &view);
+
+		kmPlane frustum[6];
+		kmPlaneExtractFrustum(frustum, &viewProjection);
+
+		for(int i=0; i<NUM_ITEMS; i++) RandomAABB(&boxes[i]);
+
+		unsigned int count = NUM_ITEMS - iteration%4, expected = 0;
+		unsigned int visible = kmAABBsIntersectPlanes(results, boxes, count, frustum, 6);
+
+		for(unsigned int i=0; i<count; i++){
+			kmBool hit = kmAABBIntersectsPlanes(&boxes[i], frustum, 6);
+			expected += hit;
+
+			if(results[i] != hit){
+				printf("FAIL kmAABBsIntersectPlanes: box %d differs\n", i);
+				failures++;
+				return;
+			}
+		}
+
+		Expect(visible == expected, "kmAABBsIntersectPlanes: wrong number of visible boxes");
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	TestKnownCases();
+	TestContainsPoints();
+	TestRay3();
+	TestRay2();
+	TestFrustum();
+
+	return TestResult();
+}
@@ -0,0 +1,293 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+	Inverse accuracy test.
+
+	Checks kmMat4Inverse(), kmMat4InverseAffine() and kmMat4InverseRigid() against a double
+	precision inverse on general matrices, 2D and 3D node transforms and camera transforms,
+	and reports the error of the old Gauss-Jordan inverse (gaussj) on the same input.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "kazmath/kazmath.h"
+
+#include "test_util.h"
+
+#define ITERATIONS 20000
+
+// Maximum error relative to the largest element of the inverse.
+#define MAX_ERROR 1e-4
+#define MAX_AFFINE_ERROR 1e-5
+#define MAX_RIGID_ERROR 1e-5
+
+// The Gauss-Jordan elimination kmMat4Inverse() used before, still exported by mat4.c.
+extern int gaussj(kmMat4 *a, kmMat4 *b);
+
+typedef kmMat4* const (*InverseFunc)(kmMat4* pOut, const kmMat4* pM);
+
+// Gauss-Jordan elimination with partial pivoting in double precision.
+// Returns 0 if the matrix is singular.
+static int
+ReferenceInverse(double *out, const kmMat4 *pM)
+{
+	double a[4][8];
+	for(int row=0; row<4; row++){
+		for(int col=0; col<4; col++){
+			a[row][col] = pM->mat[col*4 + row];
+			a[row][col + 4] = (row == col);
+		}
+	}
+
+	for(int col=0; col<4; col++){
+		int pivot = col;
+		for(int row=col + 1; row<4; row++){
+			if(fabs(a[row][col]) > fabs(a[pivot][col])) pivot = row;
+		}
+		if(a[pivot][col] == 0.0) return 0;
+
+		for(int i=0; i<8; i++){
+			double tmp = a[col][i]; a[col][i] = a[pivot][i]; a[pivot][i] = tmp;
+		}
+
+		double inv = 1.0/a[col][col];
+		for(int i=0; i<8; i++) a[col][i] *= inv;
+
+		for(int row=0; row<4; row++){
+			if(row == col) continue;
+
+			double f = a[row][col];
+			for(int i=0; i<8; i++) a[row][i] -= f*a[col][i];
+		}
+	}
+
+	for(int row=0; row<4; row++){
+		for(int col=0; col<4; col++) out[col*4 + row] = a[row][col + 4];
+	}
+
+	return 1;
+}
+
+// The error of the first three and the last column are measured separately,
+// a large translation would hide the error of the rest of the matrix otherwise.
+static double
+RelativeError(const kmMat4 *result, const double *reference)
+{
+	double worst = 0.0;
+
+	for(int start=0; start<16; start+=12){
+		int end = (start == 0 ? 12 : 16);
+		double error = 0.0, scale = 0.0;
+
+		for(int i=start; i<end; i++){
+			error = fmax(error, fabs(result->mat[i] - reference[i]));
+			scale = fmax(scale, fabs(reference[i]));
+		}
+
+		if(scale > 0.0) worst = fmax(worst, error/scale);
+	}
+
+	return worst;
+}
+
+//MARK: Matrices
+
+static void
+RandomGeneral(kmMat4 *m)
+{
+	for(int i=0; i<16; i++) m->mat[i] = RandomFloat(-10.0f, 10.0f);
+}
+
+// A CCNode style 2D transform: translation, rotation about z, non uniform scale and skew.
+static void
+RandomNode2D(kmMat4 *m)
+{
+	float angle = RandomFloat(-3.14f, 3.14f);
+	float sx = RandomFloat(0.1f, 4.0f)*(RandomFloat(0.0f, 1.0f) < 0.2f ? -1.0f : 1.0f);
+	float sy = RandomFloat(0.1f, 4.0f);
+	float skew = RandomFloat(-0.5f, 0.5f);
+	float c = cosf(angle), s = sinf(angle);
+
+	kmMat4Identity(m);
+	m->mat[0] = c*sx; m->mat[1] = s*sx;
+	m->mat[4] = (skew*c - s)*sy; m->mat[5] = (skew*s + c)*sy;
+	m->mat[12] = RandomFloat(-2048.0f, 2048.0f);
+	m->mat[13] = RandomFloat(-2048.0f, 2048.0f);
+}
+
+static void
+RandomRotation(kmMat4 *m)
+{
+	kmVec3 axis = {RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(0.1f, 1.0f)};
+	kmMat4RotationAxisAngle(m, kmVec3Normalize(&axis, &axis), RandomFloat(-3.14f, 3.14f));
+}
+
+static void
+RandomNode3D(kmMat4 *m)
+{
+	kmMat4 rotation, scale, translation;
+	RandomRotation(&rotation);
+	kmMat4Scaling(&scale, RandomFloat(0.1f, 10.0f), RandomFloat(0.1f, 10.0f), RandomFloat(0.1f, 10.0f));
+	kmMat4Translation(&translation, RandomFloat(-1000.0f, 1000.0f), RandomFloat(-1000.0f, 1000.0f), RandomFloat(-1000.0f, 1000.0f));
+	kmMat4Multiply(m, &rotation, &scale);
+	kmMat4Multiply(m, &translation, m);
+}
+
+static void
+RandomCamera(kmMat4 *m)
+{
+	kmVec3 eye = {RandomFloat(-500.0f, 500.0f), RandomFloat(-500.0f, 500.0f), RandomFloat(100.0f, 1000.0f)};
+	kmVec3 center = {RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), 0.0f};
+	kmVec3 up = {0.0f, 1.0f, 0.0f};
+	kmMat4LookAt(m, &eye, &center, &up);
+}
+
+static void
+RandomRigid(kmMat4 *m)
+{
+	kmMat4 translation;
+	RandomRotation(m);
+	kmMat4Translation(&translation, RandomFloat(-1000.0f, 1000.0f), RandomFloat(-1000.0f, 1000.0f), RandomFloat(-1000.0f, 1000.0f));
+	kmMat4Multiply(m, &translation, m);
+}
+
+//MARK: Tests
+
+typedef struct Case {
+	const char *name;
+	void (*generate)(kmMat4 *m);
+	InverseFunc inverse;
+	double maxError;
+	// Skip badly conditioned matrices, no float inverse is accurate for those.
+	int skipIllConditioned;
+} Case;
+
+static const Case cases[] = {
+	{"inverse general", RandomGeneral, kmMat4Inverse, MAX_ERROR, 1},
+	{"inverse node2d", RandomNode2D, kmMat4Inverse, MAX_AFFINE_ERROR, 0},
+	{"inverse node3d", RandomNode3D, kmMat4Inverse, MAX_AFFINE_ERROR, 0},
+	{"affine node2d", RandomNode2D, kmMat4InverseAffine, MAX_AFFINE_ERROR, 0},
+	{"affine node3d", RandomNode3D, kmMat4InverseAffine, MAX_AFFINE_ERROR, 0},
+	{"affine camera", RandomCamera, kmMat4InverseAffine, MAX_AFFINE_ERROR, 0},
+	{"rigid rigid", RandomRigid, kmMat4InverseRigid, MAX_RIGID_ERROR, 0},
+	{"rigid camera", RandomCamera, kmMat4InverseRigid, MAX_RIGID_ERROR, 0},
+};
+
+#define NUM_CASES (int)(sizeof(cases)/sizeof(*cases))
+
+static void
+RunCase(const Case *c)
+{
+	double worst = 0.0, worstGaussj = 0.0;
+	int tested = 0;
+
+	for(int i=0; i<ITERATIONS; i++){
+		kmMat4 m, result;
+		double reference[16];
+		c->generate(&m);
+
+		if(!ReferenceInverse(reference, &m)) continue;
+
+		if(c->skipIllConditioned){
+			double norm = 0.0, inverseNorm = 0.0;
+			for(int j=0; j<16; j++){
+				norm = fmax(norm, fabs(m.mat[j]));
+				inverseNorm = fmax(inverseNorm, fabs(reference[j]));
+			}
+			if(norm*inverseNorm > 1e3) continue;
+		}
+
+		if(c->inverse(&result, &m) == NULL){
+			printf("FAIL %s: iteration %d, invertible matrix reported as singular\n", c->name, i);
+			failures++;
+			return;
+		}
+
+		double error = RelativeError(&result, reference);
+		worst = fmax(worst, error);
+		tested++;
+
+		if(error > c->maxError){
+			printf("FAIL %s: iteration %d, relative error %g\n", c->name, i, error);
+			failures++;
+			return;
+		}
+
+		// The output may alias the input.
+		kmMat4 aliased = m;
+		c->inverse(&aliased, &aliased);
+		if(memcmp(&aliased, &result, sizeof(kmMat4)) != 0){
+			printf("FAIL %s: iteration %d, aliased result differs\n", c->name, i);
+			failures++;
+			return;
+		}
+
+		kmMat4 tmp;
+		kmMat4Identity(&tmp);
+		if(gaussj(&m, &tmp)) worstGaussj = fmax(worstGaussj, RelativeError(&m, reference));
+	}
+
+	printf("%-16s %6d matrices, max relative error %.3g (gaussj %.3g)\n", c->name, tested, worst, worstGaussj);
+}
+
+static void
+TestSingular(void)
+{
+	kmMat4 m, result;
+
+	// Small integers so the determinant is exactly zero.
+	for(int i=0; i<16; i++) m.mat[i] = floorf(RandomFloat(-10.0f, 10.0f));
+	memcpy(&m.mat[8], &m.mat[4], 4*sizeof(float));
+	if(kmMat4Inverse(&result, &m) != NULL){
+		printf("FAIL kmMat4Inverse: singular matrix was inverted\n");
+		failures++;
+	}
+
+	kmMat4Scaling(&m, 2.0f, 0.0f, 1.0f);
+	if(kmMat4Inverse(&result, &m) != NULL || kmMat4InverseAffine(&result, &m) != NULL){
+		printf("FAIL kmMat4InverseAffine: singular matrix was inverted\n");
+		failures++;
+	}
+
+	// Would overflow.
+	kmMat4Scaling(&m, 1e-20f, 1e-20f, 1e-20f);
+	if(kmMat4InverseAffine(&result, &m) != NULL){
+		printf("FAIL kmMat4InverseAffine: inverse overflowed\n");
+		failures++;
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	for(int i=0; i<NUM_CASES; i++) RunCase(&cases[i]);
+	TestSingular();
+
+	return TestResult();
+}
@@ -0,0 +1,276 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+	2D affine matrix test.
+
+	Checks every kmMat3x2 operation against the same operation done with kmMat4 on the
+	expanded matrices, using random CCNode style 2D transforms.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "kazmath/kazmath.h"
+#include "kazmath/GL/matrix.h"
+
+#include "test_util.h"
+
+#define ITERATIONS 20000
+#define MAX_ERROR 1e-5
+
+// Translation, rotation, non uniform scale and skew.
+static void
+RandomNode(kmMat3x2 *m)
+{
+	float angle = RandomFloat(-3.14f, 3.14f);
+	float sx = RandomFloat(0.1f, 4.0f), sy = RandomFloat(0.1f, 4.0f);
+	float skew = RandomFloat(-0.5f, 0.5f);
+	float c = cosf(angle), s = sinf(angle);
+
+	m->mat[0] = c*sx; m->mat[1] = s*sx;
+	m->mat[2] = (skew*c - s)*sy; m->mat[3] = (skew*s + c)*sy;
+	m->mat[4] = RandomFloat(-1024.0f, 1024.0f);
+	m->mat[5] = RandomFloat(-1024.0f, 1024.0f);
+}
+
+// Largest difference relative to the largest element of the reference.
+static double
+Error(const float *result, const float *reference, int count)
+{
+	double error = 0.0, scale = 1e-30;
+	for(int i=0; i<count; i++){
+		error = fmax(error, fabs(result[i] - reference[i]));
+		scale = fmax(scale, fabs(reference[i]));
+	}
+
+	return error/scale;
+}
+
+static void
+Check(const char *name, int iteration, double error, double *worst)
+{
+	if(error > *worst) *worst = error;
+	if(error > MAX_ERROR){
+		printf("FAIL %s: iteration %d, relative error %g\n", name, iteration, error);
+		failures++;
+	}
+}
+
+static void
+TestAgainstMat4(void)
+{
+	double worstMultiply = 0.0, worstInverse = 0.0, worstMat4 = 0.0, worstVec = 0.0;
+
+	for(int i=0; i<ITERATIONS && !failures; i++){
+		kmMat3x2 a, b, result, expected;
+		kmMat4 a4, b4, result4, m4;
+		RandomNode(&a);
+		RandomNode(&b);
+		kmMat4AssignMat3x2(&a4, &a);
+		kmMat4AssignMat3x2(&b4, &b);
+
+		// Round trip
+		kmMat3x2AssignMat4(&result, &a4);
+		if(memcmp(&result, &a, sizeof(kmMat3x2)) != 0){
+			printf("FAIL kmMat3x2AssignMat4: round trip changed the matrix\n");
+			failures++;
+		}
+
+		kmMat3x2Multiply(&result, &a, &b);
+		kmMat4Multiply(&result4, &a4, &b4);
+		kmMat3x2AssignMat4(&expected, &result4);
+		Check("kmMat3x2Multiply", i, Error(result.mat, expected.mat, 6), &worstMultiply);
+
+		// Aliased output
+		kmMat3x2 aliased = a;
+		kmMat3x2Multiply(&aliased, &aliased, &b);
+		if(memcmp(&aliased, &result, sizeof(kmMat3x2)) != 0){
+			printf("FAIL kmMat3x2Multiply: aliased result differs\n");
+			failures++;
+		}
+
+		if(kmMat3x2Inverse(&result, &a) == NULL){
+			printf("FAIL kmMat3x2Inverse: iteration %d, invertible matrix reported as singular\n", i);
+			failures++;
+			break;
+		}
+		kmMat4InverseAffine(&result4, &a4);
+		kmMat3x2AssignMat4(&expected, &result4);
+		Check("kmMat3x2Inverse", i, Error(result.mat, expected.mat, 6), &worstInverse);
+
+		// pM1 * pM2 with a general 4x4 pM1, like the modelview matrix of kmGLMultMatrix3x2()
+		for(int j=0; j<16; j++) m4.mat[j] = RandomFloat(-10.0f, 10.0f);
+		kmMat4Multiply(&result4, &m4, &a4);
+		kmMat4 fast;
+		kmMat4MultiplyMat3x2(&fast, &m4, &a);
+		Check("kmMat4MultiplyMat3x2", i, Error(fast.mat, result4.mat, 16), &worstMat4);
+		kmMat4MultiplyMat3x2(&m4, &m4, &a);
+		if(memcmp(&m4, &fast, sizeof(kmMat4)) != 0){
+			printf("FAIL kmMat4MultiplyMat3x2: aliased result differs\n");
+			failures++;
+		}
+
+		kmVec2 v = {RandomFloat(-500.0f, 500.0f), RandomFloat(-500.0f, 500.0f)}, v2;
+		kmVec3 v3 = {v.x, v.y, 0.0f};
+		kmVec2TransformMat3x2(&v2, &v, &a);
+		kmVec3Transform(&v3, &v3, &a4);
+		Check("kmVec2TransformMat3x2", i, Error(&v2.x, &v3.x, 2), &worstVec);
+	}
+
+	printf("kmMat3x2Multiply: max relative error %.3g\n", worstMultiply);
+	printf("kmMat3x2Inverse: max relative error %.3g\n", worstInverse);
+	printf("kmMat4MultiplyMat3x2: max relative error %.3g\n", worstMat4);
+	printf("kmVec2TransformMat3x2: max relative error %.3g\n", worstVec);
+}
+
+static void
+TestConstructors(void)
+{
+	kmMat3x2 m, expected;
+	kmMat4 m4;
+
+	kmMat3x2Rotation(&m, 0.7f);
+	kmMat3x2AssignMat4(&expected, kmMat4RotationZ(&m4, 0.7f));
+	if(!kmMat3x2AreEqual(&m, &expected)){
+		printf("FAIL kmMat3x2Rotation: should match kmMat4RotationZ()\n");
+		failures++;
+	}
+
+	kmMat3x2Scaling(&m, 2.0f, 3.0f);
+	kmMat3x2AssignMat4(&expected, kmMat4Scaling(&m4, 2.0f, 3.0f, 1.0f));
+	if(!kmMat3x2AreEqual(&m, &expected)){
+		printf("FAIL kmMat3x2Scaling: should match kmMat4Scaling()\n");
+		failures++;
+	}
+
+	kmMat3x2Translation(&m, 4.0f, 5.0f);
+	kmMat3x2AssignMat4(&expected, kmMat4Translation(&m4, 4.0f, 5.0f, 0.0f));
+	if(!kmMat3x2AreEqual(&m, &expected)){
+		printf("FAIL kmMat3x2Translation: should match kmMat4Translation()\n");
+		failures++;
+	}
+
+	kmMat3x2 inverse;
+	kmMat3x2Multiply(&m, kmMat3x2Inverse(&inverse, &m), &m);
+	if(!kmMat3x2IsIdentity(&m)){
+		printf("FAIL kmMat3x2Inverse: should give the identity\n");
+		failures++;
+	}
+
+	kmMat3x2Scaling(&m, 1.0f, 0.0f);
+	if(kmMat3x2Inverse(&inverse, &m) != NULL){
+		printf("FAIL kmMat3x2Inverse: singular matrix was inverted\n");
+		failures++;
+	}
+
+	// kmGLMultMatrix3x2() must match kmGLMultMatrix() with the expanded matrix.
+	kmMat4 expected4, result4;
+	RandomNode(&m);
+	kmGLMatrixMode(KM_GL_MODELVIEW);
+	kmGLLoadIdentity();
+	kmGLTranslatef(1.0f, 2.0f, 3.0f);
+	kmGLPushMatrix();
+	kmGLMultMatrix(kmMat4AssignMat3x2(&m4, &m));
+	kmGLGetMatrix(KM_GL_MODELVIEW, &expected4);
+	kmGLPopMatrix();
+	kmGLMultMatrix3x2(&m);
+	kmGLGetMatrix(KM_GL_MODELVIEW, &result4);
+	if(Error(result4.mat, expected4.mat, 16) > MAX_ERROR){
+		printf("FAIL kmGLMultMatrix3x2: should match kmGLMultMatrix()\n");
+		failures++;
+	}
+}
+
+// Same layout as cocos2d's ccV3F_C4B_T2F.
+typedef struct Vertex {
+	kmVec3 position;
+	unsigned char color[4];
+	float u, v;
+} Vertex;
+
+#define NUM_VERTICES 1001
+
+static void
+TestStrided(void)
+{
+	static Vertex vertices[NUM_VERTICES], transformed[NUM_VERTICES];
+	static kmVec2 points[NUM_VERTICES], results[NUM_VERTICES];
+
+	for(int iteration=0; iteration<20; iteration++){
+		kmMat3x2 m;
+		RandomNode(&m);
+
+		for(int i=0; i<NUM_VERTICES; i++){
+			kmVec3Fill(&vertices[i].position, RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), (float)i);
+			memset(vertices[i].color, i, 4);
+			vertices[i].u = vertices[i].v = (float)i;
+			points[i].x = vertices[i].position.x;
+			points[i].y = vertices[i].position.y;
+		}
+
+		// Odd counts exercise the remainder of the SIMD kernel.
+		unsigned int count = NUM_VERTICES - (iteration&1);
+
+		memcpy(transformed, vertices, sizeof(vertices));
+		kmVec2TransformMat3x2Strided((kmVec2 *)&transformed[0].position, sizeof(Vertex), (kmVec2 *)&transformed[0].position, sizeof(Vertex), &m, count);
+		kmVec2TransformMat3x2Strided(results, 0, points, 0, &m, count);
+
+		for(unsigned int i=0; i<NUM_VERTICES; i++){
+			kmVec2 expected = points[i];
+			if(i < count) kmVec2TransformMat3x2(&expected, &points[i], &m);
+
+			if(memcmp(&results[i], &expected, sizeof(kmVec2)) != 0 && i < count){
+				printf("FAIL kmVec2TransformMat3x2Strided: vector %d differs\n", i);
+				failures++;
+				return;
+			}
+
+			if(transformed[i].position.x != expected.x || transformed[i].position.y != expected.y){
+				printf("FAIL kmVec2TransformMat3x2Strided: vertex %d differs\n", i);
+				failures++;
+				return;
+			}
+
+			if(transformed[i].position.z != vertices[i].position.z || memcmp(transformed[i].color, vertices[i].color, 4) != 0 || transformed[i].u != vertices[i].u){
+				printf("FAIL kmVec2TransformMat3x2Strided: vertex %d was overwritten\n", i);
+				failures++;
+				return;
+			}
+		}
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	TestAgainstMat4();
+	TestConstructors();
+	TestStrided();
+
+	return TestResult();
+}
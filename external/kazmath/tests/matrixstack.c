@@ -0,0 +1,207 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+	Matrix stack test.
+
+	Checks that the kmGL matrix stacks grow without losing matrices, that contexts are
+	independent of each other and of the default context, and that worker threads can
+	use the global kmGL API on their own contexts at the same time.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "kazmath/kazmath.h"
+#include "kazmath/GL/matrix.h"
+
+#include "test_util.h"
+
+#define DEPTH 1000
+#define NUM_THREADS 8
+#define THREAD_ITERATIONS 2000
+
+// Pushes DEPTH matrices, each translated by one more than the previous, then pops them all.
+// Returns 0 if any matrix came back wrong.
+static int
+PushPopTranslations(kmGLContext *context)
+{
+	kmMat4 m;
+
+	for(int i=1; i<=DEPTH; i++){
+		kmGLContextPushMatrix(context);
+		kmGLContextTranslatef(context, 1.0f, 0.0f, 0.0f);
+	}
+
+	kmGLContextGetMatrix(context, KM_GL_MODELVIEW, &m);
+	if(m.mat[12] != (float)DEPTH) return 0;
+
+	for(int i=DEPTH - 1; i>=0; i--){
+		kmGLContextPopMatrix(context);
+		kmGLContextGetMatrix(context, KM_GL_MODELVIEW, &m);
+		if(m.mat[12] != (float)i) return 0;
+	}
+
+	return 1;
+}
+
+static void
+TestGrowth(void)
+{
+	kmGLContext context;
+	kmGLContextInitialize(&context, 4);
+	Expect(context.modelview_matrix_stack.capacity == 4, "initial capacity");
+
+	Expect(PushPopTranslations(&context), "matrices lost while growing");
+
+	// Doubling from 4 to fit DEPTH + 1 matrices.
+	int capacity = 4;
+	while(capacity < DEPTH + 1) capacity *= 2;
+	Expect(context.modelview_matrix_stack.capacity == capacity, "capacity should double");
+	Expect(context.modelview_matrix_stack.item_count == 1, "only the identity should be left");
+
+	// Popping into a matrix returns the popped one.
+	kmMat4 popped;
+	kmGLContextPushMatrix(&context);
+	kmGLContextScalef(&context, 2.0f, 2.0f, 2.0f);
+	km_mat4_stack_pop(context.current_stack, &popped);
+	Expect(popped.mat[0] == 2.0f, "km_mat4_stack_pop() should return the popped matrix");
+
+	kmGLContextRelease(&context);
+}
+
+static void
+TestIndependentContexts(void)
+{
+	kmGLContext a, b;
+	kmMat4 m;
+	kmGLContextInitialize(&a, 0);
+	kmGLContextInitialize(&b, 0);
+
+	kmGLMatrixMode(KM_GL_MODELVIEW);
+	kmGLLoadIdentity();
+
+	kmGLContextMatrixMode(&a, KM_GL_PROJECTION);
+	kmGLContextScalef(&a, 3.0f, 3.0f, 3.0f);
+	kmGLContextTranslatef(&b, 5.0f, 0.0f, 0.0f);
+
+	kmGLContextGetMatrix(&a, KM_GL_PROJECTION, &m);
+	Expect(m.mat[0] == 3.0f, "context projection");
+	kmGLContextGetMatrix(&a, KM_GL_MODELVIEW, &m);
+	Expect(kmMat4IsIdentity(&m), "context modelview should be untouched");
+	kmGLContextGetMatrix(&b, KM_GL_MODELVIEW, &m);
+	Expect(m.mat[12] == 5.0f, "second context modelview");
+	kmGLGetMatrix(KM_GL_MODELVIEW, &m);
+	Expect(kmMat4IsIdentity(&m), "default context should be untouched");
+
+	// The global API follows the current context.
+	kmGLSetCurrentContext(&b);
+	Expect(kmGLGetCurrentContext() == &b, "current context");
+	kmGLTranslatef(1.0f, 0.0f, 0.0f);
+	kmGLContextGetMatrix(&b, KM_GL_MODELVIEW, &m);
+	Expect(m.mat[12] == 6.0f, "global API should use the current context");
+	kmGLSetCurrentContext(NULL);
+
+	kmGLGetMatrix(KM_GL_MODELVIEW, &m);
+	Expect(kmMat4IsIdentity(&m), "default context should be restored");
+
+	kmGLContextRelease(&a);
+	kmGLContextRelease(&b);
+}
+
+typedef struct ThreadData {
+	int index;
+	int ok;
+} ThreadData;
+
+static void *
+ThreadFunc(void *ptr)
+{
+	ThreadData *data = (ThreadData *)ptr;
+	kmGLContext context;
+	kmGLContextInitialize(&context, 2);
+	kmGLSetCurrentContext(&context);
+
+	data->ok = 1;
+	for(int i=0; i<THREAD_ITERATIONS && data->ok; i++){
+		kmMat4 m;
+		kmGLMatrixMode(KM_GL_MODELVIEW);
+		kmGLPushMatrix();
+		kmGLTranslatef((float)data->index, (float)i, 0.0f);
+		kmGLPushMatrix();
+		kmGLScalef(2.0f, 2.0f, 2.0f);
+		kmGLGetMatrix(KM_GL_MODELVIEW, &m);
+		if(m.mat[0] != 2.0f || m.mat[12] != (float)data->index || m.mat[13] != (float)i) data->ok = 0;
+		kmGLPopMatrix();
+		kmGLPopMatrix();
+
+		kmGLGetMatrix(KM_GL_MODELVIEW, &m);
+		if(!kmMat4IsIdentity(&m)) data->ok = 0;
+	}
+
+	kmGLSetCurrentContext(NULL);
+	kmGLContextRelease(&context);
+	return NULL;
+}
+
+static void
+TestThreads(void)
+{
+	pthread_t threads[NUM_THREADS];
+	ThreadData data[NUM_THREADS];
+
+	for(int i=0; i<NUM_THREADS; i++){
+		data[i].index = i + 1;
+		pthread_create(&threads[i], NULL, ThreadFunc, &data[i]);
+	}
+
+	// Use the default context on the main thread in the meantime.
+	Expect(PushPopTranslations(kmGLGetCurrentContext()), "default context while threads run");
+
+	for(int i=0; i<NUM_THREADS; i++){
+		pthread_join(threads[i], NULL);
+		Expect(data[i].ok, "thread context results");
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	// Run the threads first so they race the main thread to create the thread key and the default context.
+	TestThreads();
+	TestGrowth();
+	TestIndependentContexts();
+
+	// The default context can be freed and is recreated on next use.
+	kmGLFreeAll();
+	kmMat4 m;
+	kmGLGetMatrix(KM_GL_PROJECTION, &m);
+	Expect(kmMat4IsIdentity(&m), "default context after kmGLFreeAll()");
+	kmGLFreeAll();
+
+	return TestResult();
+}
@@ -0,0 +1,410 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+	SIMD regression test.
+
+	Checks kmMat4Multiply(), kmVec3Transform(), kmVec4Transform(), their strided array versions,
+	kmQuaternionMultiply() and kmMat4Inverse() against the scalar formulas on random input. The products must
+	be within a few ulps of the scalar reference (they are accumulated in the same order,
+	so normally they match exactly). The inverse is compared against a double precision
+	inverse since the scalar float version is not exact either.
+
+	Built against both the SIMD and the scalar (KM_NO_SIMD) library.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "kazmath/kazmath.h"
+#include "kazmath/vec4.h"
+#include "kazmath/sse_matrix_impl.h"
+
+#include "test_util.h"
+
+#define ITERATIONS 100000
+#define MAX_ULPS 4
+#define MAX_INVERSE_ERROR 1e-4
+
+static int
+UlpDistance(float a, float b)
+{
+	if(a == b) return 0;
+	if(isnan(a) || isnan(b)) return 0x7FFFFFFF;
+
+	int ia, ib;
+	memcpy(&ia, &a, sizeof(float));
+	memcpy(&ib, &b, sizeof(float));
+	if(ia < 0) ia = (int)0x80000000 - ia;
+	if(ib < 0) ib = (int)0x80000000 - ib;
+
+	long long d = (long long)ia - (long long)ib;
+	if(d < 0) d = -d;
+	return (d > 0x7FFFFFFF ? 0x7FFFFFFF : (int)d);
+}
+
+static int
+CheckUlps(const char *name, int iteration, const float *result, const float *reference, int count, int *worst)
+{
+	for(int i=0; i<count; i++){
+		int ulps = UlpDistance(result[i], reference[i]);
+		if(ulps > *worst) *worst = ulps;
+
+		if(ulps > MAX_ULPS){
+			printf("FAIL %s: iteration %d, element %d is %.9g, expected %.9g (%d ulps)\n", name, iteration, i, result[i], reference[i], ulps);
+			failures++;
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static void
+RandomMat4(float *m)
+{
+	for(int i=0; i<16; i++) m[i] = RandomFloat(-10.0f, 10.0f);
+}
+
+//MARK: Scalar Reference
+
+static void
+ReferenceMat4Multiply(float *out, const float *m1, const float *m2)
+{
+	for(int col=0; col<4; col++){
+		for(int row=0; row<4; row++){
+			out[col*4 + row] = m1[row] * m2[col*4] + m1[row + 4] * m2[col*4 + 1] + m1[row + 8] * m2[col*4 + 2] + m1[row + 12] * m2[col*4 + 3];
+		}
+	}
+}
+
+static void
+ReferenceVec4Transform(float *out, const float *v, const float *m)
+{
+	for(int row=0; row<4; row++){
+		out[row] = v[0] * m[row] + v[1] * m[row + 4] + v[2] * m[row + 8] + v[3] * m[row + 12];
+	}
+}
+
+static void
+ReferenceVec3Transform(float *out, const float *v, const float *m)
+{
+	for(int row=0; row<3; row++){
+		out[row] = v[0] * m[row] + v[1] * m[row + 4] + v[2] * m[row + 8] + m[row + 12];
+	}
+}
+
+static void
+ReferenceQuaternionMultiply(kmQuaternion *out, const kmQuaternion *q1, const kmQuaternion *q2)
+{
+	out->w = q1->w * q2->w - q1->x * q2->x - q1->y * q2->y - q1->z * q2->z;
+	out->x = q1->w * q2->x + q1->x * q2->w + q1->y * q2->z - q1->z * q2->y;
+	out->y = q1->w * q2->y + q1->y * q2->w + q1->z * q2->x - q1->x * q2->z;
+	out->z = q1->w * q2->z + q1->z * q2->w + q1->x * q2->y - q1->y * q2->x;
+}
+
+// Gauss-Jordan elimination with partial pivoting in double precision.
+// Returns 0 if the matrix is singular.
+static int
+ReferenceMat4Inverse(double *out, const float *m)
+{
+	double a[4][8];
+	for(int row=0; row<4; row++){
+		for(int col=0; col<4; col++){
+			a[row][col] = m[col*4 + row];
+			a[row][col + 4] = (row == col);
+		}
+	}
+
+	for(int col=0; col<4; col++){
+		int pivot = col;
+		for(int row=col + 1; row<4; row++){
+			if(fabs(a[row][col]) > fabs(a[pivot][col])) pivot = row;
+		}
+		if(a[pivot][col] == 0.0) return 0;
+
+		for(int i=0; i<8; i++){
+			double tmp = a[col][i]; a[col][i] = a[pivot][i]; a[pivot][i] = tmp;
+		}
+
+		double inv = 1.0/a[col][col];
+		for(int i=0; i<8; i++) a[col][i] *= inv;
+
+		for(int row=0; row<4; row++){
+			if(row == col) continue;
+
+			double f = a[row][col];
+			for(int i=0; i<8; i++) a[row][i] -= f*a[col][i];
+		}
+	}
+
+	for(int row=0; row<4; row++){
+		for(int col=0; col<4; col++) out[col*4 + row] = a[row][col + 4];
+	}
+
+	return 1;
+}
+
+//MARK: Tests
+
+static void
+TestMat4Multiply(void)
+{
+	int worst = 0;
+
+	for(int i=0; i<ITERATIONS; i++){
+		kmMat4 a, b, result;
+		float reference[16];
+		RandomMat4(a.mat);
+		RandomMat4(b.mat);
+
+		ReferenceMat4Multiply(reference, a.mat, b.mat);
+		kmMat4Multiply(&result, &a, &b);
+		if(!CheckUlps("kmMat4Multiply", i, result.mat, reference, 16, &worst)) break;
+
+		// The output is allowed to alias the input.
+		kmMat4Multiply(&a, &a, &b);
+		if(!CheckUlps("kmMat4Multiply (aliased)", i, a.mat, reference, 16, &worst)) break;
+	}
+
+	printf("kmMat4Multiply: max %d ulps\n", worst);
+}
+
+static void
+TestVecTransform(void)
+{
+	int worst3 = 0, worst4 = 0;
+
+	for(int i=0; i<ITERATIONS; i++){
+		kmMat4 m;
+		RandomMat4(m.mat);
+
+		kmVec4 v4 = {RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), RandomFloat(-2.0f, 2.0f)};
+		kmVec4 result4;
+		float reference4[4];
+		ReferenceVec4Transform(reference4, &v4.x, m.mat);
+		kmVec4Transform(&result4, &v4, &m);
+		if(!CheckUlps("kmVec4Transform", i, &result4.x, reference4, 4, &worst4)) break;
+
+		// Must not write past the end of a kmVec3.
+		struct {kmVec3 v; float guard;} result3 = {{0.0f, 0.0f, 0.0f}, 12345.0f};
+		kmVec3 v3 = {v4.x, v4.y, v4.z};
+		float reference3[3];
+		ReferenceVec3Transform(reference3, &v3.x, m.mat);
+		kmVec3Transform(&result3.v, &v3, &m);
+		if(!CheckUlps("kmVec3Transform", i, &result3.v.x, reference3, 3, &worst3)) break;
+
+		if(result3.guard != 12345.0f){
+			printf("FAIL kmVec3Transform: wrote past the end of the output\n");
+			failures++;
+			break;
+		}
+	}
+
+	printf("kmVec4Transform: max %d ulps\n", worst4);
+	printf("kmVec3Transform: max %d ulps\n", worst3);
+}
+
+static void
+TestQuaternionMultiply(void)
+{
+	int worst = 0;
+
+	for(int i=0; i<ITERATIONS; i++){
+		kmQuaternion a = {RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f)};
+		kmQuaternion b = {RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f)};
+		kmQuaternion result, reference;
+
+		ReferenceQuaternionMultiply(&reference, &a, &b);
+		kmQuaternionMultiply(&result, &a, &b);
+		if(!CheckUlps("kmQuaternionMultiply", i, &result.x, &reference.x, 4, &worst)) break;
+	}
+
+	printf("kmQuaternionMultiply: max %d ulps\n", worst);
+}
+
+// Same layout as cocos2d's ccV3F_C4B_T2F.
+typedef struct Vertex {
+	kmVec3 position;
+	unsigned char color[4];
+	float u, v;
+} Vertex;
+
+#define NUM_VERTICES 1001
+
+static void
+TestStridedTransform(void)
+{
+	static Vertex vertices[NUM_VERTICES], transformed[NUM_VERTICES];
+	static kmVec4 vec4s[NUM_VERTICES], results[NUM_VERTICES];
+	int worst3 = 0, worst4 = 0;
+
+	for(int iteration=0; iteration<20; iteration++){
+		kmMat4 m;
+		RandomMat4(m.mat);
+
+		for(int i=0; i<NUM_VERTICES; i++){
+			kmVec3Fill(&vertices[i].position, RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f));
+			memset(vertices[i].color, i, 4);
+			vertices[i].u = vertices[i].v = (float)i;
+
+			kmVec4Fill(&vec4s[i], RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), RandomFloat(-100.0f, 100.0f), RandomFloat(-2.0f, 2.0f));
+		}
+
+		// Transform the positions in place, the colors and texture coordinates must be left alone.
+		memcpy(transformed, vertices, sizeof(vertices));
+		kmVec3TransformStrided(&transformed[0].position, sizeof(Vertex), &transformed[0].position, sizeof(Vertex), &m, NUM_VERTICES);
+
+		kmVec4TransformStrided(results, 0, vec4s, 0, &m, NUM_VERTICES);
+
+		for(int i=0; i<NUM_VERTICES; i++){
+			float reference3[3], reference4[4];
+			ReferenceVec3Transform(reference3, &vertices[i].position.x, m.mat);
+			ReferenceVec4Transform(reference4, &vec4s[i].x, m.mat);
+
+			if(!CheckUlps("kmVec3TransformStrided", i, &transformed[i].position.x, reference3, 3, &worst3)) return;
+			if(!CheckUlps("kmVec4TransformStrided", i, &results[i].x, reference4, 4, &worst4)) return;
+
+			if(memcmp(transformed[i].color, vertices[i].color, 4) != 0 || transformed[i].u != vertices[i].u || transformed[i].v != vertices[i].v){
+				printf("FAIL kmVec3TransformStrided: vertex %d was overwritten\n", i);
+				failures++;
+				return;
+			}
+		}
+
+		// The element strides of kmVec4TransformArray(), every other vector.
+		memset(results, 0, sizeof(results));
+		kmVec4TransformArray(results, 2, vec4s, 2, &m, NUM_VERTICES/2);
+
+		for(int i=0; i<NUM_VERTICES; i++){
+			float reference4[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			if(i%2 == 0 && i/2 < NUM_VERTICES/2) ReferenceVec4Transform(reference4, &vec4s[i].x, m.mat);
+
+			if(!CheckUlps("kmVec4TransformArray", i, &results[i].x, reference4, 4, &worst4)) return;
+		}
+	}
+
+	printf("kmVec3TransformStrided: max %d ulps\n", worst3);
+	printf("kmVec4TransformStrided: max %d ulps\n", worst4);
+}
+
+static double
+InverseError(const kmMat4 *result, const double *reference)
+{
+	double error = 0.0, scale = 0.0;
+	for(int i=0; i<16; i++){
+		error = fmax(error, fabs(result->mat[i] - reference[i]));
+		scale = fmax(scale, fabs(reference[i]));
+	}
+
+	return error/scale;
+}
+
+static void
+TestMat4Inverse(void)
+{
+	double worst = 0.0;
+	int tested = 0;
+
+	for(int i=0; i<ITERATIONS/10; i++){
+		kmMat4 m, result;
+		double reference[16];
+
+		if(i%2 == 0){
+			RandomMat4(m.mat);
+		} else {
+			// Typical scene graph transform.
+			kmMat4 rotation, scale, translation;
+			kmVec3 axis = {RandomFloat(-1.0f, 1.0f), RandomFloat(-1.0f, 1.0f), RandomFloat(0.1f, 1.0f)};
+			kmMat4RotationAxisAngle(&rotation, kmVec3Normalize(&axis, &axis), RandomFloat(-3.0f, 3.0f));
+			kmMat4Scaling(&scale, RandomFloat(0.1f, 10.0f), RandomFloat(0.1f, 10.0f), RandomFloat(0.1f, 10.0f));
+			kmMat4Translation(&translation, RandomFloat(-1000.0f, 1000.0f), RandomFloat(-1000.0f, 1000.0f), RandomFloat(-1000.0f, 1000.0f));
+			kmMat4Multiply(&m, &rotation, &scale);
+			kmMat4Multiply(&m, &translation, &m);
+		}
+
+		if(!ReferenceMat4Inverse(reference, m.mat)) continue;
+
+		// Skip badly conditioned random matrices, neither version is accurate for those.
+		double norm = 0.0, inverseNorm = 0.0;
+		for(int j=0; j<16; j++){
+			norm = fmax(norm, fabs(m.mat[j]));
+			inverseNorm = fmax(inverseNorm, fabs(reference[j]));
+		}
+		if(norm*inverseNorm > 1e3) continue;
+
+		if(kmMat4Inverse(&result, &m) == NULL){
+			printf("FAIL kmMat4Inverse: iteration %d, invertible matrix reported as singular\n", i);
+			failures++;
+			break;
+		}
+
+		double error = InverseError(&result, reference);
+		worst = fmax(worst, error);
+		tested++;
+
+		if(error > MAX_INVERSE_ERROR){
+			printf("FAIL kmMat4Inverse: iteration %d, relative error %g\n", i, error);
+			failures++;
+			break;
+		}
+	}
+
+	// Small integers so the determinant is exactly zero, nearly singular matrices are not detected.
+	kmMat4 singular, result;
+	for(int j=0; j<16; j++) singular.mat[j] = floorf(RandomFloat(-10.0f, 10.0f));
+	// Make the last column a copy of the first.
+	memcpy(&singular.mat[12], &singular.mat[0], 4*sizeof(float));
+	if(kmMat4Inverse(&result, &singular) != NULL){
+		printf("FAIL kmMat4Inverse: singular matrix was inverted\n");
+		failures++;
+	}
+
+	printf("kmMat4Inverse: max relative error %g over %d matrices\n", worst, tested);
+}
+
+int
+main(int argc, char **argv)
+{
+#if KM_USE_SSE && defined(__AVX__)
+	printf("Testing the SSE kernels with AVX.\n");
+#elif KM_USE_SSE
+	printf("Testing the SSE kernels.\n");
+#elif defined(__ARM_NEON__) && !defined(KM_NO_SIMD)
+	printf("Testing the NEON kernels.\n");
+#else
+	printf("Testing the scalar kernels.\n");
+#endif
+
+	TestMat4Multiply();
+	TestVecTransform();
+	TestStridedTransform();
+	TestQuaternionMultiply();
+	TestMat4Inverse();
+
+	return TestResult();
+}
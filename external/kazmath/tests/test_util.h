@@ -0,0 +1,71 @@
+/*
+Copyright (c) 2008, Luke Benstead.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+    * Redistributions of source code must retain the above copyright notice,
+      this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright notice,
+      this list of conditions and the following disclaimer in the documentation
+      and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+	Helpers shared by the tests. Each test is a separate executable, so the
+	counters live in the header.
+*/
+
+#ifndef KAZMATH_TEST_UTIL_H_INCLUDED
+#define KAZMATH_TEST_UTIL_H_INCLUDED
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int failures = 0;
+
+static unsigned int seed = 1;
+
+// Small LCG so the input is the same everywhere.
+static inline float
+RandomFloat(float min, float max)
+{
+	seed = seed*1664525u + 1013904223u;
+	return min + (max - min)*(float)(seed >> 8)/(float)(1 << 24);
+}
+
+static inline void
+Expect(int condition, const char *message)
+{
+	if(!condition){
+		printf("FAIL %s\n", message);
+		failures++;
+	}
+}
+
+// Prints the summary and returns the exit status for main().
+static inline int
+TestResult(void)
+{
+	if(failures){
+		printf("%d failures\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	printf("All passed\n");
+	return EXIT_SUCCESS;
+}
+
+#endif // KAZMATH_TEST_UTIL_H_INCLUDED
@@ -147,6 +147,26 @@
 }
 @end
 
+@interface TextureAsyncPriority : TextureDemo
+{
+	CCLabelTTF *status_;
+	int spritesLoaded_;
+}
+@end
+
+@interface TextureAsyncCancel : TextureDemo
+{
+	CCLabelTTF *status_;
+}
+@end
+
+@interface TextureAsyncBatch : TextureDemo
+{
+	CCLabelTTF *status_;
+	int batches_;
+}
+@end
+
 @interface TextureLibPNG : TextureDemo
 {}
 -(void) transformSprite:(CCSprite*)sprite;
@@ -53,6 +53,9 @@ static NSString *transitions[] = {
 	@"TextureBlend",
 	@"TextureAsync",
 	@"TextureAsyncBlock",
+	@"TextureAsyncPriority",
+	@"TextureAsyncCancel",
+	@"TextureAsyncBatch",
 	@"TextureLibPNGTest1",
 	@"TextureLibPNGTest2",
 	@"TextureLibPNGTest3",
@@ -1339,6 +1342,238 @@ Class restartAction()
 }
 @end
 
+#pragma mark -
+#pragma mark TextureAsyncPriority
+
+@implementation TextureAsyncPriority
+-(id) init
+{
+	if( (self=[super init]) ) {
+
+		CGSize size =[[CCDirector sharedDirector] winSize];
+
+		status_ = [CCLabelTTF labelWithString:@"Loading..." fontName:@"Marker Felt" fontSize:24];
+		status_.position = ccp( size.width/2, size.height/2);
+		[self addChild:status_ z:10];
+
+		[[CCTextureCache sharedTextureCache] removeAllTextures];
+		[self schedule:@selector(loadImages:) interval:1.0f];
+	}
+	return self;
+}
+
+- (void) dealloc
+{
+	[[CCTextureCache sharedTextureCache] removeAllTextures];
+	[super dealloc];
+}
+
+-(void) loadImages:(ccTime) dt
+{
+	[self unschedule:_cmd];
+
+	CCTextureCache *cache = [CCTextureCache sharedTextureCache];
+	CCTextureRequest *last = nil;
+
+	for( int i=0;i < 8;i++) {
+		for( int j=0;j < 8; j++) {
+			NSString *sprite = [NSString stringWithFormat:@"sprite-%d-%d.png", i, j];
+			last = [cache addImageAsync:sprite priority:0 withBlock:^(CCTexture2D *tex) {
+				spritesLoaded_++;
+			}];
+		}
+	}
+
+	// requested last, but it should be decoded as soon as a decoder is free
+	[cache addImageAsync:@"background1.jpg" priority:10 withBlock:^(CCTexture2D *tex) {
+		NSAssert( tex, @"FAIL. background1.jpg should be loaded");
+		NSAssert( spritesLoaded_ < 32, @"FAIL. background1.jpg should be loaded before most of the sprites");
+
+		[status_ setString:[NSString stringWithFormat:@"background1.jpg loaded after %d sprites", spritesLoaded_]];
+
+		CCSprite *sprite = [CCSprite spriteWithTexture:tex];
+		sprite.anchorPoint = ccp(0,0);
+		[self addChild:sprite z:-1];
+	}];
+
+	// the priority can be raised while it is pending
+	last.priority = 20;
+}
+
+-(NSString *) title
+{
+	return @"Texture Async Priority";
+}
+
+-(NSString *) subtitle
+{
+	return @"background1.jpg is requested after 64 sprites, but with a higher priority";
+}
+@end
+
+#pragma mark -
+#pragma mark TextureAsyncCancel
+
+@implementation TextureAsyncCancel
+-(id) init
+{
+	if( (self=[super init]) ) {
+
+		CGSize size =[[CCDirector sharedDirector] winSize];
+
+		status_ = [CCLabelTTF labelWithString:@"Loading..." fontName:@"Marker Felt" fontSize:24];
+		status_.position = ccp( size.width/2, size.height/2);
+		[self addChild:status_ z:10];
+
+		[[CCTextureCache sharedTextureCache] removeAllTextures];
+		[self schedule:@selector(loadImages:) interval:1.0f];
+	}
+	return self;
+}
+
+- (void) dealloc
+{
+	[[CCTextureCache sharedTextureCache] removeAllTextures];
+	[super dealloc];
+}
+
+-(void) loadImages:(ccTime) dt
+{
+	[self unschedule:_cmd];
+
+	CCTextureCache *cache = [CCTextureCache sharedTextureCache];
+	NSMutableArray *paths = [NSMutableArray arrayWithCapacity:64];
+
+	for( int i=0;i < 8;i++)
+		for( int j=0;j < 8; j++)
+			[paths addObject:[NSString stringWithFormat:@"sprite-%d-%d.png", i, j]];
+
+	NSMutableSet *cancelled = [NSMutableSet setWithCapacity:32];
+
+	NSArray *requests = [cache addImagesAsync:paths priority:0 progress:nil withBlock:^(NSDictionary *textures) {
+
+		for( NSString *path in paths ) {
+			BOOL loaded = [textures objectForKey:path] != nil;
+			NSAssert( loaded != [cancelled containsObject:path], @"FAIL. Only the requests that were not cancelled should be loaded");
+		}
+
+		[status_ setString:[NSString stringWithFormat:@"%lu loaded, %lu cancelled", (unsigned long)[textures count], (unsigned long)[cancelled count]]];
+	}];
+
+	// cancelled in the cocos2d thread: their textures must not be reported, even if they were already decoded
+	for( NSUInteger i=1; i < [requests count]; i += 2 ) {
+		CCTextureRequest *request = [requests objectAtIndex:i];
+		[request cancel];
+		[cancelled addObject:request.path];
+	}
+
+	// an image requested twice is still loaded if only one of the requests is cancelled
+	CCTextureRequest *request = [cache addImageAsync:@"background2.jpg" priority:0 withBlock:^(CCTexture2D *tex) {
+		NSAssert( NO, @"FAIL. The block of a cancelled request should not be called");
+	}];
+	[cache addImageAsync:@"background2.jpg" priority:0 withBlock:^(CCTexture2D *tex) {
+		NSAssert( tex, @"FAIL. background2.jpg should be loaded");
+
+		CCSprite *sprite = [CCSprite spriteWithTexture:tex];
+		sprite.anchorPoint = ccp(0,0);
+		[self addChild:sprite z:-1];
+	}];
+	[request cancel];
+}
+
+-(NSString *) title
+{
+	return @"Texture Async Cancel";
+}
+
+-(NSString *) subtitle
+{
+	return @"Every other sprite is cancelled. background2.jpg should appear";
+}
+@end
+
+#pragma mark -
+#pragma mark TextureAsyncBatch
+
+@implementation TextureAsyncBatch
+-(id) init
+{
+	if( (self=[super init]) ) {
+
+		CGSize size =[[CCDirector sharedDirector] winSize];
+
+		status_ = [CCLabelTTF labelWithString:@"Loading..." fontName:@"Marker Felt" fontSize:24];
+		status_.position = ccp( size.width/2, size.height/2);
+		[self addChild:status_ z:10];
+
+		batches_ = 0;
+		[[CCTextureCache sharedTextureCache] removeAllTextures];
+		[self schedule:@selector(loadImages:) interval:1.0f];
+	}
+	return self;
+}
+
+- (void) dealloc
+{
+	[[CCTextureCache sharedTextureCache] removeAllTextures];
+	[super dealloc];
+}
+
+-(void) loadImages:(ccTime) dt
+{
+	[self unschedule:_cmd];
+
+	// many more images than CC_TEXTURE_CACHE_ASYNC_UPLOADS, so the decoders have to wait for the uploads
+	NSMutableArray *paths = [NSMutableArray arrayWithCapacity:72];
+	for( int i=0;i < 8;i++)
+		for( int j=0;j < 8; j++)
+			[paths addObject:[NSString stringWithFormat:@"sprite-%d-%d.png", i, j]];
+
+	[paths addObject:@"background1.jpg"];
+	[paths addObject:@"background2.jpg"];
+	[paths addObject:@"background.png"];
+	[paths addObject:@"atlastest.png"];
+	[paths addObject:@"grossini_dance_atlas.png"];
+	[paths addObject:@"grossini_dance_atlas.pvr"];
+	[paths addObject:@"PlanetCute-1024x1024-rgba4444.pvr.ccz"];
+	// failures are reported too
+	[paths addObject:@"does-not-exist.png"];
+
+	__block NSUInteger lastProgress = 0;
+
+	[[CCTextureCache sharedTextureCache] addImagesAsync:paths priority:0 progress:^(NSUInteger loaded, NSUInteger count) {
+
+		NSAssert( [NSThread currentThread] == [[CCDirector sharedDirector] runningThread], @"FAIL. Progress should be on cocos2d thread");
+		NSAssert( loaded == lastProgress + 1 && count == [paths count], @"FAIL. Progress should be reported once per image");
+		lastProgress = loaded;
+
+		[status_ setString:[NSString stringWithFormat:@"Batch %d: %lu / %lu", batches_ + 1, (unsigned long)loaded, (unsigned long)count]];
+
+	} withBlock:^(NSDictionary *textures) {
+
+		NSAssert( lastProgress == [paths count], @"FAIL. The block should be called after the last progress");
+		NSAssert( [textures count] == [paths count] - 1 && ! [textures objectForKey:@"does-not-exist.png"], @"FAIL. All the existing images should be loaded");
+
+		// load everything again: if an upload slot leaked, the second batch would never finish
+		if( ++batches_ < 2 ) {
+			[[CCTextureCache sharedTextureCache] removeAllTextures];
+			[self loadImages:0];
+		} else
+			[status_ setString:[NSString stringWithFormat:@"%d batches of %lu images loaded", batches_, (unsigned long)[paths count]]];
+	}];
+}
+
+-(NSString *) title
+{
+	return @"Texture Async Batch";
+}
+
+-(NSString *) subtitle
+{
+	return @"Progress should reach 72 / 72 twice";
+}
+@end
+
 
 
 #pragma mark -
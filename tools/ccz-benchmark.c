@@ -0,0 +1,178 @@
+/*
+ * cocos2d for iPhone: http://www.cocos2d-iphone.org
+ *
+ */
+
+/*
+ Decode throughput of the CCZ compression methods.
+
+ Every file is compressed with zlib (like "ccz") and with LZ4 (like "ccz -lz4"), then
+ inflated repeatedly. .ccz files are inflated first, so the atlases shipped with a
+ game can be passed as they are:
+
+	./ccz-benchmark ../Resources/Images/texture2048x2048_rgba4444.pvr ../Resources/Images/landscape-1024x1024-rgba8888.pvr.ccz
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <zlib.h>
+
+#include "../cocos2d/Support/ccLZ4.h"
+
+// decode each file for at least this long
+#define MIN_SECONDS 0.25
+
+static double seconds(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static uint32_t readBigEndian32(const unsigned char *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+/* reads a file, inflating version 1 and 2 zlib .ccz files. Returns the length or -1 */
+static long loadFile(const char *path, unsigned char **out)
+{
+    FILE *in = fopen(path, "rb");
+    if(!in)
+        return -1;
+
+    fseek(in, 0, SEEK_END);
+    long len = ftell(in);
+    fseek(in, 0, SEEK_SET);
+
+    unsigned char *data = malloc(len);
+    if(!data || fread(data, 1, len, in) != len)
+    {
+        fclose(in);
+        free(data);
+        return -1;
+    }
+    fclose(in);
+
+    // sig, compression_type, version, reserved and len, all big endian
+    if(len >= 16 && memcmp(data, "CCZ!", 4) == 0)
+    {
+        if(data[4] != 0 || data[5] != 0 || data[7] > 2)
+        {
+            printf("%s: only zlib .ccz files up to version 2 are supported\n", path);
+            free(data);
+            return -1;
+        }
+
+        uLongf inflatedLen = readBigEndian32(data + 12);
+        unsigned char *inflated = malloc(inflatedLen);
+        if(!inflated || uncompress(inflated, &inflatedLen, data + 16, len - 16) != Z_OK)
+        {
+            free(inflated);
+            free(data);
+            return -1;
+        }
+
+        free(data);
+        data = inflated;
+        len = inflatedLen;
+    }
+
+    *out = data;
+    return len;
+}
+
+/* MB of inflated data per second */
+static double benchmarkZlib(const unsigned char *compressed, uLongf compressedLen, unsigned char *out, uLongf len)
+{
+    int runs = 0;
+    double start = seconds(), elapsed;
+
+    do {
+        uLongf destLen = len;
+        if(uncompress(out, &destLen, compressed, compressedLen) != Z_OK || destLen != len)
+            return 0.0;
+
+        runs++;
+    } while((elapsed = seconds() - start) < MIN_SECONDS);
+
+    return runs * (double)len / elapsed / (1024.0 * 1024.0);
+}
+
+static double benchmarkLZ4(const unsigned char *compressed, unsigned int compressedLen, unsigned char *out, unsigned int len)
+{
+    int runs = 0;
+    double start = seconds(), elapsed;
+
+    do {
+        if(ccLZ4Decompress(compressed, compressedLen, out, len) < 0)
+            return 0.0;
+
+        runs++;
+    } while((elapsed = seconds() - start) < MIN_SECONDS);
+
+    return runs * (double)len / elapsed / (1024.0 * 1024.0);
+}
+
+int main (int argc, const char * argv[])
+{
+    if(argc < 2)
+    {
+        printf("\nUSAGE: ccz-benchmark <file> [<file> ...]\n\n");
+        exit(10);
+    }
+
+    printf("%-40s %10s %8s %8s %10s %10s %8s\n", "file", "size", "zlib %", "lz4 %", "zlib MB/s", "lz4 MB/s", "speedup");
+
+    int i;
+    for(i = 1; i < argc; i++)
+    {
+        unsigned char *data = NULL;
+        long len = loadFile(argv[i], &data);
+        if(len <= 0)
+        {
+            printf("%s: could not be read\n", argv[i]);
+            continue;
+        }
+
+        uLongf zlibLen = compressBound(len);
+        unsigned int lz4Len = ccLZ4CompressBound((unsigned int)len);
+        unsigned char *zlibData = malloc(zlibLen);
+        unsigned char *lz4Data = malloc(lz4Len);
+        unsigned char *out = malloc(len);
+        if(!zlibData || !lz4Data || !out)
+        {
+            printf("Out of memory\n");
+            exit(10);
+        }
+
+        if(compress2(zlibData, &zlibLen, data, len, Z_DEFAULT_COMPRESSION) != Z_OK ||
+           (lz4Len = ccLZ4Compress(data, (unsigned int)len, lz4Data, lz4Len)) == 0)
+        {
+            printf("%s: failed to compress\n", argv[i]);
+            exit(10);
+        }
+
+        double zlibSpeed = benchmarkZlib(zlibData, zlibLen, out, len);
+        double lz4Speed = benchmarkLZ4(lz4Data, lz4Len, out, (unsigned int)len);
+        if(memcmp(out, data, len) != 0 || zlibSpeed == 0.0 || lz4Speed == 0.0)
+        {
+            printf("%s: decoded data differs\n", argv[i]);
+            exit(10);
+        }
+
+        const char *name = strrchr(argv[i], '/');
+        printf("%-40s %10ld %7.1f%% %7.1f%% %10.1f %10.1f %7.2fx\n", name ? name + 1 : argv[i], len,
+               100.0 * zlibLen / len, 100.0 * lz4Len / len, zlibSpeed, lz4Speed, lz4Speed / zlibSpeed);
+
+        free(data);
+        free(zlibData);
+        free(lz4Data);
+        free(out);
+    }
+
+    return 0;
+}
@@ -1,3 +1,3 @@
 #!/bin/bash
-gcc ccz.c -lz -o ccz 
-
+gcc ccz.c ../cocos2d/Support/ccLZ4.c -lz -o ccz 
+gcc -O2 ccz-benchmark.c ../cocos2d/Support/ccLZ4.c -lz -o ccz-benchmark
@@ -16,43 +16,120 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #include <zlib.h>
 #include <architecture/byte_order.h>
 
+#include "../cocos2d/Support/ccLZ4.h"
+
 
 // Format header
 struct CCZHeader {
     uint8_t			sig[4];				// signature. Should be 'CCZ!' 4 bytes
     uint16_t		compression_type;	// should 0 (See below for supported formats)
-    uint16_t		version;			// should be 2 
+    uint16_t		version;			// 2, or 3 for chunked files
     uint32_t		reserved;			// Reserverd for users.
     uint32_t		len;				// size of the uncompressed file
 };
 
+// Version 3 only: followed by chunk_count big endian uint32_t compressed chunk sizes, then the chunks
+struct CCZChunkTable {
+    uint32_t		chunk_size;			// uncompressed size of each chunk, the last one holds the remainder
+    uint32_t		chunk_count;
+};
+
 
 enum {
     CCZ_COMPRESSION_ZLIB,				// zlib format.
     CCZ_COMPRESSION_BZIP2,				// bzip2 format (not supported yet)
-    CCZ_COMPRESSION_GZIP,				// gzip format (not supported yet)
+    CCZ_COMPRESSION_GZIP,				// gzip format.
+    CCZ_COMPRESSION_NONE,				// plain
+    CCZ_COMPRESSION_LZ4,				// LZ4 block format.
 };
 
 
+static void usage(void)
+{
+    printf("\nUSAGE: ccz [-chunk <KB> | -raw] [-gzip | -lz4 | -none] <infile>\n");
+    printf("\nA new file called <infile>.ccz will be generated\n");
+    printf("\n  -chunk <KB>  write a version 3 file with chunks of <KB> kilobytes, which load in parallel");
+    printf("\n  -raw         write only the compressed data to <infile>.raw, without the CCZ header.");
+    printf("\n               -raw -lz4 gives the data of TMX layers with compression=\"lz4\" (before base64)");
+    printf("\n  -gzip        use gzip instead of zlib");
+    printf("\n  -lz4         use LZ4, bigger files than zlib that load several times faster");
+    printf("\n  -none        store the data uncompressed\n\n");
+    exit(10);
+}
+
+/* compresses in into out, returns the compressed length or 0 on error */
+static uLongf compressBlock(int compression, unsigned char *out, uLongf outLen, const unsigned char *in, uLongf inLen)
+{
+    if(compression == CCZ_COMPRESSION_NONE)
+    {
+        memcpy(out, in, inLen);
+        return inLen;
+    }
+
+    if(compression == CCZ_COMPRESSION_LZ4)
+        return ccLZ4Compress(in, inLen, out, outLen);
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    int windowBits = (compression == CCZ_COMPRESSION_GZIP) ? 15 + 16 : 15;
+    if(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return 0;
+
+    stream.next_in = (Bytef*)in;
+    stream.avail_in = inLen;
+    stream.next_out = out;
+    stream.avail_out = outLen;
+
+    int err = deflate(&stream, Z_FINISH);
+    uLongf len = stream.total_out;
+    deflateEnd(&stream);
+
+    return (err == Z_STREAM_END) ? len : 0;
+}
+
+
 int main (int argc, const char * argv[]) 
 {
+    int compression = CCZ_COMPRESSION_ZLIB;
+    long chunkSize = 0;
+    int chunked = 0;
+    int raw = 0;
+    int arg;
+
     /* arg check */
-    if(argc != 2)
+    for(arg = 1; arg < argc - 1; arg++)
     {
-        printf("\nUSAGE: ccz <infile>\n");
-        printf("\nA new file called <infile>.ccz will be generated\n\n");
-        exit(10);
+        if(strcmp(argv[arg], "-chunk") == 0 && arg + 1 < argc - 1)
+        {
+            chunkSize = atol(argv[++arg]) * 1024;
+            chunked = 1;
+        }
+        else if(strcmp(argv[arg], "-raw") == 0)
+            raw = 1;
+        else if(strcmp(argv[arg], "-gzip") == 0)
+            compression = CCZ_COMPRESSION_GZIP;
+        else if(strcmp(argv[arg], "-lz4") == 0)
+            compression = CCZ_COMPRESSION_LZ4;
+        else if(strcmp(argv[arg], "-none") == 0)
+            compression = CCZ_COMPRESSION_NONE;
+        else
+            usage();
     }
-    
+
+    if(arg != argc - 1 || argv[arg][0] == '-' || (chunked && chunkSize <= 0) || (chunked && raw))
+        usage();
+
     /* open file to read */
-    FILE *in = fopen(argv[1], "rb");
+    FILE *in = fopen(argv[arg], "rb");
     if(!in)
     {
-        printf("Failed to open %s for reading\n", argv[1]);
+        printf("Failed to open %s for reading\n", argv[arg]);
         exit(10);
     }
     
@@ -67,9 +144,21 @@ int main (int argc, const char * argv[])
 
     struct CCZHeader *header;
 
-    /* allocate output memory for the compressed block */
-    uLongf destLen = compressBound(len)+sizeof(*header);
-    unsigned char *compressed = malloc(destLen);
+    /* version 2 is a single block without a chunk table */
+    long chunkCount = 1;
+    long tableLen = 0;
+    if(chunked)
+    {
+        chunkCount = (len + chunkSize - 1) / chunkSize;
+        tableLen = sizeof(struct CCZChunkTable) + chunkCount * sizeof(uint32_t);
+    }
+    else
+        chunkSize = len;
+
+    /* allocate output memory for the compressed blocks */
+    uLongf bound = compressBound(chunkSize) + ccLZ4CompressBound(chunkSize) + 32;
+    uLongf destLen = 0;
+    unsigned char *compressed = malloc(sizeof(*header) + tableLen + bound * chunkCount);
     if(!data || !compressed)
     {
         printf("Out of memory\n");
@@ -85,11 +174,27 @@ int main (int argc, const char * argv[])
     fclose(in);
         
 
-    /* compress the data */
-    if(compress2(compressed+sizeof(*header), &destLen, data, len, Z_DEFAULT_COMPRESSION) != Z_OK)
+    /* compress the data, chunk by chunk for version 3 */
+    unsigned char *chunks = compressed + sizeof(*header) + tableLen;
+    uint32_t *sizes = (uint32_t*)(compressed + sizeof(*header) + sizeof(struct CCZChunkTable));
+    long i;
+
+    for(i = 0; i < chunkCount; i++)
     {
-        printf("Failed to compress the data\n");
-        exit(10);
+        long start = i * chunkSize;
+        long chunkLen = (len - start < chunkSize) ? len - start : chunkSize;
+
+        uLongf size = compressBlock(compression, chunks + destLen, bound, data + start, chunkLen);
+        if(size == 0 && chunkLen != 0)
+        {
+            printf("Failed to compress the data\n");
+            exit(10);
+        }
+
+        if(chunked)
+            sizes[i] = OSSwapHostToBigInt32(size);
+
+        destLen += size;
     }
 
     header = (struct CCZHeader*) compressed;
@@ -99,19 +204,31 @@ int main (int argc, const char * argv[])
     header->sig[3] = '!';
     
     header->len = OSSwapHostToBigInt32(len);
-    header->version = OSSwapHostToBigInt16(2);
-    header->compression_type = OSSwapHostToBigInt16(CCZ_COMPRESSION_ZLIB);
+    header->version = OSSwapHostToBigInt16(chunked ? 3 : 2);
+    header->compression_type = OSSwapHostToBigInt16(compression);
+    header->reserved = 0;
+
+    if(chunked)
+    {
+        struct CCZChunkTable *table = (struct CCZChunkTable*)(compressed + sizeof(*header));
+        table->chunk_size = OSSwapHostToBigInt32(chunkSize);
+        table->chunk_count = OSSwapHostToBigInt32(chunkCount);
+    }
+
+    destLen += tableLen;
     
     /* write data */
     char dstname[1024];
-    snprintf(&dstname[0], sizeof(dstname)-1, "%s.ccz", argv[1]);
+    snprintf(&dstname[0], sizeof(dstname)-1, raw ? "%s.raw" : "%s.ccz", argv[arg]);
     FILE *out = fopen(&dstname[0], "wb");
     if(!out)
     {
         printf("Failed to open %s for writing.\n", dstname);
         exit(10);
     }
-    if( fwrite(compressed, 1, destLen + sizeof(*header), out) != destLen+sizeof(*header) )
+    unsigned char *start = raw ? compressed + sizeof(*header) : compressed;
+    uLongf writeLen = raw ? destLen : destLen + sizeof(*header);
+    if( fwrite(start, 1, writeLen, out) != writeLen )
     {
         printf("Failed to write data.\n");
         exit(10);
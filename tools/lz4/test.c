@@ -0,0 +1,264 @@
+/*
+ * cocos2d for iPhone: http://www.cocos2d-iphone.org
+ *
+ */
+
+/*
+	ccLZ4 regression test.
+
+	Round trips zeros, short repeating patterns, text, random bytes and mixes of them at many
+	sizes, so every literal and match length encoding and every match copy path is used.
+	Then feeds the decoder every truncation of a block, blocks with single bits flipped and
+	random garbage: it must reject them or produce exactly outLength bytes, without writing
+	outside the output. The output sits between guard bytes to catch stray writes, build
+	with -DCMAKE_C_FLAGS=-fsanitize=address to catch stray reads too.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ccLZ4.h"
+
+#define GUARD 64
+#define GUARD_BYTE 0xA5
+
+static int failures = 0;
+
+static unsigned int seed = 1;
+
+static unsigned int Random(void)
+{
+	// Small LCG so the input is the same everywhere.
+	seed = seed*1664525u + 1013904223u;
+	return seed >> 8;
+}
+
+typedef enum { kDataZeros, kDataPattern, kDataText, kDataRandom, kDataMixed, kNumDataKinds } DataKind;
+
+static const char *kindNames[] = { "zeros", "pattern", "text", "random", "mixed" };
+
+static void FillPattern(unsigned char *data, unsigned int length, unsigned int period)
+{
+	for(unsigned int i = 0; i < length; i++)
+		data[i] = (unsigned char)('a' + i%period);
+}
+
+static void FillText(unsigned char *data, unsigned int length)
+{
+	static const char *words[] = { "sprite ", "texture ", "atlas ", "frame ", "node ", "layer ", "scene ", "action " };
+
+	for(unsigned int i = 0; i < length; ) {
+		const char *word = words[Random()%8];
+		for(; *word && i < length; i++)
+			data[i] = (unsigned char)*word++;
+	}
+}
+
+static unsigned char *MakeData(DataKind kind, unsigned int length)
+{
+	unsigned char *data = malloc(length ? length : 1);
+
+	switch(kind) {
+		case kDataZeros:
+			memset(data, 0, length);
+			break;
+		case kDataPattern:
+			// periods below 8 take the short offset path of the decoder
+			FillPattern(data, length, 1 + length%11);
+			break;
+		case kDataText:
+			FillText(data, length);
+			break;
+		case kDataRandom:
+			for(unsigned int i = 0; i < length; i++)
+				data[i] = (unsigned char)Random();
+			break;
+		case kDataMixed:
+			// runs of every kind, long enough to need extra length bytes
+			for(unsigned int i = 0; i < length; ) {
+				unsigned int run = 1 + Random()%600;
+				if(run > length - i)
+					run = length - i;
+
+				switch(Random()%4) {
+					case 0: memset(data + i, (int)(Random() & 0xFF), run); break;
+					case 1: FillPattern(data + i, run, 1 + Random()%9); break;
+					case 2: FillText(data + i, run); break;
+					default:
+						for(unsigned int j = 0; j < run; j++)
+							data[i + j] = (unsigned char)Random();
+						break;
+				}
+				i += run;
+			}
+			break;
+		default:
+			break;
+	}
+
+	return data;
+}
+
+// Decompresses into a buffer surrounded by guard bytes, returns the result or -2 if a guard byte changed.
+static int GuardedDecompress(const unsigned char *in, unsigned int inLength, unsigned char *out, unsigned int outLength)
+{
+	unsigned char *buffer = malloc(outLength + 2*GUARD);
+	memset(buffer, GUARD_BYTE, outLength + 2*GUARD);
+
+	// the input gets its own exact size copy, so reads past it are caught by the sanitizers
+	unsigned char *input = malloc(inLength ? inLength : 1);
+	memcpy(input, in, inLength);
+
+	int result = ccLZ4Decompress(input, inLength, buffer + GUARD, outLength);
+
+	for(unsigned int i = 0; i < GUARD; i++) {
+		if(buffer[i] != GUARD_BYTE || buffer[GUARD + outLength + i] != GUARD_BYTE)
+			result = -2;
+	}
+
+	if(out)
+		memcpy(out, buffer + GUARD, outLength);
+
+	free(input);
+	free(buffer);
+	return result;
+}
+
+static unsigned char *Compress(const unsigned char *data, unsigned int length, unsigned int *compressedLength)
+{
+	unsigned int bound = ccLZ4CompressBound(length);
+	unsigned char *compressed = malloc(bound);
+
+	*compressedLength = ccLZ4Compress(data, length, compressed, bound);
+	return compressed;
+}
+
+static void TestRoundTrip(DataKind kind, unsigned int length)
+{
+	unsigned char *data = MakeData(kind, length);
+	unsigned int compressedLength;
+	unsigned char *compressed = Compress(data, length, &compressedLength);
+	unsigned char *out = malloc(length ? length : 1);
+
+	if(compressedLength == 0 || compressedLength > ccLZ4CompressBound(length)) {
+		printf("FAIL %s %u: compressed to %u bytes\n", kindNames[kind], length, compressedLength);
+		failures++;
+	} else if(GuardedDecompress(compressed, compressedLength, out, length) != (int)length || memcmp(out, data, length)) {
+		printf("FAIL %s %u: round trip differs\n", kindNames[kind], length);
+		failures++;
+	} else if(length && (GuardedDecompress(compressed, compressedLength, NULL, length - 1) != -1 || GuardedDecompress(compressed, compressedLength, NULL, length + 1) != -1)) {
+		printf("FAIL %s %u: accepted the wrong output length\n", kindNames[kind], length);
+		failures++;
+	}
+
+	if(kind == kDataZeros && length >= 4096 && compressedLength*50 > length) {
+		printf("FAIL %s %u: only compressed to %u bytes\n", kindNames[kind], length, compressedLength);
+		failures++;
+	}
+
+	// a smaller output buffer than the bound is refused instead of overflowed
+	if(length && ccLZ4Compress(data, length, compressed, ccLZ4CompressBound(length) - 1) != 0) {
+		printf("FAIL %s %u: compressed into a buffer below the bound\n", kindNames[kind], length);
+		failures++;
+	}
+
+	free(out);
+	free(compressed);
+	free(data);
+}
+
+// Every prefix of a block is missing bytes the output needs, so all of them must be rejected.
+static void TestTruncated(DataKind kind, unsigned int length)
+{
+	unsigned char *data = MakeData(kind, length);
+	unsigned int compressedLength;
+	unsigned char *compressed = Compress(data, length, &compressedLength);
+
+	for(unsigned int i = 0; i < compressedLength; i++) {
+		int result = GuardedDecompress(compressed, i, NULL, length);
+		if(result != -1) {
+			printf("FAIL %s %u: truncated to %u bytes returned %d\n", kindNames[kind], length, i, result);
+			failures++;
+			break;
+		}
+	}
+
+	free(compressed);
+	free(data);
+}
+
+// A flipped bit may still decode to some output, but never to another length or outside the buffer.
+static void TestBitFlips(DataKind kind, unsigned int length)
+{
+	unsigned char *data = MakeData(kind, length);
+	unsigned int compressedLength;
+	unsigned char *compressed = Compress(data, length, &compressedLength);
+
+	for(unsigned int bit = 0; bit < compressedLength*8; bit++) {
+		compressed[bit/8] ^= (unsigned char)(1 << bit%8);
+
+		int result = GuardedDecompress(compressed, compressedLength, NULL, length);
+		if(result != -1 && result != (int)length) {
+			printf("FAIL %s %u: flipping bit %u returned %d\n", kindNames[kind], length, bit, result);
+			failures++;
+			break;
+		}
+
+		compressed[bit/8] ^= (unsigned char)(1 << bit%8);
+	}
+
+	free(compressed);
+	free(data);
+}
+
+static void TestGarbage(void)
+{
+	unsigned char garbage[512];
+
+	for(int i = 0; i < 20000; i++) {
+		unsigned int inLength = Random()%sizeof(garbage);
+		unsigned int outLength = Random()%4096;
+
+		for(unsigned int j = 0; j < inLength; j++)
+			garbage[j] = (unsigned char)Random();
+
+		int result = GuardedDecompress(garbage, inLength, NULL, outLength);
+		if(result != -1 && result != (int)outLength) {
+			printf("FAIL garbage %u -> %u: returned %d\n", inLength, outLength, result);
+			failures++;
+			break;
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	// around the minimum match and last literal limits, and the 15 and 255 length steps
+	static const unsigned int lengths[] = { 0, 1, 4, 5, 12, 13, 14, 15, 16, 17, 19, 20, 31, 64, 270, 271, 300, 1000, 4096, 65536, 70000 };
+
+	for(int kind = 0; kind < kNumDataKinds; kind++) {
+		for(unsigned int i = 0; i < sizeof(lengths)/sizeof(lengths[0]); i++)
+			TestRoundTrip((DataKind)kind, lengths[i]);
+
+		for(unsigned int length = 0; length < 300; length++)
+			TestRoundTrip((DataKind)kind, length);
+
+		// bigger than the 64KB match window
+		TestRoundTrip((DataKind)kind, 1 << 20);
+
+		TestTruncated((DataKind)kind, 2000);
+		TestBitFlips((DataKind)kind, 300);
+		TestBitFlips((DataKind)kind, 3000);
+	}
+
+	TestGarbage();
+
+	if(failures) {
+		printf("%d failures\n", failures);
+		return 1;
+	}
+
+	printf("ok\n");
+	return 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * cocos2d for iPhone: http://www.cocos2d-iphone.org
+ *
+ */
+
+/*
+	ccPixelConvert benchmark.
+
+	Converts a 2048x2048 RGBA8888 image into every format with the loops CCTexture2D used
+	before, then with ccPixelConvert() in one thread, in one thread with dithering and with
+	one thread per CPU. Reports milliseconds per image, the best of several runs.
+
+	Link it against the scalar library (CC_PIXEL_NO_SIMD) to see what the SIMD kernels gain.
+
+	Usage: pixelconvert_benchmark [--size n] [--runs n] [--quick]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ccPixelConvert.h"
+
+static double Now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec*1000.0 + t.tv_nsec/1000000.0;
+}
+
+// The loops of CCTexture2D -initWithCGImage:resolutionType:.
+static void OldConvert(void *dst, const void *src, unsigned int pixels, ccPixelConvertFormat format)
+{
+	const unsigned int *inPixel32 = src;
+	unsigned short *outPixel16 = dst;
+
+	switch(format) {
+		case kCCPixelConvertRGB565:
+			for(unsigned int i = 0; i < pixels; ++i, ++inPixel32)
+				*outPixel16++ = ((((*inPixel32 >> 0) & 0xFF) >> 3) << 11) | ((((*inPixel32 >> 8) & 0xFF) >> 2) << 5) | ((((*inPixel32 >> 16) & 0xFF) >> 3) << 0);
+			break;
+		case kCCPixelConvertRGBA4444:
+			for(unsigned int i = 0; i < pixels; ++i, ++inPixel32)
+				*outPixel16++ = ((((*inPixel32 >> 0) & 0xFF) >> 4) << 12) | ((((*inPixel32 >> 8) & 0xFF) >> 4) << 8) | ((((*inPixel32 >> 16) & 0xFF) >> 4) << 4) | ((((*inPixel32 >> 24) & 0xFF) >> 4) << 0);
+			break;
+		case kCCPixelConvertRGB5A1:
+			for(unsigned int i = 0; i < pixels; ++i, ++inPixel32) {
+				if((*inPixel32 >> 31))
+					*outPixel16++ = ((((*inPixel32 >> 0) & 0xFF) >> 3) << 11) | ((((*inPixel32 >> 8) & 0xFF) >> 3) << 6) | ((((*inPixel32 >> 16) & 0xFF) >> 3) << 1) | 1;
+				else
+					*outPixel16++ = 0;
+			}
+			break;
+		case kCCPixelConvertRGB888:
+		{
+			const char *inData = src;
+			char *outData = dst;
+			int j = 0;
+			for(unsigned int i = 0; i < pixels*4; i++) {
+				outData[j++] = inData[i++];
+				outData[j++] = inData[i++];
+				outData[j++] = inData[i++];
+			}
+			break;
+		}
+		case kCCPixelConvertA8:
+			// CCTexture2D draws A8 images in an alpha only bitmap, this is the same copy.
+			for(unsigned int i = 0; i < pixels; i++)
+				((unsigned char*)dst)[i] = inPixel32[i] >> 24;
+			break;
+	}
+}
+
+static const char *formatNames[] = { "RGB565", "RGBA4444", "RGB5A1", "RGB888", "A8" };
+
+int main(int argc, char **argv)
+{
+	unsigned int size = 2048;
+	int runs = 10;
+
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+			size = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+			runs = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--quick") == 0) {
+			size = 256;
+			runs = 1;
+		}
+		else {
+			fprintf(stderr, "usage: %s [--size n] [--runs n] [--quick]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	size_t pixels = (size_t)size*size;
+	unsigned char *src = malloc(pixels*4);
+	unsigned char *dst = malloc(pixels*3);
+
+	// Random noise over a gradient, so alpha is above and below 128.
+	unsigned int seed = 1;
+	for(size_t i = 0; i < pixels*4; i++) {
+		seed = seed*1664525u + 1013904223u;
+		src[i] = (unsigned char)((i/4 % size)*256/size + (seed >> 28));
+	}
+
+	printf("%ux%u, milliseconds per image\n", size, size);
+	printf("%-10s %10s %10s %10s %10s\n", "format", "old", "1 thread", "dithered", "threads");
+
+	for(int format = 0; format < 5; format++) {
+		double best[4] = { 1e30, 1e30, 1e30, 1e30 };
+
+		for(int run = 0; run < runs; run++) {
+			for(int mode = 0; mode < 4; mode++) {
+				ccPixelConvertSetThreadCount(mode == 3 ? 0 : 1);
+
+				double start = Now();
+				if(mode == 0)
+					OldConvert(dst, src, (unsigned int)pixels, format);
+				else
+					ccPixelConvert(dst, src, size, size, format, mode == 2 ? kCCPixelConvertDither : 0);
+				double elapsed = Now() - start;
+
+				if(elapsed < best[mode])
+					best[mode] = elapsed;
+			}
+		}
+
+		printf("%-10s %10.2f %10.2f %10.2f %10.2f\n", formatNames[format], best[0], best[1], best[2], best[3]);
+	}
+
+	free(src);
+	free(dst);
+	return 0;
+}
@@ -0,0 +1,302 @@
+/*
+ * cocos2d for iPhone: http://www.cocos2d-iphone.org
+ *
+ */
+
+/*
+	ccPixelConvert regression test.
+
+	Without dithering every format must match the loops CCTexture2D used before, on random
+	images of many widths (so every SIMD tail is hit), with one thread and with several.
+	Dithered images must match a reference too, whatever the thread count or band split,
+	must stay within one step of the truncated image and must not change the average color
+	of a gradient.
+
+	Built against both the SIMD and the scalar (CC_PIXEL_NO_SIMD) library.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ccPixelConvert.h"
+
+static int failures = 0;
+
+static unsigned int seed = 1;
+
+static unsigned int Random(void)
+{
+	// Small LCG so the input is the same everywhere.
+	seed = seed*1664525u + 1013904223u;
+	return seed >> 8;
+}
+
+static const char *formatNames[] = { "RGB565", "RGBA4444", "RGB5A1", "RGB888", "A8" };
+
+#define NUM_FORMATS 5
+
+// The conversions of CCTexture2D -initWithCGImage:resolutionType:, one pixel at a time.
+static void ReferenceConvert(void *dst, const unsigned char *src, unsigned int pixels, ccPixelConvertFormat format)
+{
+	unsigned short *out16 = dst;
+	unsigned char *out8 = dst;
+
+	for(unsigned int i = 0; i < pixels; i++) {
+		unsigned int p = src[i*4] | (src[i*4+1] << 8) | (src[i*4+2] << 16) | ((unsigned int)src[i*4+3] << 24);
+
+		switch(format) {
+			case kCCPixelConvertRGB565:
+				out16[i] = ((((p >> 0) & 0xFF) >> 3) << 11) | ((((p >> 8) & 0xFF) >> 2) << 5) | ((((p >> 16) & 0xFF) >> 3) << 0);
+				break;
+			case kCCPixelConvertRGBA4444:
+				out16[i] = ((((p >> 0) & 0xFF) >> 4) << 12) | ((((p >> 8) & 0xFF) >> 4) << 8) | ((((p >> 16) & 0xFF) >> 4) << 4) | ((((p >> 24) & 0xFF) >> 4) << 0);
+				break;
+			case kCCPixelConvertRGB5A1:
+				if((p >> 31))
+					out16[i] = ((((p >> 0) & 0xFF) >> 3) << 11) | ((((p >> 8) & 0xFF) >> 3) << 6) | ((((p >> 16) & 0xFF) >> 3) << 1) | 1;
+				else
+					out16[i] = 0;
+				break;
+			case kCCPixelConvertRGB888:
+				memcpy(out8 + i*3, src + i*4, 3);
+				break;
+			case kCCPixelConvertA8:
+				out8[i] = src[i*4+3];
+				break;
+		}
+	}
+}
+
+// Ordered dithering: each n bit channel is scaled by (2^n - 1) / 2^n, then a 4x4 Bayer threshold
+// of up to one step is added before truncating. Alpha is only dithered in RGBA4444.
+static void ReferenceDither(unsigned short *dst, const unsigned char *src, unsigned int width, unsigned int height, ccPixelConvertFormat format)
+{
+	static const int bayer[4][4] = { { 0, 8, 2, 10 }, { 12, 4, 14, 6 }, { 3, 11, 1, 9 }, { 15, 7, 13, 5 } };
+	static const int bits[3][4] = { { 5, 6, 5, 0 }, { 4, 4, 4, 4 }, { 5, 5, 5, 0 } };
+	static const int positions[3][4] = { { 11, 5, 0, 0 }, { 12, 8, 4, 0 }, { 11, 6, 1, 0 } };
+
+	for(unsigned int y = 0; y < height; y++) {
+		for(unsigned int x = 0; x < width; x++) {
+			const unsigned char *p = src + (y*width + x)*4;
+			unsigned int pixel = 0;
+
+			for(int c = 0; c < 4; c++) {
+				int n = bits[format][c];
+				if(n == 0)
+					continue;
+
+				int step = 256 >> n;
+				int value = p[c] - (p[c] >> n) + bayer[y & 3][x & 3]*step/16;
+				pixel |= (value >> (8 - n)) << positions[format][c];
+			}
+
+			if(format == kCCPixelConvertRGB5A1)
+				pixel = p[3] >= 128 ? pixel | 1 : 0;
+
+			dst[y*width + x] = pixel;
+		}
+	}
+}
+
+static unsigned char *RandomImage(unsigned int width, unsigned int height)
+{
+	unsigned char *image = malloc((size_t)width*height*4 + 1);
+	for(size_t i = 0; i < (size_t)width*height*4; i++)
+		image[i] = Random();
+	return image;
+}
+
+static size_t ImageSize(unsigned int width, unsigned int height, ccPixelConvertFormat format)
+{
+	return (size_t)width*height*ccPixelConvertBitsPerPixel(format)/8;
+}
+
+// The output buffer has a guard byte so writes past the end are caught.
+#define GUARD 0xA5
+
+static void TestExact(unsigned int width, unsigned int height)
+{
+	unsigned char *src = RandomImage(width, height);
+
+	for(int format = 0; format < NUM_FORMATS; format++) {
+		size_t size = ImageSize(width, height, format);
+		unsigned char *expected = malloc(size + 1);
+		unsigned char *actual = malloc(size + 1);
+
+		ReferenceConvert(expected, src, width*height, format);
+
+		for(int threads = 1; threads <= 4; threads += 3) {
+			ccPixelConvertSetThreadCount(threads);
+			memset(actual, 0, size);
+			actual[size] = GUARD;
+			ccPixelConvert(actual, src, width, height, format, 0);
+
+			if(memcmp(expected, actual, size) != 0 || actual[size] != GUARD) {
+				printf("FAIL %s %ux%u, %d threads: differs from CCTexture2D\n", formatNames[format], width, height, threads);
+				failures++;
+			}
+		}
+
+		free(expected);
+		free(actual);
+	}
+
+	free(src);
+}
+
+static unsigned int Channel(unsigned int pixel, int shift, int bits)
+{
+	// Back to 8 bits, the way the GPU expands them.
+	unsigned int value = (pixel >> shift) & ((1 << bits) - 1);
+	return value*255/((1 << bits) - 1);
+}
+
+// Converts a 16 bit pixel back to RGBA8888.
+static void Expand(unsigned int pixel, ccPixelConvertFormat format, unsigned int rgba[4])
+{
+	switch(format) {
+		case kCCPixelConvertRGB565:
+			rgba[0] = Channel(pixel, 11, 5); rgba[1] = Channel(pixel, 5, 6); rgba[2] = Channel(pixel, 0, 5); rgba[3] = 255;
+			break;
+		case kCCPixelConvertRGBA4444:
+			rgba[0] = Channel(pixel, 12, 4); rgba[1] = Channel(pixel, 8, 4); rgba[2] = Channel(pixel, 4, 4); rgba[3] = Channel(pixel, 0, 4);
+			break;
+		default:
+			rgba[0] = Channel(pixel, 11, 5); rgba[1] = Channel(pixel, 6, 5); rgba[2] = Channel(pixel, 1, 5); rgba[3] = Channel(pixel, 0, 1);
+			break;
+	}
+}
+
+static void TestDither(unsigned int width, unsigned int height)
+{
+	unsigned char *src = RandomImage(width, height);
+
+	for(int format = 0; format < 3; format++) {
+		size_t size = ImageSize(width, height, format);
+		unsigned short *whole = malloc(size + 1);
+		unsigned short *threaded = malloc(size + 1);
+		unsigned short *bands = malloc(size + 1);
+		unsigned short *plain = malloc(size);
+		unsigned short *expected = malloc(size);
+
+		ReferenceDither(expected, src, width, height, format);
+
+		ccPixelConvertSetThreadCount(1);
+		ccPixelConvert(whole, src, width, height, format, kCCPixelConvertDither);
+		ccPixelConvert(plain, src, width, height, format, 0);
+
+		ccPixelConvertSetThreadCount(3);
+		ccPixelConvert(threaded, src, width, height, format, kCCPixelConvertDither);
+
+		// Odd sized bands, the dither pattern must stay in phase.
+		for(unsigned int y = 0; y < height; y += 5) {
+			unsigned int rows = height - y < 5 ? height - y : 5;
+			ccPixelConvertRows(bands + (size_t)y*width, width*2, src + (size_t)y*width*4, width*4, width, y, rows, format, kCCPixelConvertDither);
+		}
+
+		if(memcmp(whole, expected, size) != 0) {
+			printf("FAIL %s %ux%u: dithering differs from the reference\n", formatNames[format], width, height);
+			failures++;
+		}
+
+		if(memcmp(whole, threaded, size) != 0 || memcmp(whole, bands, size) != 0) {
+			printf("FAIL %s %ux%u: dithering depends on the threads or bands\n", formatNames[format], width, height);
+			failures++;
+		}
+
+		// Never more than one step away from the truncated value.
+		for(size_t i = 0; i < (size_t)width*height; i++) {
+			unsigned int d[4], t[4];
+			Expand(whole[i], format, d);
+			Expand(plain[i], format, t);
+
+			for(int c = 0; c < 4; c++) {
+				unsigned int step = format == kCCPixelConvertRGBA4444 ? 17 : (format == kCCPixelConvertRGB565 && c == 1 ? 4 : 8);
+				if(d[c] + step + 1 < t[c] || d[c] > t[c] + step + 1) {
+					printf("FAIL %s pixel %zu channel %d: dithered %u, truncated %u\n", formatNames[format], i, c, d[c], t[c]);
+					failures++;
+					i = (size_t)width*height;
+					break;
+				}
+			}
+		}
+
+		free(whole);
+		free(threaded);
+		free(bands);
+		free(plain);
+		free(expected);
+	}
+
+	free(src);
+}
+
+// A horizontal gray gradient, its average error must be much smaller when dithered.
+static void TestGradient(void)
+{
+	const unsigned int width = 256, height = 64;
+	unsigned char *src = malloc(width*height*4);
+	unsigned short *out = malloc(width*height*2);
+
+	for(unsigned int y = 0; y < height; y++)
+		for(unsigned int x = 0; x < width; x++)
+			memset(src + (y*width + x)*4, x, 4);
+
+	for(int format = 0; format < 2; format++) {
+		double error[2];
+
+		for(int dither = 0; dither < 2; dither++) {
+			ccPixelConvert(out, src, width, height, format, dither ? kCCPixelConvertDither : 0);
+
+			// Mean signed error of every column of 4x4 cells.
+			double total = 0;
+			for(unsigned int x = 0; x < width; x += 4) {
+				double sum = 0;
+				for(unsigned int y = 0; y < 4; y++) {
+					for(unsigned int i = 0; i < 4; i++) {
+						unsigned int rgba[4];
+						Expand(out[y*width + x + i], format, rgba);
+						sum += (double)rgba[0] - src[(y*width + x + i)*4];
+					}
+				}
+				total += sum < 0 ? -sum/16 : sum/16;
+			}
+			error[dither] = total/(width/4);
+		}
+
+		if(error[1]*2 > error[0]) {
+			printf("FAIL %s gradient: mean error %.2f dithered, %.2f truncated\n", formatNames[format], error[1], error[0]);
+			failures++;
+		}
+	}
+
+	free(src);
+	free(out);
+}
+
+int main(int argc, char **argv)
+{
+	static const unsigned int widths[] = { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 64, 100, 257 };
+
+	for(unsigned int i = 0; i < sizeof(widths)/sizeof(widths[0]); i++) {
+		TestExact(widths[i], 1);
+		TestExact(widths[i], 13);
+		TestDither(widths[i], 11);
+	}
+
+	// Big enough to be split between threads.
+	TestExact(1024, 700);
+	TestExact(513, 1023);
+	TestDither(1000, 600);
+
+	TestGradient();
+
+	if(failures) {
+		printf("%d failures\n", failures);
+		return 1;
+	}
+
+	printf("ok\n");
+	return 0;
+}